@@ -27,6 +27,7 @@
 #include "GooString.h"
 #include "PDFDoc.h"
 #include "GlobalParams.h"
+#include "TextPageCache.h"
 
 #include <vector>
 
@@ -51,6 +52,8 @@ public:
     int raw_doc_data_length;
     bool is_locked;
     std::vector<embedded_file *> embedded_files;
+    unsigned int serial; // unique per document, unlike the address of doc which can be reused
+    TextPageCache text_page_cache;
 
 private:
     document_private();
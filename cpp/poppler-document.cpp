@@ -45,6 +45,7 @@
 #include "Outline.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <memory>
 
@@ -76,7 +77,11 @@ document_private::document_private(const char *file_data, int file_data_length,
     doc = new PDFDoc(memstr, &goo_owner_password, &goo_user_password);
 }
 
-document_private::document_private() : GlobalParamsIniter(detail::error_function), doc(nullptr), raw_doc_data(nullptr), raw_doc_data_length(0), is_locked(false) { }
+document_private::document_private() : GlobalParamsIniter(detail::error_function), doc(nullptr), raw_doc_data(nullptr), raw_doc_data_length(0), is_locked(false)
+{
+    static std::atomic<unsigned int> next_serial(0);
+    serial = next_serial++;
+}
 
 document_private::~document_private()
 {
@@ -1013,6 +1018,36 @@ std::map<std::string, destination> document::create_destination_map() const
     return m;
 }
 
+/**
+ The maximum amount of memory, in bytes, used to keep the text of the pages.
+
+ \see set_text_cache_size
+
+ \since 21.03
+ */
+size_t document::text_cache_size() const
+{
+    return d->text_page_cache.getMaxBytes();
+}
+
+/**
+ Sets the maximum amount of memory, in bytes, used to keep the text of the
+ pages between calls to page::search(), page::search_all(), page::text() and
+ page::text_list(), so that querying the text of a page again doesn't extract
+ it again.
+
+ When the limit is reached, the text of the least recently used pages is
+ dropped. The default, 0, keeps no text.
+
+ \param bytes the new limit
+
+ \since 21.03
+ */
+void document::set_text_cache_size(size_t bytes)
+{
+    d->text_page_cache.setMaxBytes(bytes);
+}
+
 /**
  Saves the %document to file \p file_name.
 
@@ -116,6 +116,9 @@ public:
     // So we use std::string instead of ustring.
     std::map<std::string, destination> create_destination_map() const;
 
+    size_t text_cache_size() const;
+    void set_text_cache_size(size_t bytes);
+
     bool save(const std::string &file_name) const;
     bool save_a_copy(const std::string &file_name) const;
 
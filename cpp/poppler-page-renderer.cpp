@@ -32,6 +32,9 @@
 #include <config.h>
 #include <poppler-config.h>
 
+#include <algorithm>
+#include <memory>
+
 #include "PDFDoc.h"
 #if defined(HAVE_SPLASH)
 #    include "SplashOutputDev.h"
@@ -48,12 +51,19 @@ public:
 #if defined(HAVE_SPLASH)
     static bool conv_color_mode(image::format_enum mode, SplashColorMode &splash_mode);
     static bool conv_line_mode(page_renderer::line_mode_enum mode, SplashThinLineMode &splash_mode);
+    std::unique_ptr<SplashOutputDev> create_output_dev(PDFDoc *pdfdoc) const;
+    SplashOutputDev *get_output_dev(document_private *doc);
 #endif
 
     argb paper_color;
     unsigned int hints;
     image::format_enum image_format;
     page_renderer::line_mode_enum line_mode;
+
+#if defined(HAVE_SPLASH)
+    std::unique_ptr<SplashOutputDev> output_dev; // kept across renderings, with its fonts and caches
+    unsigned int output_dev_doc_serial; // serial of the document output_dev was started for
+#endif
 };
 
 #if defined(HAVE_SPLASH)
@@ -98,6 +108,36 @@ bool page_renderer_private::conv_line_mode(page_renderer::line_mode_enum mode, S
     }
     return true;
 }
+
+std::unique_ptr<SplashOutputDev> page_renderer_private::create_output_dev(PDFDoc *pdfdoc) const
+{
+    SplashColorMode colorMode;
+    SplashThinLineMode lineMode;
+
+    if (!conv_color_mode(image_format, colorMode) || !conv_line_mode(line_mode, lineMode)) {
+        return nullptr;
+    }
+
+    SplashColor bgColor;
+    bgColor[0] = paper_color & 0xff;
+    bgColor[1] = (paper_color >> 8) & 0xff;
+    bgColor[2] = (paper_color >> 16) & 0xff;
+    std::unique_ptr<SplashOutputDev> splashOutputDev(new SplashOutputDev(colorMode, 4, false, bgColor, true, lineMode));
+    splashOutputDev->setFontAntialias(hints & page_renderer::text_antialiasing ? true : false);
+    splashOutputDev->setVectorAntialias(hints & page_renderer::antialiasing ? true : false);
+    splashOutputDev->setFreeTypeHinting(hints & page_renderer::text_hinting ? true : false, false);
+    splashOutputDev->startDoc(pdfdoc);
+    return splashOutputDev;
+}
+
+SplashOutputDev *page_renderer_private::get_output_dev(document_private *doc)
+{
+    if (!output_dev || output_dev_doc_serial != doc->serial) {
+        output_dev = create_output_dev(doc->doc);
+        output_dev_doc_serial = doc->serial;
+    }
+    return output_dev.get();
+}
 #endif
 
 /**
@@ -105,6 +145,12 @@ bool page_renderer_private::conv_line_mode(page_renderer::line_mode_enum mode, S
 
  Simple way to render a page of a PDF %document.
 
+ A page_renderer keeps its fonts and glyph caches from one rendering to the
+ next, so rendering many pages of a document, or the same page at different
+ resolutions, is faster with a single page_renderer than with a new one for
+ each page. A page_renderer must not be used by several threads at the same
+ time; use one for each rendering thread instead.
+
  \since 0.16
  */
 
@@ -146,6 +192,9 @@ argb page_renderer::paper_color() const
  */
 void page_renderer::set_paper_color(argb c)
 {
+    if (c != d->paper_color) {
+        clear_cache();
+    }
     d->paper_color = c;
 }
 
@@ -169,11 +218,7 @@ unsigned int page_renderer::render_hints() const
  */
 void page_renderer::set_render_hint(page_renderer::render_hint hint, bool on)
 {
-    if (on) {
-        d->hints |= hint;
-    } else {
-        d->hints &= ~(int)hint;
-    }
+    set_render_hints(on ? d->hints | hint : d->hints & ~(int)hint);
 }
 
 /**
@@ -183,6 +228,9 @@ void page_renderer::set_render_hint(page_renderer::render_hint hint, bool on)
  */
 void page_renderer::set_render_hints(unsigned int hints)
 {
+    if (hints != d->hints) {
+        clear_cache();
+    }
     d->hints = hints;
 }
 
@@ -209,6 +257,9 @@ image::format_enum page_renderer::image_format() const
  */
 void page_renderer::set_image_format(image::format_enum format)
 {
+    if (format != d->image_format) {
+        clear_cache();
+    }
     d->image_format = format;
 }
 
@@ -235,9 +286,33 @@ page_renderer::line_mode_enum page_renderer::line_mode() const
  */
 void page_renderer::set_line_mode(page_renderer::line_mode_enum mode)
 {
+    if (mode != d->line_mode) {
+        clear_cache();
+    }
     d->line_mode = mode;
 }
 
+/**
+ Release the resources kept between renderings.
+
+ The output device used for rendering, with its fonts, glyph caches and
+ page bitmap, is kept across render_page() and render_page_strips() calls
+ for the same document, so that the fonts of a document are loaded and its
+ glyphs rasterized only once. It is built again when rendering a page of
+ another document, or after a setting of the renderer changed.
+
+ This releases it, for example to give memory back when no rendering is
+ expected for a while.
+
+ \since 21.03
+ */
+void page_renderer::clear_cache()
+{
+#if defined(HAVE_SPLASH)
+    d->output_dev.reset();
+#endif
+}
+
 /**
  Render the specified page.
 
@@ -267,25 +342,14 @@ image page_renderer::render_page(const page *p, double xres, double yres, int x,
     page_private *pp = page_private::get(p);
     PDFDoc *pdfdoc = pp->doc->doc;
 
-    SplashColorMode colorMode;
-    SplashThinLineMode lineMode;
-
-    if (!d->conv_color_mode(d->image_format, colorMode) || !d->conv_line_mode(d->line_mode, lineMode)) {
+    SplashOutputDev *splashOutputDev = d->get_output_dev(pp->doc);
+    if (!splashOutputDev) {
         return image();
     }
 
-    SplashColor bgColor;
-    bgColor[0] = d->paper_color & 0xff;
-    bgColor[1] = (d->paper_color >> 8) & 0xff;
-    bgColor[2] = (d->paper_color >> 16) & 0xff;
-    SplashOutputDev splashOutputDev(colorMode, 4, false, bgColor, true, lineMode);
-    splashOutputDev.setFontAntialias(d->hints & text_antialiasing ? true : false);
-    splashOutputDev.setVectorAntialias(d->hints & antialiasing ? true : false);
-    splashOutputDev.setFreeTypeHinting(d->hints & text_hinting ? true : false, false);
-    splashOutputDev.startDoc(pdfdoc);
-    pdfdoc->displayPageSlice(&splashOutputDev, pp->index + 1, xres, yres, int(rotate) * 90, false, true, false, x, y, w, h, nullptr, nullptr, nullptr, nullptr, true);
-
-    SplashBitmap *bitmap = splashOutputDev.getBitmap();
+    pdfdoc->displayPageSlice(splashOutputDev, pp->index + 1, xres, yres, int(rotate) * 90, false, true, false, x, y, w, h, nullptr, nullptr, nullptr, nullptr, true);
+
+    SplashBitmap *bitmap = splashOutputDev->getBitmap();
     const int bw = bitmap->getWidth();
     const int bh = bitmap->getHeight();
 
@@ -298,6 +362,269 @@ image page_renderer::render_page(const page *p, double xres, double yres, int x,
 #endif
 }
 
+/**
+ \typedef poppler::page_renderer::strip_func
+
+ Function type receiving the strips rendered by render_page_strips():
+ the first parameter is the image of the strip, which is only valid during
+ the call, the second is the row of the whole rendered area where the strip
+ starts, and the third is the unaltered closure argument passed to
+ render_page_strips(). Returning false stops the rendering.
+
+ \since 21.03
+ */
+
+#if defined(HAVE_SPLASH)
+namespace {
+
+struct strip_data
+{
+    SplashOutputDev *output_dev;
+    image::format_enum format;
+    page_renderer::strip_func func;
+    void *closure;
+};
+
+bool render_strip(int strip_y, int strip_h, void *data)
+{
+    strip_data *sd = static_cast<strip_data *>(data);
+    SplashBitmap *bitmap = sd->output_dev->getBitmap();
+    const image strip(reinterpret_cast<char *>(bitmap->getDataPtr()), bitmap->getWidth(), bitmap->getHeight(), sd->format);
+    return sd->func(strip, strip_y, sd->closure);
+}
+
+}
+#endif
+
+/**
+ Render the specified page in horizontal strips.
+
+ This functions renders the specified page like render_page(), but a strip of
+ at most \p strip_height rows at a time, passing each one to \p func as soon
+ as it is rendered. This way the memory needed is bounded by the size of a
+ strip rather than the size of the whole image, at the cost of processing
+ the page once per strip.
+
+ \param p the page to render
+ \param strip_height the maximum height in pixels of a strip
+ \param func the function receiving the rendered strips
+ \param closure user data which will be passed as-is to \p func
+ \param xres the X resolution, in dot per inch (DPI)
+ \param yres the Y resolution, in dot per inch (DPI)
+ \param x the X top-right coordinate, in pixels
+ \param y the Y top-right coordinate, in pixels
+ \param w the width in pixels of the area to render
+ \param h the height in pixels of the area to render
+ \param rotate the rotation to apply when rendering the page
+
+ \returns whether the whole area was rendered, false in case of errors or if
+           \p func stopped the rendering
+
+ \see render_page, can_render
+
+ \since 21.03
+ */
+bool page_renderer::render_page_strips(const page *p, int strip_height, strip_func func, void *closure, double xres, double yres, int x, int y, int w, int h, rotation_enum rotate) const
+{
+    if (!p || !func) {
+        return false;
+    }
+
+#if defined(HAVE_SPLASH)
+    page_private *pp = page_private::get(p);
+    PDFDoc *pdfdoc = pp->doc->doc;
+
+    SplashOutputDev *splashOutputDev = d->get_output_dev(pp->doc);
+    if (!splashOutputDev) {
+        return false;
+    }
+
+    strip_data sd = { splashOutputDev, d->image_format, func, closure };
+    return pdfdoc->displayPageStrips(splashOutputDev, pp->index + 1, xres, yres, int(rotate) * 90, false, true, false, x, y, w, h, strip_height, render_strip, &sd);
+#else
+    return false;
+#endif
+}
+
+/**
+ \typedef poppler::page_renderer::frame_func
+
+ Function type receiving the first frame rendered by
+ render_page_progressive(): the first parameter is the image of the page
+ without its large images and shadings, which is only valid during the call,
+ and the second is the unaltered closure argument passed to
+ render_page_progressive(). Returning false stops the rendering.
+
+ \since 21.03
+ */
+
+/**
+ \typedef poppler::page_renderer::abort_func
+
+ Function type checked regularly during render_page_progressive(), including
+ while decoding an image or filling a shading: the parameter is the
+ unaltered closure argument passed to render_page_progressive(). Returning
+ true stops the rendering.
+
+ \since 21.03
+ */
+
+#if defined(HAVE_SPLASH)
+namespace {
+
+struct progressive_data
+{
+    page_renderer::abort_func should_abort;
+    void *closure;
+};
+
+bool progressive_abort_check(void *data)
+{
+    progressive_data *pd = static_cast<progressive_data *>(data);
+    return pd->should_abort && pd->should_abort(pd->closure);
+}
+
+}
+#endif
+
+/**
+ Render the specified page progressively.
+
+ This functions renders the specified page like render_page(), but in two
+ passes when it has large images or shadings: the first one draws them as
+ flat placeholders, without decoding them, and passes the resulting frame to
+ \p func, so that it can be shown early; the second one renders the page
+ completely. When there is nothing to defer, the page is rendered once and
+ \p func is not called.
+
+ \param p the page to render
+ \param func the function receiving the first frame, or nullptr
+ \param should_abort the function checked to stop the rendering, or nullptr
+ \param closure user data which will be passed as-is to \p func and
+                \p should_abort
+ \param xres the X resolution, in dot per inch (DPI)
+ \param yres the Y resolution, in dot per inch (DPI)
+ \param x the X top-right coordinate, in pixels
+ \param y the Y top-right coordinate, in pixels
+ \param w the width in pixels of the area to render
+ \param h the height in pixels of the area to render
+ \param rotate the rotation to apply when rendering the page
+
+ \returns the completely rendered image, or a null one in case of errors or
+           if the rendering was stopped
+
+ \see render_page, can_render
+
+ \since 21.03
+ */
+image page_renderer::render_page_progressive(const page *p, frame_func func, abort_func should_abort, void *closure, double xres, double yres, int x, int y, int w, int h, rotation_enum rotate) const
+{
+    if (!p) {
+        return image();
+    }
+
+#if defined(HAVE_SPLASH)
+    page_private *pp = page_private::get(p);
+    PDFDoc *pdfdoc = pp->doc->doc;
+
+    SplashOutputDev *splashOutputDev = d->get_output_dev(pp->doc);
+    if (!splashOutputDev) {
+        return image();
+    }
+
+    progressive_data pd = { should_abort, closure };
+    splashOutputDev->setPlaceholderMode(true);
+    pdfdoc->displayPageSlice(splashOutputDev, pp->index + 1, xres, yres, int(rotate) * 90, false, true, false, x, y, w, h, progressive_abort_check, &pd, nullptr, nullptr, true);
+    splashOutputDev->setPlaceholderMode(false);
+    if (progressive_abort_check(&pd)) {
+        return image();
+    }
+
+    if (splashOutputDev->hasPlaceholders()) {
+        if (func) {
+            SplashBitmap *bitmap = splashOutputDev->getBitmap();
+            const image frame(reinterpret_cast<char *>(bitmap->getDataPtr()), bitmap->getWidth(), bitmap->getHeight(), d->image_format);
+            if (!func(frame, closure)) {
+                return image();
+            }
+        }
+        pdfdoc->displayPageSlice(splashOutputDev, pp->index + 1, xres, yres, int(rotate) * 90, false, true, false, x, y, w, h, progressive_abort_check, &pd, nullptr, nullptr, true);
+        if (progressive_abort_check(&pd)) {
+            return image();
+        }
+    }
+
+    SplashBitmap *bitmap = splashOutputDev->getBitmap();
+    const image img(reinterpret_cast<char *>(bitmap->getDataPtr()), bitmap->getWidth(), bitmap->getHeight(), d->image_format);
+    return img.copy();
+#else
+    return image();
+#endif
+}
+
+/**
+ Render a thumbnail of the specified page.
+
+ This function renders the specified page like render_page(), at the
+ resolution which makes the larger side of its crop box \p size pixels long,
+ but favouring speed over quality: if the page has an embedded thumbnail at
+ least that large, it is scaled down instead of rendering the page; otherwise
+ the page is rendered without vector anti-aliasing nor image interpolation,
+ and its JPEG images are decoded at a reduced resolution when they are drawn
+ much smaller than their size.
+
+ \param p the page to render
+ \param size the size in pixels of the larger side of the thumbnail
+ \param rotate the rotation to apply when rendering the page
+
+ \returns the rendered thumbnail, or a null one in case of errors
+
+ \see render_page
+
+ \since 21.03
+ */
+image page_renderer::render_thumbnail(const page *p, int size, rotation_enum rotate) const
+{
+    if (!p || size <= 0) {
+        return image();
+    }
+
+#if defined(HAVE_SPLASH)
+    page_private *pp = page_private::get(p);
+    PDFDoc *pdfdoc = pp->doc->doc;
+    const int pageNum = pp->index + 1;
+
+    SplashOutputDev *splashOutputDev = d->get_output_dev(pp->doc);
+    if (!splashOutputDev) {
+        return image();
+    }
+
+    const double pageSize = std::max(pdfdoc->getPageCropWidth(pageNum), pdfdoc->getPageCropHeight(pageNum));
+    if (pageSize <= 0) {
+        return image();
+    }
+    const double res = 72.0 * size / pageSize;
+
+    if (!pdfdoc->displayPageThumb(splashOutputDev, pageNum, res, res, int(rotate) * 90, false)) {
+        // the output device is kept for the next renderings
+        const bool vectorAntialias = splashOutputDev->getVectorAntialias();
+        splashOutputDev->setVectorAntialias(false);
+        splashOutputDev->setImageInterpolation(false);
+        splashOutputDev->setReducedImageDecoding(true);
+        pdfdoc->displayPageSlice(splashOutputDev, pageNum, res, res, int(rotate) * 90, false, true, false, -1, -1, -1, -1, nullptr, nullptr, nullptr, nullptr, true);
+        splashOutputDev->setVectorAntialias(vectorAntialias);
+        splashOutputDev->setImageInterpolation(true);
+        splashOutputDev->setReducedImageDecoding(false);
+    }
+
+    SplashBitmap *bitmap = splashOutputDev->getBitmap();
+    const image img(reinterpret_cast<char *>(bitmap->getDataPtr()), bitmap->getWidth(), bitmap->getHeight(), d->image_format);
+    return img.copy();
+#else
+    return image();
+#endif
+}
+
 /**
  Rendering capability test.
 
@@ -65,6 +65,17 @@ public:
 
     image render_page(const page *p, double xres = 72.0, double yres = 72.0, int x = -1, int y = -1, int w = -1, int h = -1, rotation_enum rotate = rotate_0) const;
 
+    typedef bool (*strip_func)(const image &strip, int y, void *closure);
+    bool render_page_strips(const page *p, int strip_height, strip_func func, void *closure, double xres = 72.0, double yres = 72.0, int x = -1, int y = -1, int w = -1, int h = -1, rotation_enum rotate = rotate_0) const;
+
+    typedef bool (*frame_func)(const image &frame, void *closure);
+    typedef bool (*abort_func)(void *closure);
+    image render_page_progressive(const page *p, frame_func func, abort_func should_abort, void *closure, double xres = 72.0, double yres = 72.0, int x = -1, int y = -1, int w = -1, int h = -1, rotation_enum rotate = rotate_0) const;
+
+    image render_thumbnail(const page *p, int size, rotation_enum rotate = rotate_0) const;
+
+    void clear_cache();
+
     static bool can_render();
 
 private:
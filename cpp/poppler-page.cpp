@@ -230,9 +230,8 @@ bool page::search(const ustring &text, rectf &r, search_direction_enum direction
     double rect_right = r.right();
     double rect_bottom = r.bottom();
 
-    TextOutputDev td(nullptr, true, 0, false, false);
-    d->doc->doc->displayPage(&td, d->index + 1, 72, 72, rotation_value, false, true, false);
-    TextPage *text_page = td.takeText();
+    const TextPageCache::Key key = { d->index + 1, rotation_value, false, true };
+    TextPage *text_page = d->doc->text_page_cache.acquire(d->doc->doc, key);
 
     switch (direction) {
     case search_from_top:
@@ -246,7 +245,7 @@ bool page::search(const ustring &text, rectf &r, search_direction_enum direction
         break;
     }
 
-    text_page->decRefCnt();
+    d->doc->text_page_cache.release(key, text_page);
     r.set_left(rect_left);
     r.set_top(rect_top);
     r.set_right(rect_right);
@@ -255,6 +254,45 @@ bool page::search(const ustring &text, rectf &r, search_direction_enum direction
     return found;
 }
 
+/**
+ Search the page for several texts at once.
+
+ All the \p texts are looked for in a single pass over the text of the page,
+ which is much faster than calling search() repeatedly for each of them.
+
+ \param texts the texts to search
+ \param case_sensitivity whether search in a case sensitive way
+ \param rotation the rotation assumed for the page
+
+ \returns for each of the \p texts, the areas of all its occurrences,
+          from the top to the bottom of the page
+
+ \since 21.03
+ */
+std::vector<std::vector<rectf>> page::search_all(const std::vector<ustring> &texts, case_sensitivity_enum case_sensitivity, rotation_enum rotation) const
+{
+    std::vector<std::vector<rectf>> results(texts.size());
+
+    std::vector<std::vector<Unicode>> terms(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        terms[i].assign(texts[i].begin(), texts[i].end());
+    }
+
+    const bool sCase = case_sensitivity == case_sensitive;
+    const int rotation_value = (int)rotation * 90;
+
+    const TextPageCache::Key key = { d->index + 1, rotation_value, false, true };
+    TextPage *text_page = d->doc->text_page_cache.acquire(d->doc->doc, key);
+
+    for (const TextSearchHit &hit : text_page->findAllText(terms, sCase, false, false)) {
+        results[hit.term].push_back(rectf(hit.xMin, hit.yMin, hit.xMax - hit.xMin, hit.yMax - hit.yMin));
+    }
+
+    d->doc->text_page_cache.release(key, text_page);
+
+    return results;
+}
+
 /**
  Returns the text in the page, in its physical layout.
 
@@ -289,10 +327,13 @@ ustring page::text(const rectf &r, text_layout_enum layout_mode) const
     std::unique_ptr<GooString> out(new GooString());
     const bool use_raw_order = (layout_mode == raw_order_layout);
     const bool use_physical_layout = (layout_mode == physical_layout);
-    TextOutputDev td(&appendToGooString, out.get(), use_physical_layout, 0, use_raw_order, false);
     if (r.is_empty()) {
-        d->doc->doc->displayPage(&td, d->index + 1, 72, 72, 0, false, true, false);
+        const TextPageCache::Key key = { d->index + 1, 0, use_raw_order, true };
+        TextPage *text_page = d->doc->text_page_cache.acquire(d->doc->doc, key);
+        text_page->dump(out.get(), &appendToGooString, use_physical_layout, TextOutputDev::defaultEndOfLine(), true);
+        d->doc->text_page_cache.release(key, text_page);
     } else {
+        TextOutputDev td(&appendToGooString, out.get(), use_physical_layout, 0, use_raw_order, false);
         d->doc->doc->displayPageSlice(&td, d->index + 1, 72, 72, 0, false, true, false, r.left(), r.top(), r.width(), r.height());
     }
     return ustring::from_utf8(out->c_str());
@@ -379,28 +420,18 @@ std::vector<text_box> page::text_list(int opt_flag) const
 {
     std::vector<text_box> output_list;
 
-    /* config values are same with Qt5 Page::TextList() */
-    auto output_dev = std::make_unique<TextOutputDev>(nullptr, /* char* fileName */
-                                                      false, /* bool physLayoutA */
-                                                      0, /* double fixedPitchA */
-                                                      false, /* bool rawOrderA */
-                                                      false /* bool append */
-    );
-
     /*
      * config values are same with Qt5 Page::TextList(),
      * but rotation is fixed to zero.
      * Few people use non-zero values.
      */
-    d->doc->doc->displayPageSlice(output_dev.get(), d->index + 1, /* page */
-                                  72, 72, 0, /* hDPI, vDPI, rot */
-                                  false, false, false, /* useMediaBox, crop, printing */
-                                  -1, -1, -1, -1, /* sliceX, sliceY, sliceW, sliceH */
-                                  nullptr, nullptr, /* abortCheckCbk(), abortCheckCbkData */
-                                  nullptr, nullptr, /* annotDisplayDecideCbk(), annotDisplayDecideCbkData */
-                                  true); /* copyXRef */
+    const TextPageCache::Key key = { d->index + 1, /* page */
+                                     0, /* rotate */
+                                     false, /* rawOrder */
+                                     false }; /* crop */
+    TextPage *text_page = d->doc->text_page_cache.acquire(d->doc->doc, key);
 
-    if (std::unique_ptr<TextWordList> word_list { output_dev->makeWordList() }) {
+    if (std::unique_ptr<TextWordList> word_list { text_page->makeWordList(false) }) {
 
         output_list.reserve(word_list->getLength());
         for (int i = 0; i < word_list->getLength(); i++) {
@@ -466,6 +497,8 @@ std::vector<text_box> page::text_list(int opt_flag) const
         }
     }
 
+    d->doc->text_page_cache.release(key, text_page);
+
     return output_list;
 }
 
@@ -172,6 +172,7 @@ public:
     page_transition *transition() const;
 
     bool search(const ustring &text, rectf &r, search_direction_enum direction, case_sensitivity_enum case_sensitivity, rotation_enum rotation = rotate_0) const;
+    std::vector<std::vector<rectf>> search_all(const std::vector<ustring> &texts, case_sensitivity_enum case_sensitivity, rotation_enum rotation = rotate_0) const;
     ustring text(const rectf &rect = rectf()) const;
     ustring text(const rectf &rect, text_layout_enum layout_mode) const;
 
@@ -0,0 +1,163 @@
+// Checks that page_renderer::render_page_progressive() returns the image
+// render_page() does, and passes a first frame to its callback only for the
+// pages with large images or shadings drawn as placeholders.
+
+#include <poppler-document.h>
+#include <poppler-image.h>
+#include <poppler-page.h>
+#include <poppler-page-renderer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::string streamObject(const std::string &entries, const std::string &data)
+{
+    return "<< " + entries + " /Length " + std::to_string(data.size()) + " >>\nstream\n" + data + "\nendstream";
+}
+
+// Return a document whose first page has a large image and a shading,
+// whose second page has text and a small image, and whose third page has
+// a large image in a form.
+static std::string makePdf()
+{
+    std::string large, small;
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 300; ++x) {
+            large.push_back((char)(x ^ y));
+        }
+    }
+    for (int i = 0; i < 16 * 16; ++i) {
+        small.push_back((char)(i * 16));
+    }
+    const std::string resources = "/Resources << /Font << /F1 4 0 R >> /XObject << /Im1 8 0 R /Im2 9 0 R /Fm1 10 0 R >> /Shading << /Sh0 << /ShadingType 2 /ColorSpace /DeviceRGB /Coords [100 0 500 0] /Function << /FunctionType 2 /Domain [0 1] /C0 [1 0 0] /C1 [0 0 1] /N 1 >> >> >> >>";
+    const std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R 5 0 R 6 0 R] /Count 3 >>",
+                                               "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] " + resources + " /Contents 7 0 R >>", "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+                                               "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] " + resources + " /Contents 11 0 R >>",
+                                               "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 300 400] " + resources + " /Contents 12 0 R >>",
+                                               streamObject("", "BT /F1 24 Tf 72 720 Td (Progressive) Tj ET q 300 0 0 300 72 350 cm /Im1 Do Q q 100 100 400 150 re W n /Sh0 sh Q 0 0.5 0 rg 72 50 400 30 re f"),
+                                               streamObject("/Type /XObject /Subtype /Image /Width 300 /Height 300 /ColorSpace /DeviceGray /BitsPerComponent 8", large),
+                                               streamObject("/Type /XObject /Subtype /Image /Width 16 /Height 16 /ColorSpace /DeviceGray /BitsPerComponent 8", small),
+                                               streamObject("/Type /XObject /Subtype /Form /BBox [0 0 300 400]", "q 200 0 0 200 50 150 cm /Im1 Do Q"),
+                                               streamObject("", "BT /F1 24 Tf 72 720 Td (Text only) Tj ET q 64 0 0 64 72 500 cm /Im2 Do Q"),
+                                               streamObject("", "BT /F1 12 Tf 20 370 Td (Form) Tj ET /Fm1 Do") };
+    std::string pdf = "%PDF-1.4\n";
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        offsets.push_back(pdf.size());
+        pdf += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const size_t xref = pdf.size();
+    pdf += "xref\n0 " + std::to_string(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (size_t offset : offsets) {
+        char line[21];
+        snprintf(line, sizeof(line), "%010zu 00000 n \n", offset);
+        pdf += line;
+    }
+    pdf += "trailer\n<< /Size " + std::to_string(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+    return pdf;
+}
+
+static bool sameImage(const poppler::image &a, const poppler::image &b)
+{
+    if (!a.is_valid() || !b.is_valid() || a.format() != b.format() || a.width() != b.width() || a.height() != b.height() || a.bytes_per_row() != b.bytes_per_row()) {
+        return false;
+    }
+    return memcmp(a.const_data(), b.const_data(), a.bytes_per_row() * a.height()) == 0;
+}
+
+struct Progress
+{
+    int frames;
+    poppler::image firstFrame;
+    bool keepGoing;
+};
+
+static bool onFrame(const poppler::image &frame, void *closure)
+{
+    Progress *progress = static_cast<Progress *>(closure);
+    ++progress->frames;
+    progress->firstFrame = frame.copy();
+    return progress->keepGoing;
+}
+
+static bool abortNow(void *)
+{
+    return true;
+}
+
+int main()
+{
+    const std::string pdf = makePdf();
+    std::unique_ptr<poppler::document> doc(poppler::document::load_from_raw_data(pdf.data(), pdf.size()));
+    if (!doc || doc->pages() != 3) {
+        fprintf(stderr, "can't load the document\n");
+        return EXIT_FAILURE;
+    }
+
+    // whether the page has something drawn as a placeholder
+    const bool deferred[3] = { true, false, true };
+
+    int failures = 0;
+    for (poppler::image::format_enum format : { poppler::image::format_argb32, poppler::image::format_rgb24 }) {
+        poppler::page_renderer renderer;
+        renderer.set_render_hints(poppler::page_renderer::antialiasing | poppler::page_renderer::text_antialiasing);
+        renderer.set_image_format(format);
+        for (int i = 0; i < 3; ++i) {
+            std::unique_ptr<poppler::page> p(doc->create_page(i));
+            if (!p) {
+                fprintf(stderr, "can't load page %d\n", i + 1);
+                return EXIT_FAILURE;
+            }
+
+            // what a new renderer draws
+            poppler::page_renderer refRenderer;
+            refRenderer.set_render_hints(renderer.render_hints());
+            refRenderer.set_image_format(format);
+            const poppler::image ref = refRenderer.render_page(p.get());
+
+            // twice, to render with the device of the previous page
+            for (int pass = 0; pass < 2; ++pass) {
+                Progress progress = { 0, poppler::image(), true };
+                const poppler::image img = renderer.render_page_progressive(p.get(), onFrame, nullptr, &progress);
+                if (!sameImage(img, ref)) {
+                    fprintf(stderr, "page %d: the progressive rendering differs from render_page()\n", i + 1);
+                    ++failures;
+                }
+                if (progress.frames != (deferred[i] ? 1 : 0)) {
+                    fprintf(stderr, "page %d: %d first frames\n", i + 1, progress.frames);
+                    ++failures;
+                }
+                if (progress.frames == 1 && (progress.firstFrame.width() != ref.width() || progress.firstFrame.height() != ref.height() || sameImage(progress.firstFrame, ref))) {
+                    fprintf(stderr, "page %d: the first frame isn't a draft of the page\n", i + 1);
+                    ++failures;
+                }
+            }
+
+            // the renderer is back to normal rendering
+            if (!sameImage(renderer.render_page(p.get()), ref)) {
+                fprintf(stderr, "page %d: render_page() after a progressive rendering differs\n", i + 1);
+                ++failures;
+            }
+
+            // stopping the rendering
+            if (deferred[i]) {
+                Progress progress = { 0, poppler::image(), false };
+                if (renderer.render_page_progressive(p.get(), onFrame, nullptr, &progress).is_valid() || progress.frames != 1) {
+                    fprintf(stderr, "page %d: the rendering wasn't stopped by the frame callback\n", i + 1);
+                    ++failures;
+                }
+            }
+            Progress progress = { 0, poppler::image(), true };
+            if (renderer.render_page_progressive(p.get(), onFrame, abortNow, &progress).is_valid() || progress.frames != 0) {
+                fprintf(stderr, "page %d: the rendering wasn't aborted\n", i + 1);
+                ++failures;
+            }
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
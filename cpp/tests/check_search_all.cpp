@@ -0,0 +1,104 @@
+// Checks that page::search_all() finds, for each of its texts, the same
+// occurrences as page::search() called for that text alone.
+
+#include <poppler-document.h>
+#include <poppler-page.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::string makePdf()
+{
+    const std::string content = "BT /F1 12 Tf 72 720 Td (The quick brown fox jumps over the lazy dog.) Tj 0 -20 Td (The dog sleeps, the fox does not.) Tj ET";
+    const std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                                               "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 4 0 R >> >> /Contents 5 0 R >>",
+                                               "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>", "<< /Length " + std::to_string(content.size()) + " >>\nstream\n" + content + "\nendstream" };
+    std::string pdf = "%PDF-1.4\n";
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        offsets.push_back(pdf.size());
+        pdf += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const size_t xref = pdf.size();
+    pdf += "xref\n0 " + std::to_string(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (size_t offset : offsets) {
+        char line[21];
+        snprintf(line, sizeof(line), "%010zu 00000 n \n", offset);
+        pdf += line;
+    }
+    pdf += "trailer\n<< /Size " + std::to_string(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+    return pdf;
+}
+
+static std::vector<poppler::rectf> searchEach(const poppler::page *p, const std::string &text, poppler::case_sensitivity_enum cs)
+{
+    std::vector<poppler::rectf> found;
+    poppler::rectf r;
+    const poppler::ustring u = poppler::ustring::from_utf8(text.c_str());
+    if (p->search(u, r, poppler::page::search_from_top, cs)) {
+        do {
+            found.push_back(r);
+        } while (p->search(u, r, poppler::page::search_next_result, cs));
+    }
+    return found;
+}
+
+static bool sameRects(const std::vector<poppler::rectf> &a, const std::vector<poppler::rectf> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].left() != b[i].left() || a[i].top() != b[i].top() || a[i].right() != b[i].right() || a[i].bottom() != b[i].bottom()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    const std::string pdf = makePdf();
+    std::unique_ptr<poppler::document> doc(poppler::document::load_from_raw_data(pdf.data(), pdf.size()));
+    if (!doc) {
+        fprintf(stderr, "can't load the document\n");
+        return EXIT_FAILURE;
+    }
+    std::unique_ptr<poppler::page> p(doc->create_page(0));
+    if (!p) {
+        fprintf(stderr, "can't load the page\n");
+        return EXIT_FAILURE;
+    }
+
+    // the counts are the case insensitive ones
+    const std::vector<std::string> texts = { "the", "dog", "fox jumps", "xyzzy", "The" };
+    const std::vector<size_t> counts = { 4, 2, 1, 0, 4 };
+    std::vector<poppler::ustring> utexts;
+    for (const std::string &text : texts) {
+        utexts.push_back(poppler::ustring::from_utf8(text.c_str()));
+    }
+
+    int failures = 0;
+    for (poppler::case_sensitivity_enum cs : { poppler::case_sensitive, poppler::case_insensitive }) {
+        const std::vector<std::vector<poppler::rectf>> results = p->search_all(utexts, cs);
+        if (results.size() != texts.size()) {
+            fprintf(stderr, "search_all returned %zu lists for %zu texts\n", results.size(), texts.size());
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < texts.size(); ++i) {
+            if (!sameRects(results[i], searchEach(p.get(), texts[i], cs))) {
+                fprintf(stderr, "\"%s\" (%s): search_all differs from search\n", texts[i].c_str(), cs == poppler::case_sensitive ? "case sensitive" : "case insensitive");
+                ++failures;
+            }
+            if (cs == poppler::case_insensitive && results[i].size() != counts[i]) {
+                fprintf(stderr, "\"%s\": %zu occurrences found, %zu expected\n", texts[i].c_str(), results[i].size(), counts[i]);
+                ++failures;
+            }
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
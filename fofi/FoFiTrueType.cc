@@ -708,7 +708,7 @@ void FoFiTrueType::getFontMatrix(double *mat) const
     delete ff;
 }
 
-void FoFiTrueType::convertToType42(const char *psName, char **encoding, int *codeToGID, FoFiOutputFunc outputFunc, void *outputStream) const
+void FoFiTrueType::convertToType42(const char *psName, char **encoding, int *codeToGID, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs) const
 {
     GooString *buf;
     int maxUsedGlyph;
@@ -739,7 +739,7 @@ void FoFiTrueType::convertToType42(const char *psName, char **encoding, int *cod
     // write the guts of the dictionary
     cvtEncoding(encoding, outputFunc, outputStream);
     cvtCharStrings(encoding, codeToGID, outputFunc, outputStream);
-    cvtSfnts(outputFunc, outputStream, nullptr, false, &maxUsedGlyph);
+    cvtSfnts(outputFunc, outputStream, nullptr, false, &maxUsedGlyph, usedGlyphs);
 
     // end the dictionary and define the font
     (*outputFunc)(outputStream, "FontName currentdict end definefont pop\n", 40);
@@ -761,7 +761,7 @@ void FoFiTrueType::convertToType1(const char *psName, const char **newEncoding,
     delete ff;
 }
 
-void FoFiTrueType::convertToCIDType2(const char *psName, const int *cidMap, int nCIDs, bool needVerticalMetrics, FoFiOutputFunc outputFunc, void *outputStream) const
+void FoFiTrueType::convertToCIDType2(const char *psName, const int *cidMap, int nCIDs, bool needVerticalMetrics, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs) const
 {
     GooString *buf;
     int cid, maxUsedGlyph;
@@ -874,13 +874,13 @@ void FoFiTrueType::convertToCIDType2(const char *psName, const int *cidMap, int
     (*outputFunc)(outputStream, "  end readonly def\n", 19);
 
     // write the guts of the dictionary
-    cvtSfnts(outputFunc, outputStream, nullptr, needVerticalMetrics, &maxUsedGlyph);
+    cvtSfnts(outputFunc, outputStream, nullptr, needVerticalMetrics, &maxUsedGlyph, usedGlyphs);
 
     // end the dictionary and define the font
     (*outputFunc)(outputStream, "CIDFontName currentdict end /CIDFont defineresource pop\n", 56);
 }
 
-void FoFiTrueType::convertToCIDType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream) const
+void FoFiTrueType::convertToCIDType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs) const
 {
     char *start;
     int length;
@@ -892,11 +892,11 @@ void FoFiTrueType::convertToCIDType0(const char *psName, int *cidMap, int nCIDs,
     if (!(ff = FoFiType1C::make(start, length))) {
         return;
     }
-    ff->convertToCIDType0(psName, cidMap, nCIDs, outputFunc, outputStream);
+    ff->convertToCIDType0(psName, cidMap, nCIDs, outputFunc, outputStream, usedCIDs);
     delete ff;
 }
 
-void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, bool needVerticalMetrics, int *maxValidGlyph, FoFiOutputFunc outputFunc, void *outputStream) const
+void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, bool needVerticalMetrics, int *maxValidGlyph, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs) const
 {
     GooString *buf;
     GooString *sfntsName;
@@ -910,7 +910,7 @@ void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, bo
 
     // write the Type 42 sfnts array
     sfntsName = (new GooString(psName))->append("_sfnts");
-    cvtSfnts(outputFunc, outputStream, sfntsName, needVerticalMetrics, &maxUsedGlyph);
+    cvtSfnts(outputFunc, outputStream, sfntsName, needVerticalMetrics, &maxUsedGlyph, usedGlyphs);
     delete sfntsName;
 
     // write the descendant Type 42 fonts
@@ -1004,7 +1004,7 @@ void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, bo
     (*outputFunc)(outputStream, "FontName currentdict end definefont pop\n", 40);
 }
 
-void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream) const
+void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs) const
 {
     char *start;
     int length;
@@ -1016,7 +1016,7 @@ void FoFiTrueType::convertToType0(const char *psName, int *cidMap, int nCIDs, Fo
     if (!(ff = FoFiType1C::make(start, length))) {
         return;
     }
-    ff->convertToType0(psName, cidMap, nCIDs, outputFunc, outputStream);
+    ff->convertToType0(psName, cidMap, nCIDs, outputFunc, outputStream, usedCIDs);
     delete ff;
 }
 
@@ -1098,7 +1098,7 @@ err:
     (*outputFunc)(outputStream, "end readonly def\n", 17);
 }
 
-void FoFiTrueType::cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const GooString *name, bool needVerticalMetrics, int *maxUsedGlyph) const
+void FoFiTrueType::cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const GooString *name, bool needVerticalMetrics, int *maxUsedGlyph, const std::vector<bool> *usedGlyphs) const
 {
     unsigned char headData[54];
     TrueTypeLoca *locaTable;
@@ -1183,6 +1183,28 @@ void FoFiTrueType::cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const
     }
     locaTable[nGlyphs].len = 0;
     std::sort(locaTable, locaTable + nGlyphs + 1, cmpTrueTypeLocaIdxFunctor());
+
+    // subset the font: empty out the glyphs that aren't needed, keeping
+    // the glyph numbering so that the callers' GID maps stay valid
+    if (usedGlyphs) {
+        std::vector<bool> keep(nGlyphs, false);
+        for (i = 0; i < nGlyphs && i < (int)usedGlyphs->size(); ++i) {
+            keep[i] = (*usedGlyphs)[i];
+        }
+        if (nGlyphs > 0) {
+            keep[0] = true; // .notdef
+        }
+        addCompositeGlyphComponents(&keep, locaTable, tables[seekTable("glyf")].offset);
+        for (i = 0; i < nGlyphs; ++i) {
+            if (keep[i]) {
+                // used glyphs must stay addressable even if they are empty
+                *maxUsedGlyph = i;
+            } else {
+                locaTable[i].len = 0;
+            }
+        }
+    }
+
     pos = 0;
     for (i = 0; i <= nGlyphs; ++i) {
         locaTable[i].newOffset = pos;
@@ -1190,7 +1212,7 @@ void FoFiTrueType::cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const
         if (pos & 3) {
             pos += 4 - (pos & 3);
         }
-        if (locaTable[i].len > 0) {
+        if (locaTable[i].len > 0 && i > *maxUsedGlyph) {
             *maxUsedGlyph = i;
         }
     }
@@ -1412,6 +1434,59 @@ void FoFiTrueType::cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const
     }
 }
 
+// Add the components of the composite glyphs flagged in <glyphs> to
+// it, recursively.
+void FoFiTrueType::addCompositeGlyphComponents(std::vector<bool> *glyphs, const TrueTypeLoca *locaTable, int glyfPos) const
+{
+    std::vector<int> todo;
+    int flags, gid, pos, end;
+    bool ok;
+
+    for (int i = 0; i < (int)glyphs->size(); ++i) {
+        if ((*glyphs)[i]) {
+            todo.push_back(i);
+        }
+    }
+    while (!todo.empty()) {
+        const int i = todo.back();
+        todo.pop_back();
+        if (locaTable[i].len < 10) {
+            continue;
+        }
+        pos = glyfPos + locaTable[i].origOffset;
+        end = pos + locaTable[i].len;
+        ok = true;
+        if (getS16BE(pos, &ok) >= 0 || !ok) {
+            // simple glyph (numberOfContours >= 0)
+            continue;
+        }
+        pos += 10;
+        do {
+            if (pos + 4 > end) {
+                break;
+            }
+            flags = getU16BE(pos, &ok);
+            gid = getU16BE(pos + 2, &ok);
+            if (!ok) {
+                break;
+            }
+            if (gid < (int)glyphs->size() && !(*glyphs)[gid]) {
+                (*glyphs)[gid] = true;
+                todo.push_back(gid);
+            }
+            pos += 4;
+            pos += (flags & 0x0001) ? 4 : 2; // ARG_1_AND_2_ARE_WORDS
+            if (flags & 0x0008) { // WE_HAVE_A_SCALE
+                pos += 2;
+            } else if (flags & 0x0040) { // WE_HAVE_AN_X_AND_Y_SCALE
+                pos += 4;
+            } else if (flags & 0x0080) { // WE_HAVE_A_TWO_BY_TWO
+                pos += 8;
+            }
+        } while (flags & 0x0020); // MORE_COMPONENTS
+    }
+}
+
 void FoFiTrueType::dumpString(const unsigned char *s, int length, FoFiOutputFunc outputFunc, void *outputStream) const
 {
     GooString *buf;
@@ -31,6 +31,7 @@
 #include <cstddef>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "FoFiBase.h"
 
 class GooString;
@@ -105,8 +106,10 @@ public:
     // <encoding> array specifies the mapping from char codes to names.
     // If <encoding> is NULL, the encoding is unknown or undefined.  The
     // <codeToGID> array specifies the mapping from char codes to GIDs.
-    // (Not useful for OpenType CFF fonts.)
-    void convertToType42(const char *psName, char **encoding, int *codeToGID, FoFiOutputFunc outputFunc, void *outputStream) const;
+    // If <usedGlyphs> is not NULL, only the glyphs it flags (plus .notdef
+    // and the components of composite glyphs) are written, the other
+    // ones are left empty.  (Not useful for OpenType CFF fonts.)
+    void convertToType42(const char *psName, char **encoding, int *codeToGID, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs = nullptr) const;
 
     // Convert to a Type 1 font, suitable for embedding in a PostScript
     // file.  This is only useful with 8-bit fonts.  If <newEncoding> is
@@ -121,25 +124,30 @@ public:
     // PostScript file.  <psName> will be used as the PostScript font
     // name (so we don't need to depend on the 'name' table in the
     // font).  The <cidMap> array maps CIDs to GIDs; it has <nCIDs>
-    // entries.  (Not useful for OpenType CFF fonts.)
-    void convertToCIDType2(const char *psName, const int *cidMap, int nCIDs, bool needVerticalMetrics, FoFiOutputFunc outputFunc, void *outputStream) const;
+    // entries.  <usedGlyphs> is as in convertToType42.  (Not useful for
+    // OpenType CFF fonts.)
+    void convertToCIDType2(const char *psName, const int *cidMap, int nCIDs, bool needVerticalMetrics, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs = nullptr) const;
 
     // Convert to a Type 0 CIDFont, suitable for embedding in a
     // PostScript file.  <psName> will be used as the PostScript font
-    // name.  (Only useful for OpenType CFF fonts.)
-    void convertToCIDType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream) const;
+    // name.  <usedCIDs> is as in FoFiType1C::convertToCIDType0.  (Only
+    // useful for OpenType CFF fonts.)
+    void convertToCIDType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs = nullptr) const;
 
     // Convert to a Type 0 (but non-CID) composite font, suitable for
     // embedding in a PostScript file.  <psName> will be used as the
     // PostScript font name (so we don't need to depend on the 'name'
     // table in the font).  The <cidMap> array maps CIDs to GIDs; it has
-    // <nCIDs> entries.  (Not useful for OpenType CFF fonts.)
-    void convertToType0(const char *psName, int *cidMap, int nCIDs, bool needVerticalMetrics, int *maxValidGlyph, FoFiOutputFunc outputFunc, void *outputStream) const;
+    // <nCIDs> entries.  <usedGlyphs> is as in convertToType42.  (Not
+    // useful for OpenType CFF fonts.)
+    void convertToType0(const char *psName, int *cidMap, int nCIDs, bool needVerticalMetrics, int *maxValidGlyph, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedGlyphs = nullptr) const;
 
     // Convert to a Type 0 (but non-CID) composite font, suitable for
     // embedding in a PostScript file.  <psName> will be used as the
-    // PostScript font name.  (Only useful for OpenType CFF fonts.)
-    void convertToType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream) const;
+    // PostScript font name.  <usedCIDs> is as in
+    // FoFiType1C::convertToCIDType0.  (Only useful for OpenType CFF
+    // fonts.)
+    void convertToType0(const char *psName, int *cidMap, int nCIDs, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs = nullptr) const;
 
     // Returns a pointer to the CFF font embedded in this OpenType font.
     // If successful, sets *<start> and *<length>, and returns true.
@@ -156,7 +164,8 @@ private:
     FoFiTrueType(const char *fileA, int lenA, bool freeFileDataA, int faceIndexA);
     void cvtEncoding(char **encoding, FoFiOutputFunc outputFunc, void *outputStream) const;
     void cvtCharStrings(char **encoding, const int *codeToGID, FoFiOutputFunc outputFunc, void *outputStream) const;
-    void cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const GooString *name, bool needVerticalMetrics, int *maxUsedGlyph) const;
+    void cvtSfnts(FoFiOutputFunc outputFunc, void *outputStream, const GooString *name, bool needVerticalMetrics, int *maxUsedGlyph, const std::vector<bool> *usedGlyphs) const;
+    void addCompositeGlyphComponents(std::vector<bool> *glyphs, const struct TrueTypeLoca *locaTable, int glyfPos) const;
     void dumpString(const unsigned char *s, int length, FoFiOutputFunc outputFunc, void *outputStream) const;
     unsigned int computeTableChecksum(const unsigned char *data, int length) const;
     void parse();
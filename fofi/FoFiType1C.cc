@@ -466,7 +466,26 @@ void FoFiType1C::convertToType1(const char *psName, const char **newEncoding, bo
     (*outputFunc)(outputStream, "cleartomark\n", 12);
 }
 
-void FoFiType1C::convertToCIDType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream)
+// Drop the glyphs of the CIDs not flagged in <usedCIDs> (except CID 0)
+// from <cidMap>, and trim *<nCIDs> to the last CID with a glyph.
+static void subsetCIDMap(int *cidMap, int *nCIDs, const std::vector<bool> *usedCIDs)
+{
+    int n = 0;
+
+    for (int i = 0; i < *nCIDs; ++i) {
+        if (i > 0 && (i >= (int)usedCIDs->size() || !(*usedCIDs)[i])) {
+            cidMap[i] = -1;
+        }
+        if (cidMap[i] >= 0) {
+            n = i + 1;
+        }
+    }
+    if (n > 0) {
+        *nCIDs = n;
+    }
+}
+
+void FoFiType1C::convertToCIDType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs)
 {
     int *cidMap;
     GooString *charStrings;
@@ -511,6 +530,9 @@ void FoFiType1C::convertToCIDType0(const char *psName, const int *codeMap, int n
             cidMap[i] = i;
         }
     }
+    if (usedCIDs) {
+        subsetCIDMap(cidMap, &nCIDs, usedCIDs);
+    }
 
     // build the charstrings
     charStrings = new GooString();
@@ -785,7 +807,7 @@ void FoFiType1C::convertToCIDType0(const char *psName, const int *codeMap, int n
     gfree(cidMap);
 }
 
-void FoFiType1C::convertToType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream)
+void FoFiType1C::convertToType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs)
 {
     int *cidMap;
     Type1CIndex subrIdx;
@@ -828,6 +850,9 @@ void FoFiType1C::convertToType0(const char *psName, const int *codeMap, int nCod
             cidMap[i] = i;
         }
     }
+    if (usedCIDs) {
+        subsetCIDMap(cidMap, &nCIDs, usedCIDs);
+    }
 
     if (privateDicts) {
         // write the descendant Type 1 fonts
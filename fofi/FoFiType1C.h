@@ -28,6 +28,7 @@
 #include "FoFiBase.h"
 
 #include <set>
+#include <vector>
 
 class GooString;
 
@@ -193,7 +194,9 @@ public:
     //     font's internal CID-to-GID mapping is used
     // (3) is <codeMap> is NULL and this is an 8-bit CFF font, then
     //     the identity CID-to-GID mapping is used
-    void convertToCIDType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream);
+    // If <usedCIDs> is not NULL, only the CIDs it flags (plus CID 0) are
+    // given glyphs, and the CID count is trimmed to the last one.
+    void convertToCIDType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs = nullptr);
 
     // Convert to a Type 0 (but non-CID) composite font, suitable for
     // embedding in a PostScript file.  <psName> will be used as the
@@ -204,7 +207,8 @@ public:
     //     font's internal CID-to-GID mapping is used
     // (3) is <codeMap> is NULL and this is an 8-bit CFF font, then
     //     the identity CID-to-GID mapping is used
-    void convertToType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream);
+    // <usedCIDs> is as in convertToCIDType0.
+    void convertToType0(const char *psName, const int *codeMap, int nCodes, FoFiOutputFunc outputFunc, void *outputStream, const std::vector<bool> *usedCIDs = nullptr);
 
 private:
     FoFiType1C(const char *fileA, int lenA, bool freeFileDataA);
@@ -871,6 +871,71 @@ GList *poppler_page_find_text(PopplerPage *page, const char *text)
     return poppler_page_find_text_with_options(page, text, POPPLER_FIND_DEFAULT);
 }
 
+/**
+ * poppler_page_find_texts_with_options:
+ * @page: a #PopplerPage
+ * @texts: (array zero-terminated=1): a %NULL-terminated array of texts to search for (UTF-8 encoded)
+ * @options: find options
+ * @n_texts: (out) (optional): return location for the number of texts
+ *
+ * Finds all the @texts in @page with the given #PopplerFindFlags options and
+ * returns, for each of them, a #GList of rectangles for each occurrence of that
+ * text on the page. All the texts are searched for in a single pass over the
+ * text of the page, which is much faster than calling
+ * poppler_page_find_text_with_options() for each of them. The coordinates are
+ * in PDF points.
+ *
+ * Free each list with g_list_free_full() and poppler_rectangle_free(), and the
+ * array with g_free().
+ *
+ * Return value: (array length=n_texts) (transfer full): an array, indexed like @texts,
+ * of #GList of #PopplerRectangle
+ *
+ * Since: 21.03.0
+ **/
+GList **poppler_page_find_texts_with_options(PopplerPage *page, const char *const *texts, PopplerFindFlags options, guint *n_texts)
+{
+    PopplerRectangle *match;
+    GList **matches;
+    TextPage *text_dev;
+    double height;
+    std::vector<std::vector<Unicode>> terms;
+
+    g_return_val_if_fail(POPPLER_IS_PAGE(page), NULL);
+    g_return_val_if_fail(texts != nullptr, NULL);
+
+    text_dev = poppler_page_get_text_page(page);
+
+    for (int i = 0; texts[i]; i++) {
+        glong ucs4_len;
+        gunichar *ucs4 = g_utf8_to_ucs4_fast(texts[i], -1, &ucs4_len);
+        terms.emplace_back(ucs4, ucs4 + ucs4_len);
+        g_free(ucs4);
+    }
+    poppler_page_get_size(page, nullptr, &height);
+
+    matches = g_new0(GList *, terms.size() + 1);
+    for (const TextSearchHit &hit : text_dev->findAllText(terms, options & POPPLER_FIND_CASE_SENSITIVE, options & POPPLER_FIND_IGNORE_DIACRITICS, options & POPPLER_FIND_WHOLE_WORDS_ONLY)) {
+        match = poppler_rectangle_new();
+        match->x1 = hit.xMin;
+        match->y1 = height - hit.yMax;
+        match->x2 = hit.xMax;
+        match->y2 = height - hit.yMin;
+        matches[hit.term] = g_list_prepend(matches[hit.term], match);
+    }
+
+    if (!(options & POPPLER_FIND_BACKWARDS)) {
+        for (size_t i = 0; i < terms.size(); i++) {
+            matches[i] = g_list_reverse(matches[i]);
+        }
+    }
+    if (n_texts) {
+        *n_texts = terms.size();
+    }
+
+    return matches;
+}
+
 static CairoImageOutputDev *poppler_page_get_image_output_dev(PopplerPage *page, bool (*imgDrawDeviceCbk)(int img_id, void *data), void *imgDrawCbkData)
 {
     CairoImageOutputDev *image_dev;
@@ -62,6 +62,8 @@ GList *poppler_page_find_text_with_options(PopplerPage *page, const char *text,
 POPPLER_PUBLIC
 GList *poppler_page_find_text(PopplerPage *page, const char *text);
 POPPLER_PUBLIC
+GList **poppler_page_find_texts_with_options(PopplerPage *page, const char *const *texts, PopplerFindFlags options, guint *n_texts);
+POPPLER_PUBLIC
 void poppler_page_render_to_ps(PopplerPage *page, PopplerPSFile *ps_file);
 POPPLER_PUBLIC
 char *poppler_page_get_text(PopplerPage *page);
@@ -0,0 +1,105 @@
+/*
+ * testing program for the poppler_page_find_texts_with_options function
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <poppler.h>
+
+static const char *content = "BT /F1 12 Tf 72 720 Td (The quick brown fox jumps over the lazy dog.) Tj 0 -20 Td (The dog sleeps, the fox does not.) Tj ET";
+
+static GBytes *make_pdf(void)
+{
+    const char *objects[5];
+    char *stream;
+    goffset offsets[5];
+    goffset xref;
+    GString *pdf;
+    int i;
+
+    stream = g_strdup_printf("<< /Length %d >>\nstream\n%s\nendstream", (int)strlen(content), content);
+    objects[0] = "<< /Type /Catalog /Pages 2 0 R >>";
+    objects[1] = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
+    objects[2] = "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 4 0 R >> >> /Contents 5 0 R >>";
+    objects[3] = "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>";
+    objects[4] = stream;
+
+    pdf = g_string_new("%PDF-1.4\n");
+    for (i = 0; i < 5; i++) {
+        offsets[i] = pdf->len;
+        g_string_append_printf(pdf, "%d 0 obj\n%s\nendobj\n", i + 1, objects[i]);
+    }
+    xref = pdf->len;
+    g_string_append(pdf, "xref\n0 6\n0000000000 65535 f \n");
+    for (i = 0; i < 5; i++) {
+        g_string_append_printf(pdf, "%010d 00000 n \n", (int)offsets[i]);
+    }
+    g_string_append_printf(pdf, "trailer\n<< /Size 6 /Root 1 0 R >>\nstartxref\n%d\n%%%%EOF\n", (int)xref);
+    g_free(stream);
+
+    return g_string_free_to_bytes(pdf);
+}
+
+static gboolean same_rectangles(GList *a, GList *b)
+{
+    for (; a && b; a = a->next, b = b->next) {
+        PopplerRectangle *ra = (PopplerRectangle *)a->data;
+        PopplerRectangle *rb = (PopplerRectangle *)b->data;
+
+        if (ra->x1 != rb->x1 || ra->y1 != rb->y1 || ra->x2 != rb->x2 || ra->y2 != rb->y2)
+            return FALSE;
+    }
+    return !a && !b;
+}
+
+/*
+ * main
+ */
+int main(int argc, char *argv[])
+{
+    const char *texts[] = { "the", "dog", "fox jumps", "xyzzy", NULL };
+    const guint counts[] = { 4, 2, 1, 0 };
+    const PopplerFindFlags options[] = { POPPLER_FIND_DEFAULT, POPPLER_FIND_CASE_SENSITIVE, POPPLER_FIND_BACKWARDS };
+    PopplerDocument *doc;
+    PopplerPage *page;
+    GBytes *bytes;
+    GList **matches;
+    guint n_texts, i, j;
+    GError *err = NULL;
+
+    /* open document */
+
+    bytes = make_pdf();
+    doc = poppler_document_new_from_bytes(bytes, NULL, &err);
+    if (doc == NULL) {
+        g_printerr("error opening pdf file: %s\n", err->message);
+        g_error_free(err);
+        exit(EXIT_FAILURE);
+    }
+    page = poppler_document_get_page(doc, 0);
+
+    /* each list of matches is the one of its text searched alone */
+
+    for (j = 0; j < G_N_ELEMENTS(options); j++) {
+        matches = poppler_page_find_texts_with_options(page, texts, options[j], &n_texts);
+        g_assert_cmpuint(n_texts, ==, G_N_ELEMENTS(counts));
+        for (i = 0; i < n_texts; i++) {
+            GList *single = poppler_page_find_text_with_options(page, texts[i], options[j]);
+
+            g_assert_true(same_rectangles(matches[i], single));
+            if (!(options[j] & POPPLER_FIND_CASE_SENSITIVE))
+                g_assert_cmpuint(g_list_length(matches[i]), ==, counts[i]);
+            g_list_free_full(single, (GDestroyNotify)poppler_rectangle_free);
+            g_list_free_full(matches[i], (GDestroyNotify)poppler_rectangle_free);
+        }
+        g_free(matches);
+    }
+
+    g_object_unref(page);
+    g_object_unref(doc);
+    g_bytes_unref(bytes);
+
+    return EXIT_SUCCESS;
+}
@@ -32,9 +32,10 @@
 
 #include "NetPBMWriter.h"
 
-// Writer for the NetPBM formats (PBM and PPM)
+// Writer for the NetPBM formats (PBM, PGM and PPM)
 // This format is documented at:
 //   http://netpbm.sourceforge.net/doc/pbm.html
+//   http://netpbm.sourceforge.net/doc/pgm.html
 //   http://netpbm.sourceforge.net/doc/ppm.html
 
 NetPBMWriter::NetPBMWriter(Format formatA) : format(formatA) { }
@@ -46,6 +47,10 @@ bool NetPBMWriter::init(FILE *f, int widthA, int heightA, int hDPI, int vDPI)
     if (format == MONOCHROME) {
         fprintf(file, "P4\n");
         fprintf(file, "%d %d\n", widthA, heightA);
+    } else if (format == GRAY) {
+        fprintf(file, "P5\n");
+        fprintf(file, "%d %d\n", widthA, heightA);
+        fprintf(file, "255\n");
     } else {
         fprintf(file, "P6\n");
         fprintf(file, "%d %d\n", widthA, heightA);
@@ -68,6 +73,8 @@ bool NetPBMWriter::writeRow(unsigned char **row)
         int size = (width + 7) / 8;
         for (int i = 0; i < size; i++)
             fputc((*row)[i] ^ 0xff, file);
+    } else if (format == GRAY) {
+        fwrite(*row, 1, width, file);
     } else {
         fwrite(*row, 1, width * 3, file);
     }
@@ -19,9 +19,10 @@
 
 #include "ImgWriter.h"
 
-// Writer for the NetPBM formats (PBM and PPM)
+// Writer for the NetPBM formats (PBM, PGM and PPM)
 // This format is documented at:
 //   http://netpbm.sourceforge.net/doc/pbm.html
+//   http://netpbm.sourceforge.net/doc/pgm.html
 //   http://netpbm.sourceforge.net/doc/ppm.html
 
 class NetPBMWriter : public ImgWriter
@@ -29,11 +30,13 @@ class NetPBMWriter : public ImgWriter
 public:
     /* RGB        - 3 bytes/pixel
      * MONOCHROME - 8 pixels/byte
+     * GRAY       - 1 byte/pixel
      */
     enum Format
     {
         RGB,
-        MONOCHROME
+        MONOCHROME,
+        GRAY
     };
 
     NetPBMWriter(Format formatA = RGB);
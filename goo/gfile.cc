@@ -43,6 +43,8 @@
 #    include <climits>
 #    include <cstring>
 #    include <pwd.h>
+#else
+#    include <sys/stat.h>
 #endif // _WIN32
 #include <cstdio>
 #include <limits>
@@ -324,6 +326,26 @@ Goffset GoffsetMax()
 #endif
 }
 
+bool getFileSizeAndModificationTime(const char *path, Goffset *size, long long *mtime)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) != 0) {
+        return false;
+    }
+    *size = st.st_size;
+    *mtime = (long long)st.st_mtime * 1000000000LL;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    *size = st.st_size;
+    *mtime = (long long)mtim(st).tv_sec * 1000000000LL + mtim(st).tv_nsec;
+#endif
+    return true;
+}
+
 //------------------------------------------------------------------------
 // GooFile
 //------------------------------------------------------------------------
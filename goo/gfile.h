@@ -107,6 +107,10 @@ extern Goffset Gftell(FILE *f);
 // Largest offset supported by Gfseek/Gftell
 extern Goffset GoffsetMax();
 
+// Get the size and the modification time (in nanoseconds since the
+// epoch) of the file <path>.  Returns false if it doesn't exist.
+extern bool getFileSizeAndModificationTime(const char *path, Goffset *size, long long *mtime);
+
 //------------------------------------------------------------------------
 // GooFile
 //------------------------------------------------------------------------
@@ -124,6 +124,42 @@ inline void *gmallocn_checkoverflow(int count, int size)
     return gmallocn(count, size, true);
 }
 
+/// Same as gmallocn, but the memory is zero-filled, as with calloc.
+inline void *gcallocn(int count, int size, bool checkoverflow = false)
+{
+    if (count == 0) {
+        return nullptr;
+    }
+
+    int bytes;
+    if (count < 0 || size <= 0 || checkedMultiply(count, size, &bytes)) {
+        std::fputs("Bogus memory allocation size\n", stderr);
+
+        if (checkoverflow) {
+            return nullptr;
+        }
+
+        std::abort();
+    }
+
+    if (void *p = std::calloc(count, size)) {
+        return p;
+    }
+
+    std::fputs("Out of memory\n", stderr);
+
+    if (checkoverflow) {
+        return nullptr;
+    }
+
+    std::abort();
+}
+
+inline void *gcallocn_checkoverflow(int count, int size)
+{
+    return gcallocn(count, size, true);
+}
+
 inline void *gmallocn3(int width, int height, int size, bool checkoverflow = false)
 {
     if (width == 0 || height == 0) {
@@ -36,19 +36,28 @@
 // Array
 //------------------------------------------------------------------------
 
-#define arrayLocker() std::unique_lock<std::recursive_mutex> locker(mutex)
+#define arrayLocker() std::unique_lock<std::recursive_mutex> locker = lockForWrite()
 
 Array::Array(XRef *xrefA)
 {
     xref = xrefA;
     ref = 1;
+    frozen = false;
+    mutex = nullptr;
 }
 
-Array::~Array() { }
+Array::~Array()
+{
+    delete mutex.load();
+}
 
 Array *Array::copy(XRef *xrefA) const
 {
-    arrayLocker();
+    // only lock if the array has been modified since it was frozen
+    std::unique_lock<std::recursive_mutex> locker;
+    if (std::recursive_mutex *m = mutex.load(std::memory_order_acquire)) {
+        locker = std::unique_lock<std::recursive_mutex>(*m);
+    }
     Array *a = new Array(xrefA);
     a->elems.reserve(elems.size());
     for (const auto &elem : elems) {
@@ -57,6 +66,23 @@ Array *Array::copy(XRef *xrefA) const
     return a;
 }
 
+std::unique_lock<std::recursive_mutex> Array::lockForWrite()
+{
+    if (!frozen) {
+        return std::unique_lock<std::recursive_mutex>();
+    }
+    std::recursive_mutex *m = mutex.load(std::memory_order_acquire);
+    if (!m) {
+        auto *newMutex = new std::recursive_mutex();
+        if (mutex.compare_exchange_strong(m, newMutex, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            m = newMutex;
+        } else {
+            delete newMutex;
+        }
+    }
+    return std::unique_lock<std::recursive_mutex>(*m);
+}
+
 void Array::add(Object &&elem)
 {
     arrayLocker();
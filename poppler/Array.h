@@ -41,6 +41,9 @@ class XRef;
 // Array
 //------------------------------------------------------------------------
 
+// Like Dict, an Array is private to the thread building it until
+// freeze() is called, and modifying it afterwards takes a mutex created
+// the first time it's needed.  Reads never lock.
 class Array
 {
 public:
@@ -59,6 +62,9 @@ public:
     // Copy array with new xref
     Array *copy(XRef *xrefA) const;
 
+    // Mark the array as complete and shared with other threads.
+    void freeze() { frozen = true; }
+
     // Add an element
     // elem becomes a dead object after this call
     void add(Object &&elem);
@@ -83,7 +89,10 @@ private:
     XRef *xref; // the xref table for this PDF file
     std::vector<Object> elems; // array of elements
     std::atomic_int ref; // reference count
-    mutable std::recursive_mutex mutex;
+    bool frozen; // visible to other threads
+    std::atomic<std::recursive_mutex *> mutex; // created on first use
+
+    std::unique_lock<std::recursive_mutex> lockForWrite();
 };
 
 #endif
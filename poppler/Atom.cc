@@ -0,0 +1,97 @@
+//========================================================================
+//
+// Atom.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <cstdint>
+
+#include "Atom.h"
+
+//------------------------------------------------------------------------
+// well known atoms
+//------------------------------------------------------------------------
+
+#define POPPLER_DEFINE_ATOM_STRING(name) const char atomString_##name[] = #name;
+POPPLER_WELL_KNOWN_ATOMS(POPPLER_DEFINE_ATOM_STRING)
+#undef POPPLER_DEFINE_ATOM_STRING
+
+#define POPPLER_ATOM_STRING(name) atomString_##name,
+static const char *const wellKnownAtoms[] = { POPPLER_WELL_KNOWN_ATOMS(POPPLER_ATOM_STRING) };
+#undef POPPLER_ATOM_STRING
+
+//------------------------------------------------------------------------
+// AtomTable
+//------------------------------------------------------------------------
+
+// Open addressing hash table of the well known names.  It is filled
+// once, when it is created, and only read afterwards.
+namespace {
+
+constexpr size_t tableSize = 256; // must be a power of 2, and at least twice the number of names
+
+class AtomTable
+{
+public:
+    AtomTable()
+    {
+        static_assert(sizeof(wellKnownAtoms) / sizeof(wellKnownAtoms[0]) <= tableSize / 2, "the atom table is too small");
+        for (const char *&slot : slots) {
+            slot = nullptr;
+        }
+        for (const char *name : wellKnownAtoms) {
+            size_t i = hash(name, strlen(name));
+            while (slots[i]) {
+                i = (i + 1) & (tableSize - 1);
+            }
+            slots[i] = name;
+        }
+    }
+
+    AtomTable(const AtomTable &) = delete;
+    AtomTable &operator=(const AtomTable &) = delete;
+
+    const char *lookup(const char *s, size_t length) const
+    {
+        for (size_t i = hash(s, length); slots[i]; i = (i + 1) & (tableSize - 1)) {
+            if (!strncmp(slots[i], s, length) && slots[i][length] == '\0') {
+                return slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    static size_t hash(const char *s, size_t length)
+    {
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+        }
+        return h & (tableSize - 1);
+    }
+
+    const char *slots[tableSize];
+};
+
+const AtomTable &atomTable()
+{
+    static const AtomTable table;
+    return table;
+}
+
+}
+
+//------------------------------------------------------------------------
+// Atom
+//------------------------------------------------------------------------
+
+Atom Atom::find(const char *s, size_t length)
+{
+    return Atom(atomTable().lookup(s, length));
+}
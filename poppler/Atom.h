@@ -0,0 +1,84 @@
+//========================================================================
+//
+// Atom.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Interned PDF names.
+//
+//========================================================================
+
+#ifndef ATOM_H
+#define ATOM_H
+
+#include <cstddef>
+#include <cstring>
+
+//------------------------------------------------------------------------
+// Atom
+//------------------------------------------------------------------------
+
+// An Atom is one of the well known PDF names, stored once for the whole
+// process, so that two atoms are equal when their pointers are, without
+// comparing the strings.  Names and dict keys equal to a well known name
+// are stored as its atom, and Dict compares its keys by atom.
+//
+// The table of atoms is fixed: other names are never added to it, so
+// that the names of a document can't make a process wide table grow,
+// and the objects and dicts holding them keep a copy of the string.
+class Atom
+{
+public:
+    constexpr Atom() : str(nullptr) { }
+    explicit constexpr Atom(const char *strA) : str(strA) { }
+
+    // Return the atom of the <length> first chars of <s>, or a null
+    // atom if they aren't a well known name.  Thread safe.
+    static Atom find(const char *s, size_t length);
+    static Atom find(const char *s) { return find(s, strlen(s)); }
+
+    const char *c_str() const { return str; }
+    bool isNull() const { return str == nullptr; }
+    explicit operator bool() const { return str != nullptr; }
+
+    bool operator==(const Atom other) const { return str == other.str; }
+    bool operator!=(const Atom other) const { return str != other.str; }
+
+private:
+    const char *str; // the well known name, or nullptr
+};
+
+//------------------------------------------------------------------------
+// well known atoms
+//------------------------------------------------------------------------
+
+// The names most often looked up.  Atoms::<name> can be used without
+// looking them up.
+#define POPPLER_WELL_KNOWN_ATOMS(X) \
+    X(A) X(AA) X(AcroForm) X(Annot) X(Annots) X(AP) X(ArtBox) X(AS) \
+    X(BaseFont) X(BBox) X(BitsPerComponent) X(BleedBox) X(BM) X(Border) X(C) \
+    X(CA) X(ca) X(Catalog) X(CIDSystemInfo) X(CIDToGIDMap) X(ColorSpace) \
+    X(Contents) X(Count) X(CropBox) X(D) X(Decode) X(DecodeParms) \
+    X(DescendantFonts) X(DP) X(DW) X(Encoding) X(Encrypt) X(ExtGState) X(F) \
+    X(Filter) X(First) X(FirstChar) X(Font) X(FontDescriptor) X(FontFile) \
+    X(FontFile2) X(FontFile3) X(Form) X(FT) X(Group) X(Height) X(ID) \
+    X(Image) X(ImageMask) X(Index) X(Info) X(Interpolate) X(Kids) \
+    X(LastChar) X(Length) X(Mask) X(Matrix) X(MediaBox) X(N) X(Name) \
+    X(ObjStm) X(OC) X(P) X(Page) X(Pages) X(Parent) X(Pattern) X(Prev) \
+    X(ProcSet) X(Properties) X(Rect) X(Resources) X(Root) X(Rotate) X(S) \
+    X(Shading) X(Size) X(SMask) X(StructParents) X(Subtype) X(T) \
+    X(ToUnicode) X(TrimBox) X(Type) X(V) X(W) X(Width) X(Widths) X(XObject) \
+    X(XRef) X(XRefStm)
+
+// the storage of the well known names, defined in Atom.cc
+#define POPPLER_DECLARE_ATOM_STRING(name) extern const char atomString_##name[];
+POPPLER_WELL_KNOWN_ATOMS(POPPLER_DECLARE_ATOM_STRING)
+#undef POPPLER_DECLARE_ATOM_STRING
+
+namespace Atoms {
+#define POPPLER_DECLARE_ATOM(name) constexpr Atom name { atomString_##name };
+POPPLER_WELL_KNOWN_ATOMS(POPPLER_DECLARE_ATOM)
+#undef POPPLER_DECLARE_ATOM
+}
+
+#endif
@@ -341,6 +341,23 @@ void CMap::freeCMapVector(CMapVectorEntry *vec)
     gfree(vec);
 }
 
+size_t CMap::getMemorySize() const
+{
+    return sizeof(CMap) + (vector ? getCMapVectorSize(vector) : 0);
+}
+
+size_t CMap::getCMapVectorSize(const CMapVectorEntry *vec)
+{
+    size_t size = 256 * sizeof(CMapVectorEntry);
+
+    for (int i = 0; i < 256; ++i) {
+        if (vec[i].isVector) {
+            size += getCMapVectorSize(vec[i].vector);
+        }
+    }
+    return size;
+}
+
 void CMap::incRefCnt()
 {
     ++refCnt;
@@ -427,54 +444,53 @@ void CMap::setReverseMap(unsigned int *rmap, unsigned int rmapSize, unsigned int
 
 CMapCache::CMapCache()
 {
-    int i;
-
-    for (i = 0; i < cMapCacheSize; ++i) {
-        cache[i] = nullptr;
-    }
+    totalBytes = 0;
 }
 
 CMapCache::~CMapCache()
 {
-    int i;
-
-    for (i = 0; i < cMapCacheSize; ++i) {
-        if (cache[i]) {
-            cache[i]->decRefCnt();
-        }
+    for (CMap *cmap : cache) {
+        cmap->decRefCnt();
     }
 }
 
 CMap *CMapCache::getCMap(const GooString *collection, const GooString *cMapName)
 {
     CMap *cmap;
-    int i, j;
 
-    if (cache[0] && cache[0]->match(collection, cMapName)) {
-        cache[0]->incRefCnt();
-        return cache[0];
-    }
-    for (i = 1; i < cMapCacheSize; ++i) {
-        if (cache[i] && cache[i]->match(collection, cMapName)) {
+    for (size_t i = 0; i < cache.size(); ++i) {
+        if (cache[i]->match(collection, cMapName)) {
             cmap = cache[i];
-            for (j = i; j >= 1; --j) {
-                cache[j] = cache[j - 1];
+            if (i > 0) {
+                const size_t bytes = cacheBytes[i];
+                cache.erase(cache.begin() + i);
+                cacheBytes.erase(cacheBytes.begin() + i);
+                cache.insert(cache.begin(), cmap);
+                cacheBytes.insert(cacheBytes.begin(), bytes);
             }
-            cache[0] = cmap;
             cmap->incRefCnt();
             return cmap;
         }
     }
     if ((cmap = CMap::parse(this, collection, cMapName))) {
-        if (cache[cMapCacheSize - 1]) {
-            cache[cMapCacheSize - 1]->decRefCnt();
-        }
-        for (j = cMapCacheSize - 1; j >= 1; --j) {
-            cache[j] = cache[j - 1];
-        }
-        cache[0] = cmap;
+        add(cmap);
         cmap->incRefCnt();
         return cmap;
     }
     return nullptr;
 }
+
+void CMapCache::add(CMap *cmap)
+{
+    const size_t bytes = cmap->getMemorySize();
+
+    cache.insert(cache.begin(), cmap);
+    cacheBytes.insert(cacheBytes.begin(), bytes);
+    totalBytes += bytes;
+    while (cache.size() > 1 && (cache.size() > cMapCacheMaxEntries || totalBytes > cMapCacheMaxBytes)) {
+        cache.back()->decRefCnt();
+        totalBytes -= cacheBytes.back();
+        cache.pop_back();
+        cacheBytes.pop_back();
+    }
+}
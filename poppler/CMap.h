@@ -27,6 +27,7 @@
 #define CMAP_H
 
 #include <atomic>
+#include <vector>
 
 #include "poppler-config.h"
 #include "CharTypes.h"
@@ -81,6 +82,10 @@ public:
 
     void setReverseMap(unsigned int *rmap, unsigned int rmapSize, unsigned int ncand);
 
+    // Return the (approximate) number of bytes used by the mapping
+    // tables.
+    size_t getMemorySize() const;
+
 private:
     void parse2(CMapCache *cache, int (*getCharFunc)(void *), void *data);
     CMap(GooString *collectionA, GooString *cMapNameA);
@@ -90,6 +95,7 @@ private:
     void copyVector(CMapVectorEntry *dest, CMapVectorEntry *src);
     void addCIDs(unsigned int start, unsigned int end, unsigned int nBytes, CID firstCID);
     void freeCMapVector(CMapVectorEntry *vec);
+    static size_t getCMapVectorSize(const CMapVectorEntry *vec);
     void setReverseMapVector(unsigned int startCode, CMapVectorEntry *vec, unsigned int *rmap, unsigned int rmapSize, unsigned int ncand);
 
     GooString *collection;
@@ -104,7 +110,11 @@ private:
 
 //------------------------------------------------------------------------
 
-#define cMapCacheSize 4
+// The cache keeps the most recently used CMaps as long as their tables
+// fit in cMapCacheMaxBytes, and never more than cMapCacheMaxEntries of
+// them.  The most recently used CMap is always kept.
+#define cMapCacheMaxBytes (8 * 1024 * 1024)
+#define cMapCacheMaxEntries 64
 
 class CMapCache
 {
@@ -124,7 +134,11 @@ public:
     CMap *getCMap(const GooString *collection, const GooString *cMapName);
 
 private:
-    CMap *cache[cMapCacheSize];
+    void add(CMap *cmap);
+
+    std::vector<CMap *> cache; // most recently used first
+    std::vector<size_t> cacheBytes; // getMemorySize() of each entry
+    size_t totalBytes;
 };
 
 #endif
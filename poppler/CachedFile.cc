@@ -119,6 +119,26 @@ int CachedFile::cache(const std::vector<ByteRange> &origRanges)
         }
     }
 
+    // Bridge short gaps of not yet loaded chunks between needed ones, a
+    // few more bytes in a request are cheaper than one more request.
+    int lastNeeded = -1;
+    for (int i = 0; i < numChunks; ++i) {
+        if (!chunkNeeded[i])
+            continue;
+        if (lastNeeded >= 0 && i - lastNeeded - 1 <= CachedFileMaxGapChunks) {
+            bool gapIsNew = true;
+            for (int j = lastNeeded + 1; j < i && gapIsNew; ++j) {
+                gapIsNew = (*chunks)[j].state == chunkStateNew;
+            }
+            if (gapIsNew) {
+                for (int j = lastNeeded + 1; j < i; ++j) {
+                    chunkNeeded[j] = true;
+                }
+            }
+        }
+        lastNeeded = i;
+    }
+
     int chunk = 0;
     while (chunk < numChunks) {
         while (!chunkNeeded[chunk] && (++chunk != numChunks))
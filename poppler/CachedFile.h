@@ -25,6 +25,7 @@
 //------------------------------------------------------------------------
 
 #define CachedFileChunkSize 8192 // This should be a multiple of cachedStreamBufSize
+#define CachedFileMaxGapChunks 4 // Gaps of up to this many chunks are loaded along with the ranges around them
 
 class GooString;
 class CachedFileLoader;
@@ -54,6 +55,9 @@ public:
     int seek(long int offset, int origin);
     size_t read(void *ptr, size_t unitsize, size_t count);
     size_t write(const char *ptr, size_t size, size_t fromByte);
+    // Load the given byte ranges (the whole file if ranges is empty) into
+    // the cache, with as few loader requests as possible.
+    // Returns 0 on success, anything but 0 on failure.
     int cache(const std::vector<ByteRange> &ranges);
 
     // Reference counting.
@@ -139,6 +143,9 @@ public:
     virtual size_t init(GooString *uri, CachedFile *cachedFile) = 0;
 
     // Loads specified byte ranges and passes it to the writer to store them.
+    // The ranges are sorted and don't overlap; the data must be passed to
+    // the writer in that order, but the loader is free to fetch the ranges
+    // concurrently.
     // Returns 0 on success, Anything but 0 on failure.
     // The caller is responsible for deleting the writer.
     virtual int load(const std::vector<ByteRange> &ranges, CachedFileWriter *writer) = 0;
@@ -532,6 +532,20 @@ bool CharCodeToUnicode::match(const GooString *tagA)
     return tag && !tag->cmp(tagA);
 }
 
+size_t CharCodeToUnicode::getMemorySize() const
+{
+    size_t size = sizeof(CharCodeToUnicode);
+
+    if (map) {
+        size += mapLen * sizeof(Unicode);
+    }
+    size += sMapSize * sizeof(CharCodeToUnicodeString);
+    for (int i = 0; i < sMapLen; ++i) {
+        size += sMap[i].len * sizeof(Unicode);
+    }
+    return size;
+}
+
 void CharCodeToUnicode::setMapping(CharCode c, Unicode *u, int len)
 {
     int i, j;
@@ -636,45 +650,33 @@ int CharCodeToUnicode::mapToCharCode(const Unicode *u, CharCode *c, int usize) c
 
 //------------------------------------------------------------------------
 
-CharCodeToUnicodeCache::CharCodeToUnicodeCache(int sizeA)
+CharCodeToUnicodeCache::CharCodeToUnicodeCache(size_t maxBytesA)
 {
-    int i;
-
-    size = sizeA;
-    cache = (CharCodeToUnicode **)gmallocn(size, sizeof(CharCodeToUnicode *));
-    for (i = 0; i < size; ++i) {
-        cache[i] = nullptr;
-    }
+    totalBytes = 0;
+    maxBytes = maxBytesA;
 }
 
 CharCodeToUnicodeCache::~CharCodeToUnicodeCache()
 {
-    int i;
-
-    for (i = 0; i < size; ++i) {
-        if (cache[i]) {
-            cache[i]->decRefCnt();
-        }
+    for (CharCodeToUnicode *ctu : cache) {
+        ctu->decRefCnt();
     }
-    gfree(cache);
 }
 
 CharCodeToUnicode *CharCodeToUnicodeCache::getCharCodeToUnicode(const GooString *tag)
 {
     CharCodeToUnicode *ctu;
-    int i, j;
 
-    if (cache[0] && cache[0]->match(tag)) {
-        cache[0]->incRefCnt();
-        return cache[0];
-    }
-    for (i = 1; i < size; ++i) {
-        if (cache[i] && cache[i]->match(tag)) {
+    for (size_t i = 0; i < cache.size(); ++i) {
+        if (cache[i]->match(tag)) {
             ctu = cache[i];
-            for (j = i; j >= 1; --j) {
-                cache[j] = cache[j - 1];
+            if (i > 0) {
+                const size_t bytes = cacheBytes[i];
+                cache.erase(cache.begin() + i);
+                cacheBytes.erase(cacheBytes.begin() + i);
+                cache.insert(cache.begin(), ctu);
+                cacheBytes.insert(cacheBytes.begin(), bytes);
             }
-            cache[0] = ctu;
             ctu->incRefCnt();
             return ctu;
         }
@@ -684,14 +686,16 @@ CharCodeToUnicode *CharCodeToUnicodeCache::getCharCodeToUnicode(const GooString
 
 void CharCodeToUnicodeCache::add(CharCodeToUnicode *ctu)
 {
-    int i;
+    const size_t bytes = ctu->getMemorySize();
 
-    if (cache[size - 1]) {
-        cache[size - 1]->decRefCnt();
-    }
-    for (i = size - 1; i >= 1; --i) {
-        cache[i] = cache[i - 1];
-    }
-    cache[0] = ctu;
+    cache.insert(cache.begin(), ctu);
+    cacheBytes.insert(cacheBytes.begin(), bytes);
+    totalBytes += bytes;
     ctu->incRefCnt();
+    while (cache.size() > 1 && totalBytes > maxBytes) {
+        cache.back()->decRefCnt();
+        totalBytes -= cacheBytes.back();
+        cache.pop_back();
+        cacheBytes.pop_back();
+    }
 }
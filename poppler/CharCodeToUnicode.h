@@ -32,6 +32,7 @@
 #define CHARCODETOUNICODE_H
 
 #include <atomic>
+#include <vector>
 
 #include "poppler-config.h"
 #include "CharTypes.h"
@@ -98,6 +99,9 @@ public:
     // code supported by the mapping.
     CharCode getLength() const { return mapLen; }
 
+    // Return the (approximate) number of bytes used by the mapping.
+    size_t getMemorySize() const;
+
 private:
     void parseCMap1(int (*getCharFunc)(void *), void *data, int nBits);
     void addMapping(CharCode code, char *uStr, int n, int offset);
@@ -116,10 +120,12 @@ private:
 
 //------------------------------------------------------------------------
 
+// Keeps the most recently used mappings as long as they fit in
+// <maxBytesA> bytes; the most recently used mapping is always kept.
 class CharCodeToUnicodeCache
 {
 public:
-    CharCodeToUnicodeCache(int sizeA);
+    CharCodeToUnicodeCache(size_t maxBytesA);
     ~CharCodeToUnicodeCache();
 
     CharCodeToUnicodeCache(const CharCodeToUnicodeCache &) = delete;
@@ -134,8 +140,10 @@ public:
     void add(CharCodeToUnicode *ctu);
 
 private:
-    CharCodeToUnicode **cache;
-    int size;
+    std::vector<CharCodeToUnicode *> cache; // most recently used first
+    std::vector<size_t> cacheBytes; // getMemorySize() of each entry
+    size_t totalBytes;
+    size_t maxBytes;
 };
 
 #endif
@@ -16,6 +16,8 @@
 
 #include "goo/GooString.h"
 
+#include <string>
+
 //------------------------------------------------------------------------
 
 CurlCachedFileLoader::CurlCachedFileLoader()
@@ -23,11 +25,14 @@ CurlCachedFileLoader::CurlCachedFileLoader()
     url = nullptr;
     cachedFile = nullptr;
     curl = nullptr;
+    multi = nullptr;
 }
 
 CurlCachedFileLoader::~CurlCachedFileLoader()
 {
     curl_easy_cleanup(curl);
+    if (multi)
+        curl_multi_cleanup(multi);
 }
 
 static size_t noop_cb(char *ptr, size_t size, size_t nmemb, void *ptr2)
@@ -65,32 +70,130 @@ size_t CurlCachedFileLoader::init(GooString *urlA, CachedFile *cachedFileA)
 
 static size_t load_cb(const char *ptr, size_t size, size_t nmemb, void *data)
 {
-    CachedFileWriter *writer = (CachedFileWriter *)data;
-    return (writer->write)(ptr, size * nmemb);
+    std::string *buf = (std::string *)data;
+    buf->append(ptr, size * nmemb);
+    return size * nmemb;
 }
 
+// A range request that is being transferred
+struct CurlRangeTransfer
+{
+    CURL *curl;
+    GooString *range;
+    std::string data;
+    CURLcode result;
+    bool done;
+};
+
 int CurlCachedFileLoader::load(const std::vector<ByteRange> &ranges, CachedFileWriter *writer)
 {
-    CURLcode r = CURLE_OK;
-    unsigned long long fromByte, toByte;
-    for (const ByteRange &bRange : ranges) {
+    if (ranges.empty())
+        return 0;
 
-        fromByte = bRange.offset;
-        toByte = fromByte + bRange.length - 1;
-        GooString *range = GooString::format("{0:ulld}-{1:ulld}", fromByte, toByte);
+    if (!multi) {
+        multi = curl_multi_init();
+        if (!multi)
+            return CURLE_FAILED_INIT;
+    }
 
-        curl_easy_setopt(curl, CURLOPT_URL, url->c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, load_cb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, writer);
-        curl_easy_setopt(curl, CURLOPT_RANGE, range->c_str());
-        r = curl_easy_perform(curl);
-        curl_easy_reset(curl);
+    // Issue up to maxParallelTransfers range requests at once and hand
+    // the data over to the writer in the order of the ranges, as soon as
+    // all the ranges before it are done.
+    std::vector<CurlRangeTransfer> transfers(ranges.size());
+    size_t next = 0, written = 0;
+    int active = 0;
+    CURLcode r = CURLE_OK;
 
-        delete range;
+    const auto startTransfer = [&](size_t i) {
+        CurlRangeTransfer &t = transfers[i];
+        const unsigned long long fromByte = ranges[i].offset;
+        const unsigned long long toByte = fromByte + ranges[i].length - 1;
+        t.range = GooString::format("{0:ulld}-{1:ulld}", fromByte, toByte);
+        t.data.reserve(ranges[i].length);
+        t.result = CURLE_OK;
+        t.done = false;
+        t.curl = curl_easy_init();
+        curl_easy_setopt(t.curl, CURLOPT_URL, url->c_str());
+        curl_easy_setopt(t.curl, CURLOPT_WRITEFUNCTION, load_cb);
+        curl_easy_setopt(t.curl, CURLOPT_WRITEDATA, &t.data);
+        curl_easy_setopt(t.curl, CURLOPT_RANGE, t.range->c_str());
+        curl_easy_setopt(t.curl, CURLOPT_PRIVATE, &t);
+        curl_multi_add_handle(multi, t.curl);
+        ++active;
+    };
+
+    while (next < ranges.size() && active < maxParallelTransfers) {
+        startTransfer(next++);
+    }
 
-        if (r != CURLE_OK)
+    while (active > 0) {
+        int running;
+        CURLMcode mc = curl_multi_perform(multi, &running);
+        if (mc == CURLM_OK && running > 0) {
+            mc = curl_multi_wait(multi, nullptr, 0, 1000, nullptr);
+        }
+        if (mc != CURLM_OK) {
+            error(errInternal, -1, "Failed to load '{0:t}': {1:s}.", url, curl_multi_strerror(mc));
+            r = CURLE_RECV_ERROR;
+        }
+
+        CURLMsg *msg;
+        int msgsLeft;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft))) {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            CurlRangeTransfer *t;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&t);
+            t->result = msg->data.result;
+            if (t->result == CURLE_OK) {
+                long code = 0;
+                curl_easy_getinfo(t->curl, CURLINFO_RESPONSE_CODE, &code);
+                // A server that doesn't support ranges sends the whole
+                // file, which is only of use for a range at its start.
+                if (code == 200 && ranges[t - transfers.data()].offset != 0) {
+                    error(errInternal, -1, "Server of '{0:t}' doesn't support byte ranges.", url);
+                    t->result = CURLE_RANGE_ERROR;
+                } else if (t->data.size() > ranges[t - transfers.data()].length) {
+                    t->data.resize(ranges[t - transfers.data()].length);
+                }
+            }
+            t->done = true;
+            curl_multi_remove_handle(multi, t->curl);
+            curl_easy_cleanup(t->curl);
+            t->curl = nullptr;
+            delete t->range;
+            --active;
+            if (r == CURLE_OK && t->result != CURLE_OK) {
+                r = t->result;
+            }
+        }
+
+        // Stop issuing requests once one of them failed, but let the
+        // active ones finish so that their handles are cleaned up.
+        while (r == CURLE_OK && next < ranges.size() && active < maxParallelTransfers) {
+            startTransfer(next++);
+        }
+
+        while (r == CURLE_OK && written < next && transfers[written].done) {
+            writer->write(transfers[written].data.c_str(), transfers[written].data.size());
+            std::string().swap(transfers[written].data);
+            ++written;
+        }
+
+        if (r != CURLE_OK && mc != CURLM_OK) {
             break;
+        }
     }
+
+    // Only reached with active transfers if the multi handle itself broke
+    for (CurlRangeTransfer &t : transfers) {
+        if (t.curl) {
+            curl_multi_remove_handle(multi, t.curl);
+            curl_easy_cleanup(t.curl);
+            delete t.range;
+        }
+    }
+
     return r;
 }
 
@@ -19,6 +19,9 @@
 
 //------------------------------------------------------------------------
 
+// Loads a file over HTTP(S) with range requests.  The ranges of a load
+// call are fetched concurrently through a curl multi handle, which also
+// keeps the connections alive between calls.
 class CurlCachedFileLoader : public CachedFileLoader
 {
 
@@ -32,6 +35,9 @@ private:
     GooString *url;
     CachedFile *cachedFile;
     CURL *curl;
+    CURLM *multi;
+
+    static const int maxParallelTransfers = 4;
 };
 
 #endif
@@ -16,6 +16,7 @@
 #include "CachedFile.h"
 #include "CurlCachedFile.h"
 #include "ErrorCodes.h"
+#include "Linearization.h"
 
 //------------------------------------------------------------------------
 // CurlPDFDocBuilder
@@ -32,7 +33,16 @@ PDFDoc *CurlPDFDocBuilder::buildPDFDoc(const GooString &uri, GooString *ownerPas
 
     BaseStream *str = new CachedFileStream(cachedFile, 0, false, cachedFile->getLength(), Object(objNull));
 
-    return new PDFDoc(str, ownerPassword, userPassword, guiDataA);
+    PDFDoc *doc = new PDFDoc(str, ownerPassword, userPassword, guiDataA);
+
+    // Fetch the first page of a linearized file with a few requests
+    // instead of one per chunk the parser runs into.
+    if (doc->isOk() && doc->isLinearized()) {
+        const int firstPage = doc->getLinearization()->getPageFirst() + 1;
+        doc->prefetchPages(firstPage, firstPage);
+    }
+
+    return doc;
 }
 
 bool CurlPDFDocBuilder::supports(const GooString &uri)
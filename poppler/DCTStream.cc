@@ -59,6 +59,7 @@ static void str_term_source(j_decompress_ptr cinfo) { }
 DCTStream::DCTStream(Stream *strA, int colorXformA, Dict *dict, int recursion) : FilterStream(strA)
 {
     colorXform = colorXformA;
+    reduction = 1;
     if (dict != nullptr) {
         Object obj = dict->lookup("Width", recursion);
         err.width = (obj.isInt() && obj.getInt() <= JPEG_MAX_DIMENSION) ? obj.getInt() : 0;
@@ -176,6 +177,10 @@ void DCTStream::reset()
                 break;
             }
 
+            // libjpeg scales the image down while decoding it
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = reduction;
+
             jpeg_start_decompress(&cinfo);
 
             row_stride = cinfo.output_width * cinfo.output_components;
@@ -253,3 +258,12 @@ bool DCTStream::isBinary(bool last)
 {
     return str->isBinary(true);
 }
+
+bool DCTStream::setDecodeReduction(int reductionA)
+{
+    if (reductionA != 1 && reductionA != 2 && reductionA != 4 && reductionA != 8) {
+        return false;
+    }
+    reduction = reductionA;
+    return true;
+}
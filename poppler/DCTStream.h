@@ -66,6 +66,7 @@ public:
     int lookChar() override;
     GooString *getPSFilter(int psLevel, const char *indent) override;
     bool isBinary(bool last = true) override;
+    bool setDecodeReduction(int reductionA) override;
 
 private:
     void init();
@@ -75,6 +76,7 @@ private:
     int getChars(int nChars, unsigned char *buffer) override;
 
     int colorXform;
+    int reduction; // the image is decoded at 1/reduction of its size
     JSAMPLE *current;
     JSAMPLE *limit;
     struct jpeg_decompress_struct cinfo;
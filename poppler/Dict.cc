@@ -40,23 +40,56 @@
 // Dict
 //------------------------------------------------------------------------
 
-#define dictLocker() std::unique_lock<std::recursive_mutex> locker(mutex)
+#define dictLocker() std::unique_lock<std::recursive_mutex> locker = lockForWrite()
 
 constexpr int SORT_LENGTH_LOWER_LIMIT = 32;
 
+// Sorting by name rather than by atom keeps the order of the keys the
+// same from one run to the next.
 struct Dict::CmpDictEntry
 {
-    bool operator()(const DictEntry &lhs, const DictEntry &rhs) const { return lhs.first < rhs.first; }
-    bool operator()(const DictEntry &lhs, const char *rhs) const { return lhs.first < rhs; }
-    bool operator()(const char *lhs, const DictEntry &rhs) const { return lhs < rhs.first; }
+    bool operator()(const DictEntry &lhs, const DictEntry &rhs) const { return strcmp(lhs.key, rhs.key) < 0; }
+    bool operator()(const DictEntry &lhs, const char *rhs) const { return strcmp(lhs.key, rhs) < 0; }
+    bool operator()(const char *lhs, const DictEntry &rhs) const { return strcmp(lhs, rhs.key) < 0; }
 };
 
+Dict::DictEntry::DictEntry(const char *keyA, Object &&valueA) : value(std::move(valueA))
+{
+    const Atom atom = Atom::find(keyA);
+    interned = !atom.isNull();
+    key = interned ? atom.c_str() : copyString(keyA);
+}
+
+Dict::DictEntry &Dict::DictEntry::operator=(DictEntry &&other) noexcept
+{
+    if (this != &other) {
+        if (!interned) {
+            gfree(const_cast<char *>(key));
+        }
+        key = other.key;
+        interned = other.interned;
+        value = std::move(other.value);
+        other.key = nullptr;
+        other.interned = false;
+    }
+    return *this;
+}
+
+Dict::DictEntry::~DictEntry()
+{
+    if (!interned) {
+        gfree(const_cast<char *>(key));
+    }
+}
+
 Dict::Dict(XRef *xrefA)
 {
     xref = xrefA;
     ref = 1;
 
     sorted = false;
+    frozen = false;
+    mutex = nullptr;
 }
 
 Dict::Dict(const Dict *dictA)
@@ -66,25 +99,74 @@ Dict::Dict(const Dict *dictA)
 
     entries.reserve(dictA->entries.size());
     for (const auto &entry : dictA->entries) {
-        entries.emplace_back(entry.first, entry.second.copy());
+        if (entry.interned) {
+            entries.emplace_back(Atom(entry.key), entry.value.copy());
+        } else {
+            entries.emplace_back(entry.key, entry.value.copy());
+        }
     }
 
     sorted = dictA->sorted.load();
+    frozen = false;
+    mutex = nullptr;
+}
+
+Dict::~Dict()
+{
+    delete mutex.load();
 }
 
 Dict *Dict::copy(XRef *xrefA) const
 {
-    dictLocker();
+    // only lock if the dict has been modified since it was frozen
+    std::unique_lock<std::recursive_mutex> locker;
+    if (std::recursive_mutex *m = mutex.load(std::memory_order_acquire)) {
+        locker = std::unique_lock<std::recursive_mutex>(*m);
+    }
     Dict *dictA = new Dict(this);
     dictA->xref = xrefA;
     for (auto &entry : dictA->entries) {
-        if (entry.second.getType() == objDict) {
-            entry.second = Object(entry.second.getDict()->copy(xrefA));
+        if (entry.value.getType() == objDict) {
+            entry.value = Object(entry.value.getDict()->copy(xrefA));
         }
     }
     return dictA;
 }
 
+void Dict::freeze()
+{
+    if (frozen) {
+        return;
+    }
+    if (!sorted && entries.size() >= SORT_LENGTH_LOWER_LIMIT) {
+        std::sort(entries.begin(), entries.end(), CmpDictEntry {});
+        sorted = true;
+    }
+    frozen = true;
+}
+
+std::recursive_mutex &Dict::getMutex() const
+{
+    std::recursive_mutex *m = mutex.load(std::memory_order_acquire);
+    if (!m) {
+        auto *newMutex = new std::recursive_mutex();
+        if (mutex.compare_exchange_strong(m, newMutex, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            m = newMutex;
+        } else {
+            delete newMutex;
+        }
+    }
+    return *m;
+}
+
+std::unique_lock<std::recursive_mutex> Dict::lockForWrite()
+{
+    if (!frozen) {
+        return std::unique_lock<std::recursive_mutex>();
+    }
+    return std::unique_lock<std::recursive_mutex>(getMutex());
+}
+
 void Dict::add(const char *key, Object &&val)
 {
     dictLocker();
@@ -92,11 +174,18 @@ void Dict::add(const char *key, Object &&val)
     sorted = false;
 }
 
-inline const Dict::DictEntry *Dict::find(const char *key) const
+void Dict::add(Atom key, Object &&val)
+{
+    dictLocker();
+    entries.emplace_back(key, std::move(val));
+    sorted = false;
+}
+
+const Dict::DictEntry *Dict::find(Atom atom, const char *key) const
 {
     if (entries.size() >= SORT_LENGTH_LOWER_LIMIT) {
         if (!sorted) {
-            dictLocker();
+            std::unique_lock<std::recursive_mutex> locker(getMutex());
             if (!sorted) {
                 Dict *that = const_cast<Dict *>(this);
 
@@ -108,11 +197,11 @@ inline const Dict::DictEntry *Dict::find(const char *key) const
 
     if (sorted) {
         const auto pos = std::lower_bound(entries.begin(), entries.end(), key, CmpDictEntry {});
-        if (pos != entries.end() && pos->first == key) {
+        if (pos != entries.end() && !strcmp(pos->key, key)) {
             return &*pos;
         }
     } else {
-        const auto pos = std::find_if(entries.rbegin(), entries.rend(), [key](const DictEntry &entry) { return entry.first == key; });
+        const auto pos = std::find_if(entries.rbegin(), entries.rend(), [atom, key](const DictEntry &entry) { return entry.matches(atom, key); });
         if (pos != entries.rend()) {
             return &*pos;
         }
@@ -120,9 +209,9 @@ inline const Dict::DictEntry *Dict::find(const char *key) const
     return nullptr;
 }
 
-inline Dict::DictEntry *Dict::find(const char *key)
+Dict::DictEntry *Dict::find(Atom atom, const char *key)
 {
-    return const_cast<DictEntry *>(const_cast<const Dict *>(this)->find(key));
+    return const_cast<DictEntry *>(const_cast<const Dict *>(this)->find(atom, key));
 }
 
 void Dict::remove(const char *key)
@@ -133,7 +222,7 @@ void Dict::remove(const char *key)
             const auto index = entry - &entries.front();
             entries.erase(entries.begin() + index);
         } else {
-            swap(*entry, entries.back());
+            std::swap(*entry, entries.back());
             entries.pop_back();
         }
     }
@@ -147,7 +236,7 @@ void Dict::set(const char *key, Object &&val)
     }
     dictLocker();
     if (auto *entry = find(key)) {
-        entry->second = std::move(val);
+        entry->value = std::move(val);
     } else {
         add(key, std::move(val));
     }
@@ -155,8 +244,16 @@ void Dict::set(const char *key, Object &&val)
 
 bool Dict::is(const char *type) const
 {
-    if (const auto *entry = find("Type")) {
-        return entry->second.isName(type);
+    if (const auto *entry = find(Atoms::Type, Atoms::Type.c_str())) {
+        return entry->value.isName(type);
+    }
+    return false;
+}
+
+bool Dict::is(Atom type) const
+{
+    if (const auto *entry = find(Atoms::Type, Atoms::Type.c_str())) {
+        return entry->value.isName(type);
     }
     return false;
 }
@@ -164,7 +261,15 @@ bool Dict::is(const char *type) const
 Object Dict::lookup(const char *key, int recursion) const
 {
     if (const auto *entry = find(key)) {
-        return entry->second.fetch(xref, recursion);
+        return entry->value.fetch(xref, recursion);
+    }
+    return Object(objNull);
+}
+
+Object Dict::lookup(Atom key, int recursion) const
+{
+    if (const auto *entry = find(key, key.c_str())) {
+        return entry->value.fetch(xref, recursion);
     }
     return Object(objNull);
 }
@@ -172,12 +277,12 @@ Object Dict::lookup(const char *key, int recursion) const
 Object Dict::lookup(const char *key, Ref *returnRef, int recursion) const
 {
     if (const auto *entry = find(key)) {
-        if (entry->second.getType() == objRef) {
-            *returnRef = entry->second.getRef();
+        if (entry->value.getType() == objRef) {
+            *returnRef = entry->value.getRef();
         } else {
             *returnRef = Ref::INVALID();
         }
-        return entry->second.fetch(xref, recursion);
+        return entry->value.fetch(xref, recursion);
     }
     *returnRef = Ref::INVALID();
     return Object(objNull);
@@ -189,18 +294,27 @@ Object Dict::lookupEnsureEncryptedIfNeeded(const char *key) const
     if (!entry)
         return Object(objNull);
 
-    if (entry->second.getType() == objRef && xref->isEncrypted() && !xref->isRefEncrypted(entry->second.getRef())) {
+    if (entry->value.getType() == objRef && xref->isEncrypted() && !xref->isRefEncrypted(entry->value.getRef())) {
         error(errSyntaxError, -1, "{0:s} is not encrypted and the document is. This may be a hacking attempt", key);
         return Object(objNull);
     }
 
-    return entry->second.fetch(xref);
+    return entry->value.fetch(xref);
 }
 
 const Object &Dict::lookupNF(const char *key) const
 {
     if (const auto *entry = find(key)) {
-        return entry->second;
+        return entry->value;
+    }
+    static Object nullObj(objNull);
+    return nullObj;
+}
+
+const Object &Dict::lookupNF(Atom key) const
+{
+    if (const auto *entry = find(key, key.c_str())) {
+        return entry->value;
     }
     static Object nullObj(objNull);
     return nullObj;
@@ -222,15 +336,20 @@ bool Dict::lookupInt(const char *key, const char *alt_key, int *value) const
 Object Dict::getVal(int i, Ref *returnRef) const
 {
     const DictEntry &entry = entries[i];
-    if (entry.second.getType() == objRef) {
-        *returnRef = entry.second.getRef();
+    if (entry.value.getType() == objRef) {
+        *returnRef = entry.value.getRef();
     } else {
         *returnRef = Ref::INVALID();
     }
-    return entry.second.fetch(xref);
+    return entry.value.fetch(xref);
 }
 
 bool Dict::hasKey(const char *key) const
 {
     return find(key) != nullptr;
 }
+
+bool Dict::hasKey(Atom key) const
+{
+    return find(key, key.c_str()) != nullptr;
+}
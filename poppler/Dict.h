@@ -43,6 +43,11 @@
 // Dict
 //------------------------------------------------------------------------
 
+// A Dict is private to the thread building it until freeze() is
+// called, which the Parser does for every dictionary it reads.  Reads
+// never lock; frozen dicts are sorted up front so that their lookups
+// don't have to, and modifying a frozen dict (as the editing APIs do)
+// takes a mutex, created the first time it's needed.
 class Dict
 {
 public:
@@ -51,12 +56,17 @@ public:
     Dict(const Dict *dictA);
     Dict *copy(XRef *xrefA) const;
 
+    ~Dict();
+
     Dict(const Dict &) = delete;
     Dict &operator=(const Dict &) = delete;
 
     // Get number of entries.
     int getLength() const { return static_cast<int>(entries.size()); }
 
+    // Mark the dict as complete and shared with other threads.
+    void freeze();
+
     // Add an entry. (Copies key into Dict.)
     // val becomes a dead object after the call
     void add(const char *key, Object &&val);
@@ -64,6 +74,10 @@ public:
     // Add an entry. (Takes ownership of key.)
     void add(char *key, Object &&val) = delete;
 
+    // Add an entry whose key is a well known name.
+    // val becomes a dead object after the call
+    void add(Atom key, Object &&val);
+
     // Update the value of an existing entry, otherwise create it
     // val becomes a dead object after the call
     void set(const char *key, Object &&val);
@@ -72,24 +86,29 @@ public:
 
     // Check if dictionary is of specified type.
     bool is(const char *type) const;
+    bool is(Atom type) const;
 
     // Look up an entry and return the value.  Returns a null object
-    // if <key> is not in the dictionary.
+    // if <key> is not in the dictionary.  The Atom overloads skip the
+    // lookup of the key in the atom table, use them with the well
+    // known Atoms.
     Object lookup(const char *key, int recursion = 0) const;
+    Object lookup(Atom key, int recursion = 0) const;
     // Same as above but if the returned object is a fetched Ref returns such Ref in returnRef, otherwise returnRef is Ref::INVALID()
     Object lookup(const char *key, Ref *returnRef, int recursion = 0) const;
     // Look up an entry and return the value.  Returns a null object
     // if <key> is not in the dictionary or if it is a ref to a non encrypted object in a partially encrypted document
     Object lookupEnsureEncryptedIfNeeded(const char *key) const;
     const Object &lookupNF(const char *key) const;
+    const Object &lookupNF(Atom key) const;
     bool lookupInt(const char *key, const char *alt_key, int *value) const;
 
     // Iterative accessors.
-    const char *getKey(int i) const { return entries[i].first.c_str(); }
-    Object getVal(int i) const { return entries[i].second.fetch(xref); }
+    const char *getKey(int i) const { return entries[i].key; }
+    Object getVal(int i) const { return entries[i].value.fetch(xref); }
     // Same as above but if the returned object is a fetched Ref returns such Ref in returnRef, otherwise returnRef is Ref::INVALID()
     Object getVal(int i, Ref *returnRef) const;
-    const Object &getValNF(int i) const { return entries[i].second; }
+    const Object &getValNF(int i) const { return entries[i].value; }
 
     // Set the xref pointer.  This is only used in one special case: the
     // trailer dictionary, which is read before the xref table is
@@ -99,6 +118,7 @@ public:
     XRef *getXRef() const { return xref; }
 
     bool hasKey(const char *key) const;
+    bool hasKey(Atom key) const;
 
 private:
     friend class Object; // for incRef/decRef
@@ -107,17 +127,43 @@ private:
     int incRef() { return ++ref; }
     int decRef() { return --ref; }
 
-    using DictEntry = std::pair<std::string, Object>;
+    // The key of an entry is an Atom when it is a well known name, so that
+    // it is compared by pointer, else a copy of the name.
+    struct DictEntry
+    {
+        DictEntry(const char *keyA, Object &&valueA);
+        DictEntry(Atom keyA, Object &&valueA) : key(keyA.c_str()), interned(true), value(std::move(valueA)) { }
+        DictEntry(DictEntry &&other) noexcept : key(other.key), interned(other.interned), value(std::move(other.value)) { other.key = nullptr; }
+        DictEntry &operator=(DictEntry &&other) noexcept;
+        ~DictEntry();
+
+        DictEntry(const DictEntry &) = delete;
+        DictEntry &operator=(const DictEntry &) = delete;
+
+        // a key equal to a well known name is always its atom
+        bool matches(Atom atom, const char *name) const { return atom ? key == atom.c_str() : !interned && !strcmp(key, name); }
+
+        const char *key;
+        bool interned; // key is an Atom, not owned
+        Object value;
+    };
     struct CmpDictEntry;
 
     XRef *xref; // the xref table for this PDF file
     std::vector<DictEntry> entries;
     std::atomic_int ref; // reference count
     std::atomic_bool sorted;
-    mutable std::recursive_mutex mutex;
+    bool frozen; // visible to other threads
+    mutable std::atomic<std::recursive_mutex *> mutex; // created on first use
+
+    std::recursive_mutex &getMutex() const;
+    std::unique_lock<std::recursive_mutex> lockForWrite();
 
-    const DictEntry *find(const char *key) const;
-    DictEntry *find(const char *key);
+    // <atom> is the atom of <key>, or a null atom if it has none.
+    const DictEntry *find(Atom atom, const char *key) const;
+    DictEntry *find(Atom atom, const char *key);
+    const DictEntry *find(const char *key) const { return find(Atom::find(key), key); }
+    DictEntry *find(const char *key) { return find(Atom::find(key), key); }
 };
 
 #endif
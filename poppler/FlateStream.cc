@@ -85,6 +85,16 @@ int FlateStream::lookChar()
     return out_buf[out_pos];
 }
 
+const unsigned char *FlateStream::getBufferedChars(int *n)
+{
+    if (pred || fill_buffer()) {
+        *n = 0;
+        return NULL;
+    }
+    *n = out_buf_len - out_pos;
+    return out_buf + out_pos;
+}
+
 int FlateStream::fill_buffer()
 {
     /* only fill the buffer if it has all been used */
@@ -45,6 +45,8 @@ public:
     void getRawChars(int nChars, int *buffer) override;
     GooString *getPSFilter(int psLevel, const char *indent) override;
     bool isBinary(bool last = true) override;
+    const unsigned char *getBufferedChars(int *n) override;
+    void skipBufferedChars(int n) override { out_pos += n; }
 
 private:
     inline int doGetRawChar()
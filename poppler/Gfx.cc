@@ -244,7 +244,7 @@ GfxResources::GfxResources(XRef *xrefA, Dict *resDictA, GfxResources *nextA) : g
         // build font dictionary
         Dict *resDict = resDictA->copy(xref);
         fonts = nullptr;
-        const Object &obj1 = resDict->lookupNF("Font");
+        const Object &obj1 = resDict->lookupNF(Atoms::Font);
         if (obj1.isRef()) {
             Object obj2 = obj1.fetch(xref);
             if (obj2.isDict()) {
@@ -256,22 +256,22 @@ GfxResources::GfxResources(XRef *xrefA, Dict *resDictA, GfxResources *nextA) : g
         }
 
         // get XObject dictionary
-        xObjDict = resDict->lookup("XObject");
+        xObjDict = resDict->lookup(Atoms::XObject);
 
         // get color space dictionary
-        colorSpaceDict = resDict->lookup("ColorSpace");
+        colorSpaceDict = resDict->lookup(Atoms::ColorSpace);
 
         // get pattern dictionary
-        patternDict = resDict->lookup("Pattern");
+        patternDict = resDict->lookup(Atoms::Pattern);
 
         // get shading dictionary
-        shadingDict = resDict->lookup("Shading");
+        shadingDict = resDict->lookup(Atoms::Shading);
 
         // get graphics state parameter dictionary
-        gStateDict = resDict->lookup("ExtGState");
+        gStateDict = resDict->lookup(Atoms::ExtGState);
 
         // get properties dictionary
-        propertiesDict = resDict->lookup("Properties");
+        propertiesDict = resDict->lookup(Atoms::Properties);
 
         delete resDict;
     } else {
@@ -477,6 +477,7 @@ Gfx::Gfx(PDFDoc *docA, OutputDev *outA, int pageNum, Dict *resDict, double hDPI,
     fontChanged = false;
     clip = clipNone;
     ignoreUndef = 0;
+    out->setAbortCheckCbk(abortCheckCbkA, abortCheckCbkDataA);
     out->startPage(pageNum, state, xref);
     out->setDefaultCTM(state->getCTM());
     out->updateAll(state);
@@ -605,6 +606,7 @@ Gfx::~Gfx()
     }
     if (!subPage) {
         out->endPage();
+        out->setAbortCheckCbk(nullptr, nullptr);
     }
     // There shouldn't be more saves, but pop them if there were any
     while (state->hasSaves()) {
@@ -3246,6 +3248,9 @@ void Gfx::doGouraudTriangleShFill(GfxGouraudTriangleShading *shading)
         // a relative threshold:
         const double refineColorThreshold = gouraudParameterizedColorDelta * (shading->getParameterDomainMax() - shading->getParameterDomainMin());
         for (i = 0; i < shading->getNTriangles(); ++i) {
+            if ((i & 15) == 0 && out->checkAbort()) {
+                break;
+            }
             shading->getTriangle(i, &x0, &y0, &color0, &x1, &y1, &color1, &x2, &y2, &color2);
             gouraudFillTriangle(x0, y0, color0, x1, y1, color1, x2, y2, color2, refineColorThreshold, 0, shading, reusablePath);
         }
@@ -3259,6 +3264,9 @@ void Gfx::doGouraudTriangleShFill(GfxGouraudTriangleShading *shading)
         // triangle), but in general, it will simply be wrong.
         GfxColor color0, color1, color2;
         for (i = 0; i < shading->getNTriangles(); ++i) {
+            if ((i & 15) == 0 && out->checkAbort()) {
+                break;
+            }
             shading->getTriangle(i, &x0, &y0, &color0, &x1, &y1, &color1, &x2, &y2, &color2);
             gouraudFillTriangle(x0, y0, &color0, x1, y1, &color1, x2, y2, &color2, shading->getColorSpace()->getNComps(), 0, reusablePath);
         }
@@ -3411,6 +3419,9 @@ void Gfx::doPatchMeshShFill(GfxPatchMeshShading *shading)
     }
 
     for (i = 0; i < shading->getNPatches(); ++i) {
+        if ((i & 15) == 0 && out->checkAbort()) {
+            break;
+        }
         fillPatch(shading->getPatch(i), colorComps, shading->isParameterized() ? 1 : colorComps, refineColorThreshold, start, shading);
     }
 }
@@ -4543,7 +4554,7 @@ bool Gfx::checkTransparencyGroup(Dict *resDict)
     if (resDict == nullptr)
         return false;
     pushResources(resDict);
-    Object extGStates = resDict->lookup("ExtGState");
+    Object extGStates = resDict->lookup(Atoms::ExtGState);
     if (extGStates.isDict()) {
         Dict *dict = extGStates.getDict();
         for (int i = 0; i < dict->getLength() && !transpGroup; i++) {
@@ -1755,6 +1755,9 @@ GfxCIDFont::GfxCIDFont(XRef *xref, const char *tagA, Ref idA, GooString *nameA,
     widths.nExcepsV = 0;
     cidToGID = nullptr;
     cidToGIDLen = 0;
+    for (auto &page : charInfo) {
+        page = nullptr;
+    }
 
     // get the descendant font
     obj1 = fontDict->lookup("DescendantFonts");
@@ -1997,14 +2000,18 @@ GfxCIDFont::~GfxCIDFont()
     if (cidToGID) {
         gfree(cidToGID);
     }
+    for (auto &page : charInfo) {
+        delete[] page.load();
+    }
 }
 
 int GfxCIDFont::getNextChar(const char *s, int len, CharCode *code, Unicode const **u, int *uLen, double *dx, double *dy, double *ox, double *oy) const
 {
+    GfxCIDFontCharInfo info1;
+    const GfxCIDFontCharInfo *info;
+    CharCode c;
     CID cid;
-    CharCode dummy;
-    double w, h, vx, vy;
-    int n, a, b, m;
+    int n;
 
     if (!cMap) {
         *code = 0;
@@ -2013,33 +2020,107 @@ int GfxCIDFont::getNextChar(const char *s, int len, CharCode *code, Unicode cons
         return 1;
     }
 
-    *code = (CharCode)(cid = cMap->getCID(s, len, &dummy, &n));
-    if (ctu) {
-        if (hasToUnicode) {
-            int i = 0, c = 0;
-            while (i < n) {
-                c = (c << 8) + (s[i] & 0xff);
-                ++i;
-            }
-            *uLen = ctu->mapToUnicode(c, u);
+    cid = cMap->getCID(s, len, &c, &n);
+    if (!(info = getCharInfo(c, n))) {
+        fillCharInfo(c, n, cid, &info1);
+        info = &info1;
+    }
+
+    *code = (CharCode)info->cid;
+    *u = info->u;
+    *uLen = info->uLen;
+    *dx = info->dx;
+    *dy = info->dy;
+    *ox = info->ox;
+    *oy = info->oy;
+
+    return n;
+}
+
+const GfxCIDFontCharInfo *GfxCIDFont::getCharInfo(CharCode c, int nBytes) const
+{
+    GfxCIDFontCharInfo *page, *expected;
+    int pageIdx;
+
+    if (nBytes == 1) {
+        pageIdx = gfxCIDFontCharInfoPages - 1;
+    } else if (nBytes == 2) {
+        pageIdx = c >> 8;
+    } else {
+        return nullptr;
+    }
+    if (!(page = charInfo[pageIdx].load(std::memory_order_acquire))) {
+        // several threads may build the same page; keep the first one
+        page = buildCharInfoPage(pageIdx);
+        expected = nullptr;
+        if (!charInfo[pageIdx].compare_exchange_strong(expected, page, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            delete[] page;
+            page = expected;
+        }
+    }
+    page += c & 0xff;
+    return page->nBytes == nBytes ? page : nullptr;
+}
+
+GfxCIDFontCharInfo *GfxCIDFont::buildCharInfoPage(int pageIdx) const
+{
+    GfxCIDFontCharInfo *page;
+    char buf[2];
+    CharCode c;
+    CID cid;
+    int len, n;
+
+    page = new GfxCIDFontCharInfo[256];
+    for (int i = 0; i < 256; ++i) {
+        if (pageIdx == gfxCIDFontCharInfoPages - 1) {
+            buf[0] = (char)i;
+            len = 1;
         } else {
-            *uLen = ctu->mapToUnicode(cid, u);
+            buf[0] = (char)pageIdx;
+            buf[1] = (char)i;
+            len = 2;
+        }
+        cid = cMap->getCID(buf, len, &c, &n);
+        if (n != len) {
+            // a shorter code: it is looked up in its own page
+            page[i].nBytes = 0;
+            continue;
+        }
+        fillCharInfo(c, n, cid, &page[i]);
+        // the pointers returned by CharCodeToUnicode::mapToUnicode for
+        // single chars may refer to scratch storage
+        if (page[i].uLen == 1) {
+            page[i].uChar = *page[i].u;
+            page[i].u = &page[i].uChar;
         }
+    }
+    return page;
+}
+
+void GfxCIDFont::fillCharInfo(CharCode c, int nBytes, CID cid, GfxCIDFontCharInfo *info) const
+{
+    int a, b, m;
+
+    info->nBytes = nBytes;
+    info->cid = cid;
+    info->u = nullptr;
+    if (ctu) {
+        info->uLen = ctu->mapToUnicode(hasToUnicode ? c : cid, &info->u);
     } else {
-        *uLen = 0;
+        info->uLen = 0;
     }
 
     // horizontal
     if (cMap->getWMode() == 0) {
-        w = getWidth(cid);
-        h = vx = vy = 0;
+        info->dx = getWidth(cid);
+        info->dy = info->ox = info->oy = 0;
 
         // vertical
     } else {
-        w = 0;
-        h = widths.defHeight;
-        vx = getWidth(cid) / 2;
-        vy = widths.defVY;
+        info->dx = 0;
+        info->dy = widths.defHeight;
+        info->ox = getWidth(cid) / 2;
+        info->oy = widths.defVY;
         if (widths.nExcepsV > 0 && cid >= widths.excepsV[0].first) {
             a = 0;
             b = widths.nExcepsV;
@@ -2053,19 +2134,12 @@ int GfxCIDFont::getNextChar(const char *s, int len, CharCode *code, Unicode cons
                 }
             }
             if (cid <= widths.excepsV[a].last) {
-                h = widths.excepsV[a].height;
-                vx = widths.excepsV[a].vx;
-                vy = widths.excepsV[a].vy;
+                info->dy = widths.excepsV[a].height;
+                info->ox = widths.excepsV[a].vx;
+                info->oy = widths.excepsV[a].vy;
             }
         }
     }
-
-    *dx = w;
-    *dy = h;
-    *ox = vx;
-    *oy = vy;
-
-    return n;
 }
 
 int GfxCIDFont::getWMode()
@@ -33,6 +33,8 @@
 #ifndef GFXFONT_H
 #define GFXFONT_H
 
+#include <atomic>
+
 #include "goo/GooString.h"
 #include "Object.h"
 #include "CharTypes.h"
@@ -43,6 +45,7 @@ class CharCodeToUnicode;
 class FoFiTrueType;
 class PSOutputDev;
 struct GfxFontCIDWidths;
+struct GfxCIDFontCharInfo;
 struct Base14FontMapEntry;
 class FNVHash;
 
@@ -99,6 +102,26 @@ struct GfxFontCIDWidths
     int nExcepsV; // number of valid entries in excepsV
 };
 
+//------------------------------------------------------------------------
+// GfxCIDFontCharInfo
+//------------------------------------------------------------------------
+
+// What GfxCIDFont::getNextChar returns for a 1- or 2-byte char code.
+struct GfxCIDFontCharInfo
+{
+    int nBytes; // length of the code, 0 if this entry can't be used
+    CID cid;
+    const Unicode *u; // Unicode mapping, points to uChar if uLen is 1
+    int uLen;
+    Unicode uChar;
+    double dx, dy; // char width/height
+    double ox, oy; // origin offset
+};
+
+// The char info tables are split in pages of 256 codes: one per high
+// byte of the 2-byte codes, plus one for the 1-byte codes.
+#define gfxCIDFontCharInfoPages 257
+
 //------------------------------------------------------------------------
 // GfxFontLoc
 //------------------------------------------------------------------------
@@ -425,6 +448,13 @@ private:
     int mapCodeToGID(FoFiTrueType *ff, int cmapi, Unicode unicode, bool wmode);
     double getWidth(CID cid) const; // Get width of a character.
 
+    // Look up the char info for the <nBytes>-byte code <c>, building
+    // its table page on first use.  Returns NULL if the code is not
+    // covered by the tables.
+    const GfxCIDFontCharInfo *getCharInfo(CharCode c, int nBytes) const;
+    GfxCIDFontCharInfo *buildCharInfoPage(int page) const;
+    void fillCharInfo(CharCode c, int nBytes, CID cid, GfxCIDFontCharInfo *info) const;
+
     GooString *collection; // collection name
     CMap *cMap; // char code --> CID
     CharCodeToUnicode *ctu; // CID --> Unicode
@@ -434,6 +464,8 @@ private:
     int *cidToGID; // CID --> GID mapping (for embedded
                    //   TrueType fonts)
     int cidToGIDLen;
+    mutable std::atomic<GfxCIDFontCharInfo *> // char info tables, built
+            charInfo[gfxCIDFontCharInfoPages]; //   lazily by getCharInfo
 };
 
 //------------------------------------------------------------------------
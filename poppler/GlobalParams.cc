@@ -52,7 +52,9 @@
 
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <cctype>
+#include <sys/stat.h>
 #ifdef _WIN32
 #    include <shlobj.h>
 #    include <mbstring.h>
@@ -62,6 +64,7 @@
 #include "goo/GooString.h"
 #include "goo/gfile.h"
 #include "goo/gdir.h"
+#include "goo/grandom.h"
 #include "Error.h"
 #include "NameToCharCode.h"
 #include "CharCodeToUnicode.h"
@@ -91,8 +94,9 @@
 
 //------------------------------------------------------------------------
 
-#define cidToUnicodeCacheSize 4
-#define unicodeToUnicodeCacheSize 4
+// memory budgets for the CharCodeToUnicode caches
+#define cidToUnicodeCacheMaxBytes (4 * 1024 * 1024)
+#define unicodeToUnicodeCacheMaxBytes (1024 * 1024)
 
 //------------------------------------------------------------------------
 
@@ -366,6 +370,225 @@ const SysFontInfo *SysFontList::find(const GooString *name, bool fixedWidth, boo
     return fi;
 }
 
+//------------------------------------------------------------------------
+// FontMatchCache
+//------------------------------------------------------------------------
+
+// The result of matching a non-embedded font with the system fonts.
+struct SysFontMatch
+{
+    std::string path; // empty if no font matched
+    SysFontType type = sysFontTTF;
+    int fontNum = 0;
+    bool bold = false;
+    bool italic = false;
+    bool oblique = false;
+    std::string substituteName;
+};
+
+// A cache of system font matches, persisted in a file so that it can
+// be shared by later processes.  The file records a stamp of the font
+// configuration it was built with, and is ignored if the stamp doesn't
+// match the current one.
+class FontMatchCache
+{
+public:
+    explicit FontMatchCache(const std::string &pathA) : path(pathA), stamp(0), loaded(false), dirty(false) { }
+    FontMatchCache(const FontMatchCache &) = delete;
+    FontMatchCache &operator=(const FontMatchCache &) = delete;
+
+    bool isLoaded() const { return loaded; }
+
+    // Read the cache file, if it was written with <stampA>.
+    void load(unsigned long long stampA);
+
+    const SysFontMatch *find(const std::string &key) const;
+    void add(const std::string &key, const SysFontMatch &match);
+
+    // Write the cache file, if matches were added since it was read.
+    bool save();
+
+private:
+    bool readFile(std::unordered_map<std::string, SysFontMatch> *matchesA) const;
+
+    std::string path;
+    unsigned long long stamp;
+    bool loaded;
+    bool dirty;
+    std::unordered_map<std::string, SysFontMatch> matches;
+};
+
+static void fontMatchCacheEscape(const std::string &in, std::string *out)
+{
+    for (char c : in) {
+        if (c == '\\') {
+            out->append("\\\\");
+        } else if (c == '\t') {
+            out->append("\\t");
+        } else if (c == '\n') {
+            out->append("\\n");
+        } else {
+            out->push_back(c);
+        }
+    }
+}
+
+// Split a cache file line into its tab separated, unescaped fields.
+static std::vector<std::string> fontMatchCacheSplit(const std::string &line)
+{
+    std::vector<std::string> fields(1);
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (c == '\t') {
+            fields.emplace_back();
+        } else if (c == '\\' && i + 1 < line.size()) {
+            const char c2 = line[++i];
+            fields.back().push_back(c2 == 't' ? '\t' : c2 == 'n' ? '\n' : c2);
+        } else {
+            fields.back().push_back(c);
+        }
+    }
+    return fields;
+}
+
+bool FontMatchCache::readFile(std::unordered_map<std::string, SysFontMatch> *matchesA) const
+{
+    char buf[1024];
+    std::string line;
+    bool headerOk = false;
+
+    FILE *f = openFile(path.c_str(), "r");
+    if (!f) {
+        return false;
+    }
+    while (fgets(buf, sizeof(buf), f)) {
+        line.append(buf);
+        if (line.back() != '\n' && !feof(f)) {
+            continue;
+        }
+        if (line.back() == '\n') {
+            line.pop_back();
+        }
+        const std::vector<std::string> fields = fontMatchCacheSplit(line);
+        line.clear();
+        if (!headerOk) {
+            // first line: magic and stamp
+            if (fields.size() != 2 || fields[0] != "poppler-font-match-cache-1" || strtoull(fields[1].c_str(), nullptr, 16) != stamp) {
+                break;
+            }
+            headerOk = true;
+        } else if (fields.size() == 8) {
+            SysFontMatch match;
+            const int type = atoi(fields[2].c_str());
+            if (type < sysFontPFA || type > sysFontTTC) {
+                continue;
+            }
+            match.path = fields[1];
+            match.type = (SysFontType)type;
+            match.fontNum = atoi(fields[3].c_str());
+            match.bold = fields[4] == "1";
+            match.italic = fields[5] == "1";
+            match.oblique = fields[6] == "1";
+            match.substituteName = fields[7];
+            matchesA->emplace(fields[0], std::move(match));
+        }
+    }
+    fclose(f);
+    return headerOk;
+}
+
+void FontMatchCache::load(unsigned long long stampA)
+{
+    stamp = stampA;
+    loaded = true;
+    readFile(&matches);
+}
+
+const SysFontMatch *FontMatchCache::find(const std::string &key) const
+{
+    const auto match = matches.find(key);
+    return match == matches.end() ? nullptr : &match->second;
+}
+
+void FontMatchCache::add(const std::string &key, const SysFontMatch &match)
+{
+    matches[key] = match;
+    dirty = true;
+}
+
+bool FontMatchCache::save()
+{
+    unsigned char rnd[8];
+    std::string data;
+    char buf[32];
+
+    if (!dirty) {
+        return true;
+    }
+
+    // keep the matches other processes may have saved in the meantime,
+    // and don't rewrite the file if it already has all of ours
+    std::unordered_map<std::string, SysFontMatch> saved;
+    if (readFile(&saved)) {
+        bool added = false;
+        for (const auto &entry : matches) {
+            if (saved.find(entry.first) == saved.end()) {
+                added = true;
+                break;
+            }
+        }
+        for (auto &entry : saved) {
+            matches.emplace(entry.first, std::move(entry.second));
+        }
+        if (!added) {
+            dirty = false;
+            return true;
+        }
+    }
+
+    snprintf(buf, sizeof(buf), "%llx", stamp);
+    data.append("poppler-font-match-cache-1\t").append(buf).append("\n");
+    for (const auto &entry : matches) {
+        const SysFontMatch &match = entry.second;
+        fontMatchCacheEscape(entry.first, &data);
+        data.push_back('\t');
+        fontMatchCacheEscape(match.path, &data);
+        snprintf(buf, sizeof(buf), "\t%d\t%d\t%d\t%d\t%d\t", (int)match.type, match.fontNum, match.bold ? 1 : 0, match.italic ? 1 : 0, match.oblique ? 1 : 0);
+        data.append(buf);
+        fontMatchCacheEscape(match.substituteName, &data);
+        data.push_back('\n');
+    }
+
+    // write to a temporary file, then move it over the cache file, so
+    // that concurrent readers never see a partial file
+    grandom_fill(rnd, sizeof(rnd));
+    std::string tmpPath = path + ".";
+    for (unsigned char c : rnd) {
+        snprintf(buf, sizeof(buf), "%02x", c);
+        tmpPath.append(buf);
+    }
+    FILE *f = openFile(tmpPath.c_str(), "wb");
+    if (!f) {
+        error(errIO, -1, "Couldn't write font match cache file '{0:s}'", tmpPath.c_str());
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+    if (ok && rename(tmpPath.c_str(), path.c_str()) != 0) {
+        // rename doesn't replace existing files on Windows
+        remove(path.c_str());
+        ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        remove(tmpPath.c_str());
+        error(errIO, -1, "Couldn't write font match cache file '{0:s}'", path.c_str());
+        return false;
+    }
+    dirty = false;
+    return true;
+}
+
 #define globalParamsLocker() std::unique_lock<std::recursive_mutex> locker(mutex)
 #define unicodeMapCacheLocker() std::unique_lock<std::recursive_mutex> locker(unicodeMapCacheMutex)
 #define cMapCacheLocker() std::unique_lock<std::recursive_mutex> locker(cMapCacheMutex)
@@ -389,6 +612,12 @@ GlobalParams::GlobalParams(const char *customPopplerDataDir) : popplerDataDir(cu
     nameToUnicodeText = new NameToCharCode();
     toUnicodeDirs = new std::vector<GooString *>();
     sysFonts = new SysFontList();
+    fontMatchCache = nullptr;
+    if (const char *fontMatchCachePath = getenv("POPPLER_FONT_MATCH_CACHE")) {
+        if (fontMatchCachePath[0]) {
+            fontMatchCache = new FontMatchCache(fontMatchCachePath);
+        }
+    }
     psExpandSmaller = false;
     psShrinkLarger = true;
     textEncoding = new GooString("UTF-8");
@@ -397,8 +626,8 @@ GlobalParams::GlobalParams(const char *customPopplerDataDir) : popplerDataDir(cu
     profileCommands = false;
     errQuiet = false;
 
-    cidToUnicodeCache = new CharCodeToUnicodeCache(cidToUnicodeCacheSize);
-    unicodeToUnicodeCache = new CharCodeToUnicodeCache(unicodeToUnicodeCacheSize);
+    cidToUnicodeCache = new CharCodeToUnicodeCache(cidToUnicodeCacheMaxBytes);
+    unicodeToUnicodeCache = new CharCodeToUnicodeCache(unicodeToUnicodeCacheMaxBytes);
     unicodeMapCache = new UnicodeMapCache();
     cMapCache = new CMapCache();
 
@@ -547,6 +776,10 @@ GlobalParams::~GlobalParams()
     }
     delete toUnicodeDirs;
     delete sysFonts;
+    if (fontMatchCache) {
+        fontMatchCache->save();
+        delete fontMatchCache;
+    }
     delete textEncoding;
 
     delete cidToUnicodeCache;
@@ -870,6 +1103,138 @@ GooString *GlobalParams::findBase14FontFile(const GooString *base14Name, const G
     return findSystemFontFile(font, &type, &fontNum, nullptr, base14Name);
 }
 
+// Stamp of the fontconfig configuration: changes whenever fontconfig,
+// its configuration files, font directories or caches change.
+static unsigned long long getFcConfigStamp()
+{
+    unsigned long long h = 0xcbf29ce484222325ULL; // 64-bit FNV-1a
+    auto hash = [&h](const void *buf, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            h = (h ^ ((const unsigned char *)buf)[i]) * 0x100000001b3ULL;
+        }
+    };
+
+    const int version = FcGetVersion();
+    hash(&version, sizeof(version));
+    FcStrList *lists[3] = { FcConfigGetConfigFiles(nullptr), FcConfigGetFontDirs(nullptr), FcConfigGetCacheDirs(nullptr) };
+    for (FcStrList *list : lists) {
+        if (!list) {
+            continue;
+        }
+        while (FcChar8 *name = FcStrListNext(list)) {
+            struct stat st;
+            hash(name, strlen((const char *)name) + 1);
+            if (stat((const char *)name, &st) == 0) {
+                const long long mtime = st.st_mtime;
+                const long long size = st.st_size;
+                hash(&mtime, sizeof(mtime));
+                hash(&size, sizeof(size));
+            }
+        }
+        FcStrListDone(list);
+    }
+    return h;
+}
+
+// Match the pattern <p> built for <font> with the system fonts.
+static void matchFcPattern(FcPattern *p, const GfxFont *font, SysFontMatch *match)
+{
+    FcChar8 *s;
+    char *ext;
+    FcResult res;
+    FcFontSet *set;
+    int i;
+    FcLangSet *lb = nullptr;
+
+    FcConfigSubstitute(nullptr, p, FcMatchPattern);
+    FcDefaultSubstitute(p);
+    set = FcFontSort(nullptr, p, FcFalse, nullptr, &res);
+    if (!set)
+        return;
+
+    // find the language we want the font to support
+    const char *lang = getFontLang(font);
+    if (strcmp(lang, "xx") != 0) {
+        lb = FcLangSetCreate();
+        FcLangSetAdd(lb, (FcChar8 *)lang);
+    }
+
+    /*
+      scan twice.
+      first: fonts support the language
+      second: all fonts (fall back)
+    */
+    while (match->path.empty()) {
+        for (i = 0; i < set->nfont; ++i) {
+            res = FcPatternGetString(set->fonts[i], FC_FILE, 0, &s);
+            if (res != FcResultMatch || !s)
+                continue;
+            if (lb != nullptr) {
+                FcLangSet *l;
+                res = FcPatternGetLangSet(set->fonts[i], FC_LANG, 0, &l);
+                if (res != FcResultMatch || !FcLangSetContains(l, lb)) {
+                    continue;
+                }
+            }
+            FcChar8 *s2;
+            res = FcPatternGetString(set->fonts[i], FC_FULLNAME, 0, &s2);
+            if (res == FcResultMatch && s2) {
+                match->substituteName = (char *)s2;
+            } else {
+                // fontconfig does not extract fullname for some fonts
+                // create the fullname from family and style
+                res = FcPatternGetString(set->fonts[i], FC_FAMILY, 0, &s2);
+                if (res == FcResultMatch && s2) {
+                    match->substituteName = (char *)s2;
+                    res = FcPatternGetString(set->fonts[i], FC_STYLE, 0, &s2);
+                    if (res == FcResultMatch && s2) {
+                        if (strcmp((char *)s2, "Regular") != 0) {
+                            match->substituteName.append(" ");
+                            match->substituteName.append((char *)s2);
+                        }
+                    }
+                }
+            }
+            ext = strrchr((char *)s, '.');
+            if (!ext)
+                continue;
+            if (!strncasecmp(ext, ".ttf", 4) || !strncasecmp(ext, ".ttc", 4)) {
+                match->type = (!strncasecmp(ext, ".ttc", 4)) ? sysFontTTC : sysFontTTF;
+            } else if (!strncasecmp(ext, ".otf", 4)) {
+                match->type = sysFontTTF;
+            } else if (!strncasecmp(ext, ".pfa", 4) || !strncasecmp(ext, ".pfb", 4)) {
+                match->type = (!strncasecmp(ext, ".pfa", 4)) ? sysFontPFA : sysFontPFB;
+            } else
+                continue;
+            int weight, slant;
+            match->bold = font->isBold();
+            match->italic = font->isItalic();
+            match->oblique = false;
+            FcPatternGetInteger(set->fonts[i], FC_WEIGHT, 0, &weight);
+            FcPatternGetInteger(set->fonts[i], FC_SLANT, 0, &slant);
+            if (weight == FC_WEIGHT_DEMIBOLD || weight == FC_WEIGHT_BOLD || weight == FC_WEIGHT_EXTRABOLD || weight == FC_WEIGHT_BLACK) {
+                match->bold = true;
+            }
+            if (slant == FC_SLANT_ITALIC)
+                match->italic = true;
+            if (slant == FC_SLANT_OBLIQUE)
+                match->oblique = true;
+            match->fontNum = 0;
+            FcPatternGetInteger(set->fonts[i], FC_INDEX, 0, &match->fontNum);
+            match->path = (char *)s;
+            break;
+        }
+        if (lb != nullptr) {
+            FcLangSetDestroy(lb);
+            lb = nullptr;
+        } else {
+            /* scan all fonts of the list */
+            break;
+        }
+    }
+    FcFontSetDestroy(set);
+}
+
 GooString *GlobalParams::findSystemFontFile(const GfxFont *font, SysFontType *type, int *fontNum, GooString *substituteFontName, const GooString *base14Name)
 {
     const SysFontInfo *fi = nullptr;
@@ -888,125 +1253,45 @@ GooString *GlobalParams::findSystemFontFile(const GfxFont *font, SysFontType *ty
         *fontNum = fi->fontNum;
         substituteName.Set(fi->substituteName->c_str());
     } else {
-        FcChar8 *s;
-        char *ext;
-        FcResult res;
-        FcFontSet *set;
-        int i;
-        FcLangSet *lb = nullptr;
+        SysFontMatch match;
+        const SysFontMatch *cachedMatch = nullptr;
+        std::string cacheKey;
         p = buildFcPattern(font, base14Name);
 
         if (!p)
             goto fin;
-        FcConfigSubstitute(nullptr, p, FcMatchPattern);
-        FcDefaultSubstitute(p);
-        set = FcFontSort(nullptr, p, FcFalse, nullptr, &res);
-        if (!set)
-            goto fin;
-
-        // find the language we want the font to support
-        const char *lang = getFontLang(font);
-        if (strcmp(lang, "xx") != 0) {
-            lb = FcLangSetCreate();
-            FcLangSetAdd(lb, (FcChar8 *)lang);
-        }
 
-        /*
-          scan twice.
-          first: fonts support the language
-          second: all fonts (fall back)
-        */
-        while (fi == nullptr) {
-            for (i = 0; i < set->nfont; ++i) {
-                res = FcPatternGetString(set->fonts[i], FC_FILE, 0, &s);
-                if (res != FcResultMatch || !s)
-                    continue;
-                if (lb != nullptr) {
-                    FcLangSet *l;
-                    res = FcPatternGetLangSet(set->fonts[i], FC_LANG, 0, &l);
-                    if (res != FcResultMatch || !FcLangSetContains(l, lb)) {
-                        continue;
-                    }
-                }
-                FcChar8 *s2;
-                res = FcPatternGetString(set->fonts[i], FC_FULLNAME, 0, &s2);
-                if (res == FcResultMatch && s2) {
-                    substituteName.Set((char *)s2);
-                } else {
-                    // fontconfig does not extract fullname for some fonts
-                    // create the fullname from family and style
-                    res = FcPatternGetString(set->fonts[i], FC_FAMILY, 0, &s2);
-                    if (res == FcResultMatch && s2) {
-                        substituteName.Set((char *)s2);
-                        res = FcPatternGetString(set->fonts[i], FC_STYLE, 0, &s2);
-                        if (res == FcResultMatch && s2) {
-                            GooString *style = new GooString((char *)s2);
-                            if (style->cmp("Regular") != 0) {
-                                substituteName.append(" ");
-                                substituteName.append(style);
-                            }
-                            delete style;
-                        }
-                    }
-                }
-                ext = strrchr((char *)s, '.');
-                if (!ext)
-                    continue;
-                if (!strncasecmp(ext, ".ttf", 4) || !strncasecmp(ext, ".ttc", 4) || !strncasecmp(ext, ".otf", 4)) {
-                    int weight, slant;
-                    bool bold = font->isBold();
-                    bool italic = font->isItalic();
-                    bool oblique = false;
-                    FcPatternGetInteger(set->fonts[i], FC_WEIGHT, 0, &weight);
-                    FcPatternGetInteger(set->fonts[i], FC_SLANT, 0, &slant);
-                    if (weight == FC_WEIGHT_DEMIBOLD || weight == FC_WEIGHT_BOLD || weight == FC_WEIGHT_EXTRABOLD || weight == FC_WEIGHT_BLACK) {
-                        bold = true;
-                    }
-                    if (slant == FC_SLANT_ITALIC)
-                        italic = true;
-                    if (slant == FC_SLANT_OBLIQUE)
-                        oblique = true;
-                    *fontNum = 0;
-                    *type = (!strncasecmp(ext, ".ttc", 4)) ? sysFontTTC : sysFontTTF;
-                    FcPatternGetInteger(set->fonts[i], FC_INDEX, 0, fontNum);
-                    SysFontInfo *sfi = new SysFontInfo(fontName->copy(), bold, italic, oblique, font->isFixedWidth(), new GooString((char *)s), *type, *fontNum, substituteName.copy());
-                    sysFonts->addFcFont(sfi);
-                    fi = sfi;
-                    path = new GooString((char *)s);
-                } else if (!strncasecmp(ext, ".pfa", 4) || !strncasecmp(ext, ".pfb", 4)) {
-                    int weight, slant;
-                    bool bold = font->isBold();
-                    bool italic = font->isItalic();
-                    bool oblique = false;
-                    FcPatternGetInteger(set->fonts[i], FC_WEIGHT, 0, &weight);
-                    FcPatternGetInteger(set->fonts[i], FC_SLANT, 0, &slant);
-                    if (weight == FC_WEIGHT_DEMIBOLD || weight == FC_WEIGHT_BOLD || weight == FC_WEIGHT_EXTRABOLD || weight == FC_WEIGHT_BLACK) {
-                        bold = true;
-                    }
-                    if (slant == FC_SLANT_ITALIC)
-                        italic = true;
-                    if (slant == FC_SLANT_OBLIQUE)
-                        oblique = true;
-                    *fontNum = 0;
-                    *type = (!strncasecmp(ext, ".pfa", 4)) ? sysFontPFA : sysFontPFB;
-                    FcPatternGetInteger(set->fonts[i], FC_INDEX, 0, fontNum);
-                    SysFontInfo *sfi = new SysFontInfo(fontName->copy(), bold, italic, oblique, font->isFixedWidth(), new GooString((char *)s), *type, *fontNum, substituteName.copy());
-                    sysFonts->addFcFont(sfi);
-                    fi = sfi;
-                    path = new GooString((char *)s);
-                } else
-                    continue;
-                break;
+        // the unsubstituted pattern, plus the font flags that are
+        // applied to the match, fully determine the result
+        if (fontMatchCache) {
+            if (!fontMatchCache->isLoaded()) {
+                fontMatchCache->load(getFcConfigStamp());
             }
-            if (lb != nullptr) {
-                FcLangSetDestroy(lb);
-                lb = nullptr;
-            } else {
-                /* scan all fonts of the list */
-                break;
+            FcChar8 *patternName = FcNameUnparse(p);
+            if (patternName) {
+                cacheKey = (char *)patternName;
+                free(patternName);
+                cacheKey.append(font->isBold() ? ":B" : ":-").append(font->isItalic() ? "I" : "-");
+                cachedMatch = fontMatchCache->find(cacheKey);
             }
         }
-        FcFontSetDestroy(set);
+        if (cachedMatch) {
+            match = *cachedMatch;
+        } else {
+            matchFcPattern(p, font, &match);
+            if (!cacheKey.empty()) {
+                fontMatchCache->add(cacheKey, match);
+            }
+        }
+        substituteName.Set(match.substituteName.c_str());
+        if (!match.path.empty()) {
+            *type = match.type;
+            *fontNum = match.fontNum;
+            SysFontInfo *sfi = new SysFontInfo(fontName->copy(), match.bold, match.italic, match.oblique, font->isFixedWidth(), new GooString(match.path), match.type, match.fontNum, substituteName.copy());
+            sysFonts->addFcFont(sfi);
+            fi = sfi;
+            path = new GooString(match.path);
+        }
     }
     if (path == nullptr && (fi = sysFonts->find(fontName, font->isFixedWidth(), false))) {
         path = fi->path->copy();
@@ -1271,6 +1556,22 @@ void GlobalParams::setErrQuiet(bool errQuietA)
     errQuiet = errQuietA;
 }
 
+void GlobalParams::setFontMatchCacheFile(const char *path)
+{
+    globalParamsLocker();
+    if (fontMatchCache) {
+        fontMatchCache->save();
+        delete fontMatchCache;
+    }
+    fontMatchCache = (path && path[0]) ? new FontMatchCache(path) : nullptr;
+}
+
+bool GlobalParams::saveFontMatchCache()
+{
+    globalParamsLocker();
+    return fontMatchCache ? fontMatchCache->save() : true;
+}
+
 GlobalParamsIniter::GlobalParamsIniter(ErrorCallback errorCallback)
 {
     std::lock_guard<std::mutex> lock { mutex };
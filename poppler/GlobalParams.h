@@ -60,6 +60,7 @@ class GlobalParams;
 class GfxFont;
 class Stream;
 class SysFontList;
+class FontMatchCache;
 
 //------------------------------------------------------------------------
 
@@ -137,6 +138,22 @@ public:
     void setProfileCommands(bool profileCommandsA);
     void setErrQuiet(bool errQuietA);
 
+    // Keep the results of the fontconfig font matching done by
+    // findSystemFontFile in the file <path>, so that later processes
+    // can reuse them instead of matching again.  The file is read on
+    // first use, and ignored if the fontconfig configuration, font
+    // directories or caches changed since it was written.  New matches
+    // are written back by saveFontMatchCache, which is also called when
+    // GlobalParams is destroyed or the cache file is changed; the file is
+    // only rewritten if matches missing from it were found since it was
+    // read.  A nullptr or empty <path> disables the cache.  The
+    // POPPLER_FONT_MATCH_CACHE environment variable sets the initial
+    // cache file.  To pre-warm the cache, scan the fonts of typical
+    // documents (e.g. with FontInfoScanner, as pdffonts does) and save
+    // it.
+    void setFontMatchCacheFile(const char *path);
+    bool saveFontMatchCache();
+
     static bool parseYesNo2(const char *token, bool *flag);
 
 private:
@@ -178,6 +195,7 @@ private:
     // font files: font name mapped to path
     std::unordered_map<std::string, std::string> fontFiles;
     SysFontList *sysFonts; // system fonts
+    FontMatchCache *fontMatchCache; // persistent cache of font matches
     bool psExpandSmaller; // expand smaller pages to fill paper
     bool psShrinkLarger; // shrink larger pages to fit paper
     GooString *textEncoding; // encoding (unicodeMap) to use for text
@@ -0,0 +1,295 @@
+//========================================================================
+//
+// ImagePrefetcher.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "Lexer.h"
+#include "PDFDoc.h"
+#include "Page.h"
+#include "Parser.h"
+#include "Stream.h"
+#include "XRef.h"
+#include "ImagePrefetcher.h"
+
+// the images smaller than this are decoded faster than they are queued
+static constexpr int minPrefetchedPixels = 64 * 64;
+
+// the depth of the forms whose images are prefetched
+static constexpr int maxFormDepth = 16;
+
+//------------------------------------------------------------------------
+// DecodedImageStream
+//------------------------------------------------------------------------
+
+// A stream reading a decoded image, which keeps its data alive.
+class DecodedImageStream : public BaseMemStream<const char>
+{
+public:
+    DecodedImageStream(const std::shared_ptr<const std::vector<char>> &dataA, Goffset startA, Goffset lengthA, Object &&dictA) : BaseMemStream(dataA->data(), startA, lengthA, std::move(dictA)), data(dataA) { }
+
+    BaseStream *copy() override { return new DecodedImageStream(data, getStart(), getLength(), dict.copy()); }
+
+    Stream *makeSubStream(Goffset startA, bool limited, Goffset lengthA, Object &&dictA) override
+    {
+        Goffset end = getStart() + getLength();
+        if (limited && startA + lengthA < end) {
+            end = startA + lengthA;
+        }
+        return new DecodedImageStream(data, startA, end - startA, std::move(dictA));
+    }
+
+private:
+    std::shared_ptr<const std::vector<char>> data;
+};
+
+//------------------------------------------------------------------------
+// ImagePrefetcher
+//------------------------------------------------------------------------
+
+ImagePrefetcher::ImagePrefetcher(PDFDoc *docA, int nThreads, size_t maxBytesA)
+{
+    doc = docA;
+    maxBytes = maxBytesA;
+    curBytes = 0;
+    stopping = false;
+
+    // a cached file is read through a cache which isn't shared by threads
+    if (doc->getBaseStream()->getKind() == strCachedFile) {
+        nThreads = 0;
+    }
+    for (int i = 0; i < nThreads; ++i) {
+        workers.emplace_back([this] { runWorker(); });
+    }
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queueCond.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+// Return the size of the decoded data of an image with the dict <dict>,
+// guessing its number of components from the name of its color space.
+static size_t decodedSizeEstimate(Dict *dict)
+{
+    Object width = dict->lookup("Width");
+    Object height = dict->lookup("Height");
+    Object bpc = dict->lookup("BitsPerComponent");
+    Object imageMask = dict->lookup("ImageMask");
+    Object colorSpace = dict->lookup("ColorSpace");
+    if (!width.isInt() || !height.isInt() || width.getInt() <= 0 || height.getInt() <= 0) {
+        return 0;
+    }
+    int bits = bpc.isInt() && bpc.getInt() > 0 && bpc.getInt() <= 16 ? bpc.getInt() : 8;
+    if (imageMask.isBool() && imageMask.getBool()) {
+        bits = 1;
+    } else if (colorSpace.isName("DeviceCMYK")) {
+        bits *= 4;
+    } else if (!colorSpace.isName("DeviceGray") && !colorSpace.isName("Indexed")) {
+        bits *= 3;
+    }
+    return (size_t)(((long long)width.getInt() * bits + 7) / 8) * height.getInt();
+}
+
+// Skip the data of an inline image up to its EI operator, a whitespace
+// delimited "EI" as the data isn't decoded.
+static void skipInlineImage(Stream *str)
+{
+    int c0 = ' ', c1 = str->getChar(), c2 = str->getChar();
+    while (c2 != EOF) {
+        const int c3 = str->getChar();
+        if (c1 == 'E' && c2 == 'I' && Lexer::isSpace(c0) && (c3 == EOF || Lexer::isSpace(c3))) {
+            return;
+        }
+        c0 = c1;
+        c1 = c2;
+        c2 = c3;
+    }
+}
+
+static void scanContent(XRef *xref, Object *contents, Dict *resDict, std::unordered_set<Ref> *visited, std::vector<Ref> *images, int depth);
+
+// Add the XObject <ref> to <images> if it is a large image, or the images
+// it draws if it is a form with the resources <resDict> of its parent.
+static void scanXObject(XRef *xref, const Object &ref, Dict *resDict, std::unordered_set<Ref> *visited, std::vector<Ref> *images, int depth)
+{
+    if (!ref.isRef() || !visited->insert(ref.getRef()).second) {
+        return;
+    }
+    Object xObj = xref->fetch(ref.getRef());
+    if (!xObj.isStream()) {
+        return;
+    }
+    Dict *dict = xObj.streamGetDict();
+    Object subtype = dict->lookup("Subtype");
+    if (subtype.isName("Image")) {
+        Object width = dict->lookup("Width");
+        Object height = dict->lookup("Height");
+        if (width.isInt() && height.isInt() && width.getInt() > 0 && height.getInt() > 0 && (double)width.getInt() * height.getInt() >= minPrefetchedPixels) {
+            images->push_back(ref.getRef());
+        }
+    } else if (subtype.isName("Form") && depth < maxFormDepth) {
+        // a form without resources uses those of its parent
+        Object formRes = dict->lookup("Resources");
+        scanContent(xref, &xObj, formRes.isDict() ? formRes.getDict() : resDict, visited, images, depth + 1);
+    }
+}
+
+// Add the large images drawn by the Do operators of the content stream(s)
+// <contents> with the resources <resDict>, and by the forms they draw, to
+// <images>, in the order they are drawn.  The other XObjects of the
+// resources, which may be shared by all the pages, are left out.
+static void scanContent(XRef *xref, Object *contents, Dict *resDict, std::unordered_set<Ref> *visited, std::vector<Ref> *images, int depth)
+{
+    if (!resDict || (!contents->isStream() && !contents->isArray())) {
+        return;
+    }
+    Object xObjDict = resDict->lookup("XObject");
+    if (!xObjDict.isDict()) {
+        return;
+    }
+    Parser parser(xref, contents, false);
+    Object operand;
+    for (Object obj = parser.getObj(); !obj.isEOF(); obj = parser.getObj()) {
+        if (obj.isCmd("Do")) {
+            if (operand.isName()) {
+                scanXObject(xref, xObjDict.dictLookupNF(operand.getName()), resDict, visited, images, depth);
+            }
+        } else if (obj.isCmd("ID") && parser.getStream()) {
+            skipInlineImage(parser.getStream());
+        }
+        operand = std::move(obj);
+    }
+}
+
+void ImagePrefetcher::prefetchPage(int pageNum)
+{
+    if (workers.empty()) {
+        return;
+    }
+    Page *page = doc->getPage(pageNum);
+    std::vector<Ref> images;
+    if (page) {
+        Object contents = page->getContents();
+        std::unordered_set<Ref> visited;
+        scanContent(doc->getXRef(), &contents, page->getResourceDict(), &visited, &images, 0);
+    }
+
+    // keep the images of the previous page used again
+    std::unique_lock<std::mutex> lock(mutex);
+    std::unordered_map<Ref, std::shared_ptr<Entry>> oldEntries;
+    oldEntries.swap(entries);
+    for (const std::shared_ptr<Entry> &entry : queue) {
+        entry->state = entryFailed;
+    }
+    queue.clear();
+    curBytes = 0;
+    for (const Ref ref : images) {
+        auto it = oldEntries.find(ref);
+        if (it != oldEntries.end() && (it->second->state == entryDecoding || it->second->state == entryDecoded)) {
+            if (it->second->state == entryDecoded) {
+                curBytes += it->second->data->size();
+            }
+            entries.emplace(ref, it->second);
+        } else {
+            auto entry = std::make_shared<Entry>();
+            entry->ref = ref;
+            entry->state = entryQueued;
+            entries.emplace(ref, entry);
+            queue.push_back(entry);
+        }
+    }
+    lock.unlock();
+    queueCond.notify_all();
+}
+
+Stream *ImagePrefetcher::getDecodedImage(Ref ref, Stream *str)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = entries.find(ref);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    std::shared_ptr<Entry> entry = it->second;
+    if (entry->state == entryQueued) {
+        // the caller decodes it now
+        entry->state = entryFailed;
+        entries.erase(it);
+        return nullptr;
+    }
+    decodedCond.wait(lock, [&entry] { return entry->state != entryDecoding; });
+    if (entry->state != entryDecoded) {
+        return nullptr;
+    }
+    return new DecodedImageStream(entry->data, 0, entry->data->size(), str->getDictObject()->copy());
+}
+
+void ImagePrefetcher::runWorker()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        queueCond.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        std::shared_ptr<Entry> entry = std::move(queue.front());
+        queue.pop_front();
+        if (entry->state != entryQueued) {
+            continue;
+        }
+        entry->state = entryDecoding;
+        const size_t limit = maxBytes - curBytes;
+        lock.unlock();
+        std::shared_ptr<const std::vector<char>> data = decodeImage(entry->ref, limit);
+        lock.lock();
+
+        // the images decoded meanwhile may have used the bytes left, and
+        // the page may have changed
+        auto it = entries.find(entry->ref);
+        if (data && it != entries.end() && it->second == entry && curBytes + data->size() <= maxBytes) {
+            curBytes += data->size();
+            entry->data = std::move(data);
+            entry->state = entryDecoded;
+        } else {
+            entry->state = entryFailed;
+        }
+        decodedCond.notify_all();
+    }
+}
+
+std::shared_ptr<const std::vector<char>> ImagePrefetcher::decodeImage(Ref ref, size_t limit)
+{
+    Object obj = doc->getXRef()->fetch(ref);
+    if (!obj.isStream()) {
+        return nullptr;
+    }
+    Stream *str = obj.getStream();
+    auto data = std::make_shared<std::vector<char>>();
+    data->reserve(std::min(decodedSizeEstimate(str->getDict()), limit));
+    unsigned char buf[16384];
+    int n;
+    str->reset();
+    while ((n = str->doGetChars(sizeof(buf), buf)) > 0) {
+        if (data->size() + n > limit) {
+            str->close();
+            return nullptr;
+        }
+        data->insert(data->end(), buf, buf + n);
+    }
+    str->close();
+    return data;
+}
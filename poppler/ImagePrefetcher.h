@@ -0,0 +1,89 @@
+//========================================================================
+//
+// ImagePrefetcher.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Decoding the images of a page ahead of its rendering.
+//
+//========================================================================
+
+#ifndef IMAGEPREFETCHER_H
+#define IMAGEPREFETCHER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Object.h"
+
+class PDFDoc;
+class Stream;
+
+//------------------------------------------------------------------------
+// ImagePrefetcher
+//------------------------------------------------------------------------
+
+// Decodes the image XObjects of a page in worker threads, while the page
+// is being rendered, so that the output device gets their decoded data
+// instead of decoding them when the content stream draws them.  The
+// images are those the Do operators of the content stream of the page
+// and of its forms draw, decoded in that order.  The workers read the
+// document through its XRef, which is locked during fetches.  The decoded
+// images are kept until the next page is prefetched, up to maxBytes.
+class ImagePrefetcher
+{
+public:
+    ImagePrefetcher(PDFDoc *docA, int nThreads, size_t maxBytesA = 128 * 1024 * 1024);
+    ~ImagePrefetcher();
+
+    ImagePrefetcher(const ImagePrefetcher &) = delete;
+    ImagePrefetcher &operator=(const ImagePrefetcher &) = delete;
+
+    // Start decoding the images of the page <pageNum>, and drop those of
+    // the page prefetched before.
+    void prefetchPage(int pageNum);
+
+    // Return a stream reading the decoded data of the image <ref>, with
+    // the dict of its stream <str>, or nullptr if it hasn't been
+    // prefetched.  Waits for the image if a worker is decoding it.  An
+    // image no worker has started yet is left to the caller.
+    Stream *getDecodedImage(Ref ref, Stream *str);
+
+private:
+    enum EntryState
+    {
+        entryQueued,
+        entryDecoding,
+        entryDecoded,
+        entryFailed
+    };
+
+    struct Entry
+    {
+        Ref ref;
+        EntryState state;
+        std::shared_ptr<const std::vector<char>> data;
+    };
+
+    void runWorker();
+    std::shared_ptr<const std::vector<char>> decodeImage(Ref ref, size_t limit);
+
+    PDFDoc *doc;
+    size_t maxBytes; // byte limit
+    size_t curBytes; // bytes of the decoded images
+    std::unordered_map<Ref, std::shared_ptr<Entry>> entries;
+    std::deque<std::shared_ptr<Entry>> queue;
+    std::vector<std::thread> workers;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable queueCond; // signaled when images are queued
+    std::condition_variable decodedCond; // signaled when an image is decoded
+};
+
+#endif
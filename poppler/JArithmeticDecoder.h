@@ -92,8 +92,18 @@ public:
     // Read any leftover data in the stream.
     void cleanup();
 
-    // Decode one bit.
-    int decodeBit(unsigned int context, JArithmeticDecoderStats *stats);
+    // Decode one bit.  The common case (MPS without renormalization) is
+    // handled inline.
+    int decodeBit(unsigned int context, JArithmeticDecoderStats *stats)
+    {
+        const unsigned int cx = stats->cxTab[context];
+        const unsigned int aNew = a - qeTab[cx >> 1];
+        if (c < aNew && (aNew & 0x80000000)) {
+            a = aNew;
+            return cx & 1;
+        }
+        return decodeBitSlow(context, stats);
+    }
 
     // Decode eight bits.
     int decodeByte(unsigned int context, JArithmeticDecoderStats *stats);
@@ -108,6 +118,7 @@ public:
 
 private:
     unsigned int readByte();
+    int decodeBitSlow(unsigned int context, JArithmeticDecoderStats *stats);
     int decodeIntBit(JArithmeticDecoderStats *stats);
     void byteIn();
 
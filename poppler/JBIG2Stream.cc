@@ -36,6 +36,7 @@
 
 #include <config.h>
 
+#include <algorithm>
 #include <memory>
 
 #include <cstdlib>
@@ -759,12 +760,120 @@ void JBIG2Bitmap::duplicateRow(int yDest, int ySrc)
     memcpy(data + yDest * line, data + ySrc * line, line);
 }
 
+// Load the 8 bytes at <p> as a big endian word, i.e. with the left-most
+// pixel in the most significant bit.
+static inline unsigned long long loadPixelWord(const unsigned char *p)
+{
+    unsigned long long word = 0;
+    for (int i = 0; i < 8; ++i) {
+        word = (word << 8) | p[i];
+    }
+    return word;
+}
+
+static inline void storePixelWord(unsigned char *p, unsigned long long word)
+{
+    for (int i = 7; i >= 0; --i) {
+        p[i] = (unsigned char)word;
+        word >>= 8;
+    }
+}
+
+// Get the 64 pixels of the row <row> (<rowSize> bytes long) starting at
+// pixel <x>, which may be negative.  Pixels outside the row are zero.
+static inline unsigned long long getPixelWord(const unsigned char *row, int rowSize, int x)
+{
+    const int i = x >= 0 ? x >> 3 : -((7 - x) >> 3);
+    const int shift = x & 7;
+    unsigned long long word;
+    unsigned int next;
+
+    if (i >= 0 && i + 8 < rowSize) {
+        word = loadPixelWord(row + i);
+        next = row[i + 8];
+    } else {
+        word = 0;
+        for (int j = i; j < i + 8; ++j) {
+            word = (word << 8) | ((j >= 0 && j < rowSize) ? row[j] : 0);
+        }
+        next = (i + 8 >= 0 && i + 8 < rowSize) ? row[i + 8] : 0;
+    }
+    if (shift) {
+        word = (word << shift) | (next >> (8 - shift));
+    }
+    return word;
+}
+
+// Combine the pixels <x0> to <x1> - 1 of the row <dest> with the pixels
+// of the row <src> shifted right by <x>, 64 pixels at a time.
+template<unsigned int combOp>
+static void combineRow(unsigned char *dest, int destSize, const unsigned char *src, int srcSize, int x, int x0, int x1)
+{
+    for (int xx = x0 & ~7; xx < x1; xx += 64) {
+        unsigned char *destPtr = dest + (xx >> 3);
+        const int n = std::min(8, destSize - (xx >> 3));
+
+        // mask of the pixels to be modified
+        unsigned long long mask = ~0ULL;
+        if (xx < x0) {
+            mask >>= x0 - xx;
+        }
+        if (x1 - xx < 64) {
+            mask &= ~(~0ULL >> (x1 - xx));
+        }
+
+        const unsigned long long s = getPixelWord(src, srcSize, xx - x);
+        unsigned long long d;
+        if (n == 8) {
+            d = loadPixelWord(destPtr);
+        } else {
+            d = 0;
+            for (int i = 0; i < n; ++i) {
+                d |= (unsigned long long)destPtr[i] << (56 - 8 * i);
+            }
+        }
+
+        switch (combOp) {
+        case 0: // or
+            d |= s & mask;
+            break;
+        case 1: // and
+            d &= s | ~mask;
+            break;
+        case 2: // xor
+            d ^= s & mask;
+            break;
+        case 3: // xnor
+            d ^= ~s & mask;
+            break;
+        case 4: // replace
+            d = (d & ~mask) | (s & mask);
+            break;
+        }
+
+        if (n == 8) {
+            storePixelWord(destPtr, d);
+        } else {
+            for (int i = 0; i < n; ++i) {
+                destPtr[i] = (unsigned char)(d >> (56 - 8 * i));
+            }
+        }
+    }
+}
+
+template<unsigned int combOp>
+static void combineRows(unsigned char *dest, int destSize, const unsigned char *src, int srcSize, int x, int x0, int x1, int nRows)
+{
+    for (int i = 0; i < nRows; ++i) {
+        combineRow<combOp>(dest, destSize, src, srcSize, x, x0, x1);
+        dest += destSize;
+        src += srcSize;
+    }
+}
+
 void JBIG2Bitmap::combine(JBIG2Bitmap *bitmap, int x, int y, unsigned int combOp)
 {
-    int x0, x1, y0, y1, xx, yy;
-    unsigned char *srcPtr, *destPtr;
-    unsigned int src0, src1, src, dest, s1, s2, m1, m2, m3;
-    bool oneByte;
+    int x0, x1, y0, y1;
 
     // check for the pathological case where y = -2^31
     if (y < -0x7fffffff) {
@@ -785,7 +894,7 @@ void JBIG2Bitmap::combine(JBIG2Bitmap *bitmap, int x, int y, unsigned int combOp
     }
 
     if (x >= 0) {
-        x0 = x & ~7;
+        x0 = x;
     } else {
         x0 = 0;
     }
@@ -799,158 +908,25 @@ void JBIG2Bitmap::combine(JBIG2Bitmap *bitmap, int x, int y, unsigned int combOp
         return;
     }
 
-    s1 = x & 7;
-    s2 = 8 - s1;
-    m1 = 0xff >> (x1 & 7);
-    m2 = 0xff << (((x1 & 7) == 0) ? 0 : 8 - (x1 & 7));
-    m3 = (0xff >> s1) & m2;
-
-    oneByte = x0 == ((x1 - 1) & ~7);
-
-    for (yy = y0; yy < y1; ++yy) {
-        if (unlikely((y + yy >= h) || (y + yy < 0)))
-            continue;
-
-        // one byte per line -- need to mask both left and right side
-        if (oneByte) {
-            if (x >= 0) {
-                destPtr = data + (y + yy) * line + (x >> 3);
-                srcPtr = bitmap->data + yy * bitmap->line;
-                dest = *destPtr;
-                src1 = *srcPtr;
-                switch (combOp) {
-                case 0: // or
-                    dest |= (src1 >> s1) & m2;
-                    break;
-                case 1: // and
-                    dest &= ((0xff00 | src1) >> s1) | m1;
-                    break;
-                case 2: // xor
-                    dest ^= (src1 >> s1) & m2;
-                    break;
-                case 3: // xnor
-                    dest ^= ((src1 ^ 0xff) >> s1) & m2;
-                    break;
-                case 4: // replace
-                    dest = (dest & ~m3) | ((src1 >> s1) & m3);
-                    break;
-                }
-                *destPtr = dest;
-            } else {
-                destPtr = data + (y + yy) * line;
-                srcPtr = bitmap->data + yy * bitmap->line + (-x >> 3);
-                dest = *destPtr;
-                src1 = *srcPtr;
-                switch (combOp) {
-                case 0: // or
-                    dest |= src1 & m2;
-                    break;
-                case 1: // and
-                    dest &= src1 | m1;
-                    break;
-                case 2: // xor
-                    dest ^= src1 & m2;
-                    break;
-                case 3: // xnor
-                    dest ^= (src1 ^ 0xff) & m2;
-                    break;
-                case 4: // replace
-                    dest = (src1 & m2) | (dest & m1);
-                    break;
-                }
-                *destPtr = dest;
-            }
-
-            // multiple bytes per line -- need to mask left side of left-most
-            // byte and right side of right-most byte
-        } else {
-
-            // left-most byte
-            if (x >= 0) {
-                destPtr = data + (y + yy) * line + (x >> 3);
-                srcPtr = bitmap->data + yy * bitmap->line;
-                src1 = *srcPtr++;
-                dest = *destPtr;
-                switch (combOp) {
-                case 0: // or
-                    dest |= src1 >> s1;
-                    break;
-                case 1: // and
-                    dest &= (0xff00 | src1) >> s1;
-                    break;
-                case 2: // xor
-                    dest ^= src1 >> s1;
-                    break;
-                case 3: // xnor
-                    dest ^= (src1 ^ 0xff) >> s1;
-                    break;
-                case 4: // replace
-                    dest = (dest & (0xff << s2)) | (src1 >> s1);
-                    break;
-                }
-                *destPtr++ = dest;
-                xx = x0 + 8;
-            } else {
-                destPtr = data + (y + yy) * line;
-                srcPtr = bitmap->data + yy * bitmap->line + (-x >> 3);
-                src1 = *srcPtr++;
-                xx = x0;
-            }
-
-            // middle bytes
-            for (; xx < x1 - 8; xx += 8) {
-                dest = *destPtr;
-                src0 = src1;
-                src1 = *srcPtr++;
-                src = (((src0 << 8) | src1) >> s1) & 0xff;
-                switch (combOp) {
-                case 0: // or
-                    dest |= src;
-                    break;
-                case 1: // and
-                    dest &= src;
-                    break;
-                case 2: // xor
-                    dest ^= src;
-                    break;
-                case 3: // xnor
-                    dest ^= src ^ 0xff;
-                    break;
-                case 4: // replace
-                    dest = src;
-                    break;
-                }
-                *destPtr++ = dest;
-            }
-
-            // right-most byte
-            // note: this last byte (src1) may not actually be used, depending
-            // on the values of s1, m1, and m2 - and in fact, it may be off
-            // the edge of the source bitmap, which means we need to allocate
-            // one extra guard byte at the end of each bitmap
-            dest = *destPtr;
-            src0 = src1;
-            src1 = *srcPtr++;
-            src = (((src0 << 8) | src1) >> s1) & 0xff;
-            switch (combOp) {
-            case 0: // or
-                dest |= src & m2;
-                break;
-            case 1: // and
-                dest &= src | m1;
-                break;
-            case 2: // xor
-                dest ^= src & m2;
-                break;
-            case 3: // xnor
-                dest ^= (src ^ 0xff) & m2;
-                break;
-            case 4: // replace
-                dest = (src & m2) | (dest & m1);
-                break;
-            }
-            *destPtr = dest;
-        }
+    unsigned char *dest = data + (y + y0) * line;
+    const unsigned char *src = bitmap->data + y0 * bitmap->line;
+    const int nRows = y1 - y0;
+    switch (combOp) {
+    case 0:
+        combineRows<0>(dest, line, src, bitmap->line, x, x0, x1, nRows);
+        break;
+    case 1:
+        combineRows<1>(dest, line, src, bitmap->line, x, x0, x1, nRows);
+        break;
+    case 2:
+        combineRows<2>(dest, line, src, bitmap->line, x, x0, x1, nRows);
+        break;
+    case 3:
+        combineRows<3>(dest, line, src, bitmap->line, x, x0, x1, nRows);
+        break;
+    case 4:
+        combineRows<4>(dest, line, src, bitmap->line, x, x0, x1, nRows);
+        break;
     }
 }
 
@@ -1081,13 +1057,31 @@ JBIG2CodeTable::~JBIG2CodeTable()
     gfree(table);
 }
 
+//------------------------------------------------------------------------
+// JBIG2GlobalsCache
+//------------------------------------------------------------------------
+
+std::shared_ptr<const JBIG2GlobalsCache::Segments> JBIG2GlobalsCache::lookup(Ref ref)
+{
+    std::lock_guard<std::mutex> locker(mutex);
+    const auto it = entries.find(ref);
+    return it != entries.end() ? it->second : nullptr;
+}
+
+void JBIG2GlobalsCache::add(Ref ref, std::shared_ptr<const Segments> segments)
+{
+    std::lock_guard<std::mutex> locker(mutex);
+    entries.emplace(ref, std::move(segments));
+}
+
 //------------------------------------------------------------------------
 // JBIG2Stream
 //------------------------------------------------------------------------
 
-JBIG2Stream::JBIG2Stream(Stream *strA, Object &&globalsStreamA, Object *globalsStreamRefA) : FilterStream(strA)
+JBIG2Stream::JBIG2Stream(Stream *strA, Object &&globalsStreamA, Object *globalsStreamRefA, std::shared_ptr<JBIG2GlobalsCache> globalsCacheA) : FilterStream(strA), globalsCache(std::move(globalsCacheA))
 {
     pageBitmap = nullptr;
+    globalsStreamRef = Ref::INVALID();
 
     arithDecoder = new JArithmeticDecoder();
     genericRegionStats = new JArithmeticDecoderStats(1 << 1);
@@ -1151,15 +1145,7 @@ void JBIG2Stream::reset()
 
     // read the globals stream
     if (globalsStream.isStream()) {
-        curStr = globalsStream.getStream();
-        curStr->reset();
-        arithDecoder->setStream(curStr);
-        huffDecoder->setStream(curStr);
-        mmrDecoder->setStream(curStr);
-        readSegments();
-        curStr->close();
-        // swap the newly read segments list into globalSegments
-        std::swap(segments, globalSegments);
+        readGlobalSegments();
     }
 
     // read the main stream
@@ -1178,6 +1164,39 @@ void JBIG2Stream::reset()
     }
 }
 
+void JBIG2Stream::readGlobalSegments()
+{
+    const bool cacheable = globalsCache && globalsStreamRef != Ref::INVALID();
+    if (cacheable) {
+        std::shared_ptr<const JBIG2GlobalsCache::Segments> cached = globalsCache->lookup(globalsStreamRef);
+        if (cached) {
+            globalSegments = *cached;
+            return;
+        }
+    }
+
+    curStr = globalsStream.getStream();
+    curStr->reset();
+    arithDecoder->setStream(curStr);
+    huffDecoder->setStream(curStr);
+    mmrDecoder->setStream(curStr);
+    readSegments();
+    curStr->close();
+
+    // move the newly read segments list into globalSegments
+    globalSegments.reserve(segments.size());
+    for (std::unique_ptr<JBIG2Segment> &seg : segments) {
+        globalSegments.emplace_back(std::move(seg));
+    }
+    segments.resize(0);
+
+    // a globals stream only holding dictionaries and tables leaves no
+    // state behind, anything else (e.g. page information) isn't cached
+    if (cacheable && !pageBitmap) {
+        globalsCache->add(globalsStreamRef, std::make_shared<const JBIG2GlobalsCache::Segments>(globalSegments));
+    }
+}
+
 void JBIG2Stream::close()
 {
     if (pageBitmap) {
@@ -2774,19 +2793,207 @@ inline void JBIG2Stream::mmrAddPixelsNeg(int a1, int blackPixels, int *codingLin
     }
 }
 
+//------------------------------------------------------------------------
+// generic region rows
+//------------------------------------------------------------------------
+
+// How the adaptive template pixels of a generic region are read.
+enum JBIG2GenericATMode
+{
+    jbig2ATNominal, // at their nominal positions, taken from the row registers
+    jbig2ATNear, // within 8 pixels of the current one, with their own registers
+    jbig2ATFar // anywhere else, with getPixel()
+};
+
+// Decode row <y> of a generic region bitmap with template <templ>.
+// The previous rows and the current one are kept in registers holding
+// pixel x in bit 15, so the context is assembled with constant shifts.
+template<int templ, JBIG2GenericATMode atMode, bool useSkip>
+static void decodeGenericRow(JArithmeticDecoder *arithDecoder, JArithmeticDecoderStats *stats, JBIG2Bitmap *bitmap, int y, const int *atx, const int *aty, JBIG2Bitmap *skip)
+{
+    constexpr int nAT = templ == 0 ? 4 : 1;
+    const int w = bitmap->getWidth();
+    const int line = bitmap->getLineSize();
+    unsigned char *data = bitmap->getDataPtr();
+    unsigned char *p0, *p1, *p2, *pp;
+    unsigned int buf0, buf1, buf2, cx;
+    unsigned char *atP[nAT];
+    unsigned int atBuf[nAT];
+    int atShift[nAT];
+
+    // set up the context
+    p2 = pp = data + y * line;
+    buf2 = *p2++ << 8;
+    if (y >= 1) {
+        p1 = data + (y - 1) * line;
+        buf1 = *p1++ << 8;
+    } else {
+        p1 = nullptr;
+        buf1 = 0;
+    }
+    if (templ != 3 && y >= 2) {
+        p0 = data + (y - 2) * line;
+        buf0 = *p0++ << 8;
+    } else {
+        p0 = nullptr;
+        buf0 = 0;
+    }
+
+    // set up the adaptive context
+    if (atMode == jbig2ATNear) {
+        for (int i = 0; i < nAT; ++i) {
+            if (y + aty[i] >= 0 && y + aty[i] < bitmap->getHeight()) {
+                atP[i] = data + (y + aty[i]) * line;
+                atBuf[i] = *atP[i]++ << 8;
+            } else {
+                atP[i] = nullptr;
+                atBuf[i] = 0;
+            }
+            atShift[i] = 15 - atx[i];
+        }
+    }
+
+    // decode the row
+    for (int x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
+        if (x0 + 8 < w) {
+            if (p0) {
+                buf0 |= *p0++;
+            }
+            if (p1) {
+                buf1 |= *p1++;
+            }
+            buf2 |= *p2++;
+            if (atMode == jbig2ATNear) {
+                for (int i = 0; i < nAT; ++i) {
+                    if (atP[i]) {
+                        atBuf[i] |= *atP[i]++;
+                    }
+                }
+            }
+        }
+        for (unsigned int mask = 0x80; mask && x < w; ++x, mask >>= 1) {
+
+            // build the context
+            switch (templ) {
+            case 0:
+                cx = (((buf0 >> 14) & 0x07) << 13) | (((buf1 >> 13) & 0x1f) << 8) | (((buf2 >> 16) & 0x0f) << 4);
+                if (atMode == jbig2ATNominal) {
+                    // (3,-1), (-3,-1), (2,-2), (-2,-2)
+                    cx |= (((buf1 >> 12) & 1) << 3) | (((buf1 >> 18) & 1) << 2) | (((buf0 >> 13) & 1) << 1) | ((buf0 >> 17) & 1);
+                }
+                break;
+            case 1:
+                cx = (((buf0 >> 13) & 0x0f) << 9) | (((buf1 >> 13) & 0x1f) << 4) | (((buf2 >> 16) & 0x07) << 1);
+                if (atMode == jbig2ATNominal) {
+                    // (3,-1)
+                    cx |= (buf1 >> 12) & 1;
+                }
+                break;
+            case 2:
+                cx = (((buf0 >> 14) & 0x07) << 7) | (((buf1 >> 14) & 0x0f) << 3) | (((buf2 >> 16) & 0x03) << 1);
+                if (atMode == jbig2ATNominal) {
+                    // (2,-1)
+                    cx |= (buf1 >> 13) & 1;
+                }
+                break;
+            default:
+                cx = (((buf1 >> 14) & 0x1f) << 5) | (((buf2 >> 16) & 0x0f) << 1);
+                if (atMode == jbig2ATNominal) {
+                    // (2,-1)
+                    cx |= (buf1 >> 13) & 1;
+                }
+                break;
+            }
+            if (atMode == jbig2ATNear) {
+                for (int i = 0; i < nAT; ++i) {
+                    cx |= ((atBuf[i] >> atShift[i]) & 1) << (nAT - 1 - i);
+                }
+            } else if (atMode == jbig2ATFar) {
+                for (int i = 0; i < nAT; ++i) {
+                    cx |= bitmap->getPixel(x + atx[i], y + aty[i]) << (nAT - 1 - i);
+                }
+            }
+
+            // check for a skipped pixel
+            if (!(useSkip && skip->getPixel(x, y))) {
+
+                // decode the pixel
+                if (arithDecoder->decodeBit(cx, stats)) {
+                    *pp |= mask;
+                    buf2 |= 0x8000;
+                    if (atMode == jbig2ATNear) {
+                        for (int i = 0; i < nAT; ++i) {
+                            if (aty[i] == 0) {
+                                atBuf[i] |= 0x8000;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // update the context
+            buf0 <<= 1;
+            buf1 <<= 1;
+            buf2 <<= 1;
+            if (atMode == jbig2ATNear) {
+                for (int i = 0; i < nAT; ++i) {
+                    atBuf[i] <<= 1;
+                }
+            }
+        }
+    }
+}
+
+typedef void (*JBIG2GenericRowDecoder)(JArithmeticDecoder *arithDecoder, JArithmeticDecoderStats *stats, JBIG2Bitmap *bitmap, int y, const int *atx, const int *aty, JBIG2Bitmap *skip);
+
+template<int templ>
+static JBIG2GenericRowDecoder getGenericRowDecoder(JBIG2GenericATMode atMode, bool useSkip)
+{
+    switch (atMode) {
+    case jbig2ATNominal:
+        return useSkip ? decodeGenericRow<templ, jbig2ATNominal, true> : decodeGenericRow<templ, jbig2ATNominal, false>;
+    case jbig2ATNear:
+        return useSkip ? decodeGenericRow<templ, jbig2ATNear, true> : decodeGenericRow<templ, jbig2ATNear, false>;
+    default:
+        return useSkip ? decodeGenericRow<templ, jbig2ATFar, true> : decodeGenericRow<templ, jbig2ATFar, false>;
+    }
+}
+
+// Pick the row decoder specialized for the template, the positions of
+// the adaptive template pixels, and the use of a skip bitmap.
+static JBIG2GenericRowDecoder getGenericRowDecoder(int templ, const int *atx, const int *aty, bool useSkip)
+{
+    static const int nominalATX[4][4] = { { 3, -3, 2, -2 }, { 3 }, { 2 }, { 2 } };
+    static const int nominalATY[4][4] = { { -1, -1, -2, -2 }, { -1 }, { -1 }, { -1 } };
+    const int nAT = templ == 0 ? 4 : 1;
+    bool nominal = true;
+    bool nearby = true;
+
+    for (int i = 0; i < nAT; ++i) {
+        nominal = nominal && atx[i] == nominalATX[templ][i] && aty[i] == nominalATY[templ][i];
+        nearby = nearby && atx[i] >= -8 && atx[i] <= 8;
+    }
+    const JBIG2GenericATMode atMode = nominal ? jbig2ATNominal : nearby ? jbig2ATNear : jbig2ATFar;
+
+    switch (templ) {
+    case 0:
+        return getGenericRowDecoder<0>(atMode, useSkip);
+    case 1:
+        return getGenericRowDecoder<1>(atMode, useSkip);
+    case 2:
+        return getGenericRowDecoder<2>(atMode, useSkip);
+    default:
+        return getGenericRowDecoder<3>(atMode, useSkip);
+    }
+}
+
 std::unique_ptr<JBIG2Bitmap> JBIG2Stream::readGenericBitmap(bool mmr, int w, int h, int templ, bool tpgdOn, bool useSkip, JBIG2Bitmap *skip, int *atx, int *aty, int mmrDataLength)
 {
     bool ltp;
-    unsigned int ltpCX, cx, cx0, cx1, cx2;
+    unsigned int ltpCX;
     int *refLine, *codingLine;
     int code1, code2, code3;
-    unsigned char *p0, *p1, *p2, *pp;
-    unsigned char *atP0, *atP1, *atP2, *atP3;
-    unsigned int buf0, buf1, buf2;
-    unsigned int atBuf0, atBuf1, atBuf2, atBuf3;
-    int atShift0, atShift1, atShift2, atShift3;
-    unsigned char mask;
-    int x, y, x0, x1, a0i, b1i, blackPixels, pix, i;
+    int x, y, a0i, b1i, blackPixels, i;
 
     auto bitmap = std::make_unique<JBIG2Bitmap>(0, w, h);
     if (!bitmap->isOk()) {
@@ -3031,8 +3238,9 @@ std::unique_ptr<JBIG2Bitmap> JBIG2Stream::readGenericBitmap(bool mmr, int w, int
             }
         }
 
+        const JBIG2GenericRowDecoder decodeRow = getGenericRowDecoder(templ, atx, aty, useSkip);
+
         ltp = false;
-        cx = cx0 = cx1 = cx2 = 0; // make gcc happy
         for (y = 0; y < h; ++y) {
 
             // check for a "typical" (duplicate) row
@@ -3048,491 +3256,7 @@ std::unique_ptr<JBIG2Bitmap> JBIG2Stream::readGenericBitmap(bool mmr, int w, int
                 }
             }
 
-            switch (templ) {
-            case 0:
-
-                // set up the context
-                p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-                buf2 = *p2++ << 8;
-                if (y >= 1) {
-                    p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-                    buf1 = *p1++ << 8;
-                    if (y >= 2) {
-                        p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-                        buf0 = *p0++ << 8;
-                    } else {
-                        p0 = nullptr;
-                        buf0 = 0;
-                    }
-                } else {
-                    p1 = p0 = nullptr;
-                    buf1 = buf0 = 0;
-                }
-
-                if (atx[0] >= -8 && atx[0] <= 8 && atx[1] >= -8 && atx[1] <= 8 && atx[2] >= -8 && atx[2] <= 8 && atx[3] >= -8 && atx[3] <= 8) {
-                    // set up the adaptive context
-                    if (y + aty[0] >= 0 && y + aty[0] < bitmap->getHeight()) {
-                        atP0 = bitmap->getDataPtr() + (y + aty[0]) * bitmap->getLineSize();
-                        atBuf0 = *atP0++ << 8;
-                    } else {
-                        atP0 = nullptr;
-                        atBuf0 = 0;
-                    }
-                    atShift0 = 15 - atx[0];
-                    if (y + aty[1] >= 0 && y + aty[1] < bitmap->getHeight()) {
-                        atP1 = bitmap->getDataPtr() + (y + aty[1]) * bitmap->getLineSize();
-                        atBuf1 = *atP1++ << 8;
-                    } else {
-                        atP1 = nullptr;
-                        atBuf1 = 0;
-                    }
-                    atShift1 = 15 - atx[1];
-                    if (y + aty[2] >= 0 && y + aty[2] < bitmap->getHeight()) {
-                        atP2 = bitmap->getDataPtr() + (y + aty[2]) * bitmap->getLineSize();
-                        atBuf2 = *atP2++ << 8;
-                    } else {
-                        atP2 = nullptr;
-                        atBuf2 = 0;
-                    }
-                    atShift2 = 15 - atx[2];
-                    if (y + aty[3] >= 0 && y + aty[3] < bitmap->getHeight()) {
-                        atP3 = bitmap->getDataPtr() + (y + aty[3]) * bitmap->getLineSize();
-                        atBuf3 = *atP3++ << 8;
-                    } else {
-                        atP3 = nullptr;
-                        atBuf3 = 0;
-                    }
-                    atShift3 = 15 - atx[3];
-
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                            if (atP0) {
-                                atBuf0 |= *atP0++;
-                            }
-                            if (atP1) {
-                                atBuf1 |= *atP1++;
-                            }
-                            if (atP2) {
-                                atBuf2 |= *atP2++;
-                            }
-                            if (atP3) {
-                                atBuf3 |= *atP3++;
-                            }
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 14) & 0x07;
-                            cx1 = (buf1 >> 13) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x0f;
-                            cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) | (((atBuf0 >> atShift0) & 1) << 3) | (((atBuf1 >> atShift1) & 1) << 2) | (((atBuf2 >> atShift2) & 1) << 1) | ((atBuf3 >> atShift3) & 1);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                    if (aty[0] == 0) {
-                                        atBuf0 |= 0x8000;
-                                    }
-                                    if (aty[1] == 0) {
-                                        atBuf1 |= 0x8000;
-                                    }
-                                    if (aty[2] == 0) {
-                                        atBuf2 |= 0x8000;
-                                    }
-                                    if (aty[3] == 0) {
-                                        atBuf3 |= 0x8000;
-                                    }
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                            atBuf0 <<= 1;
-                            atBuf1 <<= 1;
-                            atBuf2 <<= 1;
-                            atBuf3 <<= 1;
-                        }
-                    }
-
-                } else {
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 14) & 0x07;
-                            cx1 = (buf1 >> 13) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x0f;
-                            cx = (cx0 << 13) | (cx1 << 8) | (cx2 << 4) | (bitmap->getPixel(x + atx[0], y + aty[0]) << 3) | (bitmap->getPixel(x + atx[1], y + aty[1]) << 2) | (bitmap->getPixel(x + atx[2], y + aty[2]) << 1)
-                                    | bitmap->getPixel(x + atx[3], y + aty[3]);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                        }
-                    }
-                }
-                break;
-
-            case 1:
-
-                // set up the context
-                p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-                buf2 = *p2++ << 8;
-                if (y >= 1) {
-                    p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-                    buf1 = *p1++ << 8;
-                    if (y >= 2) {
-                        p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-                        buf0 = *p0++ << 8;
-                    } else {
-                        p0 = nullptr;
-                        buf0 = 0;
-                    }
-                } else {
-                    p1 = p0 = nullptr;
-                    buf1 = buf0 = 0;
-                }
-
-                if (atx[0] >= -8 && atx[0] <= 8) {
-                    // set up the adaptive context
-                    const int atY = y + aty[0];
-                    if ((atY >= 0) && (atY < bitmap->getHeight())) {
-                        atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-                        atBuf0 = *atP0++ << 8;
-                    } else {
-                        atP0 = nullptr;
-                        atBuf0 = 0;
-                    }
-                    atShift0 = 15 - atx[0];
-
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                            if (atP0) {
-                                atBuf0 |= *atP0++;
-                            }
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 13) & 0x0f;
-                            cx1 = (buf1 >> 13) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x07;
-                            cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) | ((atBuf0 >> atShift0) & 1);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                    if (aty[0] == 0) {
-                                        atBuf0 |= 0x8000;
-                                    }
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                            atBuf0 <<= 1;
-                        }
-                    }
-
-                } else {
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 13) & 0x0f;
-                            cx1 = (buf1 >> 13) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x07;
-                            cx = (cx0 << 9) | (cx1 << 4) | (cx2 << 1) | bitmap->getPixel(x + atx[0], y + aty[0]);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                        }
-                    }
-                }
-                break;
-
-            case 2:
-
-                // set up the context
-                p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-                buf2 = *p2++ << 8;
-                if (y >= 1) {
-                    p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-                    buf1 = *p1++ << 8;
-                    if (y >= 2) {
-                        p0 = bitmap->getDataPtr() + (y - 2) * bitmap->getLineSize();
-                        buf0 = *p0++ << 8;
-                    } else {
-                        p0 = nullptr;
-                        buf0 = 0;
-                    }
-                } else {
-                    p1 = p0 = nullptr;
-                    buf1 = buf0 = 0;
-                }
-
-                if (atx[0] >= -8 && atx[0] <= 8) {
-                    // set up the adaptive context
-                    const int atY = y + aty[0];
-                    if ((atY >= 0) && (atY < bitmap->getHeight())) {
-                        atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-                        atBuf0 = *atP0++ << 8;
-                    } else {
-                        atP0 = nullptr;
-                        atBuf0 = 0;
-                    }
-                    atShift0 = 15 - atx[0];
-
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                            if (atP0) {
-                                atBuf0 |= *atP0++;
-                            }
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 14) & 0x07;
-                            cx1 = (buf1 >> 14) & 0x0f;
-                            cx2 = (buf2 >> 16) & 0x03;
-                            cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) | ((atBuf0 >> atShift0) & 1);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                    if (aty[0] == 0) {
-                                        atBuf0 |= 0x8000;
-                                    }
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                            atBuf0 <<= 1;
-                        }
-                    }
-
-                } else {
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p0) {
-                                buf0 |= *p0++;
-                            }
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx0 = (buf0 >> 14) & 0x07;
-                            cx1 = (buf1 >> 14) & 0x0f;
-                            cx2 = (buf2 >> 16) & 0x03;
-                            cx = (cx0 << 7) | (cx1 << 3) | (cx2 << 1) | bitmap->getPixel(x + atx[0], y + aty[0]);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                }
-                            }
-
-                            // update the context
-                            buf0 <<= 1;
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                        }
-                    }
-                }
-                break;
-
-            case 3:
-
-                // set up the context
-                p2 = pp = bitmap->getDataPtr() + y * bitmap->getLineSize();
-                buf2 = *p2++ << 8;
-                if (y >= 1) {
-                    p1 = bitmap->getDataPtr() + (y - 1) * bitmap->getLineSize();
-                    buf1 = *p1++ << 8;
-                } else {
-                    p1 = nullptr;
-                    buf1 = 0;
-                }
-
-                if (atx[0] >= -8 && atx[0] <= 8) {
-                    // set up the adaptive context
-                    const int atY = y + aty[0];
-                    if ((atY >= 0) && (atY < bitmap->getHeight())) {
-                        atP0 = bitmap->getDataPtr() + atY * bitmap->getLineSize();
-                        atBuf0 = *atP0++ << 8;
-                    } else {
-                        atP0 = nullptr;
-                        atBuf0 = 0;
-                    }
-                    atShift0 = 15 - atx[0];
-
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                            if (atP0) {
-                                atBuf0 |= *atP0++;
-                            }
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx1 = (buf1 >> 14) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x0f;
-                            cx = (cx1 << 5) | (cx2 << 1) | ((atBuf0 >> atShift0) & 1);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                    if (aty[0] == 0) {
-                                        atBuf0 |= 0x8000;
-                                    }
-                                }
-                            }
-
-                            // update the context
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                            atBuf0 <<= 1;
-                        }
-                    }
-
-                } else {
-                    // decode the row
-                    for (x0 = 0, x = 0; x0 < w; x0 += 8, ++pp) {
-                        if (x0 + 8 < w) {
-                            if (p1) {
-                                buf1 |= *p1++;
-                            }
-                            buf2 |= *p2++;
-                        }
-                        for (x1 = 0, mask = 0x80; x1 < 8 && x < w; ++x1, ++x, mask >>= 1) {
-
-                            // build the context
-                            cx1 = (buf1 >> 14) & 0x1f;
-                            cx2 = (buf2 >> 16) & 0x0f;
-                            cx = (cx1 << 5) | (cx2 << 1) | bitmap->getPixel(x + atx[0], y + aty[0]);
-
-                            // check for a skipped pixel
-                            if (!(useSkip && skip->getPixel(x, y))) {
-
-                                // decode the pixel
-                                if ((pix = arithDecoder->decodeBit(cx, genericRegionStats))) {
-                                    *pp |= mask;
-                                    buf2 |= 0x8000;
-                                }
-                            }
-
-                            // update the context
-                            buf1 <<= 1;
-                            buf2 <<= 1;
-                        }
-                    }
-                }
-                break;
-            }
+            decodeRow(arithDecoder, genericRegionStats, bitmap.get(), y, atx, aty, skip);
         }
     }
 
@@ -3946,7 +3670,7 @@ void JBIG2Stream::readExtensionSeg(unsigned int length)
 
 JBIG2Segment *JBIG2Stream::findSegment(unsigned int segNum)
 {
-    for (std::unique_ptr<JBIG2Segment> &seg : globalSegments) {
+    for (std::shared_ptr<JBIG2Segment> &seg : globalSegments) {
         if (seg->getSegNum() == segNum) {
             return seg.get();
         }
@@ -29,6 +29,11 @@
 #ifndef JBIG2STREAM_H
 #define JBIG2STREAM_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "Object.h"
 #include "Stream.h"
 
@@ -40,12 +45,43 @@ class JBIG2HuffmanDecoder;
 struct JBIG2HuffmanTable;
 class JBIG2MMRDecoder;
 
+//------------------------------------------------------------------------
+// JBIG2GlobalsCache
+//------------------------------------------------------------------------
+
+// The decoded segments (symbol and pattern dictionaries, code tables) of
+// the JBIG2Globals streams of a document, keyed by the stream Ref.
+// Scanned documents often share a single symbol dictionary between all
+// their page images, which then only needs to be decoded once.  The
+// segments are never modified once decoded, so the entries can be used
+// from several threads at once.
+class JBIG2GlobalsCache
+{
+public:
+    typedef std::vector<std::shared_ptr<JBIG2Segment>> Segments;
+
+    JBIG2GlobalsCache() = default;
+    JBIG2GlobalsCache(const JBIG2GlobalsCache &) = delete;
+    JBIG2GlobalsCache &operator=(const JBIG2GlobalsCache &) = delete;
+
+    // Returns the segments of the globals stream <ref>, or nullptr if
+    // they haven't been decoded yet.
+    std::shared_ptr<const Segments> lookup(Ref ref);
+    void add(Ref ref, std::shared_ptr<const Segments> segments);
+
+private:
+    std::mutex mutex;
+    std::map<Ref, std::shared_ptr<const Segments>> entries;
+};
+
+//------------------------------------------------------------------------
+// JBIG2Stream
 //------------------------------------------------------------------------
 
 class JBIG2Stream : public FilterStream
 {
 public:
-    JBIG2Stream(Stream *strA, Object &&globalsStreamA, Object *globalsStreamRefA);
+    JBIG2Stream(Stream *strA, Object &&globalsStreamA, Object *globalsStreamRefA, std::shared_ptr<JBIG2GlobalsCache> globalsCacheA = nullptr);
     ~JBIG2Stream() override;
     StreamKind getKind() const override { return strJBIG2; }
     void reset() override;
@@ -63,6 +99,7 @@ private:
     int getChars(int nChars, unsigned char *buffer) override;
 
     void readSegments();
+    void readGlobalSegments();
     bool readSymbolDictSeg(unsigned int segNum, unsigned int length, unsigned int *refSegs, unsigned int nRefSegs);
     void readTextRegionSeg(unsigned int segNum, bool imm, bool lossless, unsigned int length, unsigned int *refSegs, unsigned int nRefSegs);
     std::unique_ptr<JBIG2Bitmap> readTextRegion(bool huff, bool refine, int w, int h, unsigned int numInstances, unsigned int logStrips, int numSyms, const JBIG2HuffmanTable *symCodeTab, unsigned int symCodeLen, JBIG2Bitmap **syms,
@@ -100,7 +137,8 @@ private:
     JBIG2Bitmap *pageBitmap;
     unsigned int defCombOp;
     std::vector<std::unique_ptr<JBIG2Segment>> segments;
-    std::vector<std::unique_ptr<JBIG2Segment>> globalSegments;
+    std::vector<std::shared_ptr<JBIG2Segment>> globalSegments;
+    std::shared_ptr<JBIG2GlobalsCache> globalsCache;
     Stream *curStr;
     unsigned char *dataPtr;
     unsigned char *dataEnd;
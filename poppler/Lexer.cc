@@ -31,6 +31,8 @@
 #include <cstring>
 #include <climits>
 #include <cctype>
+#include <cstdio>
+#include "goo/gstrtod.h"
 #include "Lexer.h"
 #include "Error.h"
 #include "XRef.h"
@@ -61,6 +63,44 @@ static const char specialChars[256] = {
 static const int IntegerSafeLimit = (INT_MAX - 9) / 10;
 static const long long LongLongSafeLimit = (LLONG_MAX - 9) / 10;
 
+// The significant digits of a real kept, the others are dropped.
+static const int maxRealDigits = 64;
+
+static const double powersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static inline bool isDigit(int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Return the real <digits> * 10^<exp>, negated if <neg>, correctly
+// rounded.  When the digits and the power of ten are exact doubles, one
+// division is enough; otherwise the conversion is left to gstrtod().
+static double makeReal(const char *digits, int nDigits, int exp, bool neg)
+{
+    double x;
+
+    while (nDigits > 0 && *digits == '0') {
+        ++digits;
+        --nDigits;
+    }
+    if (nDigits == 0) {
+        x = 0;
+    } else if (nDigits <= 15 && exp <= 0 && exp >= -22) {
+        long long m = 0;
+        for (int i = 0; i < nDigits; ++i) {
+            m = m * 10 + (digits[i] - '0');
+        }
+        x = (double)m / powersOfTen[-exp];
+    } else {
+        char buf[maxRealDigits + 16];
+        memcpy(buf, digits, nDigits);
+        snprintf(buf + nDigits, sizeof(buf) - nDigits, "e%d", exp);
+        x = gstrtod(buf, nullptr);
+    }
+    return neg ? -x : x;
+}
+
 //------------------------------------------------------------------------
 // Lexer
 //------------------------------------------------------------------------
@@ -162,9 +202,17 @@ Object Lexer::getObj(int objNum)
     int numParen;
     int xi;
     long long xll = 0;
-    double xf = 0, scale;
+    double xf = 0;
     GooString *s;
     int n, m;
+    int nDigits, exp;
+
+    {
+        Object obj;
+        if (getBufferedObj(&obj)) {
+            return obj;
+        }
+    }
 
     // skip whitespace and comments
     comment = false;
@@ -203,17 +251,30 @@ Object Lexer::getObj(int objNum)
         overflownLongLong = false;
         neg = false;
         xi = 0;
+        // the significant digits are also kept in tokBuf, for a real
+        nDigits = 0;
+        exp = 0;
         if (c == '-') {
             neg = true;
         } else if (c == '.') {
             goto doReal;
         } else if (c != '+') {
             xi = c - '0';
+            if (c != '0') {
+                tokBuf[nDigits++] = c;
+            }
         }
         while (true) {
             c = lookChar();
-            if (isdigit(c)) {
+            if (isDigit(c)) {
                 getChar();
+                if (nDigits < maxRealDigits) {
+                    if (nDigits > 0 || c != '0') {
+                        tokBuf[nDigits++] = c;
+                    }
+                } else {
+                    ++exp;
+                }
                 if (unlikely(overflownLongLong)) {
                     xf = xf * 10.0 + (c - '0');
                 } else if (unlikely(overflownInteger)) {
@@ -258,12 +319,6 @@ Object Lexer::getObj(int objNum)
         }
         break;
     doReal:
-        if (likely(!overflownInteger)) {
-            xf = xi;
-        } else if (!overflownLongLong) {
-            xf = xll;
-        }
-        scale = 0.1;
         while (true) {
             c = lookChar();
             if (c == '-') {
@@ -273,17 +328,18 @@ Object Lexer::getObj(int objNum)
                 getChar();
                 continue;
             }
-            if (!isdigit(c)) {
+            if (!isDigit(c)) {
                 break;
             }
             getChar();
-            xf = xf + scale * (c - '0');
-            scale *= 0.1;
-        }
-        if (neg) {
-            xf = -xf;
+            if (nDigits < maxRealDigits) {
+                if (nDigits > 0 || c != '0') {
+                    tokBuf[nDigits++] = c;
+                }
+                --exp;
+            }
         }
-        return Object(xf);
+        return Object(makeReal(tokBuf, nDigits, exp, neg));
         break;
 
     // string
@@ -595,6 +651,180 @@ Object Lexer::getObj(int objNum)
     return Object();
 }
 
+// Get the next object like getObj() does, but scanning the chars the
+// stream holds in its buffer, if the whole object is there and simple
+// enough: a number, a name without escapes, a command, or array or dict
+// punctuation.  Otherwise, skips the whitespace and comments it can and
+// returns false.  The char ending the object is left in the stream, as
+// the char getObj() only looks at.
+bool Lexer::getBufferedObj(Object *obj)
+{
+    if (lookCharLastValueCached != LOOK_VALUE_NOT_CACHED) {
+        if (specialChars[lookCharLastValueCached] != 1) {
+            return false;
+        }
+        lookCharLastValueCached = LOOK_VALUE_NOT_CACHED;
+    }
+    if (!curStr.isStream()) {
+        return false;
+    }
+    Stream *str = curStr.getStream();
+    int n;
+    const unsigned char *buf = str->getBufferedChars(&n);
+    if (n <= 0) {
+        return false;
+    }
+    const unsigned char *p = buf;
+    const unsigned char *end = buf + n;
+
+    // skip whitespace and comments
+    while (true) {
+        while (p < end && specialChars[*p] == 1) {
+            ++p;
+        }
+        if (p == end || *p != '%') {
+            break;
+        }
+        const unsigned char *q = p + 1;
+        while (q < end && *q != '\r' && *q != '\n') {
+            ++q;
+        }
+        if (q == end) {
+            break;
+        }
+        p = q + 1;
+    }
+    if (p == end || *p == '%') {
+        str->skipBufferedChars(p - buf);
+        return false;
+    }
+
+    const unsigned char *q = p;
+    switch (*p) {
+
+    // number
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '+':
+    case '-':
+    case '.': {
+        bool neg = *q == '-';
+        if (*q == '+' || *q == '-') {
+            ++q;
+        }
+        const unsigned char *intStart = q;
+        while (q < end && isDigit(*q)) {
+            ++q;
+        }
+        const int nInt = q - intStart;
+        if (q == end) {
+            break;
+        }
+        if (*q != '.') {
+            if (nInt > 9) {
+                break;
+            }
+            int xi = 0;
+            for (int i = 0; i < nInt; ++i) {
+                xi = xi * 10 + (intStart[i] - '0');
+            }
+            *obj = Object(neg ? -xi : xi);
+            str->skipBufferedChars(q - buf);
+            return true;
+        }
+        const unsigned char *fracStart = ++q;
+        while (q < end && isDigit(*q)) {
+            ++q;
+        }
+        const int nFrac = q - fracStart;
+        if (q == end || *q == '-' || nInt + nFrac > maxRealDigits) {
+            break;
+        }
+        memcpy(tokBuf, intStart, nInt);
+        memcpy(tokBuf + nInt, fracStart, nFrac);
+        *obj = Object(makeReal(tokBuf, nInt + nFrac, -nFrac, neg));
+        str->skipBufferedChars(q - buf);
+        return true;
+    }
+
+    // name
+    case '/':
+        ++q;
+        while (q < end && !specialChars[*q] && *q != '#') {
+            ++q;
+        }
+        if (q == end || *q == '#' || q - p > tokBufSize - 1) {
+            break;
+        }
+        memcpy(tokBuf, p + 1, q - p - 1);
+        tokBuf[q - p - 1] = '\0';
+        *obj = Object(objName, tokBuf);
+        str->skipBufferedChars(q - buf);
+        return true;
+
+    // array punctuation
+    case '[':
+    case ']':
+        tokBuf[0] = *p;
+        tokBuf[1] = '\0';
+        *obj = Object(objCmd, tokBuf);
+        str->skipBufferedChars(p + 1 - buf);
+        return true;
+
+    // dict punctuation, hex strings are left to getObj()
+    case '<':
+    case '>':
+        if (p + 1 == end || p[1] != *p) {
+            break;
+        }
+        tokBuf[0] = tokBuf[1] = *p;
+        tokBuf[2] = '\0';
+        *obj = Object(objCmd, tokBuf);
+        str->skipBufferedChars(p + 2 - buf);
+        return true;
+
+    // strings and errors are left to getObj()
+    case '(':
+    case ')':
+    case '{':
+    case '}':
+        break;
+
+    // command
+    default:
+        while (q < end && !specialChars[*q]) {
+            ++q;
+        }
+        if (q == end || q - p > tokBufSize - 2) {
+            break;
+        }
+        memcpy(tokBuf, p, q - p);
+        tokBuf[q - p] = '\0';
+        if (tokBuf[0] == 't' && !strcmp(tokBuf, "true")) {
+            *obj = Object(true);
+        } else if (tokBuf[0] == 'f' && !strcmp(tokBuf, "false")) {
+            *obj = Object(false);
+        } else if (tokBuf[0] == 'n' && !strcmp(tokBuf, "null")) {
+            *obj = Object(objNull);
+        } else {
+            *obj = Object(objCmd, tokBuf);
+        }
+        str->skipBufferedChars(q - buf);
+        return true;
+    }
+
+    str->skipBufferedChars(p - buf);
+    return false;
+}
+
 Object Lexer::getObj(const char *cmdA, int objNum)
 {
     char *p;
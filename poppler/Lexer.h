@@ -99,6 +99,7 @@ public:
 private:
     int getChar(bool comesFromLook = false);
     int lookChar();
+    bool getBufferedObj(Object *obj);
 
     Array *streams; // array of input streams
     int strPtr; // index of current stream
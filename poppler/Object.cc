@@ -53,7 +53,9 @@ Object Object::copy() const
         break;
     case objName:
     case objCmd:
-        obj.cString = copyString(cString);
+        if (!interned) {
+            obj.cString = copyString(cString);
+        }
         break;
     case objArray:
         array->incRef();
@@ -88,7 +90,9 @@ void Object::free()
         break;
     case objName:
     case objCmd:
-        gfree(cString);
+        if (!interned) {
+            gfree(const_cast<char *>(cString));
+        }
         break;
     case objArray:
         if (!array->decRef()) {
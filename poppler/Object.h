@@ -43,6 +43,7 @@
 #include "goo/GooString.h"
 #include "goo/GooLikely.h"
 #include "Error.h"
+#include "Atom.h"
 
 #define OBJECT_TYPE_CHECK(wanted_type)                                                                                                                                                                                                         \
     if (unlikely(type != wanted_type)) {                                                                                                                                                                                                       \
@@ -202,7 +203,16 @@ public:
         assert(typeA == objName || typeA == objCmd);
         assert(stringA);
         type = typeA;
-        cString = copyString(stringA);
+        const Atom atom = typeA == objName ? Atom::find(stringA) : Atom();
+        interned = !atom.isNull();
+        cString = interned ? atom.c_str() : copyString(stringA);
+    }
+    explicit Object(Atom atomA)
+    {
+        assert(!atomA.isNull());
+        type = objName;
+        interned = true;
+        cString = atomA.c_str();
     }
     explicit Object(long long int64gA)
     {
@@ -368,7 +378,9 @@ public:
 
     // Special type checking.
     bool isName(const char *nameA) const { return type == objName && !strcmp(cString, nameA); }
+    bool isName(Atom nameA) const { return type == objName && cString == nameA.c_str(); }
     bool isDict(const char *dictType) const;
+    bool isDict(Atom dictType) const;
     bool isCmd(const char *cmdA) const { return type == objCmd && !strcmp(cString, cmdA); }
 
     // Accessors.
@@ -431,6 +443,12 @@ public:
         OBJECT_TYPE_CHECK(objName);
         return cString;
     }
+    // Returns a null atom if the name is not a well known one.
+    Atom getNameAtom() const
+    {
+        OBJECT_TYPE_CHECK(objName);
+        return interned ? Atom(cString) : Atom();
+    }
     Array *getArray() const
     {
         OBJECT_TYPE_CHECK(objArray);
@@ -491,8 +509,11 @@ public:
     void dictSet(const char *key, Object &&val);
     void dictRemove(const char *key);
     bool dictIs(const char *dictType) const;
+    bool dictIs(Atom dictType) const;
     Object dictLookup(const char *key, int recursion = 0) const;
+    Object dictLookup(Atom key, int recursion = 0) const;
     const Object &dictLookupNF(const char *key) const;
+    const Object &dictLookupNF(Atom key) const;
     const char *dictGetKey(int i) const;
     Object dictGetVal(int i) const;
     const Object &dictGetValNF(int i) const;
@@ -524,13 +545,14 @@ private:
     void free();
 
     ObjType type; // object type
+    bool interned; // cString is an Atom, not owned
     union { // value for each type:
         bool booln; //   boolean
         int intg; //   integer
         long long int64g; //   64-bit integer
         double real; //   real
         GooString *string; // [hex] string
-        char *cString; //   name or command, depending on objType
+        const char *cString; //   name or command, depending on objType
         Array *array; //   array
         Dict *dict; //   dictionary
         Stream *stream; //   stream
@@ -610,23 +632,46 @@ inline bool Object::dictIs(const char *dictType) const
     return dict->is(dictType);
 }
 
+inline bool Object::dictIs(Atom dictType) const
+{
+    OBJECT_TYPE_CHECK(objDict);
+    return dict->is(dictType);
+}
+
 inline bool Object::isDict(const char *dictType) const
 {
     return type == objDict && dictIs(dictType);
 }
 
+inline bool Object::isDict(Atom dictType) const
+{
+    return type == objDict && dictIs(dictType);
+}
+
 inline Object Object::dictLookup(const char *key, int recursion) const
 {
     OBJECT_TYPE_CHECK(objDict);
     return dict->lookup(key, recursion);
 }
 
+inline Object Object::dictLookup(Atom key, int recursion) const
+{
+    OBJECT_TYPE_CHECK(objDict);
+    return dict->lookup(key, recursion);
+}
+
 inline const Object &Object::dictLookupNF(const char *key) const
 {
     OBJECT_TYPE_CHECK(objDict);
     return dict->lookupNF(key);
 }
 
+inline const Object &Object::dictLookupNF(Atom key) const
+{
+    OBJECT_TYPE_CHECK(objDict);
+    return dict->lookupNF(key);
+}
+
 inline const char *Object::dictGetKey(int i) const
 {
     OBJECT_TYPE_CHECK(objDict);
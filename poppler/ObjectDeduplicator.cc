@@ -0,0 +1,527 @@
+//========================================================================
+//
+// ObjectDeduplicator.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+#include "goo/GooString.h"
+#include "PDFDoc.h"
+#include "Stream.h"
+#include "XRef.h"
+#include "ObjectDeduplicator.h"
+
+//------------------------------------------------------------------------
+// hashing
+//------------------------------------------------------------------------
+
+namespace {
+
+// 64 bit FNV-1a.  Objects with the same hash are compared before being
+// merged, so it only has to find the candidates.
+class Hasher
+{
+public:
+    Hasher() : hash(14695981039346656037ull) { }
+
+    void add(const void *data, size_t length)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    }
+    void addTag(char tag) { add(&tag, 1); }
+    void addInt(uint64_t n) { add(&n, sizeof(n)); }
+
+    uint64_t get() const { return hash; }
+
+private:
+    uint64_t hash;
+};
+
+}
+
+// Streams are copied as they are in the file, except the ones changed in
+// memory, which PDFDoc::writeObject() decodes.
+static bool isRawCopy(Stream *stream)
+{
+    return stream->getKind() != strWeird && stream->getKind() != strCrypt;
+}
+
+// Get the length of the data PDFDoc::writeObject() copies for <stream>.
+static bool getRawLength(Stream *stream, XRef *xref, Goffset *length)
+{
+    if (FilterStream *fs = dynamic_cast<FilterStream *>(stream)) {
+        BaseStream *bs = fs->getBaseStream();
+        Goffset streamEnd;
+        if (bs && xref->getStreamEnd(bs->getStart(), &streamEnd)) {
+            *length = streamEnd - bs->getStart();
+            return true;
+        }
+    }
+    Object obj = stream->getDict()->lookup("Length");
+    if (obj.isInt() || obj.isInt64()) {
+        *length = obj.getIntOrInt64();
+        return true;
+    }
+    return false;
+}
+
+// Read the next chunk of the data of <stream> copied by
+// PDFDoc::writeRawStream(), <*left> bytes of which remain.
+static int readRawChunk(Stream *stream, Goffset *left, unsigned char *buf, int size)
+{
+    int n = 0;
+    while (n < size && *left > 0) {
+        const int c = stream->getUnfilteredChar();
+        if (c == EOF) {
+            *left = 0;
+            break;
+        }
+        buf[n++] = c;
+        --*left;
+    }
+    return n;
+}
+
+static void hashObject(const Object &obj, XRef *xref, Hasher *hasher, std::vector<Ref> *refs, bool *unique);
+
+static void hashDict(const Dict *dict, bool skipLength, XRef *xref, Hasher *hasher, std::vector<Ref> *refs, bool *unique)
+{
+    hasher->addTag('d');
+    for (int i = 0; i < dict->getLength(); ++i) {
+        const char *key = dict->getKey(i);
+        if (skipLength && !strcmp(key, "Length")) {
+            continue;
+        }
+        hasher->add(key, strlen(key) + 1);
+        hashObject(dict->getValNF(i), xref, hasher, refs, unique);
+    }
+    hasher->addTag('e');
+}
+
+// Hash <obj> without the objects it refers to, which are added to <refs>.
+static void hashObject(const Object &obj, XRef *xref, Hasher *hasher, std::vector<Ref> *refs, bool *unique)
+{
+    switch (obj.getType()) {
+    case objBool:
+        hasher->addTag(obj.getBool() ? 't' : 'f');
+        break;
+    case objInt:
+    case objInt64:
+        hasher->addTag('i');
+        hasher->addInt(obj.getIntOrInt64());
+        break;
+    case objReal: {
+        const double x = obj.getReal();
+        hasher->addTag('r');
+        hasher->add(&x, sizeof(x));
+    } break;
+    case objString:
+    case objHexString: {
+        const GooString *s = obj.isString() ? obj.getString() : obj.getHexString();
+        hasher->addTag(obj.isString() ? 's' : 'h');
+        hasher->addInt(s->getLength());
+        hasher->add(s->c_str(), s->getLength());
+    } break;
+    case objName:
+        hasher->addTag('n');
+        hasher->add(obj.getName(), strlen(obj.getName()) + 1);
+        break;
+    case objNull:
+        hasher->addTag('z');
+        break;
+    case objArray:
+        hasher->addTag('a');
+        for (int i = 0; i < obj.arrayGetLength(); ++i) {
+            hashObject(obj.arrayGetNF(i), xref, hasher, refs, unique);
+        }
+        hasher->addTag('e');
+        break;
+    case objDict:
+        hashDict(obj.getDict(), false, xref, hasher, refs, unique);
+        break;
+    case objStream: {
+        Stream *stream = obj.getStream();
+        Goffset length;
+        if (!isRawCopy(stream) || !getRawLength(stream, xref, &length)) {
+            *unique = true;
+            break;
+        }
+        // the Length is written from the data
+        hashDict(stream->getDict(), true, xref, hasher, refs, unique);
+        hasher->addTag('S');
+        stream->unfilteredReset();
+        unsigned char buf[4096];
+        int n;
+        while ((n = readRawChunk(stream, &length, buf, sizeof(buf))) > 0) {
+            hasher->add(buf, n);
+        }
+        hasher->addTag('e');
+    } break;
+    case objRef:
+        hasher->addTag('R');
+        refs->push_back(obj.getRef());
+        break;
+    default:
+        *unique = true;
+        break;
+    }
+}
+
+//------------------------------------------------------------------------
+// ObjectDeduplicator
+//------------------------------------------------------------------------
+
+ObjectDeduplicator::ObjectDeduplicator() { }
+
+ObjectDeduplicator::~ObjectDeduplicator() { }
+
+void ObjectDeduplicator::addDocument(PDFDoc *doc, XRef *yRef, unsigned int numOffset, int numEnd)
+{
+    Document document;
+    document.doc = doc;
+    document.numOffset = numOffset;
+    document.numEnd = std::min(numEnd, yRef->getNumObjects());
+    for (int num = numOffset; num < document.numEnd; ++num) {
+        XRefEntry *entry = yRef->getEntry(num);
+        if (entry->type != xrefEntryFree) {
+            Node node;
+            node.ref = { num, entry->gen };
+            node.contentHash = node.hash = 0;
+            node.unique = false;
+            document.nodes.push_back(std::move(node));
+        }
+    }
+    documents.push_back(std::move(document));
+}
+
+void ObjectDeduplicator::hashDocument(Document *document)
+{
+    XRef *xref = document->doc->getXRef();
+    std::vector<Node> &nodes = document->nodes;
+    const int nNums = document->numEnd - document->numOffset;
+    std::vector<int> nodeOfNum(std::max(nNums, 0), -1); // indexed by the number in the document
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodeOfNum[nodes[i].ref.num - document->numOffset] = i;
+    }
+
+    std::vector<Ref> refs;
+    for (Node &node : nodes) {
+        const int num = node.ref.num - document->numOffset;
+        Object obj = xref->fetch(num, node.ref.gen);
+        // the objects changed in memory, like the pages rewritten by
+        // replacePageDict(), are specific to the output
+        if (xref->getEntry(num)->getFlag(XRefEntry::Updated)) {
+            node.unique = true;
+        }
+        Hasher hasher;
+        refs.clear();
+        hashObject(obj, xref, &hasher, &refs, &node.unique);
+        node.contentHash = hasher.get();
+        for (const Ref &ref : refs) {
+            if (ref.num < 0 || ref.num >= nNums || nodeOfNum[ref.num] < 0) {
+                node.unique = true;
+            } else {
+                node.children.push_back(nodeOfNum[ref.num]);
+            }
+        }
+    }
+
+    // find the reference cycles with Tarjan's algorithm, which also
+    // orders the nodes after the nodes they refer to
+    const int nNodes = nodes.size();
+    std::vector<int> index(nNodes, -1), lowLink(nNodes);
+    std::vector<bool> onStack(nNodes, false);
+    std::vector<int> stack;
+    std::vector<std::pair<int, size_t>> path; // the nodes being visited, and their next child
+    int visited = 0;
+    document->order.clear();
+    for (int root = 0; root < nNodes; ++root) {
+        if (index[root] >= 0) {
+            continue;
+        }
+        index[root] = lowLink[root] = visited++;
+        stack.push_back(root);
+        onStack[root] = true;
+        path.emplace_back(root, 0);
+        while (!path.empty()) {
+            const int v = path.back().first;
+            if (path.back().second < nodes[v].children.size()) {
+                const int w = nodes[v].children[path.back().second++];
+                if (index[w] < 0) {
+                    index[w] = lowLink[w] = visited++;
+                    stack.push_back(w);
+                    onStack[w] = true;
+                    path.emplace_back(w, 0);
+                } else if (onStack[w]) {
+                    lowLink[v] = std::min(lowLink[v], index[w]);
+                }
+                continue;
+            }
+            path.pop_back();
+            if (!path.empty()) {
+                const int u = path.back().first;
+                lowLink[u] = std::min(lowLink[u], lowLink[v]);
+            }
+            if (lowLink[v] != index[v]) {
+                continue;
+            }
+            size_t first = stack.size() - 1;
+            while (stack[first] != v) {
+                --first;
+            }
+            const std::vector<int> &children = nodes[v].children;
+            const bool cycle = first + 1 < stack.size() || std::find(children.begin(), children.end(), v) != children.end();
+            for (size_t i = first; i < stack.size(); ++i) {
+                const int w = stack[i];
+                onStack[w] = false;
+                if (cycle) {
+                    nodes[w].unique = true;
+                }
+                document->order.push_back(w);
+            }
+            stack.resize(first);
+        }
+    }
+
+    for (int v : document->order) {
+        Node &node = nodes[v];
+        Hasher hasher;
+        if (node.unique) {
+            // only ever equal to itself
+            hasher.addTag('u');
+            hasher.addInt(node.ref.num);
+        } else {
+            hasher.addInt(node.contentHash);
+            for (int child : node.children) {
+                hasher.addInt(nodes[child].hash);
+            }
+        }
+        node.hash = hasher.get();
+    }
+}
+
+int ObjectDeduplicator::deduplicate(XRef *yRef, int nThreads)
+{
+    // each document is read by one thread at a time
+    std::atomic_size_t nextDocument { 0 };
+    auto hashDocuments = [&] {
+        size_t i;
+        while ((i = nextDocument++) < documents.size()) {
+            hashDocument(&documents[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min((size_t)std::max(nThreads, 1), documents.size()); ++i) {
+        workers.emplace_back(hashDocuments);
+    }
+    hashDocuments();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    // visit the objects in the order they are written, each one after
+    // the objects it refers to, whose duplicates are known by then
+    keptRefs.assign(yRef->getNumObjects(), Ref::INVALID());
+    std::unordered_map<uint64_t, std::vector<std::pair<int, int>>> keptOfHash; // the documents and nodes of the objects kept
+    int duplicates = 0;
+    for (size_t d = 0; d < documents.size(); ++d) {
+        for (int v : documents[d].order) {
+            const Node &node = documents[d].nodes[v];
+            if (node.unique) {
+                continue;
+            }
+            std::vector<std::pair<int, int>> &candidates = keptOfHash[node.hash];
+            bool duplicate = false;
+            for (const std::pair<int, int> &candidate : candidates) {
+                const Document &keptDoc = documents[candidate.first];
+                const Node &kept = keptDoc.nodes[candidate.second];
+                if (sameObjects(documents[d], node, keptDoc, kept)) {
+                    keptRefs[node.ref.num] = kept.ref;
+                    yRef->removeIndirectObject(node.ref);
+                    ++duplicates;
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate) {
+                candidates.emplace_back(d, v);
+            }
+        }
+    }
+    return duplicates;
+}
+
+Ref ObjectDeduplicator::outputRef(Ref ref, unsigned int numOffset) const
+{
+    const Ref out = { static_cast<int>(ref.num + numOffset), ref.gen };
+    if (ref.num >= 0 && out.num < static_cast<int>(keptRefs.size()) && keptRefs[out.num].num >= 0) {
+        return keptRefs[out.num];
+    }
+    return out;
+}
+
+bool ObjectDeduplicator::sameObjects(const Document &docA, const Node &nodeA, const Document &docB, const Node &nodeB) const
+{
+    const Object a = docA.doc->getXRef()->fetch(nodeA.ref.num - docA.numOffset, nodeA.ref.gen);
+    const Object b = docB.doc->getXRef()->fetch(nodeB.ref.num - docB.numOffset, nodeB.ref.gen);
+    return sameObjects(a, docA, b, docB);
+}
+
+// Whether <a> and <b> are written the same way, but for their Length if
+// <skipLength>.
+static bool sameDicts(const Dict *a, const Dict *b, bool skipLength, const std::function<bool(const Object &, const Object &)> &sameValues)
+{
+    int i = 0, j = 0;
+    while (true) {
+        if (skipLength) {
+            while (i < a->getLength() && !strcmp(a->getKey(i), "Length")) {
+                ++i;
+            }
+            while (j < b->getLength() && !strcmp(b->getKey(j), "Length")) {
+                ++j;
+            }
+        }
+        if (i == a->getLength() || j == b->getLength()) {
+            return i == a->getLength() && j == b->getLength();
+        }
+        if (strcmp(a->getKey(i), b->getKey(j)) || !sameValues(a->getValNF(i), b->getValNF(j))) {
+            return false;
+        }
+        ++i;
+        ++j;
+    }
+}
+
+bool ObjectDeduplicator::sameObjects(const Object &a, const Document &docA, const Object &b, const Document &docB) const
+{
+    auto sameValues = [&](const Object &x, const Object &y) { return sameObjects(x, docA, y, docB); };
+
+    if ((a.isInt() || a.isInt64()) && (b.isInt() || b.isInt64())) {
+        return a.getIntOrInt64() == b.getIntOrInt64();
+    }
+    if (a.getType() != b.getType()) {
+        return false;
+    }
+    switch (a.getType()) {
+    case objBool:
+        return a.getBool() == b.getBool();
+    case objReal: {
+        const double x = a.getReal(), y = b.getReal();
+        return !memcmp(&x, &y, sizeof(x));
+    }
+    case objString:
+        return a.getString()->cmp(b.getString()) == 0;
+    case objHexString:
+        return a.getHexString()->cmp(b.getHexString()) == 0;
+    case objName:
+        return !strcmp(a.getName(), b.getName());
+    case objNull:
+        return true;
+    case objArray:
+        if (a.arrayGetLength() != b.arrayGetLength()) {
+            return false;
+        }
+        for (int i = 0; i < a.arrayGetLength(); ++i) {
+            if (!sameValues(a.arrayGetNF(i), b.arrayGetNF(i))) {
+                return false;
+            }
+        }
+        return true;
+    case objDict:
+        return sameDicts(a.getDict(), b.getDict(), false, sameValues);
+    case objStream: {
+        Stream *streamA = a.getStream();
+        Stream *streamB = b.getStream();
+        Goffset leftA, leftB;
+        if (!isRawCopy(streamA) || !isRawCopy(streamB) || !getRawLength(streamA, docA.doc->getXRef(), &leftA) || !getRawLength(streamB, docB.doc->getXRef(), &leftB) || leftA != leftB
+            || !sameDicts(streamA->getDict(), streamB->getDict(), true, sameValues)) {
+            return false;
+        }
+        streamA->unfilteredReset();
+        streamB->unfilteredReset();
+        unsigned char bufA[4096], bufB[4096];
+        while (true) {
+            const int n = readRawChunk(streamA, &leftA, bufA, sizeof(bufA));
+            if (readRawChunk(streamB, &leftB, bufB, sizeof(bufB)) != n || memcmp(bufA, bufB, n)) {
+                return false;
+            }
+            if (n == 0) {
+                return true;
+            }
+        }
+    }
+    case objRef:
+        return outputRef(a.getRef(), docA.numOffset) == outputRef(b.getRef(), docB.numOffset);
+    default:
+        return false;
+    }
+}
+
+Object ObjectDeduplicator::renumber(const Object &obj, XRef *xref, unsigned int numOffset) const
+{
+    switch (obj.getType()) {
+    case objArray: {
+        Array *array = new Array(xref);
+        for (int i = 0; i < obj.arrayGetLength(); ++i) {
+            array->add(renumber(obj.arrayGetNF(i), xref, numOffset));
+        }
+        return Object(array);
+    }
+    case objDict: {
+        const Dict *src = obj.getDict();
+        Dict *dict = new Dict(src->getXRef());
+        for (int i = 0; i < src->getLength(); ++i) {
+            dict->add(src->getKey(i), renumber(src->getValNF(i), xref, numOffset));
+        }
+        return Object(dict);
+    }
+    case objStream: {
+        Dict *dict = obj.getStream()->getDict();
+        for (int i = 0; i < dict->getLength(); ++i) {
+            const Object &value = dict->getValNF(i);
+            if (value.isRef() || value.isArray() || value.isDict()) {
+                dict->set(dict->getKey(i), renumber(value, xref, numOffset));
+            }
+        }
+        return obj.copy();
+    }
+    case objRef:
+        return Object(outputRef(obj.getRef(), numOffset));
+    default:
+        return obj.copy();
+    }
+}
+
+unsigned int ObjectDeduplicator::writeObjects(int docIndex, OutStream *outStr, XRef *yRef) const
+{
+    const Document &document = documents[docIndex];
+    XRef *xref = document.doc->getXRef();
+    unsigned int objectsCount = 0;
+    for (int n = document.numOffset; n < document.numEnd; n++) {
+        XRefEntry *entry = yRef->getEntry(n);
+        if (entry->type == xrefEntryFree) {
+            continue;
+        }
+        Ref ref = { n, entry->gen };
+        Object obj = renumber(xref->fetch(n - document.numOffset, ref.gen), xref, document.numOffset);
+        Goffset offset = PDFDoc::writeObjectHeader(&ref, outStr);
+        PDFDoc::writeObject(&obj, outStr, xref, 0, nullptr, cryptRC4, 0, 0, 0);
+        PDFDoc::writeObjectFooter(outStr);
+        yRef->add(ref, offset, true);
+        objectsCount++;
+    }
+    return objectsCount;
+}
@@ -0,0 +1,94 @@
+//========================================================================
+//
+// ObjectDeduplicator.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Writing the identical objects of merged documents once.
+//
+//========================================================================
+
+#ifndef OBJECTDEDUPLICATOR_H
+#define OBJECTDEDUPLICATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Object.h"
+
+class OutStream;
+class PDFDoc;
+class XRef;
+
+//------------------------------------------------------------------------
+// ObjectDeduplicator
+//------------------------------------------------------------------------
+
+// Finds the objects with the same content among the objects of several
+// documents marked in one output XRef, as pdfunite does with
+// PDFDoc::markPageObjects(), so that each of them is written once.
+//
+// Each object is hashed with the hashes of the objects it refers to
+// instead of its references, so that two fonts are found identical when
+// their descriptors and font files are.  Objects which are part of a
+// reference cycle, or refer to objects which aren't marked, are never
+// deduplicated.  Objects with the same hash are compared before being
+// merged, so that the output never depends on a hash collision.
+class ObjectDeduplicator
+{
+public:
+    ObjectDeduplicator();
+    ~ObjectDeduplicator();
+
+    ObjectDeduplicator(const ObjectDeduplicator &) = delete;
+    ObjectDeduplicator &operator=(const ObjectDeduplicator &) = delete;
+
+    // Add the objects of <doc> marked in <yRef> with numOffset, which
+    // are numbered from numOffset up to numEnd (excluded) in the output.
+    void addDocument(PDFDoc *doc, XRef *yRef, unsigned int numOffset, int numEnd);
+
+    // Hash the objects of the documents, in <nThreads> threads, then
+    // find the duplicates, and remove them from <yRef>.  Returns the
+    // number of duplicates.
+    int deduplicate(XRef *yRef, int nThreads);
+
+    // Return <obj>, written with numOffset, with its references to the
+    // output objects instead: a reference to a duplicate refers to the
+    // object kept instead of it.  Arrays and dicts are copied, but the
+    // dict of a stream is changed in place.
+    Object renumber(const Object &obj, XRef *xref, unsigned int numOffset) const;
+
+    // Write the objects of the document <docIndex> which are not
+    // duplicates, as PDFDoc::writePageObjects() does, and return their
+    // number.
+    unsigned int writeObjects(int docIndex, OutStream *outStr, XRef *yRef) const;
+
+private:
+    struct Node
+    {
+        Ref ref; // in the output
+        uint64_t contentHash; // of the object without its references
+        uint64_t hash; // with the hashes of the objects it refers to
+        std::vector<int> children; // the nodes it refers to, in order
+        bool unique; // can't be deduplicated
+    };
+
+    struct Document
+    {
+        PDFDoc *doc;
+        unsigned int numOffset;
+        int numEnd;
+        std::vector<Node> nodes;
+        std::vector<int> order; // the nodes, each after the nodes it refers to
+    };
+
+    static void hashDocument(Document *document);
+    bool sameObjects(const Document &docA, const Node &nodeA, const Document &docB, const Node &nodeB) const;
+    bool sameObjects(const Object &a, const Document &docA, const Object &b, const Document &docB) const;
+    Ref outputRef(Ref ref, unsigned int numOffset) const;
+
+    std::vector<Document> documents;
+    std::vector<Ref> keptRefs; // indexed by output object number, the object kept instead of a duplicate, or Ref::INVALID()
+};
+
+#endif
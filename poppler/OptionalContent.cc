@@ -31,7 +31,7 @@
 
 //------------------------------------------------------------------------
 
-OCGs::OCGs(Object *ocgObject, XRef *xref) : m_xref(xref)
+OCGs::OCGs(Object *ocgObject, XRef *xref) : m_xref(xref), stateGeneration(0)
 {
     // we need to parse the dictionary here, and build optionalContentGroups
     ok = true;
@@ -49,7 +49,7 @@ OCGs::OCGs(Object *ocgObject, XRef *xref) : m_xref(xref)
         if (!ocgDict.isDict()) {
             break;
         }
-        auto thisOptionalContentGroup = std::make_unique<OptionalContentGroup>(ocgDict.getDict());
+        auto thisOptionalContentGroup = std::make_unique<OptionalContentGroup>(ocgDict.getDict(), &stateGeneration);
         const Object &ocgRef = ocgList.arrayGetNF(i);
         if (!ocgRef.isRef()) {
             break;
@@ -287,7 +287,7 @@ bool OCGs::anyOff(Array *ocgArray)
 
 //------------------------------------------------------------------------
 
-OptionalContentGroup::OptionalContentGroup(Dict *ocgDict) : m_name(nullptr)
+OptionalContentGroup::OptionalContentGroup(Dict *ocgDict, std::atomic<unsigned int> *stateGenerationA) : m_name(nullptr), m_state(On), stateGeneration(stateGenerationA)
 {
     Object ocgName = ocgDict->lookup("Name");
     if (!ocgName.isString()) {
@@ -328,6 +328,7 @@ OptionalContentGroup::OptionalContentGroup(GooString *label)
 {
     m_name = label;
     m_state = On;
+    stateGeneration = nullptr;
 }
 
 const GooString *OptionalContentGroup::getName() const
@@ -340,6 +341,14 @@ void OptionalContentGroup::setRef(const Ref ref)
     m_ref = ref;
 }
 
+void OptionalContentGroup::setState(State state)
+{
+    m_state = state;
+    if (stateGeneration) {
+        ++*stateGeneration;
+    }
+}
+
 Ref OptionalContentGroup::getRef() const
 {
     return m_ref;
@@ -17,6 +17,7 @@
 
 #include "Object.h"
 #include "CharTypes.h"
+#include <atomic>
 #include <unordered_map>
 #include <memory>
 
@@ -48,6 +49,11 @@ public:
 
     bool optContentIsVisible(const Object *dictRef);
 
+    // Return a count incremented each time the state of one of the
+    // groups is set, so that what was drawn or extracted with the former
+    // states can be told apart.
+    unsigned int getStateGeneration() const { return stateGeneration; }
+
 private:
     bool ok;
 
@@ -62,6 +68,7 @@ private:
     Object order;
     Object rbgroups;
     XRef *m_xref;
+    std::atomic<unsigned int> stateGeneration;
 };
 
 //------------------------------------------------------------------------
@@ -83,7 +90,9 @@ public:
         ocUsageUnset
     };
 
-    OptionalContentGroup(Dict *dict);
+    // <stateGenerationA> is the counter of the OCGs the group belongs to,
+    // incremented by setState().
+    OptionalContentGroup(Dict *dict, std::atomic<unsigned int> *stateGenerationA = nullptr);
 
     OptionalContentGroup(GooString *label);
 
@@ -98,7 +107,7 @@ public:
     void setRef(const Ref ref);
 
     State getState() const { return m_state; };
-    void setState(State state) { m_state = state; };
+    void setState(State state);
 
     UsageState getViewState() const { return viewState; }
     UsageState getPrintState() const { return printState; }
@@ -109,6 +118,7 @@ private:
     State m_state;
     UsageState viewState; // suggested state when viewing
     UsageState printState; // suggested state when printing
+    std::atomic<unsigned int> *stateGeneration; // state generation of the OCGs, or nullptr
 };
 
 //------------------------------------------------------------------------
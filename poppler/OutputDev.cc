@@ -43,6 +43,8 @@ OutputDev::OutputDev()
     : iccColorSpaceCache(5)
 #endif
 {
+    pageAbortCheckCbk = nullptr;
+    pageAbortCheckCbkData = nullptr;
 }
 
 OutputDev::~OutputDev() = default;
@@ -134,6 +134,18 @@ public:
     // Dump page contents to display.
     virtual void dump() { }
 
+    // Set the callback which the device checks in its long operations,
+    // like decoding an image or filling a shading, to stop them early
+    // when it returns true.  Gfx sets it for the page it displays.
+    void setAbortCheckCbk(bool (*abortCheckCbkA)(void *data), void *abortCheckCbkDataA)
+    {
+        pageAbortCheckCbk = abortCheckCbkA;
+        pageAbortCheckCbkData = abortCheckCbkDataA;
+    }
+
+    // Check whether the display of the page has been aborted.
+    bool checkAbort() { return pageAbortCheckCbk && (*pageAbortCheckCbk)(pageAbortCheckCbkData); }
+
     virtual void initGfxState(GfxState *state)
     {
 #ifdef USE_CMS
@@ -363,6 +375,8 @@ private:
     double defCTM[6]; // default coordinate transform matrix
     double defICTM[6]; // inverse of default CTM
     std::unique_ptr<std::unordered_map<std::string, ProfileData>> profileHash;
+    bool (*pageAbortCheckCbk)(void *data); // callback to check for an abort
+    void *pageAbortCheckCbkData;
 
 #ifdef USE_CMS
     GfxLCMSProfilePtr displayprofile;
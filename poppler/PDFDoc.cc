@@ -55,7 +55,9 @@
 #include <config.h>
 #include <poppler-config.h>
 
+#include <algorithm>
 #include <cctype>
+#include <cstdarg>
 #include <clocale>
 #include <cstdio>
 #include <cerrno>
@@ -90,6 +92,7 @@
 #include "Hints.h"
 #include "UTF.h"
 #include "JSInfo.h"
+#include "PDFSplitter.h"
 
 //------------------------------------------------------------------------
 
@@ -107,6 +110,49 @@
     1024 // read this many bytes at end of file
          //   to look for 'startxref'
 
+//------------------------------------------------------------------------
+// StringOutStream
+//------------------------------------------------------------------------
+
+namespace {
+
+// Keeps the bytes of the objects PageSplitCache shares between pages.
+class StringOutStream : public OutStream
+{
+public:
+    StringOutStream() = default;
+
+    void close() override { }
+    Goffset getPos() override { return str.size(); }
+    void put(char c) override { str.push_back(c); }
+    void write(const char *data, size_t length) override { str.append(data, length); }
+    void printf(const char *format, ...) override GCC_PRINTF_FORMAT(2, 3);
+
+    std::string str;
+};
+
+void StringOutStream::printf(const char *format, ...)
+{
+    va_list argptr;
+    va_start(argptr, format);
+    va_list argptr2;
+    va_copy(argptr2, argptr);
+    char buf[256];
+    const int n = vsnprintf(buf, sizeof(buf), format, argptr);
+    if (n >= (int)sizeof(buf)) {
+        const size_t pos = str.size();
+        str.resize(pos + n + 1);
+        vsnprintf(&str[pos], n + 1, format, argptr2);
+        str.resize(pos + n);
+    } else if (n > 0) {
+        str.append(buf, n);
+    }
+    va_end(argptr2);
+    va_end(argptr);
+}
+
+}
+
 //------------------------------------------------------------------------
 // PDFDoc
 //------------------------------------------------------------------------
@@ -128,6 +174,7 @@ void PDFDoc::init()
     startXRefPos = -1;
     secHdlr = nullptr;
     pageCache = nullptr;
+    pageSplit = nullptr;
 }
 
 PDFDoc::PDFDoc()
@@ -642,6 +689,12 @@ void PDFDoc::displayPage(OutputDev *out, int page, double hDPI, double vDPI, int
         getPage(page)->display(out, hDPI, vDPI, rotate, useMediaBox, crop, printing, abortCheckCbk, abortCheckCbkData, annotDisplayDecideCbk, annotDisplayDecideCbkData, copyXRef);
 }
 
+bool PDFDoc::displayPageThumb(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox)
+{
+    Page *p = getPage(page);
+    return p && p->displayThumb(out, hDPI, vDPI, rotate, useMediaBox);
+}
+
 void PDFDoc::displayPages(OutputDev *out, int firstPage, int lastPage, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, bool (*abortCheckCbk)(void *data), void *abortCheckCbkData,
                           bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data), void *annotDisplayDecideCbkData)
 {
@@ -659,6 +712,49 @@ void PDFDoc::displayPageSlice(OutputDev *out, int page, double hDPI, double vDPI
         getPage(page)->displaySlice(out, hDPI, vDPI, rotate, useMediaBox, crop, sliceX, sliceY, sliceW, sliceH, printing, abortCheckCbk, abortCheckCbkData, annotDisplayDecideCbk, annotDisplayDecideCbkData, copyXRef);
 }
 
+bool PDFDoc::displayPageStrips(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, int sliceX, int sliceY, int sliceW, int sliceH, int stripHeight,
+                               bool (*stripCbk)(int stripY, int stripH, void *data), void *stripCbkData, bool (*abortCheckCbk)(void *data), void *abortCheckCbkData, bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data),
+                               void *annotDisplayDecideCbkData)
+{
+    Page *p = getPage(page);
+    if (!p) {
+        return false;
+    }
+
+    if (sliceW < 0 || sliceH < 0) {
+        // the size of the bitmap SplashOutputDev would use for the page
+        int pageRotate = (rotate + p->getRotate()) % 360;
+        if (pageRotate < 0) {
+            pageRotate += 360;
+        }
+        const PDFRectangle *box = useMediaBox ? p->getMediaBox() : p->getCropBox();
+        double w = box->x2 - box->x1;
+        double h = box->y2 - box->y1;
+        if (pageRotate == 90 || pageRotate == 270) {
+            std::swap(w, h);
+        }
+        sliceX = sliceY = 0;
+        sliceW = std::max((int)(w * hDPI / 72 + 0.5), 1);
+        sliceH = std::max((int)(h * vDPI / 72 + 0.5), 1);
+    }
+    if (stripHeight <= 0) {
+        stripHeight = sliceH;
+    }
+
+    for (int y = 0; y < sliceH; y += stripHeight) {
+        const int h = std::min(stripHeight, sliceH - y);
+        p->displaySlice(out, hDPI, vDPI, rotate, useMediaBox, crop, sliceX, sliceY + y, sliceW, h, printing, abortCheckCbk, abortCheckCbkData, annotDisplayDecideCbk, annotDisplayDecideCbkData);
+        if (abortCheckCbk && (*abortCheckCbk)(abortCheckCbkData)) {
+            return false;
+        }
+        if (!(*stripCbk)(y, h, stripCbkData)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 Links *PDFDoc::getLinks(int page)
 {
     Page *p = getPage(page);
@@ -847,7 +943,40 @@ Hints *PDFDoc::getHints()
     return hints;
 }
 
+bool PDFDoc::prefetchPages(int firstPage, int lastPage)
+{
+    if (str->getKind() != strCachedFile || !isLinearized()) {
+        return false;
+    }
+
+    Hints *h = getHints();
+    if (!h || !h->isOk()) {
+        return false;
+    }
+
+    firstPage = std::max(firstPage, 1);
+    lastPage = std::min(lastPage, getNumPages());
+    std::vector<ByteRange> ranges;
+    for (int page = firstPage; page <= lastPage; ++page) {
+        std::vector<ByteRange> *pageRanges = h->getPageRanges(page);
+        if (pageRanges) {
+            ranges.insert(ranges.end(), pageRanges->begin(), pageRanges->end());
+            delete pageRanges;
+        }
+    }
+    if (ranges.empty()) {
+        return false;
+    }
+
+    return static_cast<CachedFileStream *>(str)->prefetch(ranges);
+}
+
 int PDFDoc::savePageAs(const GooString *name, int pageNo)
+{
+    return savePageAs(name, pageNo, nullptr, nullptr);
+}
+
+int PDFDoc::savePageAs(const GooString *name, int pageNo, PageSplitCache *cache, bool *exact)
 {
     FILE *f;
     OutStream *outStr;
@@ -871,6 +1000,17 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
         error(errInternal, -1, "Illegal pageNo: {0:d}({1:d})", pageNo, getNumPages());
         return errOpenFile;
     }
+    PageSplit split;
+    if (cache) {
+        split.cache = cache;
+        split.exact = true;
+        split.rootNum = xref->getRootNum();
+        const Object &infoRef = xref->getTrailerDict()->dictLookupNF("Info");
+        split.infoNum = infoRef.isRef() ? infoRef.getRefNum() : -1;
+        split.rootChanged = split.infoChanged = false;
+        pageSplit = &split;
+    }
+
     const PDFRectangle *cropBox = nullptr;
     if (getCatalog()->getPage(pageNo)->isCropped()) {
         cropBox = getCatalog()->getPage(pageNo)->getCropBox();
@@ -881,6 +1021,10 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
 
     if (!(f = openFile(name->c_str(), "wb"))) {
         error(errIO, -1, "Couldn't open file '{0:t}'", name);
+        if (pageSplit) {
+            pageSplit = nullptr;
+            xref->discardModifiedObjects();
+        }
         return errOpenFile;
     }
     outStr = new FileOutStream(f, 0);
@@ -892,6 +1036,15 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
     }
     countRef = new XRef();
     Object *trailerObj = getXRef()->getTrailerDict();
+    if (pageSplit) {
+        // the trailer isn't an object, and the page is a modified one
+        split.containers.emplace_back(trailerObj->isDict() ? trailerObj->getDict() : nullptr, PageSplit::containerPrivate);
+        split.containers.emplace_back(page.getDict(), PageSplit::containerPrivate);
+        const Object &pageAnnots = page.getDict()->lookupNF("Annots");
+        if (pageAnnots.isArray()) {
+            split.containers.emplace_back(pageAnnots.getArray(), PageSplit::containerPrivate);
+        }
+    }
     if (trailerObj->isDict()) {
         markPageObjects(trailerObj->getDict(), yRef, countRef, 0, refPage->num, rootNum + 2);
     }
@@ -902,6 +1055,9 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
     Object infoObj = getXRef()->getDocInfo();
     if (infoObj.isDict()) {
         Dict *infoDict = infoObj.getDict();
+        if (pageSplit) {
+            split.containers.emplace_back(infoDict, PageSplit::containerInfo);
+        }
         markPageObjects(infoDict, yRef, countRef, 0, refPage->num, rootNum + 2);
         if (trailerObj->isDict()) {
             Dict *trailerDict = trailerObj->getDict();
@@ -918,6 +1074,9 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
     // get and mark output intents etc.
     Object catObj = getXRef()->getCatalog();
     Dict *catDict = catObj.getDict();
+    if (pageSplit) {
+        split.containers.emplace_back(catDict, PageSplit::containerRoot);
+    }
     Object pagesObj = catDict->lookup("Pages");
     Object afObj = catDict->lookupNF("AcroForm").copy();
     if (!afObj.isNull()) {
@@ -1000,6 +1159,12 @@ int PDFDoc::savePageAs(const GooString *name, int pageNo)
     delete countRef;
     delete outStr;
 
+    if (pageSplit) {
+        *exact = split.exact && !xref->isReconstructed();
+        pageSplit = nullptr;
+        xref->discardModifiedObjects();
+    }
+
     return errNone;
 }
 
@@ -1246,8 +1411,10 @@ void PDFDoc::writeStream(Stream *str, OutStream *outStr)
 {
     outStr->printf("stream\r\n");
     str->reset();
-    for (int c = str->getChar(); c != EOF; c = str->getChar()) {
-        outStr->printf("%c", c);
+    char buf[4096];
+    int n;
+    while ((n = str->doGetChars(sizeof(buf), reinterpret_cast<unsigned char *>(buf))) > 0) {
+        outStr->write(buf, n);
     }
     outStr->printf("\r\nendstream\r\n");
 }
@@ -1268,14 +1435,21 @@ void PDFDoc::writeRawStream(Stream *str, OutStream *outStr)
 
     outStr->printf("stream\r\n");
     str->unfilteredReset();
+    char buf[4096];
+    size_t n = 0;
     for (Goffset i = 0; i < length; i++) {
         int c = str->getUnfilteredChar();
         if (unlikely(c == EOF)) {
             error(errSyntaxError, -1, "PDFDoc::writeRawStream: EOF reading stream");
             break;
         }
-        outStr->printf("%c", c);
+        buf[n++] = c;
+        if (n == sizeof(buf)) {
+            outStr->write(buf, n);
+            n = 0;
+        }
     }
+    outStr->write(buf, n);
     str->reset();
     outStr->printf("\r\nendstream\r\n");
 }
@@ -1716,6 +1890,9 @@ void PDFDoc::markObject(Object *obj, XRef *xRef, XRef *countRef, unsigned int nu
             if (entry->gen > 9)
                 break;
         }
+        if (pageSplit && numOffset == 0 && markCachedClosure(obj->getRef(), xRef)) {
+            break;
+        }
         Object obj1 = getXRef()->fetch(obj->getRef());
         markObject(&obj1, xRef, countRef, numOffset, oldRefNum, newRefNum);
     } break;
@@ -1724,6 +1901,87 @@ void PDFDoc::markObject(Object *obj, XRef *xRef, XRef *countRef, unsigned int nu
     }
 }
 
+// Note that savePageAs() is about to change <container> in place.
+void PDFDoc::changingInPlace(const void *container)
+{
+    for (const auto &known : pageSplit->containers) {
+        if (known.first == container) {
+            if (known.second == PageSplit::containerRoot) {
+                pageSplit->rootChanged = getXRef()->getEntry(pageSplit->rootNum)->type == xrefEntryCompressed;
+            } else if (known.second == PageSplit::containerInfo) {
+                pageSplit->infoChanged = getXRef()->getEntry(pageSplit->infoNum)->type == xrefEntryCompressed;
+            }
+            return;
+        }
+    }
+    // without object streams, every fetch parses the object again
+    if (pageSplit->cache->hasCompressedObjects(getXRef())) {
+        pageSplit->exact = false;
+    }
+}
+
+// Mark the objects markObject() marks for <ref>, if the cache knows
+// them.
+bool PDFDoc::markCachedClosure(Ref ref, XRef *xRef)
+{
+    if ((ref.num == pageSplit->rootNum && pageSplit->rootChanged) || (ref.num == pageSplit->infoNum && pageSplit->infoChanged)) {
+        pageSplit->exact = false;
+    }
+    // once the output isn't exact, what is fetched may not be the
+    // objects of the file anymore
+    if (!pageSplit->exact || !pageSplit->cache->getClosure(getXRef(), ref, &pageSplit->closure)) {
+        return false;
+    }
+    for (const Ref &r : pageSplit->closure) {
+        if (r.num >= xRef->getNumObjects() || xRef->getEntry(r.num)->type == xrefEntryFree) {
+            xRef->add(r.num, r.gen, 0, true);
+            if (getXRef()->getEntry(r.num)->type == xrefEntryCompressed) {
+                xRef->getEntry(r.num)->type = xrefEntryCompressed;
+            }
+        }
+    }
+    return true;
+}
+
+// Write the object <ref> as writePageObjects() does, if the cache has its
+// bytes, or it is worth keeping them.
+bool PDFDoc::writeCachedObject(OutStream *outStr, XRef *xRef, Ref ref, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength)
+{
+    if ((ref.num == pageSplit->rootNum && pageSplit->rootChanged) || (ref.num == pageSplit->infoNum && pageSplit->infoChanged)) {
+        pageSplit->exact = false;
+    }
+    if (!pageSplit->exact || ref.num == pageSplit->rootNum || ref.num == pageSplit->infoNum) {
+        return false;
+    }
+    XRefEntry *entry = getXRef()->getEntry(ref.num);
+    if (entry->getFlag(XRefEntry::Updated) || (entry->type != xrefEntryUncompressed && entry->type != xrefEntryCompressed)) {
+        return false;
+    }
+
+    const bool unencrypted = xRef->getEntry(ref.num)->getFlag(XRefEntry::Unencrypted);
+    bool keep = false;
+    std::shared_ptr<const std::string> bytes = pageSplit->cache->getObjectBytes(ref, unencrypted, &keep);
+    if (!bytes) {
+        if (!keep) {
+            return false;
+        }
+        Object obj = getXRef()->fetch(ref);
+        StringOutStream strOut;
+        if (unencrypted) {
+            writeObject(&obj, &strOut, nullptr, cryptRC4, 0, 0, 0);
+        } else {
+            writeObject(&obj, &strOut, fileKey, encAlgorithm, keyLength, ref);
+        }
+        bytes = std::make_shared<const std::string>(std::move(strOut.str));
+        pageSplit->cache->putObjectBytes(ref, unencrypted, bytes);
+    }
+    Goffset offset = writeObjectHeader(&ref, outStr);
+    outStr->write(bytes->data(), bytes->size());
+    writeObjectFooter(outStr);
+    xRef->add(ref, offset, true);
+    return true;
+}
+
 void PDFDoc::replacePageDict(int pageNo, int rotate, const PDFRectangle *mediaBox, const PDFRectangle *cropBox)
 {
     Ref *refPage = getCatalog()->getPageRef(pageNo);
@@ -1761,6 +2019,9 @@ void PDFDoc::replacePageDict(int pageNo, int rotate, const PDFRectangle *mediaBo
 
 void PDFDoc::markPageObjects(Dict *pageDict, XRef *xRef, XRef *countRef, unsigned int numOffset, int oldRefNum, int newRefNum, std::set<Dict *> *alreadyMarkedDicts)
 {
+    if (pageSplit && (pageDict->hasKey("OpenAction") || pageDict->hasKey("Outlines") || pageDict->hasKey("StructTreeRoot"))) {
+        changingInPlace(pageDict);
+    }
     pageDict->remove("OpenAction");
     pageDict->remove("Outlines");
     pageDict->remove("StructTreeRoot");
@@ -1808,6 +2069,9 @@ bool PDFDoc::markAnnotations(Object *annotsObj, XRef *xRef, XRef *countRef, unsi
                                     continue;
                                 }
                             }
+                            if (pageSplit && !annotsObj->isRef()) {
+                                changingInPlace(array);
+                            }
                             array->remove(i);
                             modified = true;
                             continue;
@@ -1866,6 +2130,11 @@ void PDFDoc::markAcroForm(Object *afObj, XRef *xRef, XRef *countRef, unsigned in
         for (int i = 0; i < dict->getLength(); i++) {
             if (strcmp(dict->getKey(i), "Fields") == 0) {
                 Object fields = dict->getValNF(i).copy();
+                if (pageSplit && fields.isArray()) {
+                    // changed in place in the AcroForm dict, which is either
+                    // set as modified or part of the catalog
+                    pageSplit->containers.emplace_back(fields.getArray(), afObj->isRef() ? PageSplit::containerPrivate : PageSplit::containerRoot);
+                }
                 modified = markAnnotations(&fields, xRef, countRef, numOffset, oldRefNum, newRefNum);
             } else {
                 Object obj = dict->getValNF(i).copy();
@@ -1910,6 +2179,9 @@ unsigned int PDFDoc::writePageObjects(OutStream *outStr, XRef *xRef, unsigned in
             ref.num = n;
             ref.gen = xRef->getEntry(n)->gen;
             objectsCount++;
+            if (pageSplit && numOffset == 0 && !combine && writeCachedObject(outStr, xRef, ref, fileKey, encAlgorithm, keyLength)) {
+                continue;
+            }
             Object obj = getXRef()->fetch(ref.num - numOffset, ref.gen);
             Goffset offset = writeObjectHeader(&ref, outStr);
             if (combine) {
@@ -44,6 +44,7 @@
 #define PDFDOC_H
 
 #include <mutex>
+#include <vector>
 
 #include "poppler-config.h"
 #include <cstdio>
@@ -67,6 +68,7 @@ class Linearization;
 class SecurityHandler;
 class Hints;
 class StructTreeRoot;
+class PageSplitCache;
 
 enum PDFWriteMode
 {
@@ -186,10 +188,23 @@ public:
     // Get page.
     Page *getPage(int page);
 
+    // Load the data needed to display pages <firstPage>..<lastPage>, as
+    // given by the hint tables, ahead of their display.  This only helps
+    // (and is only done) for linearized documents loaded incrementally,
+    // e.g. over HTTP, where all the byte ranges are requested at once
+    // instead of as the parser reaches them.  Returns false if nothing
+    // was prefetched.
+    bool prefetchPages(int firstPage, int lastPage);
+
     // Display a page.
     void displayPage(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, bool (*abortCheckCbk)(void *data) = nullptr, void *abortCheckCbkData = nullptr,
                      bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data) = nullptr, void *annotDisplayDecideCbkData = nullptr, bool copyXRef = false);
 
+    // Display the embedded thumbnail of a page, as Page::displayThumb()
+    // does, if it's large enough.  Returns false if it's not, and the page
+    // should be displayed instead.
+    bool displayPageThumb(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox);
+
     // Display a range of pages.
     void displayPages(OutputDev *out, int firstPage, int lastPage, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, bool (*abortCheckCbk)(void *data) = nullptr, void *abortCheckCbkData = nullptr,
                       bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data) = nullptr, void *annotDisplayDecideCbkData = nullptr);
@@ -198,6 +213,18 @@ public:
     void displayPageSlice(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, int sliceX, int sliceY, int sliceW, int sliceH, bool (*abortCheckCbk)(void *data) = nullptr,
                           void *abortCheckCbkData = nullptr, bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data) = nullptr, void *annotDisplayDecideCbkData = nullptr, bool copyXRef = false);
 
+    // Display a page, or the part of it given as in displayPageSlice
+    // (sliceW or sliceH < 0 meaning the whole page), in horizontal strips
+    // of at most <stripHeight> pixel rows.  Each strip is a page slice of
+    // its own, so the output device only ever holds one strip, at the
+    // cost of interpreting the page contents once per strip.  After each
+    // strip <stripCbk> is called with its position in the image of the
+    // whole slice; rendering stops if it returns false.  Returns false
+    // if the page doesn't exist or the rendering was stopped or aborted.
+    bool displayPageStrips(OutputDev *out, int page, double hDPI, double vDPI, int rotate, bool useMediaBox, bool crop, bool printing, int sliceX, int sliceY, int sliceW, int sliceH, int stripHeight,
+                           bool (*stripCbk)(int stripY, int stripH, void *data), void *stripCbkData, bool (*abortCheckCbk)(void *data) = nullptr, void *abortCheckCbkData = nullptr,
+                           bool (*annotDisplayDecideCbk)(Annot *annot, void *user_data) = nullptr, void *annotDisplayDecideCbkData = nullptr);
+
     // Find a page, given its object ID.  Returns page number, or 0 if
     // not found.
     int findPage(const Ref ref) { return catalog->findPage(ref); }
@@ -285,6 +312,14 @@ public:
 
     // Save one page with another name.
     int savePageAs(const GooString *name, int pageNo);
+    // Save one page with another name, sharing through <cache> the work
+    // done for the objects it has in common with the pages saved by other
+    // calls.  The document is left unmodified, so that its other pages
+    // can be saved next.  *exact is set to false when the file may differ
+    // from the one savePageAs(name, pageNo) writes from a newly opened
+    // document: the page must then be saved again from a new PDFDoc, and
+    // this one isn't fit to save more pages.
+    int savePageAs(const GooString *name, int pageNo, PageSplitCache *cache, bool *exact);
     // Save this file with another name.
     int saveAs(const GooString *name, PDFWriteMode mode = writeStandard);
     // Save this file in the given output stream.
@@ -307,6 +342,9 @@ public:
     static void writeObject(Object *obj, OutStream *outStr, XRef *xref, unsigned int numOffset, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength, int objNum, int objGen, std::set<Dict *> *alreadyWrittenDicts = nullptr);
     static void writeObject(Object *obj, OutStream *outStr, XRef *xref, unsigned int numOffset, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength, Ref ref, std::set<Dict *> *alreadyWrittenDicts = nullptr);
     static void writeHeader(OutStream *outStr, int major, int minor);
+    // Write object header to current file stream and return its offset
+    static Goffset writeObjectHeader(Ref *ref, OutStream *outStr);
+    static void writeObjectFooter(OutStream *outStr);
 
     static Object createTrailerDict(int uxrefSize, bool incrUpdate, Goffset startxRef, Ref *root, XRef *xRef, const char *fileName, Goffset fileSize);
     static void writeXRefTableTrailer(Object &&trailerDict, XRef *uxref, bool writeAllEntries, Goffset uxrefOffset, OutStream *outStr, XRef *xRef);
@@ -318,11 +356,35 @@ private:
     // insert referenced objects in XRef
     void markDictionnary(Dict *dict, XRef *xRef, XRef *countRef, unsigned int numOffset, int oldRefNum, int newRefNum, std::set<Dict *> *alreadyMarkedDicts);
     void markObject(Object *obj, XRef *xRef, XRef *countRef, unsigned int numOffset, int oldRefNum, int newRefNum, std::set<Dict *> *alreadyMarkedDicts = nullptr);
+
+    // What savePageAs() tracks while it uses a PageSplitCache.  The dicts
+    // and arrays it changes in place, without setModifiedObject(), may be
+    // shared with the cached object streams of the XRef, and the page file
+    // then depends on what is cached when they are fetched again: such
+    // pages are not exact.
+    struct PageSplit
+    {
+        enum ContainerKind
+        {
+            containerPrivate, // changes are never fetched again
+            containerRoot, // part of the catalog
+            containerInfo // part of the info dict
+        };
+
+        PageSplitCache *cache;
+        bool exact; // the output can't depend on the cached object streams
+        int rootNum; // object number of the catalog
+        int infoNum; // object number of the info dict, or -1
+        bool rootChanged; // the catalog, in an object stream, was changed in place
+        bool infoChanged; // the info dict, in an object stream, was changed in place
+        std::vector<std::pair<const void *, ContainerKind>> containers; // the known dicts and arrays
+        std::vector<Ref> closure; // buffer for PageSplitCache::getClosure()
+    };
+    void changingInPlace(const void *container);
+    bool markCachedClosure(Ref ref, XRef *xRef);
+    bool writeCachedObject(OutStream *outStr, XRef *xRef, Ref ref, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength);
     static void writeDictionnary(Dict *dict, OutStream *outStr, XRef *xRef, unsigned int numOffset, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength, Ref ref, std::set<Dict *> *alreadyWrittenDicts);
 
-    // Write object header to current file stream and return its offset
-    static Goffset writeObjectHeader(Ref *ref, OutStream *outStr);
-    static void writeObjectFooter(OutStream *outStr);
 
     inline void writeObject(Object *obj, OutStream *outStr, unsigned char *fileKey, CryptAlgorithm encAlgorithm, int keyLength, int objNum, int objGen)
     {
@@ -379,6 +441,7 @@ private:
     Hints *hints;
     Outline *outline;
     Page **pageCache;
+    PageSplit *pageSplit; // set while savePageAs() uses a PageSplitCache
 
     bool ok;
     int errCode;
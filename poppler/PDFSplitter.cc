@@ -0,0 +1,439 @@
+//========================================================================
+//
+// PDFSplitter.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+
+#include "goo/GooString.h"
+#include "ErrorCodes.h"
+#include "PDFDoc.h"
+#include "XRef.h"
+#include "PDFSplitter.h"
+
+//------------------------------------------------------------------------
+// PageSplitCache
+//------------------------------------------------------------------------
+
+// rough size of an entry of the hash maps
+static constexpr size_t mapEntrySize = 48;
+
+PageSplitCache::PageSplitCache(size_t maxBytesA)
+{
+    maxBytes = maxBytesA;
+    curBytes = 0;
+    compressedObjects = -1;
+}
+
+bool PageSplitCache::getClosure(XRef *xref, Ref ref, std::vector<Ref> *closure)
+{
+    int component;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        component = lookupComponent(ref);
+    }
+    if (component == unknown) {
+        computeClosure(xref, ref);
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        component = lookupComponent(ref);
+        if (component == unknown || component == uncacheable || !collectClosure(component, closure)) {
+            return false;
+        }
+    }
+
+    // the cache describes the objects of the file, not their modified
+    // versions
+    for (const Ref &r : *closure) {
+        if (xref->getEntry(r.num)->getFlag(XRefEntry::Updated)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const std::string> PageSplitCache::getObjectBytes(Ref ref, bool unencrypted, bool *keep)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    *keep = false;
+    auto it = objectBytes[unencrypted].find(ref);
+    if (it == objectBytes[unencrypted].end()) {
+        if (reserve(mapEntrySize)) {
+            objectBytes[unencrypted].emplace(ref, nullptr);
+        }
+        return nullptr;
+    }
+    if (!it->second) {
+        *keep = curBytes < maxBytes;
+    }
+    return it->second;
+}
+
+void PageSplitCache::putObjectBytes(Ref ref, bool unencrypted, const std::shared_ptr<const std::string> &bytes)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = objectBytes[unencrypted].find(ref);
+    if (it != objectBytes[unencrypted].end() && !it->second && reserve(bytes->size())) {
+        it->second = bytes;
+    }
+}
+
+bool PageSplitCache::hasCompressedObjects(XRef *xref)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (compressedObjects >= 0) {
+            return compressedObjects;
+        }
+    }
+    int compressed = 0;
+    for (int i = 0; i < xref->getNumObjects() && !compressed; ++i) {
+        compressed = xref->getEntry(i, false)->type == xrefEntryCompressed;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    compressedObjects = compressed;
+    return compressed;
+}
+
+int PageSplitCache::lookupComponent(Ref ref) const
+{
+    auto it = componentOfRef.find(ref);
+    return it != componentOfRef.end() ? it->second : unknown;
+}
+
+bool PageSplitCache::collectClosure(int component, std::vector<Ref> *closure) const
+{
+    closure->clear();
+    std::unordered_set<int> visited { component };
+    std::unordered_set<int> nums;
+    std::vector<int> todo { component };
+    while (!todo.empty()) {
+        const Component &c = components[todo.back()];
+        todo.pop_back();
+        for (const Ref &r : c.refs) {
+            // markObject() keeps the first generation it finds for an
+            // object, which depends on the order of the references
+            if (!nums.insert(r.num).second) {
+                return false;
+            }
+            closure->push_back(r);
+        }
+        for (int child : c.children) {
+            if (visited.insert(child).second) {
+                todo.push_back(child);
+            }
+        }
+    }
+    return true;
+}
+
+// Add the references in <obj> to <refs>, skipping the ones to free
+// entries as PDFDoc::markObject() does.  Clears *cacheable if <obj> has
+// a dict with annotations, which markObject() hands to markAnnotations(),
+// or a reference out of the xref table.
+static void collectRefs(XRef *xref, const Object &obj, std::vector<Ref> *refs, bool *cacheable)
+{
+    switch (obj.getType()) {
+    case objArray:
+        for (int i = 0; i < obj.arrayGetLength(); ++i) {
+            collectRefs(xref, obj.arrayGetNF(i), refs, cacheable);
+        }
+        break;
+    case objDict:
+    case objStream: {
+        const Dict *dict = obj.isDict() ? obj.getDict() : obj.getStream()->getDict();
+        if (dict->hasKey(Atoms::Annots)) {
+            *cacheable = false;
+        }
+        for (int i = 0; i < dict->getLength(); ++i) {
+            collectRefs(xref, dict->getValNF(i), refs, cacheable);
+        }
+    } break;
+    case objRef: {
+        const Ref ref = obj.getRef();
+        if (ref.num < 0 || ref.num >= xref->getNumObjects()) {
+            *cacheable = false;
+        } else if (xref->getEntry(ref.num)->type != xrefEntryFree) {
+            refs->push_back(ref);
+        }
+    } break;
+    default:
+        break;
+    }
+}
+
+// Find the components of the objects reachable from <ref> with Tarjan's
+// algorithm, and add the ones not known yet to the cache.
+void PageSplitCache::computeClosure(XRef *xref, Ref ref)
+{
+    // how much the objects marked for a ref can be cached
+    enum Caching
+    {
+        cachingAlways,
+        cachingNotNow, // they depend on modified objects
+        cachingNever
+    };
+
+    struct Node
+    {
+        Ref ref;
+        int index; // visit order
+        int lowLink; // smallest index reachable from the node
+        bool onStack;
+        Caching caching;
+        std::vector<Ref> refs; // the references of its object
+        size_t nextRef; // next one of refs to follow
+        std::vector<int> children; // the nodes visited from this one
+        std::vector<int> knownChildren; // the cached components it refers to
+        int scc; // index in sccs, once known
+    };
+
+    struct Scc
+    {
+        std::vector<int> nodes;
+        Caching caching;
+        std::vector<int> children; // indices in sccs
+        std::vector<int> knownChildren;
+        int component; // index in components, once stored
+    };
+
+    const int rootNum = xref->getRootNum();
+    const Object &infoObj = xref->getTrailerDict()->dictLookupNF("Info");
+    const int infoNum = infoObj.isRef() ? infoObj.getRefNum() : -1;
+
+    std::vector<Node> nodes;
+    std::unordered_map<Ref, int> nodeOfRef;
+    std::vector<int> stack; // Tarjan's stack
+    std::vector<int> path; // the nodes being visited
+    std::vector<Scc> sccs;
+
+    auto addNode = [&](Ref r) {
+        Node node;
+        node.ref = r;
+        node.index = node.lowLink = nodes.size();
+        node.onStack = true;
+        node.caching = cachingAlways;
+        node.nextRef = 0;
+        node.scc = -1;
+        // savePageAs() changes the catalog and the info dict in place
+        if (r.num < 0 || r.num >= xref->getNumObjects() || r.num == rootNum || r.num == infoNum) {
+            node.caching = cachingNever;
+        } else {
+            XRefEntry *entry = xref->getEntry(r.num);
+            if (entry->type == xrefEntryFree) {
+                node.caching = cachingNever;
+            } else if (entry->getFlag(XRefEntry::Updated)) {
+                node.caching = cachingNotNow;
+            } else {
+                bool cacheable = true;
+                collectRefs(xref, xref->fetch(r), &node.refs, &cacheable);
+                if (!cacheable) {
+                    node.caching = cachingNever;
+                }
+            }
+        }
+        const int n = nodes.size();
+        nodes.push_back(std::move(node));
+        nodeOfRef.emplace(r, n);
+        stack.push_back(n);
+        path.push_back(n);
+        return n;
+    };
+
+    addNode(ref);
+    while (!path.empty()) {
+        const int v = path.back();
+        if (nodes[v].nextRef < nodes[v].refs.size()) {
+            const Ref r = nodes[v].refs[nodes[v].nextRef++];
+            auto it = nodeOfRef.find(r);
+            if (it != nodeOfRef.end()) {
+                const int w = it->second;
+                if (nodes[w].onStack) {
+                    nodes[v].lowLink = std::min(nodes[v].lowLink, nodes[w].index);
+                } else {
+                    nodes[v].children.push_back(w);
+                }
+                continue;
+            }
+            int component;
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                component = lookupComponent(r);
+            }
+            if (component == uncacheable) {
+                nodes[v].caching = cachingNever;
+            } else if (component != unknown) {
+                nodes[v].knownChildren.push_back(component);
+            } else {
+                const int w = addNode(r);
+                nodes[v].children.push_back(w);
+            }
+            continue;
+        }
+
+        path.pop_back();
+        if (!path.empty()) {
+            const int u = path.back();
+            nodes[u].lowLink = std::min(nodes[u].lowLink, nodes[v].lowLink);
+        }
+        if (nodes[v].lowLink != nodes[v].index) {
+            continue;
+        }
+
+        // v is the first node of a component, made of the nodes above it
+        // on the stack
+        const int s = sccs.size();
+        Scc scc;
+        scc.caching = cachingAlways;
+        scc.component = unknown;
+        int w;
+        do {
+            w = stack.back();
+            stack.pop_back();
+            nodes[w].onStack = false;
+            nodes[w].scc = s;
+            scc.nodes.push_back(w);
+        } while (w != v);
+        for (int n : scc.nodes) {
+            scc.caching = std::max(scc.caching, nodes[n].caching);
+            for (int child : nodes[n].children) {
+                const int childScc = nodes[child].scc;
+                if (childScc != s) {
+                    scc.caching = std::max(scc.caching, sccs[childScc].caching);
+                    scc.children.push_back(childScc);
+                }
+            }
+            scc.knownChildren.insert(scc.knownChildren.end(), nodes[n].knownChildren.begin(), nodes[n].knownChildren.end());
+        }
+        sccs.push_back(std::move(scc));
+    }
+
+    // the components come out children first
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    for (Scc &scc : sccs) {
+        const int existing = lookupComponent(nodes[scc.nodes.front()].ref);
+        if (existing != unknown) {
+            // another thread added it meanwhile
+            scc.component = existing;
+            continue;
+        }
+        if (scc.caching == cachingNotNow) {
+            continue;
+        }
+        if (scc.caching == cachingNever) {
+            if (reserve(scc.nodes.size() * mapEntrySize)) {
+                for (int n : scc.nodes) {
+                    componentOfRef.emplace(nodes[n].ref, uncacheable);
+                }
+                scc.component = uncacheable;
+            }
+            continue;
+        }
+
+        Component component;
+        bool complete = true;
+        for (int child : scc.children) {
+            if (sccs[child].component < 0) {
+                complete = false; // it didn't fit
+                break;
+            }
+            component.children.push_back(sccs[child].component);
+        }
+        if (!complete) {
+            continue;
+        }
+        component.children.insert(component.children.end(), scc.knownChildren.begin(), scc.knownChildren.end());
+        std::sort(component.children.begin(), component.children.end());
+        component.children.erase(std::unique(component.children.begin(), component.children.end()), component.children.end());
+        for (int n : scc.nodes) {
+            component.refs.push_back(nodes[n].ref);
+        }
+        if (!reserve(sizeof(Component) + component.refs.size() * (sizeof(Ref) + mapEntrySize) + component.children.size() * sizeof(int))) {
+            continue;
+        }
+        scc.component = components.size();
+        for (const Ref &r : component.refs) {
+            componentOfRef.emplace(r, scc.component);
+        }
+        components.push_back(std::move(component));
+    }
+}
+
+bool PageSplitCache::reserve(size_t bytes)
+{
+    if (curBytes + bytes > maxBytes) {
+        return false;
+    }
+    curBytes += bytes;
+    return true;
+}
+
+//------------------------------------------------------------------------
+// PDFSplitter
+//------------------------------------------------------------------------
+
+PDFSplitter::PDFSplitter(const GooString *fileNameA, const GooString *ownerPasswordA, const GooString *userPasswordA)
+{
+    fileName.reset(fileNameA->copy());
+    if (ownerPasswordA) {
+        ownerPassword.reset(ownerPasswordA->copy());
+    }
+    if (userPasswordA) {
+        userPassword.reset(userPasswordA->copy());
+    }
+}
+
+int PDFSplitter::savePages(const std::vector<int> &pageNos, const std::vector<std::string> &fileNames, int nThreads)
+{
+    // the worker threads share the cache and the page counter, each one
+    // reads the file through its own PDFDoc
+    std::atomic_size_t nextPage { 0 };
+    std::atomic_int errCode { errNone };
+    auto savePagesOfThread = [&] {
+        std::unique_ptr<PDFDoc> doc;
+        size_t i;
+        while (errCode == errNone && (i = nextPage++) < pageNos.size()) {
+            GooString name(fileNames[i]);
+            if (!doc) {
+                doc = std::make_unique<PDFDoc>(fileName->copy(), ownerPassword.get(), userPassword.get());
+            }
+            int code;
+            if (!doc->isOk()) {
+                code = doc->getErrorCode();
+            } else {
+                bool exact = true;
+                code = doc->savePageAs(&name, pageNos[i], &cache, &exact);
+                if (code == errNone && !exact) {
+                    // write it again as pdfseparate always did, from a
+                    // document used for this page only
+                    doc = std::make_unique<PDFDoc>(fileName->copy(), ownerPassword.get(), userPassword.get());
+                    code = doc->isOk() ? doc->savePageAs(&name, pageNos[i]) : doc->getErrorCode();
+                    doc.reset();
+                }
+            }
+            if (code != errNone) {
+                int none = errNone;
+                errCode.compare_exchange_strong(none, code);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min((size_t)std::max(nThreads, 1), pageNos.size()); ++i) {
+        workers.emplace_back(savePagesOfThread);
+    }
+    savePagesOfThread();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    return errCode;
+}
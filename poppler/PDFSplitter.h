@@ -0,0 +1,119 @@
+//========================================================================
+//
+// PDFSplitter.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Saving the pages of a document to separate files.
+//
+//========================================================================
+
+#ifndef PDFSPLITTER_H
+#define PDFSPLITTER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "goo/GooString.h"
+#include "Object.h"
+
+class XRef;
+
+//------------------------------------------------------------------------
+// PageSplitCache
+//------------------------------------------------------------------------
+
+// What PDFDoc::savePageAs() learns about the objects of a document that
+// can be reused for its other pages: the objects each reference brings
+// in the page file, and the bytes written for the objects used by
+// several pages.  Objects are only described as they are in the file,
+// so the cache can be shared by several PDFDocs reading the same file,
+// from several threads.  It holds at most maxBytes of data, after which
+// it stops growing.
+class PageSplitCache
+{
+public:
+    explicit PageSplitCache(size_t maxBytesA = 64 * 1024 * 1024);
+
+    PageSplitCache(const PageSplitCache &) = delete;
+    PageSplitCache &operator=(const PageSplitCache &) = delete;
+
+    // Get the objects PDFDoc::markObject() marks for <ref>, itself
+    // included, in <closure>.  Returns false if they are not known and
+    // can't be found from <xref> alone: when they have been modified, or
+    // depend on more than the objects of the file (like the annotations
+    // of a page, which are marked depending on the page being saved).
+    bool getClosure(XRef *xref, Ref ref, std::vector<Ref> *closure);
+
+    // Return the bytes PDFDoc::writeObject() wrote for the object <ref>
+    // of the file, or nullptr.  If it's not cached, *keep tells whether
+    // its bytes should be given to putObjectBytes(): they are the
+    // second time an object is written.
+    std::shared_ptr<const std::string> getObjectBytes(Ref ref, bool unencrypted, bool *keep);
+    void putObjectBytes(Ref ref, bool unencrypted, const std::shared_ptr<const std::string> &bytes);
+
+    // Whether the file has objects in object streams.
+    bool hasCompressedObjects(XRef *xref);
+
+private:
+    // A strongly connected component of the graph of the references: the
+    // objects marked for any of its refs are its refs and the objects
+    // marked for its children.
+    struct Component
+    {
+        std::vector<Ref> refs;
+        std::vector<int> children; // indices in components
+    };
+
+    static constexpr int uncacheable = -1; // in componentOfRef, for the objects whose closure can't be cached
+    static constexpr int unknown = -2;
+
+    int lookupComponent(Ref ref) const;
+    bool collectClosure(int component, std::vector<Ref> *closure) const;
+    void computeClosure(XRef *xref, Ref ref);
+    bool reserve(size_t bytes);
+
+    size_t maxBytes; // byte limit
+    size_t curBytes; // bytes used by the components and the objects
+    std::unordered_map<Ref, int> componentOfRef; // index in components, or uncacheable
+    std::vector<Component> components;
+    std::unordered_map<Ref, std::shared_ptr<const std::string>> objectBytes[2]; // indexed by unencrypted, nullptr until the second write
+    int compressedObjects; // -1 until known, else 0 or 1
+    mutable std::shared_mutex mutex;
+};
+
+//------------------------------------------------------------------------
+// PDFSplitter
+//------------------------------------------------------------------------
+
+// Saves pages of a document to separate files, like PDFDoc::savePageAs()
+// called on a new PDFDoc for each page, but reading the file once per
+// thread, and serializing the objects used by several pages once.
+class PDFSplitter
+{
+public:
+    PDFSplitter(const GooString *fileNameA, const GooString *ownerPasswordA, const GooString *userPasswordA);
+
+    PDFSplitter(const PDFSplitter &) = delete;
+    PDFSplitter &operator=(const PDFSplitter &) = delete;
+
+    // Save each page pageNos[i] to fileNames[i], with <nThreads> threads.
+    // No page is started after one can't be saved, and the error code of
+    // the first one that couldn't is returned, or errNone.  With one
+    // thread, the pages are saved in order, so none of the pages after
+    // the failing one is written; with more, some of them may be.
+    int savePages(const std::vector<int> &pageNos, const std::vector<std::string> &fileNames, int nThreads);
+
+private:
+    std::unique_ptr<GooString> fileName;
+    std::unique_ptr<GooString> ownerPassword;
+    std::unique_ptr<GooString> userPassword;
+    PageSplitCache cache;
+};
+
+#endif
@@ -1212,6 +1212,8 @@ void PSOutputDev::init(PSOutputFunc outputFuncA, void *outputStreamA, PSFileType
     embedCIDPostScript = true;
     embedCIDTrueType = true;
     fontPassthrough = false;
+    subsetFonts = true;
+    usedCharsScanned = false;
     optimizeColorSpace = false;
     passLevel1CustomColor = false;
     preloadImagesForms = false;
@@ -2426,6 +2428,8 @@ void PSOutputDev::setupEmbeddedTrueTypeFont(GfxFont *font, Ref *id, GooString *p
     int fontLen;
     FoFiTrueType *ffTT;
     int *codeToGID;
+    std::vector<bool> usedGlyphs;
+    bool subset;
 
     // beginning comment
     writePSFmt("%%BeginResource: font {0:t}\n", psName);
@@ -2437,7 +2441,8 @@ void PSOutputDev::setupEmbeddedTrueTypeFont(GfxFont *font, Ref *id, GooString *p
     if ((fontBuf = font->readEmbFontFile(xref, &fontLen))) {
         if ((ffTT = FoFiTrueType::make(fontBuf, fontLen))) {
             codeToGID = ((Gfx8BitFont *)font)->getCodeToGIDMap(ffTT);
-            ffTT->convertToType42(psName->c_str(), ((Gfx8BitFont *)font)->getHasEncoding() ? ((Gfx8BitFont *)font)->getEncoding() : nullptr, codeToGID, outputFunc, outputStream);
+            subset = codeToGID && getUsedGlyphs(*font->getID(), codeToGID, 256, &usedGlyphs);
+            ffTT->convertToType42(psName->c_str(), ((Gfx8BitFont *)font)->getHasEncoding() ? ((Gfx8BitFont *)font)->getEncoding() : nullptr, codeToGID, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
             if (codeToGID) {
                 if (font8InfoLen >= font8InfoSize) {
                     font8InfoSize += 16;
@@ -2460,6 +2465,8 @@ void PSOutputDev::setupExternalTrueTypeFont(GfxFont *font, GooString *fileName,
 {
     FoFiTrueType *ffTT;
     int *codeToGID;
+    std::vector<bool> usedGlyphs;
+    bool subset;
 
     // beginning comment
     writePSFmt("%%BeginResource: font {0:t}\n", psName);
@@ -2470,7 +2477,8 @@ void PSOutputDev::setupExternalTrueTypeFont(GfxFont *font, GooString *fileName,
     // convert it to a Type 42 font
     if ((ffTT = FoFiTrueType::load(fileName->c_str()))) {
         codeToGID = ((Gfx8BitFont *)font)->getCodeToGIDMap(ffTT);
-        ffTT->convertToType42(psName->c_str(), ((Gfx8BitFont *)font)->getHasEncoding() ? ((Gfx8BitFont *)font)->getEncoding() : nullptr, codeToGID, outputFunc, outputStream);
+        subset = codeToGID && getUsedGlyphs(*font->getID(), codeToGID, 256, &usedGlyphs);
+        ffTT->convertToType42(psName->c_str(), ((Gfx8BitFont *)font)->getHasEncoding() ? ((Gfx8BitFont *)font)->getEncoding() : nullptr, codeToGID, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
         if (codeToGID) {
             if (font8InfoLen >= font8InfoSize) {
                 font8InfoSize += 16;
@@ -2487,6 +2495,84 @@ void PSOutputDev::setupExternalTrueTypeFont(GfxFont *font, GooString *fileName,
     writePS("%%EndResource\n");
 }
 
+// Interpret the pages being output, recording the chars drawn with
+// each font so that the embedded fonts can be subset.
+void PSOutputDev::scanUsedChars()
+{
+    PreScanOutputDev *scan;
+    Page *page;
+    Gfx *gfx;
+    Annots *annots;
+
+    usedCharsScanned = true;
+    scan = new PreScanOutputDev(level);
+    scan->setUsedChars(&usedChars);
+    for (const int pg : pages) {
+        if (!(page = doc->getPage(pg))) {
+            continue;
+        }
+        gfx = page->createGfx(scan, 72, 72, 0, true, false, -1, -1, -1, -1, true, nullptr, nullptr);
+        page->display(gfx);
+        // annotations are included whether they are visible when
+        // printing or only on screen
+        annots = page->getAnnots();
+        for (int i = 0; i < annots->getNumAnnots(); ++i) {
+            Annot *annot = annots->getAnnot(i);
+            annot->draw(gfx, annot->getFlags() & Annot::flagPrint);
+        }
+        delete gfx;
+    }
+    delete scan;
+}
+
+// Return the chars drawn with the font (or embedded font file) <id>,
+// see PSFontUsedChars, or NULL if fonts aren't subset.
+const std::vector<bool> *PSOutputDev::getUsedChars(const Ref &id)
+{
+    if (!subsetFonts) {
+        return nullptr;
+    }
+    if (!usedCharsScanned) {
+        scanUsedChars();
+    }
+    return &usedChars[id];
+}
+
+// Map the chars drawn with the font <id> to the glyphs of its font
+// file, through <codeToGID> (NULL for the identity mapping).  Returns
+// false if fonts aren't subset.
+bool PSOutputDev::getUsedGlyphs(const Ref &id, const int *codeToGID, int codeToGIDLen, std::vector<bool> *glyphs)
+{
+    const std::vector<bool> *chars;
+    int gid;
+
+    if (!(chars = getUsedChars(id))) {
+        return false;
+    }
+    glyphs->clear();
+    for (int c = 0; c < (int)chars->size(); ++c) {
+        if (!(*chars)[c]) {
+            continue;
+        }
+        if (codeToGID) {
+            if (c >= codeToGIDLen) {
+                continue;
+            }
+            gid = codeToGID[c];
+        } else {
+            gid = c;
+        }
+        if (gid < 0) {
+            continue;
+        }
+        if (gid >= (int)glyphs->size()) {
+            glyphs->resize(gid + 1, false);
+        }
+        (*glyphs)[gid] = true;
+    }
+    return true;
+}
+
 void PSOutputDev::updateFontMaxValidGlyph(GfxFont *font, int maxValidGlyph)
 {
     if (maxValidGlyph >= 0 && font->getName()) {
@@ -2502,6 +2588,8 @@ void PSOutputDev::setupExternalCIDTrueTypeFont(GfxFont *font, GooString *fileNam
     FoFiTrueType *ffTT;
     int *codeToGID;
     int codeToGIDLen;
+    std::vector<bool> usedGlyphs;
+    bool subset;
 
     // beginning comment
     writePSFmt("%%BeginResource: font {0:t}\n", psName);
@@ -2527,15 +2615,18 @@ void PSOutputDev::setupExternalCIDTrueTypeFont(GfxFont *font, GooString *fileNam
                 codeToGID = ((GfxCIDFont *)font)->getCodeToGIDMap(ffTT, &codeToGIDLen);
             }
             if (ffTT->isOpenTypeCFF()) {
-                ffTT->convertToCIDType0(psName->c_str(), codeToGID, codeToGIDLen, outputFunc, outputStream);
-            } else if (level >= psLevel3) {
-                // Level 3: use a CID font
-                ffTT->convertToCIDType2(psName->c_str(), codeToGID, codeToGIDLen, needVerticalMetrics, outputFunc, outputStream);
+                ffTT->convertToCIDType0(psName->c_str(), codeToGID, codeToGIDLen, outputFunc, outputStream, getUsedChars(*font->getID()));
             } else {
-                // otherwise: use a non-CID composite font
-                int maxValidGlyph = -1;
-                ffTT->convertToType0(psName->c_str(), codeToGID, codeToGIDLen, needVerticalMetrics, &maxValidGlyph, outputFunc, outputStream);
-                updateFontMaxValidGlyph(font, maxValidGlyph);
+                subset = getUsedGlyphs(*font->getID(), codeToGID, codeToGIDLen, &usedGlyphs);
+                if (level >= psLevel3) {
+                    // Level 3: use a CID font
+                    ffTT->convertToCIDType2(psName->c_str(), codeToGID, codeToGIDLen, needVerticalMetrics, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
+                } else {
+                    // otherwise: use a non-CID composite font
+                    int maxValidGlyph = -1;
+                    ffTT->convertToType0(psName->c_str(), codeToGID, codeToGIDLen, needVerticalMetrics, &maxValidGlyph, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
+                    updateFontMaxValidGlyph(font, maxValidGlyph);
+                }
             }
             gfree(codeToGID);
         } else {
@@ -2582,10 +2673,10 @@ void PSOutputDev::setupEmbeddedCIDType0Font(GfxFont *font, Ref *id, GooString *p
         if ((ffT1C = FoFiType1C::make(fontBuf, fontLen))) {
             if (level >= psLevel3) {
                 // Level 3: use a CID font
-                ffT1C->convertToCIDType0(psName->c_str(), nullptr, 0, outputFunc, outputStream);
+                ffT1C->convertToCIDType0(psName->c_str(), nullptr, 0, outputFunc, outputStream, getUsedChars(*id));
             } else {
                 // otherwise: use a non-CID composite font
-                ffT1C->convertToType0(psName->c_str(), nullptr, 0, outputFunc, outputStream);
+                ffT1C->convertToType0(psName->c_str(), nullptr, 0, outputFunc, outputStream, getUsedChars(*id));
             }
             delete ffT1C;
         }
@@ -2611,13 +2702,15 @@ void PSOutputDev::setupEmbeddedCIDTrueTypeFont(GfxFont *font, Ref *id, GooString
     // convert it to a Type 0 font
     if ((fontBuf = font->readEmbFontFile(xref, &fontLen))) {
         if ((ffTT = FoFiTrueType::make(fontBuf, fontLen))) {
+            std::vector<bool> usedGlyphs;
+            const bool subset = getUsedGlyphs(*id, ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), &usedGlyphs);
             if (level >= psLevel3) {
                 // Level 3: use a CID font
-                ffTT->convertToCIDType2(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), needVerticalMetrics, outputFunc, outputStream);
+                ffTT->convertToCIDType2(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), needVerticalMetrics, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
             } else {
                 // otherwise: use a non-CID composite font
                 int maxValidGlyph = -1;
-                ffTT->convertToType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), needVerticalMetrics, &maxValidGlyph, outputFunc, outputStream);
+                ffTT->convertToType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), needVerticalMetrics, &maxValidGlyph, outputFunc, outputStream, subset ? &usedGlyphs : nullptr);
                 updateFontMaxValidGlyph(font, maxValidGlyph);
             }
             delete ffTT;
@@ -2664,10 +2757,10 @@ void PSOutputDev::setupEmbeddedOpenTypeCFFFont(GfxFont *font, Ref *id, GooString
             if (ffTT->isOpenTypeCFF()) {
                 if (level >= psLevel3) {
                     // Level 3: use a CID font
-                    ffTT->convertToCIDType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), outputFunc, outputStream);
+                    ffTT->convertToCIDType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), outputFunc, outputStream, getUsedChars(*id));
                 } else {
                     // otherwise: use a non-CID composite font
-                    ffTT->convertToType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), outputFunc, outputStream);
+                    ffTT->convertToType0(psName->c_str(), ((GfxCIDFont *)font)->getCIDToGID(), ((GfxCIDFont *)font)->getCIDToGIDLen(), outputFunc, outputStream, getUsedChars(*id));
                 }
             }
             delete ffTT;
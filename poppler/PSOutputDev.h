@@ -115,6 +115,11 @@ typedef void (*PSOutputFunc)(void *stream, const char *data, int len);
 
 typedef GooString *(*PSOutCustomCodeCbk)(PSOutputDev *psOut, PSOutCustomCodeLocation loc, int n, void *data);
 
+// The char codes (CIDs for CID fonts) drawn with each font.  CID fonts
+// are keyed by their embedded font file, which several fonts may share,
+// other fonts by their own ID.
+typedef std::unordered_map<Ref, std::vector<bool>> PSFontUsedChars;
+
 class PSOutputDev : public OutputDev
 {
 public:
@@ -322,6 +327,7 @@ public:
     bool getEmbedCIDPostScript() const { return embedCIDPostScript; }
     bool getEmbedCIDTrueType() const { return embedCIDTrueType; }
     bool getFontPassthrough() const { return fontPassthrough; }
+    bool getSubsetFonts() const { return subsetFonts; }
     bool getOptimizeColorSpace() const { return optimizeColorSpace; }
     bool getPassLevel1CustomColor() const { return passLevel1CustomColor; }
     bool getEnableLZW() const { return enableLZW; };
@@ -340,6 +346,7 @@ public:
     void setEmbedCIDPostScript(bool b) { embedCIDPostScript = b; }
     void setEmbedCIDTrueType(bool b) { embedCIDTrueType = b; }
     void setFontPassthrough(bool b) { fontPassthrough = b; }
+    void setSubsetFonts(bool b) { subsetFonts = b; }
     void setOptimizeColorSpace(bool b) { optimizeColorSpace = b; }
     void setPassLevel1CustomColor(bool b) { passLevel1CustomColor = b; }
     void setPreloadImagesForms(bool b) { preloadImagesForms = b; }
@@ -376,6 +383,9 @@ private:
     void setupExternalCIDTrueTypeFont(GfxFont *font, GooString *fileName, GooString *psName, bool needVerticalMetrics);
     void setupEmbeddedOpenTypeCFFFont(GfxFont *font, Ref *id, GooString *psName);
     void setupType3Font(GfxFont *font, GooString *psName, Dict *parentResDict);
+    void scanUsedChars();
+    const std::vector<bool> *getUsedChars(const Ref &id);
+    bool getUsedGlyphs(const Ref &id, const int *codeToGID, int codeToGIDLen, std::vector<bool> *glyphs);
     GooString *makePSFontName(GfxFont *font, const Ref *id);
     void setupImages(Dict *resDict);
     void setupImage(Ref id, Stream *str, bool mask);
@@ -451,6 +461,8 @@ private:
     std::set<int> resourceIDs; // list of object IDs of objects containing Resources we've already set up
     std::unordered_set<std::string> fontNames; // all used font names
     std::unordered_map<std::string, int> perFontMaxValidGlyph; // max valid glyph of each font
+    PSFontUsedChars usedChars; // chars drawn by the pages, for font subsetting
+    bool usedCharsScanned; // has usedChars been filled in?
     PST1FontName *t1FontNames; // font names for Type 1/1C fonts
     int t1FontNameLen; // number of entries in t1FontNames array
     int t1FontNameSize; // size of t1FontNames array
@@ -511,6 +523,7 @@ private:
     bool embedCIDPostScript; // embed CID PostScript fonts?
     bool embedCIDTrueType; // embed CID TrueType fonts?
     bool fontPassthrough; // pass all fonts through as-is?
+    bool subsetFonts; // only embed the used glyphs of TrueType and CID fonts?
     bool optimizeColorSpace; // false to keep gray RGB images in their original color space
                              // true to optimize gray images to DeviceGray color space
     bool passLevel1CustomColor; // false to convert all custom colors to CMYK
@@ -41,6 +41,7 @@
 
 #include <config.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <climits>
 #include "GlobalParams.h"
@@ -153,7 +154,7 @@ PageAttrs::PageAttrs(PageAttrs *attrs, Dict *dict)
     readBox(dict, "ArtBox", &artBox);
 
     // rotate
-    obj1 = dict->lookup("Rotate");
+    obj1 = dict->lookup(Atoms::Rotate);
     if (obj1.isInt()) {
         rotate = obj1.getInt();
     }
@@ -167,13 +168,13 @@ PageAttrs::PageAttrs(PageAttrs *attrs, Dict *dict)
     // misc attributes
     lastModified = dict->lookup("LastModified");
     boxColorInfo = dict->lookup("BoxColorInfo");
-    group = dict->lookup("Group");
+    group = dict->lookup(Atoms::Group);
     metadata = dict->lookup("Metadata");
     pieceInfo = dict->lookup("PieceInfo");
     separationInfo = dict->lookup("SeparationInfo");
 
     // resource dictionary
-    Object objResources = dict->lookup("Resources");
+    Object objResources = dict->lookup(Atoms::Resources);
     if (objResources.isDict()) {
         resources = std::move(objResources);
     }
@@ -349,14 +350,14 @@ void Page::replaceXRef(XRef *xrefA)
     Dict *pageDict = pageObj.getDict()->copy(xrefA);
     xref = xrefA;
     trans = pageDict->lookupNF("Trans").copy();
-    annotsObj = pageDict->lookupNF("Annots").copy();
-    contents = pageDict->lookupNF("Contents").copy();
+    annotsObj = pageDict->lookupNF(Atoms::Annots).copy();
+    contents = pageDict->lookupNF(Atoms::Contents).copy();
     if (contents.isArray()) {
         contents = Object(contents.getArray()->copy(xrefA));
     }
     thumb = pageDict->lookupNF("Thumb").copy();
-    actions = pageDict->lookupNF("AA").copy();
-    Object resources = pageDict->lookup("Resources");
+    actions = pageDict->lookupNF(Atoms::AA).copy();
+    Object resources = pageDict->lookup(Atoms::Resources);
     if (resources.isDict()) {
         attrs->replaceResource(std::move(resources));
     }
@@ -614,39 +615,34 @@ void Page::display(Gfx *gfx)
     }
 }
 
-bool Page::loadThumb(unsigned char **data_out, int *width_out, int *height_out, int *rowstride_out)
+// Get the size and the color map of the thumbnail image <thumbObj>, or
+// return nullptr if it's not a valid one.
+static GfxImageColorMap *parseThumb(Object *thumbObj, int *widthA, int *heightA)
 {
-    unsigned int pixbufdatasize;
     int width, height, bits;
     Object obj1;
     Dict *dict;
     GfxColorSpace *colorSpace;
-    Stream *str;
     GfxImageColorMap *colorMap;
 
-    /* Get stream dict */
-    pageLocker();
-    Object fetched_thumb = thumb.fetch(xref);
-    if (!fetched_thumb.isStream()) {
-        return false;
+    if (!thumbObj->isStream()) {
+        return nullptr;
     }
 
-    dict = fetched_thumb.streamGetDict();
-    str = fetched_thumb.getStream();
+    dict = thumbObj->streamGetDict();
 
     if (!dict->lookupInt("Width", "W", &width))
-        return false;
+        return nullptr;
     if (!dict->lookupInt("Height", "H", &height))
-        return false;
+        return nullptr;
     if (!dict->lookupInt("BitsPerComponent", "BPC", &bits))
-        return false;
+        return nullptr;
 
     /* Check for invalid dimensions and integer overflow. */
     if (width <= 0 || height <= 0)
-        return false;
+        return nullptr;
     if (width > INT_MAX / 3 / height)
-        return false;
-    pixbufdatasize = width * height * 3;
+        return nullptr;
 
     /* Get color space */
     obj1 = dict->lookup("ColorSpace");
@@ -660,7 +656,7 @@ bool Page::loadThumb(unsigned char **data_out, int *width_out, int *height_out,
     colorSpace = GfxColorSpace::parse(nullptr, &obj1, nullptr, state.get());
     if (!colorSpace) {
         fprintf(stderr, "Error: Cannot parse color space\n");
-        return false;
+        return nullptr;
     }
 
     obj1 = dict->lookup("Decode");
@@ -671,13 +667,30 @@ bool Page::loadThumb(unsigned char **data_out, int *width_out, int *height_out,
     if (!colorMap->isOk()) {
         fprintf(stderr, "Error: invalid colormap\n");
         delete colorMap;
+        return nullptr;
+    }
+
+    *widthA = width;
+    *heightA = height;
+    return colorMap;
+}
+
+bool Page::loadThumb(unsigned char **data_out, int *width_out, int *height_out, int *rowstride_out)
+{
+    int width, height;
+    GfxImageColorMap *colorMap;
+
+    /* Get stream dict */
+    pageLocker();
+    Object fetched_thumb = thumb.fetch(xref);
+    if (!(colorMap = parseThumb(&fetched_thumb, &width, &height))) {
         return false;
     }
 
     if (data_out) {
-        unsigned char *pixbufdata = (unsigned char *)gmalloc(pixbufdatasize);
+        unsigned char *pixbufdata = (unsigned char *)gmalloc(width * height * 3);
         unsigned char *p = pixbufdata;
-        ImageStream *imgstr = new ImageStream(str, width, colorMap->getNumPixelComps(), colorMap->getBits());
+        ImageStream *imgstr = new ImageStream(fetched_thumb.getStream(), width, colorMap->getNumPixelComps(), colorMap->getBits());
         imgstr->reset();
         for (int row = 0; row < height; ++row) {
             for (int col = 0; col < width; ++col) {
@@ -709,6 +722,37 @@ bool Page::loadThumb(unsigned char **data_out, int *width_out, int *height_out,
     return true;
 }
 
+bool Page::displayThumb(OutputDev *out, double hDPI, double vDPI, int rotate, bool useMediaBox)
+{
+    int width, height;
+    GfxImageColorMap *colorMap;
+
+    pageLocker();
+    Object fetched_thumb = thumb.fetch(xref);
+    if (!(colorMap = parseThumb(&fetched_thumb, &width, &height))) {
+        return false;
+    }
+
+    // don't scale the thumbnail up
+    const PDFRectangle *box = useMediaBox ? getMediaBox() : getCropBox();
+    const double boxW = box->x2 - box->x1;
+    const double boxH = box->y2 - box->y1;
+    const double maxDPI = std::max(hDPI, vDPI);
+    if (std::max(width, height) < (int)(std::max(boxW, boxH) * maxDPI / 72)) {
+        delete colorMap;
+        return false;
+    }
+
+    Gfx *gfx = createGfx(out, hDPI, vDPI, rotate, useMediaBox, false, -1, -1, -1, -1, false, nullptr, nullptr, xref);
+    GfxState *state = gfx->getState();
+    state->concatCTM(boxW, 0, 0, boxH, box->x1, box->y1);
+    out->drawImage(state, nullptr, fetched_thumb.getStream(), width, height, colorMap, false, nullptr, false);
+    delete gfx;
+    delete colorMap;
+
+    return true;
+}
+
 void Page::makeBox(double hDPI, double vDPI, int rotate, bool useMediaBox, bool upsideDown, double sliceX, double sliceY, double sliceW, double sliceH, PDFRectangle *box, bool *crop)
 {
     const PDFRectangle *mediaBox, *cropBox, *baseBox;
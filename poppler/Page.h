@@ -197,6 +197,11 @@ public:
     Object getThumb() { return thumb.fetch(xref); }
     bool loadThumb(unsigned char **data, int *width, int *height, int *rowstride);
 
+    // Display the thumbnail of the page, instead of its contents, when it
+    // is at least as large as the page at this resolution.  Returns false
+    // if it isn't, or the page has none, and then displays nothing.
+    bool displayThumb(OutputDev *out, double hDPI, double vDPI, int rotate, bool useMediaBox);
+
     // Get transition.
     Object getTrans() { return trans.fetch(xref); }
 
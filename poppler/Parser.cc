@@ -110,6 +110,7 @@ Object Parser::getObj(bool simpleOnly, const unsigned char *fileKey, CryptAlgori
             if (strict)
                 goto err;
         }
+        obj.getArray()->freeze();
         shift();
 
         // dictionary or stream
@@ -135,13 +136,17 @@ Object Parser::getObj(bool simpleOnly, const unsigned char *fileKey, CryptAlgori
                 // We don't decrypt strings that are the value of "Contents" key entries. We decrypt them if needed a few lines below.
                 // The "Contents" field of Sig dictionaries is not encrypted, but we can't know the type of the dictionary here yet
                 // so we don't decrypt any Contents and if later we find it's not a Sig dictionary we decrypt it
-                const bool isContents = !hasContentsEntry && key.isName("Contents");
+                const bool isContents = !hasContentsEntry && key.isName(Atoms::Contents);
                 hasContentsEntry = hasContentsEntry || isContents;
                 Object obj2 = getObj(false, fileKey, encAlgorithm, keyLength, objNum, objGen, recursion + 1, /*strict*/ false, /*decryptString*/ !isContents);
                 if (unlikely(obj2.isError() && recursion + 1 >= recursionLimit)) {
                     break;
                 }
-                obj.dictAdd(key.getName(), std::move(obj2));
+                if (const Atom atom = key.getNameAtom()) {
+                    obj.getDict()->add(atom, std::move(obj2));
+                } else {
+                    obj.dictAdd(key.getName(), std::move(obj2));
+                }
             }
         }
         if (buf1.isEOF()) {
@@ -160,6 +165,7 @@ Object Parser::getObj(bool simpleOnly, const unsigned char *fileKey, CryptAlgori
                 }
             }
         }
+        obj.getDict()->freeze();
         // stream objects are not allowed inside content streams or
         // object streams
         if (buf2.isCmd("stream")) {
@@ -241,7 +247,7 @@ Stream *Parser::makeStream(Object &&dict, const unsigned char *fileKey, CryptAlg
     pos = str->getPos();
 
     // get length
-    Object obj = dict.dictLookup("Length", recursion);
+    Object obj = dict.dictLookup(Atoms::Length, recursion);
     if (obj.isInt()) {
         length = obj.getInt();
     } else if (obj.isInt64()) {
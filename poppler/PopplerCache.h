@@ -58,6 +58,9 @@ public:
         entries.emplace(entries.begin(), key, std::unique_ptr<Item> { item });
     }
 
+    /* Delete all the cached items */
+    void clear() { entries.clear(); }
+
 private:
     std::vector<std::pair<Key, std::unique_ptr<Item>>> entries;
 };
@@ -42,6 +42,7 @@
 PreScanOutputDev::PreScanOutputDev(PSLevel levelA) : level(levelA)
 {
     clearStats();
+    usedChars = nullptr;
 }
 
 PreScanOutputDev::~PreScanOutputDev() { }
@@ -166,6 +167,24 @@ void PreScanOutputDev::beginStringOp(GfxState *state)
 
 void PreScanOutputDev::endStringOp(GfxState * /*state*/) { }
 
+void PreScanOutputDev::drawChar(GfxState *state, double /*x*/, double /*y*/, double /*dx*/, double /*dy*/, double /*originX*/, double /*originY*/, CharCode code, int /*nBytes*/, const Unicode * /*u*/, int /*uLen*/)
+{
+    GfxFont *font;
+    Ref id;
+
+    if (!usedChars || !(font = state->getFont()) || code > 0xffff) {
+        return;
+    }
+    if (!font->isCIDFont() || !font->getEmbeddedFontID(&id)) {
+        id = *font->getID();
+    }
+    std::vector<bool> &chars = (*usedChars)[id];
+    if (code >= chars.size()) {
+        chars.resize(code + 1, false);
+    }
+    chars[code] = true;
+}
+
 bool PreScanOutputDev::beginType3Char(GfxState * /*state*/, double /*x*/, double /*y*/, double /*dx*/, double /*dy*/, CharCode /*code*/, const Unicode * /*u*/, int /*uLen*/)
 {
     // return false so all Type 3 chars get rendered (no caching)
@@ -93,6 +93,7 @@ public:
     //----- text drawing
     void beginStringOp(GfxState *state) override;
     void endStringOp(GfxState *state) override;
+    void drawChar(GfxState *state, double x, double y, double dx, double dy, double originX, double originY, CharCode code, int nBytes, const Unicode *u, int uLen) override;
     bool beginType3Char(GfxState *state, double x, double y, double dx, double dy, CharCode code, const Unicode *u, int uLen) override;
     void endType3Char(GfxState *state) override;
 
@@ -134,6 +135,10 @@ public:
     // Clear the stats used by the above functions.
     void clearStats();
 
+    // Record the chars drawn with each font in <usedCharsA> (NULL to
+    // stop recording).
+    void setUsedChars(PSFontUsedChars *usedCharsA) { usedChars = usedCharsA; }
+
 private:
     void check(GfxColorSpace *colorSpace, const GfxColor *color, double opacity, GfxBlendMode blendMode);
 
@@ -144,6 +149,7 @@ private:
     PSLevel level; // PostScript level (1, 2, separation)
     bool patternImgMask;
     int inTilingPatternFill;
+    PSFontUsedChars *usedChars;
 };
 
 #endif
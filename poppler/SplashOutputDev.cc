@@ -62,6 +62,8 @@
 #include "Page.h"
 #include "PDFDoc.h"
 #include "Link.h"
+#include "OptionalContent.h"
+#include "ImagePrefetcher.h"
 #include "FontEncodingTables.h"
 #include "fofi/FoFiTrueType.h"
 #include "splash/SplashBitmap.h"
@@ -208,6 +210,206 @@ void SplashGouraudPattern::getParameterizedColor(double colorinterp, SplashColor
     }
 }
 
+//------------------------------------------------------------------------
+// SplashPatchMeshPattern
+//------------------------------------------------------------------------
+
+// Maximal distance between a patch and the triangles it is drawn
+// with, in device pixels.
+#define patchMeshFlatness 0.25
+
+// Maximal number of subdivisions of a patch side.
+#define patchMeshMaxGrid 64
+
+// Maximal error on the parameter of parameterized shadings, relative to
+// the parameter domain, and maximal change of a color component between
+// two vertices for color spaces which aren't mapped linearly.
+#define patchMeshParamDelta 5e-3
+#define patchMeshColorDelta (1.0 / 16)
+
+// Number of samples of the color function of parameterized shadings.
+#define patchMeshParamSamples 1024
+
+SplashPatchMeshPattern::SplashPatchMeshPattern(GfxState *stateA, GfxPatchMeshShading *shadingA)
+{
+    state = stateA;
+    shading = shadingA;
+    gfxMode = shadingA->getColorSpace()->getMode();
+    state->getCTM(&ctm);
+    paramColorsMode = splashModeMono8;
+}
+
+SplashPatchMeshPattern::~SplashPatchMeshPattern() { }
+
+void SplashPatchMeshPattern::getBBox(double *xMin, double *yMin, double *xMax, double *yMax)
+{
+    double tx, ty;
+
+    // each patch lies inside the convex hull of its control points
+    *xMin = *yMin = 0;
+    *xMax = *yMax = -1;
+    for (int i = 0; i < shading->getNPatches(); ++i) {
+        const GfxPatch *patch = shading->getPatch(i);
+        for (int j = 0; j < 4; ++j) {
+            for (int k = 0; k < 4; ++k) {
+                ctm.transform(patch->x[j][k], patch->y[j][k], &tx, &ty);
+                if (i == 0 && j == 0 && k == 0) {
+                    *xMin = *xMax = tx;
+                    *yMin = *yMax = ty;
+                } else {
+                    *xMin = std::min(*xMin, tx);
+                    *yMin = std::min(*yMin, ty);
+                    *xMax = std::max(*xMax, tx);
+                    *yMax = std::max(*yMax, ty);
+                }
+            }
+        }
+    }
+}
+
+int SplashPatchMeshPattern::getPatchGrid(int i, SplashColorMode mode, std::vector<SplashPatchMeshVertex> *grid)
+{
+    const GfxPatch *patch = shading->getPatch(i);
+    GfxColorSpace *colorSpace = shading->getColorSpace();
+    const bool parameterized = shading->isParameterized();
+    double px[4][4], py[4][4];
+    double xMin, yMin, xMax, yMax;
+
+    xMin = xMax = yMin = yMax = 0;
+    for (int j = 0; j < 4; ++j) {
+        for (int k = 0; k < 4; ++k) {
+            ctm.transform(patch->x[j][k], patch->y[j][k], &px[j][k], &py[j][k]);
+            if (j == 0 && k == 0) {
+                xMin = xMax = px[0][0];
+                yMin = yMax = py[0][0];
+            } else {
+                xMin = std::min(xMin, px[j][k]);
+                yMin = std::min(yMin, py[j][k]);
+                xMax = std::max(xMax, px[j][k]);
+                yMax = std::max(yMax, py[j][k]);
+            }
+        }
+    }
+
+    // The distance between the surface and its piecewise linear
+    // approximation on an n x n grid is bounded by the second
+    // differences of the control points along the curves and across
+    // them (the twist), divided by n^2.
+    double curve = 0, twist = 0;
+    for (int j = 0; j < 4; ++j) {
+        for (int k = 0; k < 2; ++k) {
+            curve = std::max(curve, hypot(px[j][k] - 2 * px[j][k + 1] + px[j][k + 2], py[j][k] - 2 * py[j][k + 1] + py[j][k + 2]));
+            curve = std::max(curve, hypot(px[k][j] - 2 * px[k + 1][j] + px[k + 2][j], py[k][j] - 2 * py[k + 1][j] + py[k + 2][j]));
+        }
+    }
+    for (int j = 0; j < 3; ++j) {
+        for (int k = 0; k < 3; ++k) {
+            twist = std::max(twist, hypot(px[j][k] - px[j][k + 1] - px[j + 1][k] + px[j + 1][k + 1], py[j][k] - py[j][k + 1] - py[j + 1][k] + py[j + 1][k + 1]));
+        }
+    }
+    double n2 = (0.75 * curve + 2.25 * twist) / patchMeshFlatness;
+
+    // The colors are interpolated bilinearly across the patch, which the
+    // triangles approximate up to a fourth of the color twist.
+    const double *c00 = patch->color[0][0].c;
+    const double *c01 = patch->color[0][1].c;
+    const double *c10 = patch->color[1][0].c;
+    const double *c11 = patch->color[1][1].c;
+    if (parameterized) {
+        const double range = shading->getParameterDomainMax() - shading->getParameterDomainMin();
+        if (range > 0) {
+            n2 = std::max(n2, fabs(c00[0] - c01[0] - c10[0] + c11[0]) / (4 * patchMeshParamDelta * range));
+        }
+    } else {
+        const bool linear = gfxMode == csDeviceGray || gfxMode == csDeviceRGB || gfxMode == csDeviceCMYK;
+        for (int k = 0; k < colorSpace->getNComps(); ++k) {
+            n2 = std::max(n2, fabs(c00[k] - c01[k] - c10[k] + c11[k]) / (4 * dblToCol(patchMeshParamDelta)));
+            if (!linear) {
+                const double d = std::max(std::max(fabs(c00[k] - c01[k]), fabs(c01[k] - c11[k])), std::max(fabs(c11[k] - c10[k]), fabs(c10[k] - c00[k])));
+                const double n = d / dblToCol(patchMeshColorDelta);
+                n2 = std::max(n2, n * n);
+            }
+        }
+    }
+
+    // there's no point in triangles much smaller than a pixel
+    const double extent = std::max(xMax - xMin, yMax - yMin);
+    int n = 1;
+    if (std::isfinite(n2) && std::isfinite(extent)) {
+        n = (int)std::clamp(ceil(sqrt(n2)), 1.0, std::clamp(ceil(extent), 1.0, (double)patchMeshMaxGrid));
+    }
+
+    // evaluate the tensor-product surface at the grid vertices
+    double bernstein[patchMeshMaxGrid + 1][4];
+    for (int j = 0; j <= n; ++j) {
+        const double s = (double)j / n;
+        const double s1 = 1 - s;
+        bernstein[j][0] = s1 * s1 * s1;
+        bernstein[j][1] = 3 * s * s1 * s1;
+        bernstein[j][2] = 3 * s * s * s1;
+        bernstein[j][3] = s * s * s;
+    }
+    grid->resize((n + 1) * (n + 1));
+    SplashPatchMeshVertex *vertex = grid->data();
+    for (int j = 0; j <= n; ++j) {
+        const double s = (double)j / n;
+        for (int k = 0; k <= n; ++k, ++vertex) {
+            const double t = (double)k / n;
+            double x = 0, y = 0;
+            for (int a = 0; a < 4; ++a) {
+                double xa = 0, ya = 0;
+                for (int b = 0; b < 4; ++b) {
+                    xa += bernstein[k][b] * px[a][b];
+                    ya += bernstein[k][b] * py[a][b];
+                }
+                x += bernstein[j][a] * xa;
+                y += bernstein[j][a] * ya;
+            }
+            vertex->x = x;
+            vertex->y = y;
+            const double w00 = (1 - s) * (1 - t), w01 = (1 - s) * t, w10 = s * (1 - t), w11 = s * t;
+            if (parameterized) {
+                vertex->t = w00 * c00[0] + w01 * c01[0] + w10 * c10[0] + w11 * c11[0];
+            } else {
+                GfxColor color;
+                for (int c = 0; c < colorSpace->getNComps(); ++c) {
+                    color.c[c] = GfxColorComp(w00 * c00[c] + w01 * c01[c] + w10 * c10[c] + w11 * c11[c]);
+                }
+                convertGfxColor(vertex->color, mode, colorSpace, &color);
+            }
+        }
+    }
+    return n;
+}
+
+void SplashPatchMeshPattern::getParameterizedColor(double t, SplashColorMode mode, SplashColorPtr c)
+{
+    const int nComps = splashColorModeNComps[mode];
+    const double tMin = shading->getParameterDomainMin();
+    const double tMax = shading->getParameterDomainMax();
+
+    if (paramColors.empty() || mode != paramColorsMode) {
+        GfxColor color;
+        paramColors.resize(patchMeshParamSamples * nComps);
+        for (int i = 0; i < patchMeshParamSamples; ++i) {
+            shading->getParameterizedColor(tMin + (tMax - tMin) * i / (patchMeshParamSamples - 1), &color);
+            convertGfxShortColor(&paramColors[i * nComps], mode, shading->getColorSpace(), &color);
+        }
+        paramColorsMode = mode;
+    }
+
+    int i = 0;
+    if (tMax > tMin) {
+        const double pos = (t - tMin) / (tMax - tMin) * (patchMeshParamSamples - 1) + 0.5;
+        if (pos >= patchMeshParamSamples - 1) {
+            i = patchMeshParamSamples - 1;
+        } else if (pos > 0) {
+            i = (int)pos;
+        }
+    }
+    memcpy(c, &paramColors[i * nComps], nComps);
+}
+
 //------------------------------------------------------------------------
 // SplashFunctionPattern
 //------------------------------------------------------------------------
@@ -1080,6 +1282,50 @@ private:
 
 SplashOutFontFileID::~SplashOutFontFileID() = default;
 
+//------------------------------------------------------------------------
+// SplashOutTileCacheEntry
+//------------------------------------------------------------------------
+
+// A tile of a tiling pattern, rendered at device resolution.  Tiles are
+// identified by the position of the pattern content stream in the PDF
+// file, so that they can be reused across pattern fills and pages, and
+// by the optional content state they were drawn with, as the content may
+// be in optional content groups shown or hidden meanwhile.
+struct SplashOutTileCacheEntry
+{
+    SplashOutTileCacheEntry(Goffset streamStartA, unsigned int ocStateGenerationA, int paintTypeA, bool antialiasA, const double *dmA, double phaseXA, double phaseYA, SplashBitmap *tileA)
+    {
+        streamStart = streamStartA;
+        ocStateGeneration = ocStateGenerationA;
+        paintType = paintTypeA;
+        antialias = antialiasA;
+        for (int i = 0; i < 4; ++i) {
+            dm[i] = dmA[i];
+        }
+        phaseX = phaseXA;
+        phaseY = phaseYA;
+        tile = tileA;
+    }
+    ~SplashOutTileCacheEntry() { delete tile; }
+    SplashOutTileCacheEntry(const SplashOutTileCacheEntry &) = delete;
+    SplashOutTileCacheEntry &operator=(const SplashOutTileCacheEntry &) = delete;
+
+    bool matches(Goffset streamStartA, unsigned int ocStateGenerationA, int paintTypeA, bool antialiasA, const double *dmA, double phaseXA, double phaseYA) const
+    {
+        return streamStart == streamStartA && ocStateGeneration == ocStateGenerationA && paintType == paintTypeA && antialias == antialiasA && dm[0] == dmA[0] && dm[1] == dmA[1] && dm[2] == dmA[2] && dm[3] == dmA[3] && phaseX == phaseXA && phaseY == phaseYA;
+    }
+
+    size_t getSize() const { return (size_t)tile->getHeight() * (std::abs(tile->getRowSize()) + tile->getWidth()); }
+
+    Goffset streamStart; // position of the content stream in the file
+    unsigned int ocStateGeneration; // optional content state generation
+    int paintType;
+    bool antialias; // set if the tile was rendered with vector antialiasing
+    double dm[4]; // pattern space -> device space transform
+    double phaseX, phaseY; // offset of the tile pixels, in tile space
+    SplashBitmap *tile;
+};
+
 //------------------------------------------------------------------------
 // T3FontCache
 //------------------------------------------------------------------------
@@ -1193,6 +1439,7 @@ struct SplashTransparencyGroup
 {
     int tx, ty; // translation coordinates
     SplashBitmap *tBitmap; // bitmap for transparency group
+    int modXMin, modYMin, modXMax, modYMax; // part of tBitmap drawn into
     SplashBitmap *softmask; // bitmap for softmasks
     GfxColorSpace *blendingColorSpace;
     bool isolated;
@@ -1221,6 +1468,11 @@ SplashOutputDev::SplashOutputDev(SplashColorMode colorModeA, int bitmapRowPadA,
     bitmapTopDown = bitmapTopDownA;
     fontAntialias = true;
     vectorAntialias = true;
+    imageInterpolation = true;
+    reducedImageDecoding = false;
+    placeholderMode = false;
+    placeholdersDrawn = false;
+    imagePrefetcher = nullptr;
     overprintPreview = overprintPreviewA;
     enableFreeType = true;
     enableFreeTypeHinting = false;
@@ -1242,12 +1494,14 @@ SplashOutputDev::SplashOutputDev(SplashColorMode colorModeA, int bitmapRowPadA,
     splash = new Splash(bitmap, vectorAntialias, &screenParams);
     splash->setMinLineWidth(s_minLineWidth);
     splash->setThinLineMode(thinLineMode);
+    splash->setImageInterpolation(imageInterpolation);
     splash->clear(paperColor, 0);
 
     fontEngine = nullptr;
 
     nT3Fonts = 0;
     t3GlyphStack = nullptr;
+    nTiles = 0;
 
     font = nullptr;
     needFontUpdate = false;
@@ -1289,6 +1543,9 @@ SplashOutputDev::~SplashOutputDev()
     for (i = 0; i < nT3Fonts; ++i) {
         delete t3FontCache[i];
     }
+    for (i = 0; i < nTiles; ++i) {
+        delete tileCache[i];
+    }
     if (fontEngine) {
         delete fontEngine;
     }
@@ -1314,6 +1571,10 @@ void SplashOutputDev::startDoc(PDFDoc *docA)
         delete t3FontCache[i];
     }
     nT3Fonts = 0;
+    for (i = 0; i < nTiles; ++i) {
+        delete tileCache[i];
+    }
+    nTiles = 0;
 }
 
 void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA)
@@ -1323,6 +1584,7 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA)
     SplashColor color;
 
     xref = xrefA;
+    placeholdersDrawn = false;
     if (state) {
         setupScreenParams(state->getHDPI(), state->getVDPI());
         w = (int)(state->getPageWidth() + 0.5);
@@ -1342,7 +1604,9 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA)
         delete splash;
         splash = nullptr;
     }
-    if (!bitmap || w != bitmap->getWidth() || h != bitmap->getHeight()) {
+    // the bitmap of the previous page can't be reused if its data was
+    // taken, or converted to another mode
+    if (!bitmap || !bitmap->getDataPtr() || bitmap->getMode() != colorMode || w != bitmap->getWidth() || h != bitmap->getHeight()) {
         if (bitmap) {
             delete bitmap;
             bitmap = nullptr;
@@ -1356,6 +1620,7 @@ void SplashOutputDev::startPage(int pageNum, GfxState *state, XRef *xrefA)
     }
     splash = new Splash(bitmap, vectorAntialias, &screenParams);
     splash->setThinLineMode(thinLineMode);
+    splash->setImageInterpolation(imageInterpolation);
     splash->setMinLineWidth(s_minLineWidth);
     if (state) {
         const double *ctm = state->getCTM();
@@ -2563,6 +2828,7 @@ void SplashOutputDev::type3D1(GfxState *state, double wx, double wy, double llx,
     }
     splash->setMinLineWidth(s_minLineWidth);
     splash->setThinLineMode(splashThinLineDefault);
+    splash->setImageInterpolation(imageInterpolation);
     splash->setFillPattern(new SplashSolidColor(color));
     splash->setStrokePattern(new SplashSolidColor(color));
     //~ this should copy other state from t3GlyphStack->origSplash?
@@ -2596,13 +2862,102 @@ void SplashOutputDev::endTextObject(GfxState *state)
     }
 }
 
+// In placeholder mode, fill the area of a large image with a light gray
+// instead of decoding it.  Images of Type 3 glyphs are always drawn, as
+// the glyphs are cached.
+bool SplashOutputDev::drawImagePlaceholder(GfxState *state, int width, int height)
+{
+    if (!placeholderMode || t3GlyphStack || (long long)width * height < splashOutPlaceholderImagePixels) {
+        return false;
+    }
+
+    GfxDeviceGrayColorSpace colorSpace;
+    GfxColor color;
+    SplashPath path;
+
+    color.c[0] = dblToCol(0.85);
+    path.moveTo(0, 0);
+    path.lineTo(1, 0);
+    path.lineTo(1, 1);
+    path.lineTo(0, 1);
+    path.close();
+    fillPlaceholder(state, &path, &colorSpace, &color);
+    return true;
+}
+
+void SplashOutputDev::fillPlaceholder(GfxState *state, SplashPath *path, GfxColorSpace *colorSpace, const GfxColor *color)
+{
+    GfxGray gray;
+    GfxRGB rgb;
+    GfxCMYK cmyk;
+    GfxColor deviceN;
+
+    switch (colorMode) {
+    case splashModeMono1:
+    case splashModeMono8:
+        colorSpace->getGray(color, &gray);
+        splash->setFillPattern(getColor(gray));
+        break;
+    case splashModeXBGR8:
+    case splashModeRGB8:
+    case splashModeBGR8:
+        colorSpace->getRGB(color, &rgb);
+        splash->setFillPattern(getColor(&rgb));
+        break;
+    case splashModeCMYK8:
+        colorSpace->getCMYK(color, &cmyk);
+        splash->setFillPattern(getColor(&cmyk));
+        break;
+    case splashModeDeviceN8:
+        colorSpace->createMapping(bitmap->getSeparationList(), SPOT_NCOMPS);
+        colorSpace->getDeviceN(color, &deviceN);
+        splash->setFillPattern(getColor(&deviceN));
+        break;
+    }
+    setOverprintMask(colorSpace, state->getFillOverprint(), state->getOverprintMode(), color);
+    splash->fill(path, false);
+    updateFillColor(state);
+    placeholdersDrawn = true;
+}
+
+// Splash checks the abort callback of the output device in shadings.
+static bool splashOutAbortCheck(void *data)
+{
+    return static_cast<OutputDev *>(data)->checkAbort();
+}
+
 struct SplashOutImageMaskData
 {
     ImageStream *imgStr;
+    CCITTFaxStream *faxStr; // set if the rows are read as runs
+    std::vector<int> runs;
     bool invert;
     int width, height, y;
+    OutputDev *out; // checked for an abort
+    bool aborted;
 };
 
+// The image sources check for an abort every few lines, after which
+// they leave the rest of the image undecoded.
+static inline bool imageLineAborted(OutputDev *out, int y, bool *aborted)
+{
+    if (!*aborted && (y & 31) == 31) {
+        *aborted = out->checkAbort();
+    }
+    return *aborted;
+}
+
+// Image masks straight out of a CCITT fax decoder are read as runs,
+// which are expanded into the line without packing them into bits.
+static CCITTFaxStream *getImageMaskFaxStream(Stream *str, int width)
+{
+    if (str->getKind() != strCCITTFax) {
+        return nullptr;
+    }
+    CCITTFaxStream *faxStr = static_cast<CCITTFaxStream *>(str);
+    return faxStr->getColumns() == width ? faxStr : nullptr;
+}
+
 bool SplashOutputDev::imageMaskSrc(void *data, SplashColorPtr line)
 {
     SplashOutImageMaskData *imgMaskData = (SplashOutImageMaskData *)data;
@@ -2610,9 +2965,25 @@ bool SplashOutputDev::imageMaskSrc(void *data, SplashColorPtr line)
     SplashColorPtr q;
     int x;
 
-    if (imgMaskData->y == imgMaskData->height) {
+    if (imgMaskData->y == imgMaskData->height || imageLineAborted(imgMaskData->out, imgMaskData->y, &imgMaskData->aborted)) {
         return false;
     }
+    if (imgMaskData->faxStr) {
+        // white pixels are 1 bits, like the EOF filler of ImageStream
+        unsigned char pix = 1 ^ (imgMaskData->faxStr->getBlackIs1() ? 1 : 0) ^ imgMaskData->invert;
+        if (imgMaskData->faxStr->readRowRuns(&imgMaskData->runs)) {
+            q = line;
+            for (int run : imgMaskData->runs) {
+                memset(q, pix, run);
+                q += run;
+                pix ^= 1;
+            }
+        } else {
+            memset(line, 1 ^ imgMaskData->invert, imgMaskData->width);
+        }
+        ++imgMaskData->y;
+        return true;
+    }
     if (!(p = imgMaskData->imgStr->getLine())) {
         return false;
     }
@@ -2623,6 +2994,39 @@ bool SplashOutputDev::imageMaskSrc(void *data, SplashColorPtr line)
     return true;
 }
 
+bool SplashOutputDev::imageMaskBitsSrc(void *data, unsigned char *bits)
+{
+    SplashOutImageMaskData *imgMaskData = (SplashOutImageMaskData *)data;
+    unsigned char *p;
+
+    if (imgMaskData->y == imgMaskData->height || imageLineAborted(imgMaskData->out, imgMaskData->y, &imgMaskData->aborted)) {
+        return false;
+    }
+    if (!(p = imgMaskData->imgStr->getPackedLine())) {
+        return false;
+    }
+    const int n = (imgMaskData->width + 7) / 8;
+    if (imgMaskData->invert) {
+        for (int i = 0; i < n; ++i) {
+            bits[i] = p[i] ^ 0xff;
+        }
+    } else {
+        memcpy(bits, p, n);
+    }
+    ++imgMaskData->y;
+    return true;
+}
+
+// Return a stream reading the data of the image <ref> decoded by the
+// image prefetcher, or nullptr to read <str>.
+Stream *SplashOutputDev::getPrefetchedImage(Object *ref, Stream *str)
+{
+    if (!imagePrefetcher || !ref || !ref->isRef()) {
+        return nullptr;
+    }
+    return imagePrefetcher->getDecodedImage(ref->getRef(), str);
+}
+
 void SplashOutputDev::drawImageMask(GfxState *state, Object *ref, Stream *str, int width, int height, bool invert, bool interpolate, bool inlineImg)
 {
     SplashCoord mat[6];
@@ -2638,6 +3042,13 @@ void SplashOutputDev::drawImageMask(GfxState *state, Object *ref, Stream *str, i
         if (!std::isfinite(ctm[i]))
             return;
     }
+    if (!inlineImg && drawImagePlaceholder(state, width, height)) {
+        return;
+    }
+    std::unique_ptr<Stream> prefetched(getPrefetchedImage(ref, str));
+    if (prefetched) {
+        str = prefetched.get();
+    }
     mat[0] = ctm[0];
     mat[1] = ctm[1];
     mat[2] = -ctm[2];
@@ -2647,12 +3058,15 @@ void SplashOutputDev::drawImageMask(GfxState *state, Object *ref, Stream *str, i
 
     imgMaskData.imgStr = new ImageStream(str, width, 1, 1);
     imgMaskData.imgStr->reset();
+    imgMaskData.faxStr = getImageMaskFaxStream(str, width);
     imgMaskData.invert = invert ? false : true;
     imgMaskData.width = width;
     imgMaskData.height = height;
     imgMaskData.y = 0;
+    imgMaskData.out = this;
+    imgMaskData.aborted = false;
 
-    splash->fillImageMask(&imageMaskSrc, &imgMaskData, width, height, mat, t3GlyphStack != nullptr);
+    splash->fillImageMask(&imageMaskSrc, &imgMaskData, width, height, mat, t3GlyphStack != nullptr, &imageMaskBitsSrc);
     if (inlineImg) {
         while (imgMaskData.y < height) {
             imgMaskData.imgStr->getLine();
@@ -2696,10 +3110,13 @@ void SplashOutputDev::setSoftMaskFromImageMask(GfxState *state, Object *ref, Str
     mat[5] = ctm[3] + ctm[5];
     imgMaskData.imgStr = new ImageStream(str, width, 1, 1);
     imgMaskData.imgStr->reset();
+    imgMaskData.faxStr = getImageMaskFaxStream(str, width);
     imgMaskData.invert = invert ? false : true;
     imgMaskData.width = width;
     imgMaskData.height = height;
     imgMaskData.y = 0;
+    imgMaskData.out = this;
+    imgMaskData.aborted = false;
 
     transpGroupStack->softmask = new SplashBitmap(bitmap->getWidth(), bitmap->getHeight(), 1, splashModeMono8, false);
     maskSplash = new Splash(transpGroupStack->softmask, vectorAntialias);
@@ -2707,7 +3124,7 @@ void SplashOutputDev::setSoftMaskFromImageMask(GfxState *state, Object *ref, Str
     maskSplash->clear(maskColor);
     maskColor[0] = 0xff;
     maskSplash->setFillPattern(new SplashSolidColor(maskColor));
-    maskSplash->fillImageMask(&imageMaskSrc, &imgMaskData, width, height, mat, t3GlyphStack != nullptr);
+    maskSplash->fillImageMask(&imageMaskSrc, &imgMaskData, width, height, mat, t3GlyphStack != nullptr, &imageMaskBitsSrc);
     delete maskSplash;
     delete imgMaskData.imgStr;
     str->close();
@@ -2747,6 +3164,8 @@ struct SplashOutImageData
     const int *maskColors;
     SplashColorMode colorMode;
     int width, height, y;
+    OutputDev *out; // checked for an abort
+    bool aborted;
     ImageStream *maskStr;
     GfxImageColorMap *maskColorMap;
     SplashColor matteColor;
@@ -2803,7 +3222,7 @@ bool SplashOutputDev::imageSrc(void *data, SplashColorPtr colorLine, unsigned ch
     GfxColor deviceN;
     int nComps, x;
 
-    if (imgData->y == imgData->height) {
+    if (imgData->y == imgData->height || imageLineAborted(imgData->out, imgData->y, &imgData->aborted)) {
         return false;
     }
     if (!(p = imgData->imgStr->getLine())) {
@@ -2941,6 +3360,24 @@ bool SplashOutputDev::imageSrc(void *data, SplashColorPtr colorLine, unsigned ch
     return true;
 }
 
+// Reads the lines of a 1-bit image with a lookup table as they are
+// stored, leaving the mapping of the two values to Splash.
+bool SplashOutputDev::imageBitsSrc(void *data, unsigned char *bits)
+{
+    SplashOutImageData *imgData = (SplashOutImageData *)data;
+    unsigned char *p;
+
+    if (imgData->y == imgData->height || imageLineAborted(imgData->out, imgData->y, &imgData->aborted)) {
+        return false;
+    }
+    if (!(p = imgData->imgStr->getPackedLine())) {
+        return false;
+    }
+    memcpy(bits, p, (imgData->width + 7) / 8);
+    ++imgData->y;
+    return true;
+}
+
 #ifdef USE_CMS
 bool SplashOutputDev::iccImageSrc(void *data, SplashColorPtr colorLine, unsigned char * /*alphaLine*/)
 {
@@ -2948,7 +3385,7 @@ bool SplashOutputDev::iccImageSrc(void *data, SplashColorPtr colorLine, unsigned
     unsigned char *p;
     int nComps;
 
-    if (imgData->y == imgData->height) {
+    if (imgData->y == imgData->height || imageLineAborted(imgData->out, imgData->y, &imgData->aborted)) {
         return false;
     }
     if (!(p = imgData->imgStr->getLine())) {
@@ -3048,7 +3485,7 @@ bool SplashOutputDev::alphaImageSrc(void *data, SplashColorPtr colorLine, unsign
     unsigned char alpha;
     int nComps, x, i;
 
-    if (imgData->y == imgData->height) {
+    if (imgData->y == imgData->height || imageLineAborted(imgData->out, imgData->y, &imgData->aborted)) {
         return false;
     }
     if (!(p = imgData->imgStr->getLine())) {
@@ -3137,97 +3574,6 @@ bool SplashOutputDev::alphaImageSrc(void *data, SplashColorPtr colorLine, unsign
     return true;
 }
 
-struct TilingSplashOutBitmap
-{
-    SplashBitmap *bitmap;
-    SplashPattern *pattern;
-    SplashColorMode colorMode;
-    int paintType;
-    int repeatX;
-    int repeatY;
-    int y;
-};
-
-bool SplashOutputDev::tilingBitmapSrc(void *data, SplashColorPtr colorLine, unsigned char *alphaLine)
-{
-    TilingSplashOutBitmap *imgData = (TilingSplashOutBitmap *)data;
-
-    if (imgData->y == imgData->bitmap->getHeight()) {
-        imgData->repeatY--;
-        if (imgData->repeatY == 0)
-            return false;
-        imgData->y = 0;
-    }
-
-    if (imgData->paintType == 1) {
-        const SplashColorMode cMode = imgData->bitmap->getMode();
-        SplashColorPtr q = colorLine;
-        // For splashModeBGR8 and splashModeXBGR8 we need to use getPixel
-        // for the others we can use raw access
-        if (cMode == splashModeBGR8 || cMode == splashModeXBGR8) {
-            for (int m = 0; m < imgData->repeatX; m++) {
-                for (int x = 0; x < imgData->bitmap->getWidth(); x++) {
-                    imgData->bitmap->getPixel(x, imgData->y, q);
-                    q += splashColorModeNComps[cMode];
-                }
-            }
-        } else {
-            const int n = imgData->bitmap->getRowSize();
-            SplashColorPtr p;
-            for (int m = 0; m < imgData->repeatX; m++) {
-                p = imgData->bitmap->getDataPtr() + imgData->y * imgData->bitmap->getRowSize();
-                for (int x = 0; x < n; ++x) {
-                    *q++ = *p++;
-                }
-            }
-        }
-        if (alphaLine != nullptr) {
-            SplashColorPtr aq = alphaLine;
-            SplashColorPtr p;
-            const int n = imgData->bitmap->getWidth() - 1;
-            for (int m = 0; m < imgData->repeatX; m++) {
-                p = imgData->bitmap->getAlphaPtr() + imgData->y * imgData->bitmap->getWidth();
-                for (int x = 0; x < n; ++x) {
-                    *aq++ = *p++;
-                }
-                // This is a hack, because of how Splash antialias works if we overwrite the
-                // last alpha pixel of the tile most/all of the files look much better
-                *aq++ = (n == 0) ? *p : *(p - 1);
-            }
-        }
-    } else {
-        SplashColor col, pat;
-        SplashColorPtr dest = colorLine;
-        for (int m = 0; m < imgData->repeatX; m++) {
-            for (int x = 0; x < imgData->bitmap->getWidth(); x++) {
-                imgData->bitmap->getPixel(x, imgData->y, col);
-                imgData->pattern->getColor(x, imgData->y, pat);
-                for (int i = 0; i < splashColorModeNComps[imgData->colorMode]; ++i) {
-                    if (imgData->colorMode == splashModeCMYK8 || imgData->colorMode == splashModeDeviceN8)
-                        dest[i] = div255(pat[i] * (255 - col[0]));
-                    else
-                        dest[i] = 255 - div255((255 - pat[i]) * (255 - col[0]));
-                }
-                dest += splashColorModeNComps[imgData->colorMode];
-            }
-        }
-        if (alphaLine != nullptr) {
-            const int y = (imgData->y == imgData->bitmap->getHeight() - 1 && imgData->y > 50) ? imgData->y - 1 : imgData->y;
-            SplashColorPtr aq = alphaLine;
-            SplashColorPtr p;
-            const int n = imgData->bitmap->getWidth();
-            for (int m = 0; m < imgData->repeatX; m++) {
-                p = imgData->bitmap->getAlphaPtr() + y * imgData->bitmap->getWidth();
-                for (int x = 0; x < n; ++x) {
-                    *aq++ = *p++;
-                }
-            }
-        }
-    }
-    ++imgData->y;
-    return true;
-}
-
 void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int width, int height, GfxImageColorMap *colorMap, bool interpolate, const int *maskColors, bool inlineImg)
 {
     SplashCoord mat[6];
@@ -3248,6 +3594,13 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int w
         if (!std::isfinite(ctm[i]))
             return;
     }
+    if (!inlineImg && drawImagePlaceholder(state, width, height)) {
+        return;
+    }
+    std::unique_ptr<Stream> prefetched(getPrefetchedImage(ref, str));
+    if (prefetched) {
+        str = prefetched.get();
+    }
     mat[0] = ctm[0];
     mat[1] = ctm[1];
     mat[2] = -ctm[2];
@@ -3255,6 +3608,24 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int w
     mat[4] = ctm[2] + ctm[4];
     mat[5] = ctm[3] + ctm[5];
 
+    // decode a JPEG image at the smallest fraction of its size still
+    // larger than the area it's drawn to
+    int reduction = 1;
+    if (reducedImageDecoding && !inlineImg && str->getKind() == strDCT) {
+        const double drawnWidth = std::sqrt(mat[0] * mat[0] + mat[1] * mat[1]);
+        const double drawnHeight = std::sqrt(mat[2] * mat[2] + mat[3] * mat[3]);
+        reduction = 8;
+        while (reduction > 1 && (width / reduction < drawnWidth || height / reduction < drawnHeight)) {
+            reduction /= 2;
+        }
+        if (reduction > 1 && str->setDecodeReduction(reduction)) {
+            width = (width + reduction - 1) / reduction;
+            height = (height + reduction - 1) / reduction;
+        } else {
+            reduction = 1;
+        }
+    }
+
     imgData.imgStr = new ImageStream(str, width, colorMap->getNumPixelComps(), colorMap->getBits());
     imgData.imgStr->reset();
     imgData.colorMap = colorMap;
@@ -3265,6 +3636,8 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int w
     imgData.maskStr = nullptr;
     imgData.maskColorMap = nullptr;
     imgData.y = 0;
+    imgData.out = this;
+    imgData.aborted = false;
 
     // special case for one-channel (monochrome/gray/separation) images:
     // build a lookup table here
@@ -3352,7 +3725,12 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int w
     src = maskColors ? &alphaImageSrc : &imageSrc;
     tf = nullptr;
 #endif
-    splash->drawImage(src, tf, &imgData, srcMode, maskColors ? true : false, width, height, mat, interpolate);
+    // one-bit images can be scaled down straight from their packed lines
+    SplashImageBitsSource bitsSrc = nullptr;
+    if (src == &imageSrc && imgData.lookup && colorMap->getBits() == 1) {
+        bitsSrc = &imageBitsSrc;
+    }
+    splash->drawImage(src, tf, &imgData, srcMode, maskColors ? true : false, width, height, mat, interpolate, false, bitsSrc, imgData.lookup);
     if (inlineImg) {
         while (imgData.y < height) {
             imgData.imgStr->getLine();
@@ -3363,6 +3741,9 @@ void SplashOutputDev::drawImage(GfxState *state, Object *ref, Stream *str, int w
     gfree(imgData.lookup);
     delete imgData.imgStr;
     str->close();
+    if (reduction > 1) {
+        str->setDecodeReduction(1);
+    }
 }
 
 struct SplashOutMaskedImageData
@@ -3373,6 +3754,8 @@ struct SplashOutMaskedImageData
     SplashColorPtr lookup;
     SplashColorMode colorMode;
     int width, height, y;
+    OutputDev *out; // checked for an abort
+    bool aborted;
 };
 
 bool SplashOutputDev::maskedImageSrc(void *data, SplashColorPtr colorLine, unsigned char *alphaLine)
@@ -3389,7 +3772,7 @@ bool SplashOutputDev::maskedImageSrc(void *data, SplashColorPtr colorLine, unsig
     int maskBit;
     int nComps, x;
 
-    if (imgData->y == imgData->height) {
+    if (imgData->y == imgData->height || imageLineAborted(imgData->out, imgData->y, &imgData->aborted)) {
         return false;
     }
     if (!(p = imgData->imgStr->getLine())) {
@@ -3496,6 +3879,13 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref, Stream *str,
     int n, i;
 
     colorMap->getColorSpace()->createMapping(bitmap->getSeparationList(), SPOT_NCOMPS);
+    if (drawImagePlaceholder(state, width, height)) {
+        return;
+    }
+    std::unique_ptr<Stream> prefetched(getPrefetchedImage(ref, str));
+    if (prefetched) {
+        str = prefetched.get();
+    }
     setOverprintMask(colorMap->getColorSpace(), state->getFillOverprint(), state->getOverprintMode(), nullptr);
 
     // If the mask is higher resolution than the image, use
@@ -3519,10 +3909,13 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref, Stream *str,
         mat[5] = 0;
         imgMaskData.imgStr = new ImageStream(maskStr, maskWidth, 1, 1);
         imgMaskData.imgStr->reset();
+        imgMaskData.faxStr = getImageMaskFaxStream(maskStr, maskWidth);
         imgMaskData.invert = maskInvert ? false : true;
         imgMaskData.width = maskWidth;
         imgMaskData.height = maskHeight;
         imgMaskData.y = 0;
+        imgMaskData.out = this;
+        imgMaskData.aborted = false;
         maskBitmap = new SplashBitmap(width, height, 1, splashModeMono1, false);
         if (!maskBitmap->getDataPtr()) {
             delete maskBitmap;
@@ -3534,7 +3927,7 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref, Stream *str,
         maskSplash->clear(maskColor);
         maskColor[0] = 0xff;
         maskSplash->setFillPattern(new SplashSolidColor(maskColor));
-        maskSplash->fillImageMask(&imageMaskSrc, &imgMaskData, maskWidth, maskHeight, mat, false);
+        maskSplash->fillImageMask(&imageMaskSrc, &imgMaskData, maskWidth, maskHeight, mat, false, &imageMaskBitsSrc);
         delete imgMaskData.imgStr;
         maskStr->close();
         delete maskSplash;
@@ -3563,6 +3956,8 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref, Stream *str,
         imgData.width = width;
         imgData.height = height;
         imgData.y = 0;
+        imgData.out = this;
+        imgData.aborted = false;
 
         // special case for one-channel (monochrome/gray/separation) images:
         // build a lookup table here
@@ -3637,7 +4032,7 @@ void SplashOutputDev::drawMaskedImage(GfxState *state, Object *ref, Stream *str,
     }
 }
 
-void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object * /* ref */, Stream *str, int width, int height, GfxImageColorMap *colorMap, bool interpolate, Stream *maskStr, int maskWidth, int maskHeight, GfxImageColorMap *maskColorMap,
+void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object *ref, Stream *str, int width, int height, GfxImageColorMap *colorMap, bool interpolate, Stream *maskStr, int maskWidth, int maskHeight, GfxImageColorMap *maskColorMap,
                                           bool maskInterpolate)
 {
     SplashCoord mat[6];
@@ -3661,6 +4056,13 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object * /* ref */, S
         if (!std::isfinite(ctm[i]))
             return;
     }
+    if (drawImagePlaceholder(state, width, height)) {
+        return;
+    }
+    std::unique_ptr<Stream> prefetched(getPrefetchedImage(ref, str));
+    if (prefetched) {
+        str = prefetched.get();
+    }
     mat[0] = ctm[0];
     mat[1] = ctm[1];
     mat[2] = -ctm[2];
@@ -3692,6 +4094,8 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object * /* ref */, S
     imgMaskData.width = maskWidth;
     imgMaskData.height = maskHeight;
     imgMaskData.y = 0;
+    imgMaskData.out = this;
+    imgMaskData.aborted = false;
     imgMaskData.maskStr = nullptr;
     imgMaskData.maskColorMap = nullptr;
     const unsigned imgMaskDataLookupSize = 1 << maskColorMap->getBits();
@@ -3732,6 +4136,8 @@ void SplashOutputDev::drawSoftMaskedImage(GfxState *state, Object * /* ref */, S
         imgData.maskStr->reset();
     }
     imgData.y = 0;
+    imgData.out = this;
+    imgData.aborted = false;
 
     // special case for one-channel (monochrome/gray/separation) images:
     // build a lookup table here
@@ -3929,18 +4335,23 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, const double *bbox
         }
     }
 
-    // create the temporary bitmap
-    bitmap = new SplashBitmap(w, h, bitmapRowPad, colorMode, true, bitmapTopDown, bitmap->getSeparationList());
+    // create the temporary bitmap -- an isolated group starts out
+    // transparent black, which zero-filled memory already is, so that
+    // the parts of a large group bitmap which are never drawn into are
+    // never written
+    const bool zeroed = isolated && colorMode != splashModeXBGR8;
+    bitmap = new SplashBitmap(w, h, bitmapRowPad, colorMode, true, bitmapTopDown, bitmap->getSeparationList(), zeroed);
     if (!bitmap->getDataPtr()) {
         delete bitmap;
         w = h = 1;
-        bitmap = new SplashBitmap(w, h, bitmapRowPad, colorMode, true, bitmapTopDown);
+        bitmap = new SplashBitmap(w, h, bitmapRowPad, colorMode, true, bitmapTopDown, nullptr, zeroed);
     }
     splash = new Splash(bitmap, vectorAntialias, transpGroup->origSplash->getScreen());
     if (transpGroup->next != nullptr && transpGroup->next->knockout) {
         fontEngine->setAA(false);
     }
     splash->setThinLineMode(transpGroup->origSplash->getThinLineMode());
+    splash->setImageInterpolation(imageInterpolation);
     splash->setMinLineWidth(s_minLineWidth);
     //~ Acrobat apparently copies at least the fill and stroke colors, and
     //~ maybe other state(?) -- but not the clipping path (and not sure
@@ -3949,10 +4360,13 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, const double *bbox
     splash->setFillPattern(transpGroup->origSplash->getFillPattern()->copy());
     splash->setStrokePattern(transpGroup->origSplash->getStrokePattern()->copy());
     if (isolated) {
-        splashClearColor(color);
-        if (colorMode == splashModeXBGR8)
-            color[3] = 255;
-        splash->clear(color, 0);
+        if (!zeroed) {
+            splashClearColor(color);
+            if (colorMode == splashModeXBGR8)
+                color[3] = 255;
+            splash->clear(color, 0);
+        }
+        splash->clearModRegion();
     } else {
         SplashBitmap *shape = (knockout) ? transpGroup->shape : (transpGroup->next != nullptr && transpGroup->next->shape != nullptr) ? transpGroup->next->shape : transpGroup->origBitmap;
         int shapeTx = (knockout) ? tx : (transpGroup->next != nullptr && transpGroup->next->shape != nullptr) ? transpGroup->next->tx + tx : tx;
@@ -3968,6 +4382,7 @@ void SplashOutputDev::beginTransparencyGroup(GfxState *state, const double *bbox
 void SplashOutputDev::endTransparencyGroup(GfxState *state)
 {
     // restore state
+    splash->getModRegion(&transpGroupStack->modXMin, &transpGroupStack->modYMin, &transpGroupStack->modXMax, &transpGroupStack->modYMax);
     delete splash;
     bitmap = transpGroupStack->origBitmap;
     colorMode = bitmap->getMode();
@@ -3990,10 +4405,22 @@ void SplashOutputDev::paintTransparencyGroup(GfxState *state, const double *bbox
 
     // paint the transparency group onto the parent bitmap
     // - the clip path was set in the parent's state)
+    // - the pixels which weren't drawn into are fully transparent, and
+    //   leave the parent as it is, unless they knock it out
     if (tx < bitmap->getWidth() && ty < bitmap->getHeight()) {
         SplashCoord knockoutOpacity = (transpGroupStack->next != nullptr) ? transpGroupStack->next->knockoutOpacity : transpGroupStack->knockoutOpacity;
+        const bool knockout = transpGroupStack->next != nullptr && transpGroupStack->next->knockout;
+        int xMin = 0, yMin = 0, xMax = tBitmap->getWidth() - 1, yMax = tBitmap->getHeight() - 1;
+        if (!knockout) {
+            xMin = transpGroupStack->modXMin;
+            yMin = transpGroupStack->modYMin;
+            xMax = transpGroupStack->modXMax;
+            yMax = transpGroupStack->modYMax;
+        }
         splash->setOverprintMask(0xffffffff, false);
-        splash->composite(tBitmap, 0, 0, tx, ty, tBitmap->getWidth(), tBitmap->getHeight(), false, !isolated, transpGroupStack->next != nullptr && transpGroupStack->next->knockout, knockoutOpacity);
+        if (xMin <= xMax && yMin <= yMax) {
+            splash->composite(tBitmap, xMin, yMin, tx + xMin, ty + yMin, xMax - xMin + 1, yMax - yMin + 1, false, !isolated, knockout, knockoutOpacity);
+        }
         fontEngine->setAA(transpGroupStack->fontAA);
         if (transpGroupStack->next != nullptr && transpGroupStack->next->shape != nullptr) {
             transpGroupStack->next->knockout = true;
@@ -4012,24 +4439,75 @@ void SplashOutputDev::paintTransparencyGroup(GfxState *state, const double *bbox
     delete tBitmap;
 }
 
+// Soft mask value of a pixel with alpha <a> in an alpha soft mask group.
+static unsigned char getSoftMaskAlpha(unsigned char a, Function *transferFunc)
+{
+    if (transferFunc) {
+        double lum = a / 255.0, lum2;
+        transferFunc->transform(&lum, &lum2);
+        return (int)(lum2 * 255.0 + 0.5);
+    }
+    return a;
+}
+
+// Soft mask value of a pixel of color <color> in a luminosity soft mask
+// group.
+static unsigned char getSoftMaskLuminosity(SplashColorMode mode, SplashColorConstPtr color, Function *transferFunc)
+{
+    double lum = 0, lum2;
+
+    switch (mode) {
+    case splashModeMono1:
+    case splashModeMono8:
+        lum = color[0] / 255.0;
+        break;
+    case splashModeXBGR8:
+    case splashModeRGB8:
+    case splashModeBGR8:
+        lum = (0.3 / 255.0) * color[0] + (0.59 / 255.0) * color[1] + (0.11 / 255.0) * color[2];
+        break;
+    case splashModeCMYK8:
+    case splashModeDeviceN8:
+        lum = (1 - color[3] / 255.0) - (0.3 / 255.0) * color[0] - (0.59 / 255.0) * color[1] - (0.11 / 255.0) * color[2];
+        if (lum < 0) {
+            lum = 0;
+        }
+        break;
+    }
+    if (transferFunc) {
+        transferFunc->transform(&lum, &lum2);
+    } else {
+        lum2 = lum;
+    }
+    return (int)(lum2 * 255.0 + 0.5);
+}
+
 void SplashOutputDev::setSoftMask(GfxState *state, const double *bbox, bool alpha, Function *transferFunc, GfxColor *backdropColor)
 {
     SplashBitmap *softMask, *tBitmap;
     Splash *tSplash;
     SplashTransparencyGroup *transpGroup;
-    SplashColor color;
+    SplashColor color, blankColor;
     SplashColorPtr p;
     GfxGray gray;
     GfxRGB rgb;
     GfxCMYK cmyk;
     GfxColor deviceN;
-    double lum, lum2;
     int tx, ty, x, y;
 
     tx = transpGroupStack->tx;
     ty = transpGroupStack->ty;
     tBitmap = transpGroupStack->tBitmap;
 
+    // only the part of the group which was drawn into needs to be
+    // converted pixel by pixel; the rest of it still holds the initial
+    // transparent black, i.e., the backdrop color after compositing
+    const int modXMin = transpGroupStack->modXMin;
+    const int modYMin = transpGroupStack->modYMin;
+    const int modXMax = transpGroupStack->modXMax;
+    const int modYMax = transpGroupStack->modYMax;
+    splashClearColor(blankColor);
+
     // composite with backdrop color
     if (!alpha && tBitmap->getMode() != splashModeMono1) {
         //~ need to correctly handle the case where no blending color
@@ -4043,7 +4521,8 @@ void SplashOutputDev::setSoftMask(GfxState *state, const double *bbox, bool alph
             case splashModeMono8:
                 transpGroupStack->blendingColorSpace->getGray(backdropColor, &gray);
                 color[0] = colToByte(gray);
-                tSplash->compositeBackground(color);
+                tSplash->compositeBackground(color, modXMin, modYMin, modXMax, modYMax);
+                splashColorCopy(blankColor, color);
                 break;
             case splashModeXBGR8:
                 color[3] = 255;
@@ -4054,7 +4533,8 @@ void SplashOutputDev::setSoftMask(GfxState *state, const double *bbox, bool alph
                 color[0] = colToByte(rgb.r);
                 color[1] = colToByte(rgb.g);
                 color[2] = colToByte(rgb.b);
-                tSplash->compositeBackground(color);
+                tSplash->compositeBackground(color, modXMin, modYMin, modXMax, modYMax);
+                splashColorCopy(blankColor, color);
                 break;
             case splashModeCMYK8:
                 transpGroupStack->blendingColorSpace->getCMYK(backdropColor, &cmyk);
@@ -4062,26 +4542,31 @@ void SplashOutputDev::setSoftMask(GfxState *state, const double *bbox, bool alph
                 color[1] = colToByte(cmyk.m);
                 color[2] = colToByte(cmyk.y);
                 color[3] = colToByte(cmyk.k);
-                tSplash->compositeBackground(color);
+                tSplash->compositeBackground(color, modXMin, modYMin, modXMax, modYMax);
+                splashColorCopy(blankColor, color);
                 break;
             case splashModeDeviceN8:
                 transpGroupStack->blendingColorSpace->getDeviceN(backdropColor, &deviceN);
                 for (int cp = 0; cp < SPOT_NCOMPS + 4; cp++)
                     color[cp] = colToByte(deviceN.c[cp]);
-                tSplash->compositeBackground(color);
+                tSplash->compositeBackground(color, modXMin, modYMin, modXMax, modYMax);
+                splashColorCopy(blankColor, color);
                 break;
             }
             delete tSplash;
         }
     }
 
-    softMask = new SplashBitmap(bitmap->getWidth(), bitmap->getHeight(), 1, splashModeMono8, false);
     unsigned char fill = 0;
     if (transpGroupStack->blendingColorSpace) {
         transpGroupStack->blendingColorSpace->getGray(backdropColor, &gray);
         fill = colToByte(gray);
     }
-    memset(softMask->getDataPtr(), fill, softMask->getRowSize() * softMask->getHeight());
+    softMask = new SplashBitmap(bitmap->getWidth(), bitmap->getHeight(), 1, splashModeMono8, false, true, nullptr, fill == 0);
+    if (fill != 0) {
+        memset(softMask->getDataPtr(), fill, softMask->getRowSize() * softMask->getHeight());
+    }
+    const unsigned char blank = alpha ? getSoftMaskAlpha(0, transferFunc) : getSoftMaskLuminosity(tBitmap->getMode(), blankColor, transferFunc);
     p = softMask->getDataPtr() + ty * softMask->getRowSize() + tx;
     int xMax = tBitmap->getWidth();
     int yMax = tBitmap->getHeight();
@@ -4089,42 +4574,25 @@ void SplashOutputDev::setSoftMask(GfxState *state, const double *bbox, bool alph
         xMax = bitmap->getWidth() - tx;
     if (yMax > bitmap->getHeight() - ty)
         yMax = bitmap->getHeight() - ty;
+    const int x0 = std::max(modXMin, 0);
+    const int x1 = std::min(modXMax, xMax - 1);
     for (y = 0; y < yMax; ++y) {
-        for (x = 0; x < xMax; ++x) {
-            if (alpha) {
-                if (transferFunc) {
-                    lum = tBitmap->getAlpha(x, y) / 255.0;
-                    transferFunc->transform(&lum, &lum2);
-                    p[x] = (int)(lum2 * 255.0 + 0.5);
-                } else
-                    p[x] = tBitmap->getAlpha(x, y);
-            } else {
-                tBitmap->getPixel(x, y, color);
-                // convert to luminosity
-                switch (tBitmap->getMode()) {
-                case splashModeMono1:
-                case splashModeMono8:
-                    lum = color[0] / 255.0;
-                    break;
-                case splashModeXBGR8:
-                case splashModeRGB8:
-                case splashModeBGR8:
-                    lum = (0.3 / 255.0) * color[0] + (0.59 / 255.0) * color[1] + (0.11 / 255.0) * color[2];
-                    break;
-                case splashModeCMYK8:
-                case splashModeDeviceN8:
-                    lum = (1 - color[3] / 255.0) - (0.3 / 255.0) * color[0] - (0.59 / 255.0) * color[1] - (0.11 / 255.0) * color[2];
-                    if (lum < 0) {
-                        lum = 0;
-                    }
-                    break;
-                }
-                if (transferFunc) {
-                    transferFunc->transform(&lum, &lum2);
+        if (y < modYMin || y > modYMax || x0 > x1) {
+            if (blank != fill) {
+                memset(p, blank, xMax);
+            }
+        } else {
+            if (blank != fill) {
+                memset(p, blank, x0);
+                memset(p + x1 + 1, blank, xMax - x1 - 1);
+            }
+            for (x = x0; x <= x1; ++x) {
+                if (alpha) {
+                    p[x] = getSoftMaskAlpha(tBitmap->getAlpha(x, y), transferFunc);
                 } else {
-                    lum2 = lum;
+                    tBitmap->getPixel(x, y, color);
+                    p[x] = getSoftMaskLuminosity(tBitmap->getMode(), color, transferFunc);
                 }
-                p[x] = (int)(lum2 * 255.0 + 0.5);
             }
         }
         p += softMask->getRowSize();
@@ -4182,215 +4650,218 @@ void SplashOutputDev::setVectorAntialias(bool vaa)
 }
 #endif
 
+void SplashOutputDev::setImageInterpolation(bool interpolate)
+{
+    imageInterpolation = interpolate;
+    splash->setImageInterpolation(interpolate);
+}
+
 void SplashOutputDev::setFreeTypeHinting(bool enable, bool enableSlightHintingA)
 {
     enableFreeTypeHinting = enable;
     enableSlightHinting = enableSlightHintingA;
 }
 
-bool SplashOutputDev::tilingPatternFill(GfxState *state, Gfx *gfxA, Catalog *catalog, Object *str, const double *ptm, int paintType, int /*tilingType*/, Dict *resDict, const double *mat, const double *bbox, int x0, int y0, int x1, int y1,
-                                        double xStep, double yStep)
-{
-    PDFRectangle box;
-    Splash *formerSplash = splash;
-    SplashBitmap *formerBitmap = bitmap;
-    double width, height;
-    int surface_width, surface_height, result_width, result_height, i;
-    int repeatX, repeatY;
-    SplashCoord matc[6];
-    Matrix m1;
-    const double *ctm;
-    double savedCTM[6];
-    double kx, ky, sx, sy;
-    bool retValue = false;
+// Maximal number of copies of the pattern cell drawn into a tile.
+#define splashOutMaxTileCellCopies 1024
 
-    width = bbox[2] - bbox[0];
-    height = bbox[3] - bbox[1];
+// Number of consecutive pattern cells, <size> pixels long, to put in a
+// tile.  The copies of the tile line up with the pixel grid when it
+// spans a whole number of pixels; otherwise, the tile is made long
+// enough for the rounding of its size not to distort it much.
+static int getTileCellCount(double size)
+{
+    for (int n = 1; n <= 16; ++n) {
+        if (fabs(n * size - round(n * size)) < 0.01) {
+            return n;
+        }
+    }
+    return (int)std::clamp(ceil(32 / size), 1.0, 16.0);
+}
 
-    if (xStep != width || yStep != height)
+bool SplashOutputDev::tilingPatternFill(GfxState *state, Gfx *gfxA, Catalog *catalog, Object *str, const double * /*ptm*/, int paintType, int /*tilingType*/, Dict *resDict, const double *mat, const double *bbox, int x0, int y0, int x1, int y1,
+                                        double xStep, double yStep)
+{
+    // patterns repeated a few times are drawn directly, as forms
+    if ((double)(x1 - x0) * (y1 - y0) <= 4) {
         return false;
-
-    // calculate offsets
-    ctm = state->getCTM();
-    for (i = 0; i < 6; ++i) {
-        savedCTM[i] = ctm[i];
     }
-    state->concatCTM(mat[0], mat[1], mat[2], mat[3], mat[4], mat[5]);
-    state->concatCTM(1, 0, 0, 1, bbox[0], bbox[1]);
-    ctm = state->getCTM();
-    for (i = 0; i < 6; ++i) {
-        if (!std::isfinite(ctm[i])) {
-            state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
+
+    // pattern space -> device space
+    const double *ctm = state->getCTM();
+    const double dm[6] = { mat[0] * ctm[0] + mat[1] * ctm[2], mat[0] * ctm[1] + mat[1] * ctm[3], mat[2] * ctm[0] + mat[3] * ctm[2], mat[2] * ctm[1] + mat[3] * ctm[3], mat[4] * ctm[0] + mat[5] * ctm[2] + ctm[4], mat[4] * ctm[1] + mat[5] * ctm[3] + ctm[5] };
+    for (double d : dm) {
+        if (!std::isfinite(d)) {
             return false;
         }
     }
-    matc[4] = x0 * xStep * ctm[0] + y0 * yStep * ctm[2] + ctm[4];
-    matc[5] = x0 * xStep * ctm[1] + y0 * yStep * ctm[3] + ctm[5];
-    if (splashAbs(ctm[1]) > splashAbs(ctm[0])) {
-        kx = -ctm[1];
-        ky = ctm[2] - (ctm[0] * ctm[3]) / ctm[1];
-    } else {
-        kx = ctm[0];
-        ky = ctm[3] - (ctm[1] * ctm[2]) / ctm[0];
-    }
-    result_width = (int)ceil(fabs(kx * width * (x1 - x0)));
-    result_height = (int)ceil(fabs(ky * height * (y1 - y0)));
-    kx = state->getHDPI() / 72.0;
-    ky = state->getVDPI() / 72.0;
-    m1.m[0] = (ptm[0] == 0) ? fabs(ptm[2]) * kx : fabs(ptm[0]) * kx;
-    m1.m[1] = 0;
-    m1.m[2] = 0;
-    m1.m[3] = (ptm[3] == 0) ? fabs(ptm[1]) * ky : fabs(ptm[3]) * ky;
-    m1.m[4] = 0;
-    m1.m[5] = 0;
-    m1.transform(width, height, &kx, &ky);
-    surface_width = (int)ceil(fabs(kx));
-    surface_height = (int)ceil(fabs(ky));
-
-    sx = (double)result_width / (surface_width * (x1 - x0));
-    sy = (double)result_height / (surface_height * (y1 - y0));
-    m1.m[0] *= sx;
-    m1.m[3] *= sy;
-    m1.transform(width, height, &kx, &ky);
-
-    if (fabs(kx) < 1 && fabs(ky) < 1) {
-        kx = std::min<double>(kx, ky);
-        ky = 2 / kx;
-        m1.m[0] *= ky;
-        m1.m[3] *= ky;
-        m1.transform(width, height, &kx, &ky);
-        surface_width = (int)ceil(fabs(kx));
-        surface_height = (int)ceil(fabs(ky));
-        repeatX = x1 - x0;
-        repeatY = y1 - y0;
-    } else {
-        if ((unsigned long)surface_width * surface_height > 0x800000L) {
-            state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
-            return false;
-        }
-        while (fabs(kx) > 16384 || fabs(ky) > 16384) {
-            // limit pattern bitmap size
-            m1.m[0] /= 2;
-            m1.m[3] /= 2;
-            m1.transform(width, height, &kx, &ky);
-        }
-        surface_width = (int)ceil(fabs(kx));
-        surface_height = (int)ceil(fabs(ky));
-        // adjust repeat values to completely fill region
-        if (unlikely(surface_width == 0 || surface_height == 0)) {
-            state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
-            return false;
-        }
-        repeatX = result_width / surface_width;
-        repeatY = result_height / surface_height;
-        if (surface_width * repeatX < result_width)
-            repeatX++;
-        if (surface_height * repeatY < result_height)
-            repeatY++;
-        if (x1 - x0 > repeatX)
-            repeatX = x1 - x0;
-        if (y1 - y0 > repeatY)
-            repeatY = y1 - y0;
-    }
-    // restore CTM and calculate rotate and scale with rounded matrix
-    state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
-    state->concatCTM(mat[0], mat[1], mat[2], mat[3], mat[4], mat[5]);
-    state->concatCTM(width * repeatX, 0, 0, height * repeatY, bbox[0], bbox[1]);
-    ctm = state->getCTM();
-    matc[0] = ctm[0];
-    matc[1] = ctm[1];
-    matc[2] = ctm[2];
-    matc[3] = ctm[3];
 
-    if (surface_width == 0 || surface_height == 0 || repeatX * repeatY <= 4) {
-        state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
+    // The tile holds nx x ny cells of pattern space, starting at the
+    // corner of the bounding box, with about the same number of pixels
+    // as they cover in device space.
+    const double bxMin = std::min(bbox[0], bbox[2]), bxMax = std::max(bbox[0], bbox[2]);
+    const double byMin = std::min(bbox[1], bbox[3]), byMax = std::max(bbox[1], bbox[3]);
+    const int nx = getTileCellCount(hypot(dm[0], dm[1]) * xStep);
+    const int ny = getTileCellCount(hypot(dm[2], dm[3]) * yStep);
+    const double tileW = std::max(1.0, round(hypot(dm[0], dm[1]) * xStep * nx));
+    const double tileH = std::max(1.0, round(hypot(dm[2], dm[3]) * yStep * ny));
+    if (!(tileW * tileH <= 0x800000)) {
         return false;
     }
-    m1.transform(bbox[0], bbox[1], &kx, &ky);
-    m1.m[4] = -kx;
-    m1.m[5] = -ky;
-
-    box.x1 = bbox[0];
-    box.y1 = bbox[1];
-    box.x2 = bbox[2];
-    box.y2 = bbox[3];
-    std::unique_ptr<Gfx> gfx = std::make_unique<Gfx>(doc, this, resDict, &box, nullptr, nullptr, nullptr, gfxA);
-    // set pattern transformation matrix
-    gfx->getState()->setCTM(m1.m[0], m1.m[1], m1.m[2], m1.m[3], m1.m[4], m1.m[5]);
-    if (splashAbs(matc[1]) > splashAbs(matc[0])) {
-        kx = -matc[1];
-        ky = matc[2] - (matc[0] * matc[3]) / matc[1];
-    } else {
-        kx = matc[0];
-        ky = matc[3] - (matc[1] * matc[2]) / matc[0];
-    }
-    result_width = surface_width * repeatX;
-    result_height = surface_height * repeatY;
-    kx = result_width / (fabs(kx) + 1);
-    ky = result_height / (fabs(ky) + 1);
-    state->concatCTM(kx, 0, 0, ky, 0, 0);
-    ctm = state->getCTM();
-    matc[0] = ctm[0];
-    matc[1] = ctm[1];
-    matc[2] = ctm[2];
-    matc[3] = ctm[3];
-
-    const bool doFastBlit = matc[0] > 0 && matc[1] == 0 && matc[2] == 0 && matc[3] > 0;
-    bitmap = new SplashBitmap(surface_width, surface_height, 1, (paintType == 1 || doFastBlit) ? colorMode : splashModeMono8, true);
-    if (bitmap->getDataPtr() == nullptr) {
-        SplashBitmap *tBitmap = bitmap;
-        bitmap = formerBitmap;
-        delete tBitmap;
-        state->setCTM(savedCTM[0], savedCTM[1], savedCTM[2], savedCTM[3], savedCTM[4], savedCTM[5]);
+    const int tw = (int)tileW;
+    const int th = (int)tileH;
+    const int iMin = (int)std::max(-1e6, floor((bxMin - bxMax) / xStep) + 1);
+    const int jMin = (int)std::max(-1e6, floor((byMin - byMax) / yStep) + 1);
+    if ((double)(nx - iMin) * (ny - jMin) > splashOutMaxTileCellCopies) {
         return false;
     }
-    splash = new Splash(bitmap, true);
-    updateCTM(gfx->getState(), m1.m[0], m1.m[1], m1.m[2], m1.m[3], m1.m[4], m1.m[5]);
 
-    if (paintType == 2) {
-        SplashColor clearColor;
-        clearColor[0] = (colorMode == splashModeCMYK8 || colorMode == splashModeDeviceN8) ? 0x00 : 0xFF;
-        splash->clear(clearColor, 0);
-    } else {
-        splash->clear(paperColor, 0);
+    // pattern space -> tile space, oriented like the device space
+    const double sx = (dm[0] < 0 ? -tileW : tileW) / (xStep * nx);
+    const double sy = (dm[3] < 0 ? -tileH : tileH) / (yStep * ny);
+    Matrix tm, itm;
+    tm.init(sx, 0, 0, sy, -sx * bxMin + (sx < 0 ? tileW : 0), -sy * byMin + (sy < 0 ? tileH : 0));
+    if (!tm.invertTo(&itm)) {
+        return false;
     }
-    splash->setThinLineMode(formerSplash->getThinLineMode());
-    splash->setMinLineWidth(s_minLineWidth);
-    if (doFastBlit) {
-        // drawImage would colorize the greyscale pattern in tilingBitmapSrc buffer accessor while tiling.
-        // blitImage can't, it has no buffer accessor. We instead colorize the pattern prototype in advance.
-        splash->setFillPattern(formerSplash->getFillPattern()->copy());
-        splash->setStrokePattern(formerSplash->getStrokePattern()->copy());
+
+    // tile space -> device space
+    SplashCoord tileMat[6];
+    tileMat[0] = itm.m[0] * dm[0];
+    tileMat[1] = itm.m[0] * dm[1];
+    tileMat[2] = itm.m[3] * dm[2];
+    tileMat[3] = itm.m[3] * dm[3];
+    tileMat[4] = itm.m[4] * dm[0] + itm.m[5] * dm[2] + dm[4];
+    tileMat[5] = itm.m[4] * dm[1] + itm.m[5] * dm[3] + dm[5];
+
+    // when a tile pixel is (nearly) a device pixel, shift the tile so
+    // that their boundaries match, and it can be copied as it is
+    double phaseX = 0, phaseY = 0;
+    if (tileMat[1] == 0 && tileMat[2] == 0 && fabs(fabs(tileMat[0]) - 1) < 1e-6 && fabs(fabs(tileMat[3]) - 1) < 1e-6) {
+        tileMat[0] = tileMat[0] < 0 ? -1 : 1;
+        tileMat[3] = tileMat[3] < 0 ? -1 : 1;
+        phaseX = (tileMat[4] - floor(tileMat[4])) / tileMat[0];
+        phaseY = (tileMat[5] - floor(tileMat[5])) / tileMat[3];
+        tileMat[4] = floor(tileMat[4]);
+        tileMat[5] = floor(tileMat[5]);
+        tm.m[4] += phaseX;
+        tm.m[5] += phaseY;
+    } else if (tileMat[0] == 0 && tileMat[3] == 0 && fabs(fabs(tileMat[1]) - 1) < 1e-6 && fabs(fabs(tileMat[2]) - 1) < 1e-6) {
+        // same for patterns rotated by a quarter turn, whose tile x axis
+        // is the device y axis
+        tileMat[1] = tileMat[1] < 0 ? -1 : 1;
+        tileMat[2] = tileMat[2] < 0 ? -1 : 1;
+        phaseX = (tileMat[5] - floor(tileMat[5])) / tileMat[1];
+        phaseY = (tileMat[4] - floor(tileMat[4])) / tileMat[2];
+        tileMat[4] = floor(tileMat[4]);
+        tileMat[5] = floor(tileMat[5]);
+        tm.m[4] += phaseX;
+        tm.m[5] += phaseY;
+    }
+
+    // look for the tile in the cache
+    Goffset streamStart = -1;
+    if (str->isStream()) {
+        BaseStream *baseStr = str->getStream()->getBaseStream();
+        if (baseStr && (baseStr->getKind() == strFile || baseStr->getKind() == strCachedFile)) {
+            streamStart = baseStr->getStart();
+        }
+    }
+    const OCGs *optContent = catalog ? catalog->getOptContentConfig() : nullptr;
+    const unsigned int ocStateGeneration = optContent ? optContent->getStateGeneration() : 0;
+    SplashBitmap *tile = nullptr;
+    if (streamStart >= 0) {
+        for (int i = 0; i < nTiles; ++i) {
+            if (tileCache[i]->matches(streamStart, ocStateGeneration, paintType, vectorAntialias, dm, phaseX, phaseY)) {
+                SplashOutTileCacheEntry *entry = tileCache[i];
+                for (int j = i; j > 0; --j) {
+                    tileCache[j] = tileCache[j - 1];
+                }
+                tileCache[0] = entry;
+                tile = entry->tile;
+                break;
+            }
+        }
     }
-    gfx->display(str);
-    delete splash;
-    splash = formerSplash;
 
-    TilingSplashOutBitmap imgData;
-    imgData.bitmap = bitmap;
-    imgData.paintType = paintType;
-    imgData.pattern = splash->getFillPattern();
-    imgData.colorMode = colorMode;
-    imgData.y = 0;
-    imgData.repeatX = repeatX;
-    imgData.repeatY = repeatY;
-    SplashBitmap *tBitmap = bitmap;
-    bitmap = formerBitmap;
-    if (doFastBlit) {
-        // draw the tiles
-        for (int y = 0; y < imgData.repeatY; ++y) {
-            for (int x = 0; x < imgData.repeatX; ++x) {
-                x0 = splashFloor(matc[4]) + x * tBitmap->getWidth();
-                y0 = splashFloor(matc[5]) + y * tBitmap->getHeight();
-                splash->blitImage(tBitmap, true, x0, y0);
+    // render the tile
+    if (!tile) {
+        tile = new SplashBitmap(tw, th, 1, (paintType == 1 && colorMode != splashModeMono1) ? colorMode : splashModeMono8, true);
+        if (tile->getDataPtr() == nullptr) {
+            delete tile;
+            return false;
+        }
+        Splash *formerSplash = splash;
+        SplashBitmap *formerBitmap = bitmap;
+        bitmap = tile;
+        splash = new Splash(bitmap, vectorAntialias);
+        if (paintType == 2) {
+            SplashColor clearColor;
+            clearColor[0] = 0xff;
+            splash->clear(clearColor, 0);
+        } else {
+            splash->clear(paperColor, 0);
+        }
+        splash->setThinLineMode(formerSplash->getThinLineMode());
+        splash->setImageInterpolation(imageInterpolation);
+        splash->setMinLineWidth(s_minLineWidth);
+        splash->setStrokeAdjust(true);
+
+        // draw the copies of the cell overlapping the tile
+        const PDFRectangle box(0, 0, tileW * 72 / state->getHDPI(), tileH * 72 / state->getVDPI());
+        std::unique_ptr<Gfx> gfx = std::make_unique<Gfx>(doc, this, resDict, &box, nullptr, nullptr, nullptr, gfxA);
+        gfx->getState()->setCTM(tm.m[0], tm.m[1], tm.m[2], tm.m[3], tm.m[4], tm.m[5]);
+        updateCTM(gfx->getState(), tm.m[0], tm.m[1], tm.m[2], tm.m[3], tm.m[4], tm.m[5]);
+        // (one more on each side when the tile is shifted by a phase,
+        // since the neighbouring cells then wrap into its first pixels)
+        const int iPad = phaseX != 0 || phaseY != 0 ? 1 : 0;
+        for (int j = jMin - iPad; j < ny + iPad; ++j) {
+            for (int i = iMin - iPad; i < nx + iPad; ++i) {
+                const double m[6] = { 1, 0, 0, 1, i * xStep, j * yStep };
+                gfx->drawForm(str, resDict, m, bbox);
+            }
+        }
+        gfx.reset();
+
+        delete splash;
+        splash = formerSplash;
+        bitmap = formerBitmap;
+
+        // put it in the cache, dropping the least recently used tiles,
+        // unless it is drawn with placeholders or was aborted
+        if (placeholderMode || checkAbort()) {
+            streamStart = -1;
+        }
+        if (streamStart >= 0) {
+            SplashOutTileCacheEntry *entry = new SplashOutTileCacheEntry(streamStart, ocStateGeneration, paintType, vectorAntialias, dm, phaseX, phaseY, tile);
+            size_t size = entry->getSize();
+            if (size <= splashOutTileCacheMaxBytes) {
+                for (int i = 0; i < nTiles; ++i) {
+                    size += tileCache[i]->getSize();
+                }
+                while (nTiles > 0 && (nTiles == splashOutTileCacheSize || size > splashOutTileCacheMaxBytes)) {
+                    --nTiles;
+                    size -= tileCache[nTiles]->getSize();
+                    delete tileCache[nTiles];
+                }
+                for (int i = nTiles; i > 0; --i) {
+                    tileCache[i] = tileCache[i - 1];
+                }
+                tileCache[0] = entry;
+                ++nTiles;
+            } else {
+                entry->tile = nullptr;
+                delete entry;
+                streamStart = -1;
             }
         }
-        retValue = true;
-    } else {
-        retValue = splash->drawImage(&tilingBitmapSrc, nullptr, &imgData, colorMode, true, result_width, result_height, matc, false, true) == splashOk;
     }
-    delete tBitmap;
-    return retValue;
+
+    const bool ok = splash->tileFill(tile, paintType == 2, tileMat) == splashOk;
+    if (streamStart < 0) {
+        delete tile;
+    }
+    return ok;
 }
 
 bool SplashOutputDev::gouraudTriangleShadedFill(GfxState *state, GfxGouraudTriangleShading *shading)
@@ -4408,15 +4879,85 @@ bool SplashOutputDev::gouraudTriangleShadedFill(GfxState *state, GfxGouraudTrian
     default:
         break;
     }
+    if (placeholderMode) {
+        // fill the triangles with the color of the first vertex
+        SplashPath path;
+        GfxColor color;
+        double x0, y0, x1, y1, x2, y2;
+        for (int i = 0; i < shading->getNTriangles(); ++i) {
+            if (shading->isParameterized()) {
+                double color0, color1, color2;
+                shading->getTriangle(i, &x0, &y0, &color0, &x1, &y1, &color1, &x2, &y2, &color2);
+                if (i == 0) {
+                    shading->getParameterizedColor(color0, &color);
+                }
+            } else {
+                GfxColor color0, color1, color2;
+                shading->getTriangle(i, &x0, &y0, &color0, &x1, &y1, &color1, &x2, &y2, &color2);
+                if (i == 0) {
+                    color = color0;
+                }
+            }
+            path.moveTo(x0, y0);
+            path.lineTo(x1, y1);
+            path.lineTo(x2, y2);
+            path.close();
+        }
+        if (path.getLength() > 0) {
+            fillPlaceholder(state, &path, shading->getColorSpace(), &color);
+        }
+        return true;
+    }
+
     // restore vector antialias because we support it here
     SplashGouraudPattern splashShading(bDirectColorTranslation, state, shading);
     const bool vaa = getVectorAntialias();
     setVectorAntialias(true);
+    splash->setAbortCheckCbk(&splashOutAbortCheck, this);
     const bool retVal = splash->gouraudTriangleShadedFill(&splashShading);
     setVectorAntialias(vaa);
     return retVal;
 }
 
+bool SplashOutputDev::patchMeshShadedFill(GfxState *state, GfxPatchMeshShading *shading)
+{
+    if (placeholderMode) {
+        // fill the patches with the color of the first corner
+        SplashPath path;
+        GfxColor color;
+        for (int i = 0; i < shading->getNPatches(); ++i) {
+            const GfxPatch *patch = shading->getPatch(i);
+            if (i == 0) {
+                if (shading->isParameterized()) {
+                    shading->getParameterizedColor(patch->color[0][0].c[0], &color);
+                } else {
+                    for (int j = 0; j < shading->getColorSpace()->getNComps(); ++j) {
+                        color.c[j] = GfxColorComp(patch->color[0][0].c[j]);
+                    }
+                }
+            }
+            path.moveTo(patch->x[0][0], patch->y[0][0]);
+            path.lineTo(patch->x[0][3], patch->y[0][3]);
+            path.lineTo(patch->x[3][3], patch->y[3][3]);
+            path.lineTo(patch->x[3][0], patch->y[3][0]);
+            path.close();
+        }
+        if (path.getLength() > 0) {
+            fillPlaceholder(state, &path, shading->getColorSpace(), &color);
+        }
+        return true;
+    }
+
+    // restore vector antialias because we support it here (for the clip)
+    SplashPatchMeshPattern splashShading(state, shading);
+    const bool vaa = getVectorAntialias();
+    setVectorAntialias(true);
+    splash->setAbortCheckCbk(&splashOutAbortCheck, this);
+    const bool retVal = splash->patchMeshShadedFill(&splashShading);
+    setVectorAntialias(vaa);
+    return retVal;
+}
+
 bool SplashOutputDev::univariateShadedFill(GfxState *state, SplashUnivariatePattern *pattern, double tMin, double tMax)
 {
     double xMin, yMin, xMax, yMax;
@@ -4470,9 +5011,22 @@ bool SplashOutputDev::univariateShadedFill(GfxState *state, SplashUnivariatePatt
 
     pattern->getShading()->getColorSpace()->createMapping(bitmap->getSeparationList(), SPOT_NCOMPS);
     setOverprintMask(pattern->getShading()->getColorSpace(), state->getFillOverprint(), state->getOverprintMode(), nullptr);
-    // If state->getStrokePattern() is set, then the current clipping region
-    // is a stroke path.
-    retVal = (splash->shadedFill(&path, pattern->getShading()->getHasBBox(), pattern, (state->getStrokePattern() != nullptr)) == splashOk);
+    if (placeholderMode) {
+        // fill the region with the color at the middle of the domain
+        GfxUnivariateShading *shading = pattern->getShading();
+        GfxColor color;
+        const int filled = shading->getColor((shading->getDomain0() + shading->getDomain1()) / 2, &color);
+        for (int i = filled; i < shading->getColorSpace()->getNComps(); ++i) {
+            color.c[i] = 0;
+        }
+        fillPlaceholder(state, &path, shading->getColorSpace(), &color);
+        retVal = true;
+    } else {
+        // If state->getStrokePattern() is set, then the current clipping region
+        // is a stroke path.
+        splash->setAbortCheckCbk(&splashOutAbortCheck, this);
+        retVal = (splash->shadedFill(&path, pattern->getShading()->getHasBBox(), pattern, (state->getStrokePattern() != nullptr)) == splashOk);
+    }
     state->clearPath();
     setVectorAntialias(vaa);
 
@@ -4533,9 +5087,20 @@ bool SplashOutputDev::functionShadedFill(GfxState *state, GfxFunctionShading *sh
 
     pattern->getShading()->getColorSpace()->createMapping(bitmap->getSeparationList(), SPOT_NCOMPS);
     setOverprintMask(pattern->getShading()->getColorSpace(), state->getFillOverprint(), state->getOverprintMode(), nullptr);
-    // If state->getStrokePattern() is set, then the current clipping region
-    // is a stroke path.
-    retVal = (splash->shadedFill(&path, pattern->getShading()->getHasBBox(), pattern, (state->getStrokePattern() != nullptr)) == splashOk);
+    if (placeholderMode) {
+        // fill the region with the color at the middle of the domain
+        GfxColor color;
+        double x0, y0, x1, y1;
+        shading->getDomain(&x0, &y0, &x1, &y1);
+        shading->getColor((x0 + x1) / 2, (y0 + y1) / 2, &color);
+        fillPlaceholder(state, &path, shading->getColorSpace(), &color);
+        retVal = true;
+    } else {
+        // If state->getStrokePattern() is set, then the current clipping region
+        // is a stroke path.
+        splash->setAbortCheckCbk(&splashOutAbortCheck, this);
+        retVal = (splash->shadedFill(&path, pattern->getShading()->getHasBBox(), pattern, (state->getStrokePattern() != nullptr)) == splashOk);
+    }
     state->clearPath();
     setVectorAntialias(vaa);
 
@@ -40,6 +40,7 @@
 #include "GlobalParams.h"
 
 class PDFDoc;
+class ImagePrefetcher;
 class Gfx8BitFont;
 class SplashBitmap;
 class Splash;
@@ -47,6 +48,7 @@ class SplashPath;
 class SplashFontEngine;
 class SplashFont;
 class T3FontCache;
+struct SplashOutTileCacheEntry;
 struct T3FontCacheTag;
 struct T3GlyphStack;
 struct SplashTransparencyGroup;
@@ -163,6 +165,43 @@ private:
     GfxColorSpaceMode gfxMode;
 };
 
+//------------------------------------------------------------------------
+// SplashPatchMeshPattern
+//------------------------------------------------------------------------
+
+class SplashPatchMeshPattern : public SplashPatchMeshColor
+{
+public:
+    SplashPatchMeshPattern(GfxState *state, GfxPatchMeshShading *shading);
+
+    SplashPattern *copy() override { return new SplashPatchMeshPattern(state, shading); }
+
+    ~SplashPatchMeshPattern() override;
+
+    bool getColor(int x, int y, SplashColorPtr c) override { return false; }
+
+    bool testPosition(int x, int y) override { return false; }
+
+    bool isStatic() override { return false; }
+
+    bool isCMYK() override { return gfxMode == csDeviceCMYK; }
+
+    bool isParameterized() override { return shading->isParameterized(); }
+    int getNPatches() override { return shading->getNPatches(); }
+    void getBBox(double *xMin, double *yMin, double *xMax, double *yMax) override;
+    int getPatchGrid(int i, SplashColorMode mode, std::vector<SplashPatchMeshVertex> *grid) override;
+    void getParameterizedColor(double t, SplashColorMode mode, SplashColorPtr c) override;
+
+private:
+    GfxPatchMeshShading *shading;
+    GfxState *state;
+    GfxColorSpaceMode gfxMode;
+    Matrix ctm;
+    // colors of parameterized shadings, sampled over the parameter domain
+    std::vector<unsigned char> paramColors;
+    SplashColorMode paramColorsMode;
+};
+
 // see GfxState.h, GfxRadialShading
 class SplashRadialPattern : public SplashUnivariatePattern
 {
@@ -185,6 +224,15 @@ private:
 // number of Type 3 fonts to cache
 #define splashOutT3FontCacheSize 8
 
+// number of tiling pattern tiles to cache, and their maximal total size,
+// in bytes
+#define splashOutTileCacheSize 8
+#define splashOutTileCacheMaxBytes (32 << 20)
+
+// number of pixels from which an image is drawn as a placeholder in
+// placeholder mode
+#define splashOutPlaceholderImagePixels (256 * 256)
+
 //------------------------------------------------------------------------
 // SplashOutputDev
 //------------------------------------------------------------------------
@@ -206,10 +254,11 @@ public:
     // operations.
     bool useTilingPatternFill() override { return true; }
 
-    // Does this device use functionShadedFill(), axialShadedFill(), and
-    // radialShadedFill()?  If this returns false, these shaded fills
+    // Does this device use functionShadedFill(), axialShadedFill(),
+    // radialShadedFill(), gouraudTriangleShadedFill() and
+    // patchMeshShadedFill()?  If this returns false, these shaded fills
     // will be reduced to a series of other drawing operations.
-    bool useShadedFills(int type) override { return (type >= 1 && type <= 5) ? true : false; }
+    bool useShadedFills(int type) override { return (type >= 1 && type <= 7) ? true : false; }
 
     // Does this device use upside-down coordinates?
     // (Upside-down means (0,0) is the top left corner of the page.)
@@ -271,6 +320,7 @@ public:
     bool axialShadedFill(GfxState *state, GfxAxialShading *shading, double tMin, double tMax) override;
     bool radialShadedFill(GfxState *state, GfxRadialShading *shading, double tMin, double tMax) override;
     bool gouraudTriangleShadedFill(GfxState *state, GfxGouraudTriangleShading *shading) override;
+    bool patchMeshShadedFill(GfxState *state, GfxPatchMeshShading *shading) override;
 
     //----- path clipping
     void clip(GfxState *state) override;
@@ -348,11 +398,40 @@ public:
     void setFreeTypeHinting(bool enable, bool enableSlightHinting);
     void setEnableFreeType(bool enable) { enableFreeType = enable; }
 
+    // Interpolate the images scaled up, as Splash does by default (the
+    // default is true).
+    bool getImageInterpolation() { return imageInterpolation; }
+    void setImageInterpolation(bool interpolate);
+
+    // Decode the JPEG images drawn at less than half their size at a
+    // fraction of their resolution, which is faster but keeps less
+    // detail than downscaling them (the default is false).
+    bool getReducedImageDecoding() { return reducedImageDecoding; }
+    void setReducedImageDecoding(bool reduced) { reducedImageDecoding = reduced; }
+
+    // Draw the large images and the shadings as flat placeholders,
+    // without decoding or evaluating them, to get a first view of a page
+    // before rendering it again completely (the default is false).
+    bool getPlaceholderMode() { return placeholderMode; }
+    void setPlaceholderMode(bool placeholders) { placeholderMode = placeholders; }
+
+    // Whether placeholders were drawn on the last page, which is complete
+    // otherwise.
+    bool hasPlaceholders() { return placeholdersDrawn; }
+
+    // Draw the images with the data decoded by <prefetcher>, when it has
+    // decoded them, which is owned by the caller (the default is none).
+    ImagePrefetcher *getImagePrefetcher() { return imagePrefetcher; }
+    void setImagePrefetcher(ImagePrefetcher *prefetcher) { imagePrefetcher = prefetcher; }
+
 protected:
     void doUpdateFont(GfxState *state);
 
 private:
     bool univariateShadedFill(GfxState *state, SplashUnivariatePattern *pattern, double tMin, double tMax);
+    bool drawImagePlaceholder(GfxState *state, int width, int height);
+    Stream *getPrefetchedImage(Object *ref, Stream *str);
+    void fillPlaceholder(GfxState *state, SplashPath *path, GfxColorSpace *colorSpace, const GfxColor *color);
 
     void setupScreenParams(double hDPI, double vDPI);
     SplashPattern *getColor(GfxGray gray);
@@ -369,10 +448,11 @@ private:
     static bool iccImageSrc(void *data, SplashColorPtr colorLine, unsigned char *alphaLine);
 #endif
     static bool imageMaskSrc(void *data, SplashColorPtr line);
+    static bool imageMaskBitsSrc(void *data, unsigned char *bits);
     static bool imageSrc(void *data, SplashColorPtr colorLine, unsigned char *alphaLine);
+    static bool imageBitsSrc(void *data, unsigned char *bits);
     static bool alphaImageSrc(void *data, SplashColorPtr line, unsigned char *alphaLine);
     static bool maskedImageSrc(void *data, SplashColorPtr line, unsigned char *alphaLine);
-    static bool tilingBitmapSrc(void *data, SplashColorPtr line, unsigned char *alphaLine);
 
     bool keepAlphaChannel; // don't fill with paper color, keep alpha channel
 
@@ -381,6 +461,11 @@ private:
     bool bitmapTopDown;
     bool fontAntialias;
     bool vectorAntialias;
+    bool imageInterpolation;
+    bool reducedImageDecoding;
+    bool placeholderMode;
+    bool placeholdersDrawn; // on the current page
+    ImagePrefetcher *imagePrefetcher;
     bool overprintPreview;
     bool enableFreeType;
     bool enableFreeTypeHinting;
@@ -403,6 +488,10 @@ private:
     int nT3Fonts; // number of valid entries in t3FontCache
     T3GlyphStack *t3GlyphStack; // Type 3 glyph context stack
 
+    SplashOutTileCacheEntry * // tiling pattern tile cache, MRU first
+            tileCache[splashOutTileCacheSize];
+    int nTiles; // number of valid entries in tileCache
+
     SplashFont *font; // current font
     bool needFontUpdate; // set when the font needs to be updated
     SplashPath *textClipPath; // clipping path built with text object
@@ -56,6 +56,7 @@
 #endif
 #include <cstring>
 #include <cctype>
+#include <algorithm>
 #include "goo/gmem.h"
 #include "goo/gfile.h"
 #include "poppler-config.h"
@@ -185,13 +186,13 @@ Stream *Stream::addFilters(Dict *dict, int recursion)
     int i;
 
     str = this;
-    obj = dict->lookup("Filter", recursion);
+    obj = dict->lookup(Atoms::Filter, recursion);
     if (obj.isNull()) {
-        obj = dict->lookup("F", recursion);
+        obj = dict->lookup(Atoms::F, recursion);
     }
-    params = dict->lookup("DecodeParms", recursion);
+    params = dict->lookup(Atoms::DecodeParms, recursion);
     if (params.isNull()) {
-        params = dict->lookup("DP", recursion);
+        params = dict->lookup(Atoms::DP, recursion);
     }
     if (obj.isName()) {
         str = makeFilter(obj.getName(), str, &params, recursion, dict);
@@ -372,12 +373,16 @@ Stream *Stream::makeFilter(const char *name, Stream *str, Object *params, int re
         str = new FlateStream(str, pred, columns, colors, bits);
     } else if (!strcmp(name, "JBIG2Decode")) {
         Object globals;
+        std::shared_ptr<JBIG2GlobalsCache> globalsCache;
         if (params->isDict()) {
             XRef *xref = params->getDict()->getXRef();
             obj = params->dictLookupNF("JBIG2Globals").copy();
             globals = obj.fetch(xref, recursion);
+            if (xref) {
+                globalsCache = xref->getJBIG2GlobalsCache();
+            }
         }
-        str = new JBIG2Stream(str, std::move(globals), &obj);
+        str = new JBIG2Stream(str, std::move(globals), &obj, std::move(globalsCache));
     } else if (!strcmp(name, "JPXDecode")) {
 #ifdef HAVE_JPX_DECODER
         str = new JPXStream(str);
@@ -405,6 +410,13 @@ OutStream::OutStream() { }
 
 OutStream::~OutStream() { }
 
+void OutStream::write(const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; ++i) {
+        put(data[i]);
+    }
+}
+
 //------------------------------------------------------------------------
 // FileOutStream
 //------------------------------------------------------------------------
@@ -431,6 +443,11 @@ void FileOutStream::put(char c)
     fputc(c, f);
 }
 
+void FileOutStream::write(const char *data, size_t length)
+{
+    fwrite(data, 1, length, f);
+}
+
 void FileOutStream::printf(const char *format, ...)
 {
     va_list argptr;
@@ -638,18 +655,33 @@ bool ImageStream::getPixel(unsigned char *pix)
     return true;
 }
 
-unsigned char *ImageStream::getLine()
+void ImageStream::readInputLine()
 {
-    if (unlikely(inputLine == nullptr)) {
-        return nullptr;
-    }
-
     int readChars = str->doGetChars(inputLineSize, inputLine);
     if (unlikely(readChars == -1)) {
         readChars = 0;
     }
     for (; readChars < inputLineSize; readChars++)
         inputLine[readChars] = EOF;
+}
+
+unsigned char *ImageStream::getPackedLine()
+{
+    if (unlikely(inputLine == nullptr)) {
+        return nullptr;
+    }
+
+    readInputLine();
+    return inputLine;
+}
+
+unsigned char *ImageStream::getLine()
+{
+    if (unlikely(inputLine == nullptr)) {
+        return nullptr;
+    }
+
+    readInputLine();
     if (nBits == 1) {
         unsigned char *p = inputLine;
         for (int i = 0; i < nVals; i += 8) {
@@ -1069,6 +1101,24 @@ bool CachedFileStream::fillBuf()
     return true;
 }
 
+bool CachedFileStream::prefetch(const std::vector<ByteRange> &ranges)
+{
+    // an empty list would make the cache load the whole file
+    if (ranges.empty()) {
+        return true;
+    }
+
+    std::vector<ByteRange> fileRanges;
+    fileRanges.reserve(ranges.size());
+    for (const ByteRange &r : ranges) {
+        ByteRange fileRange;
+        fileRange.offset = start + r.offset;
+        fileRange.length = r.length;
+        fileRanges.push_back(fileRange);
+    }
+    return cc->cache(fileRanges) == 0;
+}
+
 void CachedFileStream::setPos(Goffset pos, int dir)
 {
     unsigned int size;
@@ -1791,8 +1841,9 @@ CCITTFaxStream::CCITTFaxStream(Stream *strA, int encodingA, bool endOfLineA, boo
     // ---> max refLine size = columns + 2
     codingLine = (int *)gmallocn_checkoverflow(columns + 1, sizeof(int));
     refLine = (int *)gmallocn_checkoverflow(columns + 2, sizeof(int));
+    rowBuf = (unsigned char *)gmalloc_checkoverflow((columns >> 3) + 1);
 
-    if (codingLine != nullptr && refLine != nullptr) {
+    if (codingLine != nullptr && refLine != nullptr && rowBuf != nullptr) {
         eof = false;
         codingLine[0] = columns;
     } else {
@@ -1802,14 +1853,14 @@ CCITTFaxStream::CCITTFaxStream(Stream *strA, int encodingA, bool endOfLineA, boo
     nextLine2D = encoding < 0;
     inputBits = 0;
     a0i = 0;
-    outputBits = 0;
-
-    buf = EOF;
+    rowSize = 0;
+    rowPos = 0;
 }
 
 CCITTFaxStream::~CCITTFaxStream()
 {
     delete str;
+    gfree(rowBuf);
     gfree(refLine);
     gfree(codingLine);
 }
@@ -1825,8 +1876,8 @@ void CCITTFaxStream::ccittReset(bool unfiltered)
     nextLine2D = encoding < 0;
     inputBits = 0;
     a0i = 0;
-    outputBits = 0;
-    buf = EOF;
+    rowSize = 0;
+    rowPos = 0;
 }
 
 void CCITTFaxStream::unfilteredReset()
@@ -1840,7 +1891,7 @@ void CCITTFaxStream::reset()
 
     ccittReset(false);
 
-    if (codingLine != nullptr && refLine != nullptr) {
+    if (codingLine != nullptr && refLine != nullptr && rowBuf != nullptr) {
         eof = false;
         codingLine[0] = columns;
     } else {
@@ -1902,77 +1953,90 @@ inline void CCITTFaxStream::addPixelsNeg(int a1, int blackPixels)
     }
 }
 
-int CCITTFaxStream::lookChar()
+// Decode the next row into codingLine.
+bool CCITTFaxStream::readRow()
 {
     int code1, code2, code3;
-    int b1i, blackPixels, i, bits;
+    int b1i, blackPixels, i;
     bool gotEOL;
 
-    if (buf != EOF) {
-        return buf;
+    // if at eof just return EOF
+    if (eof) {
+        return false;
     }
 
-    // read the next row
-    if (outputBits == 0) {
-
-        // if at eof just return EOF
-        if (eof) {
-            return EOF;
-        }
-
-        err = false;
-
-        // 2-D encoding
-        if (nextLine2D) {
-            for (i = 0; i < columns && codingLine[i] < columns; ++i) {
-                refLine[i] = codingLine[i];
-            }
-            for (; i < columns + 2; ++i) {
-                refLine[i] = columns;
-            }
-            codingLine[0] = 0;
-            a0i = 0;
-            b1i = 0;
-            blackPixels = 0;
-            // invariant:
-            // refLine[b1i-1] <= codingLine[a0i] < refLine[b1i] < refLine[b1i+1]
-            //                                                             <= columns
-            // exception at left edge:
-            //   codingLine[a0i = 0] = refLine[b1i = 0] = 0 is possible
-            // exception at right edge:
-            //   refLine[b1i] = refLine[b1i+1] = columns is possible
-            while (codingLine[a0i] < columns && !err) {
-                code1 = getTwoDimCode();
-                switch (code1) {
-                case twoDimPass:
-                    if (likely(b1i + 1 < columns + 2)) {
-                        addPixels(refLine[b1i + 1], blackPixels);
-                        if (refLine[b1i + 1] < columns) {
-                            b1i += 2;
-                        }
-                    }
-                    break;
-                case twoDimHoriz:
-                    code1 = code2 = 0;
-                    if (blackPixels) {
-                        do {
-                            code1 += code3 = getBlackCode();
-                        } while (code3 >= 64);
-                        do {
-                            code2 += code3 = getWhiteCode();
-                        } while (code3 >= 64);
-                    } else {
-                        do {
-                            code1 += code3 = getWhiteCode();
-                        } while (code3 >= 64);
-                        do {
-                            code2 += code3 = getBlackCode();
-                        } while (code3 >= 64);
+    err = false;
+
+    // 2-D encoding
+    if (nextLine2D) {
+        for (i = 0; i < columns && codingLine[i] < columns; ++i) {
+            refLine[i] = codingLine[i];
+        }
+        for (; i < columns + 2; ++i) {
+            refLine[i] = columns;
+        }
+        codingLine[0] = 0;
+        a0i = 0;
+        b1i = 0;
+        blackPixels = 0;
+        // invariant:
+        // refLine[b1i-1] <= codingLine[a0i] < refLine[b1i] < refLine[b1i+1]
+        //                                                             <= columns
+        // exception at left edge:
+        //   codingLine[a0i = 0] = refLine[b1i = 0] = 0 is possible
+        // exception at right edge:
+        //   refLine[b1i] = refLine[b1i+1] = columns is possible
+        while (codingLine[a0i] < columns && !err) {
+            code1 = getTwoDimCode();
+            switch (code1) {
+            case twoDimPass:
+                if (likely(b1i + 1 < columns + 2)) {
+                    addPixels(refLine[b1i + 1], blackPixels);
+                    if (refLine[b1i + 1] < columns) {
+                        b1i += 2;
                     }
-                    addPixels(codingLine[a0i] + code1, blackPixels);
-                    if (codingLine[a0i] < columns) {
-                        addPixels(codingLine[a0i] + code2, blackPixels ^ 1);
+                }
+                break;
+            case twoDimHoriz:
+                code1 = code2 = 0;
+                if (blackPixels) {
+                    do {
+                        code1 += code3 = getBlackCode();
+                    } while (code3 >= 64);
+                    do {
+                        code2 += code3 = getWhiteCode();
+                    } while (code3 >= 64);
+                } else {
+                    do {
+                        code1 += code3 = getWhiteCode();
+                    } while (code3 >= 64);
+                    do {
+                        code2 += code3 = getBlackCode();
+                    } while (code3 >= 64);
+                }
+                addPixels(codingLine[a0i] + code1, blackPixels);
+                if (codingLine[a0i] < columns) {
+                    addPixels(codingLine[a0i] + code2, blackPixels ^ 1);
+                }
+                while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                    b1i += 2;
+                    if (unlikely(b1i > columns + 1)) {
+                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                        err = true;
+                        break;
                     }
+                }
+                break;
+            case twoDimVertR3:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
+                    break;
+                }
+                addPixels(refLine[b1i] + 3, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    ++b1i;
                     while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
                         b1i += 2;
                         if (unlikely(b1i > columns + 1)) {
@@ -1981,384 +2045,386 @@ int CCITTFaxStream::lookChar()
                             break;
                         }
                     }
+                }
+                break;
+            case twoDimVertR2:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVertR3:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
-                    }
-                    addPixels(refLine[b1i] + 3, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        ++b1i;
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                }
+                addPixels(refLine[b1i] + 2, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    ++b1i;
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
+                }
+                break;
+            case twoDimVertR1:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVertR2:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
-                    }
-                    addPixels(refLine[b1i] + 2, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        ++b1i;
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                }
+                addPixels(refLine[b1i] + 1, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    ++b1i;
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
+                }
+                break;
+            case twoDimVert0:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVertR1:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
-                    }
-                    addPixels(refLine[b1i] + 1, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        ++b1i;
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                }
+                addPixels(refLine[b1i], blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    ++b1i;
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
+                }
+                break;
+            case twoDimVertL3:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVert0:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
-                    }
-                    addPixels(refLine[b1i], blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
+                }
+                addPixelsNeg(refLine[b1i] - 3, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    if (b1i > 0) {
+                        --b1i;
+                    } else {
                         ++b1i;
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
-                        }
-                    }
-                    break;
-                case twoDimVertL3:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
                     }
-                    addPixelsNeg(refLine[b1i] - 3, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        if (b1i > 0) {
-                            --b1i;
-                        } else {
-                            ++b1i;
-                        }
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
+                }
+                break;
+            case twoDimVertL2:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVertL2:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
+                }
+                addPixelsNeg(refLine[b1i] - 2, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    if (b1i > 0) {
+                        --b1i;
+                    } else {
+                        ++b1i;
                     }
-                    addPixelsNeg(refLine[b1i] - 2, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        if (b1i > 0) {
-                            --b1i;
-                        } else {
-                            ++b1i;
-                        }
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
+                }
+                break;
+            case twoDimVertL1:
+                if (unlikely(b1i > columns + 1)) {
+                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                    err = true;
                     break;
-                case twoDimVertL1:
-                    if (unlikely(b1i > columns + 1)) {
-                        error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                        err = true;
-                        break;
+                }
+                addPixelsNeg(refLine[b1i] - 1, blackPixels);
+                blackPixels ^= 1;
+                if (codingLine[a0i] < columns) {
+                    if (b1i > 0) {
+                        --b1i;
+                    } else {
+                        ++b1i;
                     }
-                    addPixelsNeg(refLine[b1i] - 1, blackPixels);
-                    blackPixels ^= 1;
-                    if (codingLine[a0i] < columns) {
-                        if (b1i > 0) {
-                            --b1i;
-                        } else {
-                            ++b1i;
-                        }
-                        while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
-                            b1i += 2;
-                            if (unlikely(b1i > columns + 1)) {
-                                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                                err = true;
-                                break;
-                            }
+                    while (refLine[b1i] <= codingLine[a0i] && refLine[b1i] < columns) {
+                        b1i += 2;
+                        if (unlikely(b1i > columns + 1)) {
+                            error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                            err = true;
+                            break;
                         }
                     }
-                    break;
-                case EOF:
-                    addPixels(columns, 0);
-                    eof = true;
-                    break;
-                default:
-                    error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
-                    addPixels(columns, 0);
-                    err = true;
-                    break;
                 }
+                break;
+            case EOF:
+                addPixels(columns, 0);
+                eof = true;
+                break;
+            default:
+                error(errSyntaxError, getPos(), "Bad 2D code {0:04x} in CCITTFax stream", code1);
+                addPixels(columns, 0);
+                err = true;
+                break;
             }
+        }
 
-            // 1-D encoding
-        } else {
-            codingLine[0] = 0;
-            a0i = 0;
-            blackPixels = 0;
-            while (codingLine[a0i] < columns) {
-                code1 = 0;
-                if (blackPixels) {
-                    do {
-                        code1 += code3 = getBlackCode();
-                    } while (code3 >= 64);
-                } else {
-                    do {
-                        code1 += code3 = getWhiteCode();
-                    } while (code3 >= 64);
-                }
-                addPixels(codingLine[a0i] + code1, blackPixels);
-                blackPixels ^= 1;
+        // 1-D encoding
+    } else {
+        codingLine[0] = 0;
+        a0i = 0;
+        blackPixels = 0;
+        while (codingLine[a0i] < columns) {
+            code1 = 0;
+            if (blackPixels) {
+                do {
+                    code1 += code3 = getBlackCode();
+                } while (code3 >= 64);
+            } else {
+                do {
+                    code1 += code3 = getWhiteCode();
+                } while (code3 >= 64);
             }
+            addPixels(codingLine[a0i] + code1, blackPixels);
+            blackPixels ^= 1;
         }
+    }
 
-        // check for end-of-line marker, skipping over any extra zero bits
-        // (if EncodedByteAlign is true and EndOfLine is false, there can
-        // be "false" EOL markers -- i.e., if the last n unused bits in
-        // row i are set to zero, and the first 11-n bits in row i+1
-        // happen to be zero -- so we don't look for EOL markers in this
-        // case)
-        gotEOL = false;
-        if (!endOfBlock && row == rows - 1) {
-            eof = true;
-        } else if (endOfLine || !byteAlign) {
-            code1 = lookBits(12);
-            if (endOfLine) {
-                while (code1 != EOF && code1 != 0x001) {
-                    eatBits(1);
-                    code1 = lookBits(12);
-                }
-            } else {
-                while (code1 == 0) {
-                    eatBits(1);
-                    code1 = lookBits(12);
-                }
+    // an error may have left the row unfinished, fill it with white
+    if (codingLine[a0i] < columns) {
+        addPixels(columns, 0);
+    }
+
+    // check for end-of-line marker, skipping over any extra zero bits
+    // (if EncodedByteAlign is true and EndOfLine is false, there can
+    // be "false" EOL markers -- i.e., if the last n unused bits in
+    // row i are set to zero, and the first 11-n bits in row i+1
+    // happen to be zero -- so we don't look for EOL markers in this
+    // case)
+    gotEOL = false;
+    if (!endOfBlock && row == rows - 1) {
+        eof = true;
+    } else if (endOfLine || !byteAlign) {
+        code1 = lookBits(12);
+        if (endOfLine) {
+            while (code1 != EOF && code1 != 0x001) {
+                eatBits(1);
+                code1 = lookBits(12);
             }
-            if (code1 == 0x001) {
-                eatBits(12);
-                gotEOL = true;
+        } else {
+            while (code1 == 0) {
+                eatBits(1);
+                code1 = lookBits(12);
             }
         }
-
-        // byte-align the row
-        // (Adobe apparently doesn't do byte alignment after EOL markers
-        // -- I've seen CCITT image data streams in two different formats,
-        // both with the byteAlign flag set:
-        //   1. xx:x0:01:yy:yy
-        //   2. xx:00:1y:yy:yy
-        // where xx is the previous line, yy is the next line, and colons
-        // separate bytes.)
-        if (byteAlign && !gotEOL) {
-            inputBits &= ~7;
+        if (code1 == 0x001) {
+            eatBits(12);
+            gotEOL = true;
         }
+    }
 
-        // check for end of stream
-        if (lookBits(1) == EOF) {
-            eof = true;
-        }
+    // byte-align the row
+    // (Adobe apparently doesn't do byte alignment after EOL markers
+    // -- I've seen CCITT image data streams in two different formats,
+    // both with the byteAlign flag set:
+    //   1. xx:x0:01:yy:yy
+    //   2. xx:00:1y:yy:yy
+    // where xx is the previous line, yy is the next line, and colons
+    // separate bytes.)
+    if (byteAlign && !gotEOL) {
+        inputBits &= ~7;
+    }
 
-        // get 2D encoding tag
-        if (!eof && encoding > 0) {
-            nextLine2D = !lookBits(1);
-            eatBits(1);
-        }
+    // check for end of stream
+    if (lookBits(1) == EOF) {
+        eof = true;
+    }
 
-        // check for end-of-block marker
-        if (endOfBlock && !endOfLine && byteAlign) {
-            // in this case, we didn't check for an EOL code above, so we
-            // need to check here
-            code1 = lookBits(24);
-            if (code1 == 0x001001) {
-                eatBits(12);
-                gotEOL = true;
-            }
+    // get 2D encoding tag
+    if (!eof && encoding > 0) {
+        nextLine2D = !lookBits(1);
+        eatBits(1);
+    }
+
+    // check for end-of-block marker
+    if (endOfBlock && !endOfLine && byteAlign) {
+        // in this case, we didn't check for an EOL code above, so we
+        // need to check here
+        code1 = lookBits(24);
+        if (code1 == 0x001001) {
+            eatBits(12);
+            gotEOL = true;
         }
-        if (endOfBlock && gotEOL) {
-            code1 = lookBits(12);
-            if (code1 == 0x001) {
-                eatBits(12);
-                if (encoding > 0) {
-                    lookBits(1);
-                    eatBits(1);
-                }
-                if (encoding >= 0) {
-                    for (i = 0; i < 4; ++i) {
-                        code1 = lookBits(12);
-                        if (code1 != 0x001) {
-                            error(errSyntaxError, getPos(), "Bad RTC code in CCITTFax stream");
-                        }
-                        eatBits(12);
-                        if (encoding > 0) {
-                            lookBits(1);
-                            eatBits(1);
-                        }
+    }
+    if (endOfBlock && gotEOL) {
+        code1 = lookBits(12);
+        if (code1 == 0x001) {
+            eatBits(12);
+            if (encoding > 0) {
+                lookBits(1);
+                eatBits(1);
+            }
+            if (encoding >= 0) {
+                for (i = 0; i < 4; ++i) {
+                    code1 = lookBits(12);
+                    if (code1 != 0x001) {
+                        error(errSyntaxError, getPos(), "Bad RTC code in CCITTFax stream");
+                    }
+                    eatBits(12);
+                    if (encoding > 0) {
+                        lookBits(1);
+                        eatBits(1);
                     }
                 }
-                eof = true;
             }
+            eof = true;
+        }
 
-            // look for an end-of-line marker after an error -- we only do
-            // this if we know the stream contains end-of-line markers because
-            // the "just plow on" technique tends to work better otherwise
-        } else if (err && endOfLine) {
-            while (true) {
-                code1 = lookBits(13);
-                if (code1 == EOF) {
-                    eof = true;
-                    return EOF;
-                }
-                if ((code1 >> 1) == 0x001) {
-                    break;
-                }
-                eatBits(1);
+        // look for an end-of-line marker after an error -- we only do
+        // this if we know the stream contains end-of-line markers because
+        // the "just plow on" technique tends to work better otherwise
+    } else if (err && endOfLine) {
+        while (true) {
+            code1 = lookBits(13);
+            if (code1 == EOF) {
+                eof = true;
+                return false;
             }
-            eatBits(12);
-            if (encoding > 0) {
-                eatBits(1);
-                nextLine2D = !(code1 & 1);
+            if ((code1 >> 1) == 0x001) {
+                break;
             }
+            eatBits(1);
         }
-
-        // set up for output
-        if (codingLine[0] > 0) {
-            outputBits = codingLine[a0i = 0];
-        } else {
-            outputBits = codingLine[a0i = 1];
+        eatBits(12);
+        if (encoding > 0) {
+            eatBits(1);
+            nextLine2D = !(code1 & 1);
         }
+    }
 
-        ++row;
+    ++row;
+    return true;
+}
+
+// Set the bits of <row> for the pixels <x0> to <x1> - 1.
+static void setRowBits(unsigned char *row, int x0, int x1)
+{
+    unsigned char *p = row + (x0 >> 3);
+    unsigned char *q = row + (x1 >> 3);
+
+    if (p == q) {
+        *p |= (0xff >> (x0 & 7)) & ~(0xff >> (x1 & 7));
+        return;
+    }
+    *p++ |= 0xff >> (x0 & 7);
+    memset(p, 0xff, q - p);
+    if (x1 & 7) {
+        *q |= ~(0xff >> (x1 & 7));
     }
+}
 
-    // get a byte
-    if (outputBits >= 8) {
-        buf = (a0i & 1) ? 0x00 : 0xff;
-        outputBits -= 8;
-        if (outputBits == 0 && codingLine[a0i] < columns) {
-            ++a0i;
-            outputBits = codingLine[a0i] - codingLine[a0i - 1];
+// Decode the next row and pack it into rowBuf.
+bool CCITTFaxStream::fillRow()
+{
+    int x0, x1, i;
+
+    rowSize = rowPos = 0;
+    if (!readRow()) {
+        return false;
+    }
+
+    // the white runs end at the even changing elements
+    const int n = (columns >> 3) + ((columns & 7) ? 1 : 0);
+    memset(rowBuf, 0, n);
+    for (i = 0, x0 = 0; x0 < columns && i <= a0i; i += 2) {
+        x1 = codingLine[i];
+        if (x1 > x0) {
+            setRowBits(rowBuf, x0, x1);
         }
-    } else {
-        bits = 8;
-        buf = 0;
-        do {
-            if (outputBits > bits) {
-                buf <<= bits;
-                if (!(a0i & 1)) {
-                    buf |= 0xff >> (8 - bits);
-                }
-                outputBits -= bits;
-                bits = 0;
-            } else {
-                buf <<= outputBits;
-                if (!(a0i & 1)) {
-                    buf |= 0xff >> (8 - outputBits);
-                }
-                bits -= outputBits;
-                outputBits = 0;
-                if (codingLine[a0i] < columns) {
-                    ++a0i;
-                    if (unlikely(a0i > columns)) {
-                        error(errSyntaxError, getPos(), "Bad bits {0:04x} in CCITTFax stream", bits);
-                        err = true;
-                        break;
-                    }
-                    outputBits = codingLine[a0i] - codingLine[a0i - 1];
-                } else if (bits > 0) {
-                    buf <<= bits;
-                    bits = 0;
-                }
-            }
-        } while (bits);
+        if (x1 >= columns) {
+            break;
+        }
+        x0 = codingLine[i + 1];
     }
     if (black) {
-        buf ^= 0xff;
+        for (i = 0; i < n; ++i) {
+            rowBuf[i] ^= 0xff;
+        }
     }
-    return buf;
+    rowSize = n;
+    return true;
+}
+
+int CCITTFaxStream::getChars(int nChars, unsigned char *buffer)
+{
+    int n, i;
+
+    for (i = 0; i < nChars; i += n) {
+        if (rowPos == rowSize && !fillRow()) {
+            break;
+        }
+        n = std::min(nChars - i, rowSize - rowPos);
+        memcpy(buffer + i, rowBuf + rowPos, n);
+        rowPos += n;
+    }
+    return i;
 }
 
+bool CCITTFaxStream::readRowRuns(std::vector<int> *runs)
+{
+    int x0, x1, i;
+
+    rowSize = rowPos = 0;
+    if (!readRow()) {
+        return false;
+    }
+
+    runs->clear();
+    for (i = 0, x0 = 0; x0 < columns && i <= a0i; ++i) {
+        x1 = std::min(codingLine[i], columns);
+        runs->push_back(std::max(x1 - x0, 0));
+        x0 = std::max(x0, x1);
+    }
+    return true;
+}
+
+// The code tables are split by the number of leading zero bits, which
+// lets every code be found with a single lookup of the longest code
+// length.  Near the end of the stream lookBits() pads the missing bits
+// with zeros, which still finds any complete code.
+
 short CCITTFaxStream::getTwoDimCode()
 {
     int code;
     const CCITTCode *p;
-    int n;
 
-    code = 0; // make gcc happy
-    if (endOfBlock) {
-        if ((code = lookBits(7)) != EOF) {
-            p = &twoDimTab1[code];
-            if (p->bits > 0) {
-                eatBits(p->bits);
-                return p->n;
-            }
-        }
-    } else {
-        for (n = 1; n <= 7; ++n) {
-            if ((code = lookBits(n)) == EOF) {
-                break;
-            }
-            if (n < 7) {
-                code <<= 7 - n;
-            }
-            p = &twoDimTab1[code];
-            if (p->bits == n) {
-                eatBits(n);
-                return p->n;
-            }
+    if ((code = lookBits(7)) != EOF) {
+        p = &twoDimTab1[code];
+        if (p->bits > 0) {
+            eatBits(p->bits);
+            return p->n;
         }
     }
     error(errSyntaxError, getPos(), "Bad two dim code ({0:04x}) in CCITTFax stream", code);
@@ -2367,54 +2433,21 @@ short CCITTFaxStream::getTwoDimCode()
 
 short CCITTFaxStream::getWhiteCode()
 {
-    short code;
+    int code;
     const CCITTCode *p;
-    int n;
 
-    code = 0; // make gcc happy
-    if (endOfBlock) {
-        code = lookBits(12);
-        if (code == EOF) {
-            return 1;
-        }
-        if ((code >> 5) == 0) {
-            p = &whiteTab1[code];
-        } else {
-            p = &whiteTab2[code >> 3];
-        }
-        if (p->bits > 0) {
-            eatBits(p->bits);
-            return p->n;
-        }
+    code = lookBits(12);
+    if (code == EOF) {
+        return 1;
+    }
+    if ((code >> 5) == 0) {
+        p = &whiteTab1[code];
     } else {
-        for (n = 1; n <= 9; ++n) {
-            code = lookBits(n);
-            if (code == EOF) {
-                return 1;
-            }
-            if (n < 9) {
-                code <<= 9 - n;
-            }
-            p = &whiteTab2[code];
-            if (p->bits == n) {
-                eatBits(n);
-                return p->n;
-            }
-        }
-        for (n = 11; n <= 12; ++n) {
-            code = lookBits(n);
-            if (code == EOF) {
-                return 1;
-            }
-            if (n < 12) {
-                code <<= 12 - n;
-            }
-            p = &whiteTab1[code];
-            if (p->bits == n) {
-                eatBits(n);
-                return p->n;
-            }
-        }
+        p = &whiteTab2[code >> 3];
+    }
+    if (p->bits > 0) {
+        eatBits(p->bits);
+        return p->n;
     }
     error(errSyntaxError, getPos(), "Bad white code ({0:04x}) in CCITTFax stream", code);
     // eat a bit and return a positive number so that the caller doesn't
@@ -2425,72 +2458,23 @@ short CCITTFaxStream::getWhiteCode()
 
 short CCITTFaxStream::getBlackCode()
 {
-    short code;
+    int code;
     const CCITTCode *p;
-    int n;
 
-    code = 0; // make gcc happy
-    if (endOfBlock) {
-        code = lookBits(13);
-        if (code == EOF) {
-            return 1;
-        }
-        if ((code >> 7) == 0) {
-            p = &blackTab1[code];
-        } else if ((code >> 9) == 0 && (code >> 7) != 0) {
-            p = &blackTab2[(code >> 1) - 64];
-        } else {
-            p = &blackTab3[code >> 7];
-        }
-        if (p->bits > 0) {
-            eatBits(p->bits);
-            return p->n;
-        }
+    code = lookBits(13);
+    if (code == EOF) {
+        return 1;
+    }
+    if ((code >> 7) == 0) {
+        p = &blackTab1[code];
+    } else if ((code >> 9) == 0) {
+        p = &blackTab2[(code >> 1) - 64];
     } else {
-        for (n = 2; n <= 6; ++n) {
-            code = lookBits(n);
-            if (code == EOF) {
-                return 1;
-            }
-            if (n < 6) {
-                code <<= 6 - n;
-            }
-            p = &blackTab3[code];
-            if (p->bits == n) {
-                eatBits(n);
-                return p->n;
-            }
-        }
-        for (n = 7; n <= 12; ++n) {
-            code = lookBits(n);
-            if (code == EOF) {
-                return 1;
-            }
-            if (n < 12) {
-                code <<= 12 - n;
-            }
-            if (code >= 64) {
-                p = &blackTab2[code - 64];
-                if (p->bits == n) {
-                    eatBits(n);
-                    return p->n;
-                }
-            }
-        }
-        for (n = 10; n <= 13; ++n) {
-            code = lookBits(n);
-            if (code == EOF) {
-                return 1;
-            }
-            if (n < 13) {
-                code <<= 13 - n;
-            }
-            p = &blackTab1[code];
-            if (p->bits == n) {
-                eatBits(n);
-                return p->n;
-            }
-        }
+        p = &blackTab3[code >> 7];
+    }
+    if (p->bits > 0) {
+        eatBits(p->bits);
+        return p->n;
     }
     error(errSyntaxError, getPos(), "Bad black code ({0:04x}) in CCITTFax stream", code);
     // eat a bit and return a positive number so that the caller doesn't
@@ -2499,7 +2483,10 @@ short CCITTFaxStream::getBlackCode()
     return 1;
 }
 
-short CCITTFaxStream::lookBits(int n)
+// Bytes are only read from the underlying stream when they are needed:
+// inline images are followed by the rest of the content stream, so the
+// decoder mustn't read ahead of its data.
+int CCITTFaxStream::lookBits(int n)
 {
     int c;
 
@@ -2512,12 +2499,12 @@ short CCITTFaxStream::lookBits(int n)
             // than are available, but there may still be a valid code in
             // however many bits are available -- we need to return correct
             // data in this case
-            return (inputBuf << (n - inputBits)) & (0xffffffff >> (32 - n));
+            return (int)((inputBuf << (n - inputBits)) & ((1U << n) - 1));
         }
-        inputBuf = (inputBuf << 8) + c;
+        inputBuf = (inputBuf << 8) | c;
         inputBits += 8;
     }
-    return (inputBuf >> (inputBits - n)) & (0xffffffff >> (32 - n));
+    return (int)((inputBuf >> (inputBits - n)) & ((1U << n) - 1));
 }
 
 GooString *CCITTFaxStream::getPSFilter(int psLevel, const char *indent)
@@ -4214,6 +4201,26 @@ int FlateStream::lookChar()
     return c;
 }
 
+const unsigned char *FlateStream::getBufferedChars(int *n)
+{
+    if (pred) {
+        *n = 0;
+        return nullptr;
+    }
+    // decode ahead, leaving room for the longest match in the window
+    while (remain < flateBufferedChars && !(endOfBlock && eof)) {
+        readSome();
+    }
+    *n = std::min(remain, flateWindow - index);
+    return buf + index;
+}
+
+void FlateStream::skipBufferedChars(int n)
+{
+    index = (index + n) & flateMask;
+    remain -= n;
+}
+
 void FlateStream::getRawChars(int nChars, int *buffer)
 {
     for (int i = 0; i < nChars; ++i)
@@ -4256,15 +4263,15 @@ void FlateStream::readSome()
             return;
     }
 
+    // the output goes after the chars not read yet, if any
     if (compressedBlock) {
         if ((code1 = getHuffmanCodeWord(&litCodeTab)) == EOF)
             goto err;
         if (code1 < 256) {
-            buf[index] = code1;
-            remain = 1;
+            buf[(index + remain) & flateMask] = code1;
+            ++remain;
         } else if (code1 == 256) {
             endOfBlock = true;
-            remain = 0;
         } else {
             code1 -= 257;
             code2 = lengthDecode[code1].bits;
@@ -4277,26 +4284,26 @@ void FlateStream::readSome()
             if (code2 > 0 && (code2 = getCodeWord(code2)) == EOF)
                 goto err;
             dist = distDecode[code1].first + code2;
-            i = index;
-            j = (index - dist) & flateMask;
+            i = (index + remain) & flateMask;
+            j = (i - dist) & flateMask;
             for (k = 0; k < len; ++k) {
                 buf[i] = buf[j];
                 i = (i + 1) & flateMask;
                 j = (j + 1) & flateMask;
             }
-            remain = len;
+            remain += len;
         }
 
     } else {
-        len = (blockLen < flateWindow) ? blockLen : flateWindow;
-        for (i = 0, j = index; i < len; ++i, j = (j + 1) & flateMask) {
+        len = std::min(blockLen, flateWindow - remain);
+        for (i = 0, j = (index + remain) & flateMask; i < len; ++i, j = (j + 1) & flateMask) {
             if ((c = str->getChar()) == EOF) {
                 endOfBlock = eof = true;
                 break;
             }
             buf[j] = c & 0xff;
         }
-        remain = i;
+        remain += i;
         blockLen -= len;
         if (blockLen == 0)
             endOfBlock = true;
@@ -4307,7 +4314,6 @@ void FlateStream::readSome()
 err:
     error(errSyntaxError, getPos(), "Unexpected end of file in flate stream");
     endOfBlock = eof = true;
-    remain = 0;
 }
 
 bool FlateStream::startBlock()
@@ -39,7 +39,9 @@
 #ifndef STREAM_H
 #define STREAM_H
 
+#include <algorithm>
 #include <atomic>
+#include <climits>
 #include <cstdio>
 
 #include "poppler-config.h"
@@ -205,6 +207,24 @@ public:
     // reached.
     virtual unsigned int discardChars(unsigned int n);
 
+    // Return the next chars of the stream, if it holds some of them in a
+    // contiguous buffer, and set *n to their number (0 if it doesn't).
+    // They remain valid until the stream is used again, and are only
+    // consumed by skipBufferedChars().  This lets the Lexer scan tokens
+    // without a virtual call per char.
+    virtual const unsigned char *getBufferedChars(int *n)
+    {
+        *n = 0;
+        return nullptr;
+    }
+    virtual void skipBufferedChars(int n) { discardChars(n); }
+
+    // Decode the image of the stream at 1/<reduction> of its width and
+    // height, rounded up, from the next reset() on, if it can be done for
+    // less than decoding the whole image.  <reduction> is 1, 2, 4 or 8.
+    // Returns false if the stream can't, and then decodes it at full size.
+    virtual bool setDecodeReduction(int reduction) { return reduction == 1; }
+
     // Get current position in file.
     virtual Goffset getPos() = 0;
 
@@ -287,6 +307,9 @@ public:
     // Put a char in the stream
     virtual void put(char c) = 0;
 
+    // Put <length> chars in the stream
+    virtual void write(const char *data, size_t length);
+
     virtual void printf(const char *format, ...) GCC_PRINTF_FORMAT(2, 3) = 0;
 };
 
@@ -306,6 +329,8 @@ public:
 
     void put(char c) override;
 
+    void write(const char *data, size_t length) override;
+
     void printf(const char *format, ...) override GCC_PRINTF_FORMAT(2, 3);
 
 private:
@@ -369,6 +394,12 @@ public:
     int getChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr++ & 0xff); }
     int lookChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr & 0xff); }
     Goffset getPos() override { return bufPos + (bufPtr - buf); }
+    const unsigned char *getBufferedChars(int *n) override
+    {
+        *n = (bufPtr < bufEnd || fillBuf()) ? (int)(bufEnd - bufPtr) : 0;
+        return reinterpret_cast<const unsigned char *>(bufPtr);
+    }
+    void skipBufferedChars(int n) override { bufPtr += n; }
     void setPos(Goffset pos, int dir = 0) override;
     Goffset getStart() override { return start; }
     void moveStart(Goffset delta) override;
@@ -457,10 +488,17 @@ public:
     // end of file.
     unsigned char *getLine();
 
+    // Returns a pointer to the next line of the image, with the
+    // components still packed as in the stream (eight pixels per byte
+    // for a 1-bit image).  Returns NULL at end of file.
+    unsigned char *getPackedLine();
+
     // Skip an entire line from the image.
     void skipLine();
 
 private:
+    void readInputLine();
+
     Stream *str; // base stream
     int width; // pixels per line
     int nComps; // components per pixel
@@ -529,6 +567,12 @@ public:
     int getChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr++ & 0xff); }
     int lookChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr & 0xff); }
     Goffset getPos() override { return bufPos + (bufPtr - buf); }
+    const unsigned char *getBufferedChars(int *n) override
+    {
+        *n = (bufPtr < bufEnd || fillBuf()) ? (int)(bufEnd - bufPtr) : 0;
+        return reinterpret_cast<const unsigned char *>(bufPtr);
+    }
+    void skipBufferedChars(int n) override { bufPtr += n; }
     void setPos(Goffset pos, int dir = 0) override;
     Goffset getStart() override { return start; }
     void moveStart(Goffset delta) override;
@@ -599,6 +643,12 @@ public:
     int getChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr++ & 0xff); }
     int lookChar() override { return (bufPtr >= bufEnd && !fillBuf()) ? EOF : (*bufPtr & 0xff); }
     Goffset getPos() override { return bufPos + (bufPtr - buf); }
+    const unsigned char *getBufferedChars(int *n) override
+    {
+        *n = (bufPtr < bufEnd || fillBuf()) ? (int)(bufEnd - bufPtr) : 0;
+        return reinterpret_cast<const unsigned char *>(bufPtr);
+    }
+    void skipBufferedChars(int n) override { bufPtr += n; }
     void setPos(Goffset pos, int dir = 0) override;
     Goffset getStart() override { return start; }
     void moveStart(Goffset delta) override;
@@ -606,6 +656,10 @@ public:
     int getUnfilteredChar() override { return getChar(); }
     void unfilteredReset() override { reset(); }
 
+    // Load the given byte ranges, relative to the start of the stream,
+    // into the cache ahead of their use.  Returns false if loading failed.
+    bool prefetch(const std::vector<ByteRange> &ranges);
+
 private:
     bool fillBuf();
 
@@ -662,6 +716,12 @@ public:
     int lookChar() override { return (bufPtr < bufEnd) ? (*bufPtr & 0xff) : EOF; }
 
     Goffset getPos() override { return (int)(bufPtr - buf); }
+    const unsigned char *getBufferedChars(int *n) override
+    {
+        *n = static_cast<int>(std::min<Goffset>(bufEnd - bufPtr, INT_MAX));
+        return reinterpret_cast<const unsigned char *>(bufPtr);
+    }
+    void skipBufferedChars(int n) override { bufPtr += n; }
 
     void setPos(Goffset pos, int dir = 0) override
     {
@@ -943,16 +1003,33 @@ public:
     void reset() override;
     int getChar() override
     {
-        int c = lookChar();
-        buf = EOF;
-        return c;
+        if (rowPos < rowSize || fillRow()) {
+            return rowBuf[rowPos++];
+        }
+        return EOF;
+    }
+    int lookChar() override
+    {
+        if (rowPos < rowSize || fillRow()) {
+            return rowBuf[rowPos];
+        }
+        return EOF;
     }
-    int lookChar() override;
     GooString *getPSFilter(int psLevel, const char *indent) override;
     bool isBinary(bool last = true) override;
 
     void unfilteredReset() override;
 
+    // Decode the next row and return its run lengths in <runs>.  The
+    // runs alternate between white and black, starting with white
+    // (which may be an empty run), and add up to the number of columns.
+    // White pixels are 1 bits in the output unless BlackIs1 is set.
+    // This is faster than getting the row with getChar() as the pixels
+    // are never packed into bytes; any part of the current row not yet
+    // read with getChar() is skipped.  Returns false at the end of the
+    // stream.
+    bool readRowRuns(std::vector<int> *runs);
+
     int getEncoding() { return encoding; }
     bool getEndOfLine() { return endOfLine; }
     bool getEncodedByteAlign() { return byteAlign; }
@@ -980,15 +1057,20 @@ private:
     int *refLine; // reference line changing elements
     int a0i; // index into codingLine
     bool err; // error on current line
-    int outputBits; // remaining ouput bits
-    int buf; // character buffer
+    unsigned char *rowBuf; // current row, packed
+    int rowSize; // size of rowBuf, zero if there's no current row
+    int rowPos; // position of the next byte in rowBuf
 
+    bool readRow();
+    bool fillRow();
+    int getChars(int nChars, unsigned char *buffer) override;
+    bool hasGetChars() override { return true; }
     void addPixels(int a1, int blackPixels);
     void addPixelsNeg(int a1, int blackPixels);
     short getTwoDimCode();
     short getWhiteCode();
     short getBlackCode();
-    short lookBits(int n);
+    int lookBits(int n);
     void eatBits(int n)
     {
         if ((inputBits -= n) < 0)
@@ -1109,6 +1191,7 @@ private:
 
 #    define flateWindow 32768 // buffer size
 #    define flateMask (flateWindow - 1)
+#    define flateBufferedChars 4096 // chars decoded ahead for getBufferedChars()
 #    define flateMaxHuffman 15 // max Huffman code length
 #    define flateMaxCodeLenCodes 19 // max # code length codes
 #    define flateMaxLitCodes 288 // max # literal codes
@@ -1148,6 +1231,8 @@ public:
     GooString *getPSFilter(int psLevel, const char *indent) override;
     bool isBinary(bool last = true) override;
     void unfilteredReset() override;
+    const unsigned char *getBufferedChars(int *n) override;
+    void skipBufferedChars(int n) override;
 
 private:
     void flateReset(bool unfiltered);
@@ -0,0 +1,453 @@
+//========================================================================
+//
+// TextIndex.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STAT_H)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define TEXTINDEX_USE_MMAP 1
+#endif
+
+#include "goo/gmem.h"
+#include "goo/GooString.h"
+#include "Error.h"
+#include "PDFDoc.h"
+#include "TextOutputDev.h"
+#include "UnicodeMapFuncs.h"
+#include "UnicodeTypeTable.h"
+#include "TextIndex.h"
+
+//------------------------------------------------------------------------
+// index file layout
+//------------------------------------------------------------------------
+
+// The file is made of a header, followed by the term table (sorted by
+// term), the term strings (UTF-8, not NUL terminated, padded to a
+// multiple of 8 bytes) and the postings of all the terms (each term's
+// postings are contiguous and sorted by page, then by word).
+
+static const char textIndexMagic[8] = { 'P', 'D', 'F', 'T', 'X', 'I', 'D', 'X' };
+static const uint32_t textIndexByteOrder = 0x01020304;
+static const uint32_t textIndexVersion = 2;
+
+struct TextIndexHeader
+{
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    uint64_t pdfSize; // size of the indexed PDF file
+    uint64_t pdfChecksum; // checksum of the indexed PDF file
+    int64_t pdfMTime; // modification time of the indexed PDF file, in nanoseconds
+    uint32_t nPages;
+    uint32_t nTerms;
+    uint64_t termsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsLen;
+    uint64_t postingsOffset;
+    uint64_t nPostings;
+};
+
+struct TextIndexTerm
+{
+    uint32_t strOffset; // offset of the term into the strings
+    uint32_t strLen;
+    uint32_t firstPosting; // index of the first posting of the term
+    uint32_t nPostings;
+};
+
+struct TextIndexPosting
+{
+    uint32_t page;
+    uint32_t word;
+    float xMin, yMin, xMax, yMax;
+};
+
+//------------------------------------------------------------------------
+// TextIndex
+//------------------------------------------------------------------------
+
+TextIndex::TextIndex(const char *indexFileName)
+{
+    data = nullptr;
+    dataLen = 0;
+    mapped = false;
+
+    unsigned char *buf = nullptr;
+    size_t len = 0;
+#ifdef TEXTINDEX_USE_MMAP
+    const int fd = openFileDescriptor(indexFileName, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            buf = (unsigned char *)p;
+            len = st.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+#endif
+    if (!mapped) {
+        FILE *f = openFile(indexFileName, "rb");
+        if (!f) {
+            return;
+        }
+        Gfseek(f, 0, SEEK_END);
+        const Goffset size = Gftell(f);
+        Gfseek(f, 0, SEEK_SET);
+        if (size > 0) {
+            buf = (unsigned char *)gmalloc(size);
+            len = size;
+            if (fread(buf, 1, len, f) != len) {
+                gfree(buf);
+                buf = nullptr;
+            }
+        }
+        fclose(f);
+        if (!buf) {
+            return;
+        }
+    }
+
+    // check the header and the bounds of all the tables
+    TextIndexHeader header;
+    bool ok = len >= sizeof(header);
+    if (ok) {
+        memcpy(&header, buf, sizeof(header));
+        ok = !memcmp(header.magic, textIndexMagic, sizeof(textIndexMagic)) && header.byteOrder == textIndexByteOrder && header.version == textIndexVersion && header.termsOffset % 4 == 0 && header.postingsOffset % 4 == 0
+                && header.termsOffset <= len && header.nTerms <= (len - header.termsOffset) / sizeof(TextIndexTerm) && header.stringsOffset <= len && header.stringsLen <= len - header.stringsOffset && header.postingsOffset <= len
+                && header.nPostings <= (len - header.postingsOffset) / sizeof(TextIndexPosting);
+    }
+    if (ok) {
+        const TextIndexTerm *terms = (const TextIndexTerm *)(buf + header.termsOffset);
+        for (uint32_t i = 0; ok && i < header.nTerms; ++i) {
+            ok = terms[i].strOffset <= header.stringsLen && terms[i].strLen <= header.stringsLen - terms[i].strOffset && terms[i].firstPosting <= header.nPostings && terms[i].nPostings <= header.nPostings - terms[i].firstPosting;
+        }
+    }
+    if (!ok) {
+        error(errSyntaxError, -1, "Invalid text index file '{0:s}'", indexFileName);
+#ifdef TEXTINDEX_USE_MMAP
+        if (mapped) {
+            munmap(buf, len);
+        } else
+#endif
+        {
+            gfree(buf);
+        }
+        mapped = false;
+        return;
+    }
+
+    data = buf;
+    dataLen = len;
+}
+
+TextIndex::~TextIndex()
+{
+    if (!data) {
+        return;
+    }
+#ifdef TEXTINDEX_USE_MMAP
+    if (mapped) {
+        munmap((void *)data, dataLen);
+        return;
+    }
+#endif
+    gfree((void *)data);
+}
+
+bool TextIndex::isValidFor(const char *pdfFileName, bool checkContents) const
+{
+    Goffset size;
+    long long mtime;
+    unsigned long long checksum;
+
+    if (!data) {
+        return false;
+    }
+    const TextIndexHeader *header = (const TextIndexHeader *)data;
+    if (!getFileSizeAndModificationTime(pdfFileName, &size, &mtime) || (uint64_t)size != header->pdfSize) {
+        return false;
+    }
+    if (!checkContents && mtime == header->pdfMTime) {
+        return true;
+    }
+
+    // the file was touched, or copied: it's still the same if its
+    // contents are
+    if (!computeChecksum(pdfFileName, &size, &checksum)) {
+        return false;
+    }
+    return (uint64_t)size == header->pdfSize && checksum == header->pdfChecksum;
+}
+
+int TextIndex::getNumPages() const
+{
+    return data ? ((const TextIndexHeader *)data)->nPages : 0;
+}
+
+int TextIndex::getNumTerms() const
+{
+    return data ? ((const TextIndexHeader *)data)->nTerms : 0;
+}
+
+std::vector<TextIndexHit> TextIndex::find(const Unicode *s, int len) const
+{
+    std::vector<TextIndexHit> hits;
+
+    if (!data) {
+        return hits;
+    }
+
+    const std::string key = normalizeTerm(s, len);
+    if (key.empty()) {
+        return hits;
+    }
+
+    const TextIndexHeader *header = (const TextIndexHeader *)data;
+    const TextIndexTerm *termsBegin = (const TextIndexTerm *)(data + header->termsOffset);
+    const TextIndexTerm *termsEnd = termsBegin + header->nTerms;
+    const char *strings = (const char *)data + header->stringsOffset;
+    const TextIndexPosting *postings = (const TextIndexPosting *)(data + header->postingsOffset);
+
+    const TextIndexTerm *term = std::lower_bound(termsBegin, termsEnd, key, [strings](const TextIndexTerm &t, const std::string &k) { return k.compare(0, std::string::npos, strings + t.strOffset, t.strLen) > 0; });
+    if (term == termsEnd || key.compare(0, std::string::npos, strings + term->strOffset, term->strLen) != 0) {
+        return hits;
+    }
+
+    hits.reserve(term->nPostings);
+    for (uint32_t i = term->firstPosting; i < term->firstPosting + term->nPostings; ++i) {
+        const TextIndexPosting &p = postings[i];
+        hits.push_back({ (int)p.page, (int)p.word, p.xMin, p.yMin, p.xMax, p.yMax });
+    }
+
+    return hits;
+}
+
+std::string TextIndex::normalizeTerm(const Unicode *s, int len)
+{
+    std::string term;
+    char buf[8];
+    int normLen;
+
+    Unicode *norm = unicodeNormalizeNFKC(s, len, &normLen, nullptr);
+    for (int i = 0; i < normLen; ++i) {
+        const int n = mapUTF8(unicodeToUpper(norm[i]), buf, sizeof(buf));
+        term.append(buf, n);
+    }
+    gfree(norm);
+
+    return term;
+}
+
+bool TextIndex::computeChecksum(const char *fileName, Goffset *size, unsigned long long *checksum)
+{
+    std::vector<unsigned char> buf(65536);
+    size_t n;
+
+    FILE *f = openFile(fileName, "rb");
+    if (!f) {
+        return false;
+    }
+
+    // 64-bit FNV-1a
+    unsigned long long h = 0xcbf29ce484222325ULL;
+    Goffset total = 0;
+    while ((n = fread(buf.data(), 1, buf.size(), f)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            h = (h ^ buf[i]) * 0x100000001b3ULL;
+        }
+        total += n;
+    }
+    const bool ok = !ferror(f);
+    fclose(f);
+
+    *size = total;
+    *checksum = h;
+    return ok;
+}
+
+namespace {
+
+struct PageTerm
+{
+    std::string term;
+    TextIndexPosting posting;
+};
+
+}
+
+// Whether <c> can be part of a term.  The Unicode type table classes a
+// few ASCII symbols (like '-', '.' and '/') with the digits.
+static bool isTermChar(Unicode c)
+{
+    if (c < 0x80) {
+        return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    }
+    return unicodeTypeAlphaNum(c);
+}
+
+// Extract the terms of page <pg> of <doc>.
+static void extractPageTerms(PDFDoc *doc, int pg, std::vector<PageTerm> *terms)
+{
+    TextOutputDev textOut(nullptr, false, 0, false, false);
+    if (!textOut.isOk()) {
+        return;
+    }
+    doc->displayPage(&textOut, pg, 72, 72, 0, false, true, false);
+    std::unique_ptr<TextWordList> wordList(textOut.makeWordList());
+    if (!wordList) {
+        return;
+    }
+
+    for (int w = 0; w < wordList->getLength(); ++w) {
+        const TextWord *word = wordList->get(w);
+        const int len = word->getLength();
+        int i = 0;
+        while (i < len) {
+            if (!isTermChar(*word->getChar(i))) {
+                ++i;
+                continue;
+            }
+            // a maximal run of alphanumeric chars makes a term
+            int j = i;
+            double xMin, yMin, xMax, yMax;
+            word->getCharBBox(i, &xMin, &yMin, &xMax, &yMax);
+            while (j < len && isTermChar(*word->getChar(j))) {
+                double x0, y0, x1, y1;
+                word->getCharBBox(j, &x0, &y0, &x1, &y1);
+                xMin = std::min(xMin, x0);
+                yMin = std::min(yMin, y0);
+                xMax = std::max(xMax, x1);
+                yMax = std::max(yMax, y1);
+                ++j;
+            }
+            PageTerm pt;
+            pt.term = TextIndex::normalizeTerm(word->getChar(i), j - i);
+            pt.posting = { (uint32_t)pg, (uint32_t)w, (float)xMin, (float)yMin, (float)xMax, (float)yMax };
+            terms->push_back(std::move(pt));
+            i = j;
+        }
+    }
+}
+
+bool TextIndex::build(const char *pdfFileName, const GooString *ownerPassword, const GooString *userPassword, const char *indexFileName, int nThreads)
+{
+    Goffset pdfSize;
+    long long pdfMTime;
+    unsigned long long pdfChecksum;
+
+    // get the modification time first, so that a change made while the
+    // index is built makes isValidFor() compare the contents
+    if (!getFileSizeAndModificationTime(pdfFileName, &pdfSize, &pdfMTime) || !computeChecksum(pdfFileName, &pdfSize, &pdfChecksum)) {
+        error(errIO, -1, "Couldn't read file '{0:s}'", pdfFileName);
+        return false;
+    }
+
+    std::unique_ptr<PDFDoc> doc = std::make_unique<PDFDoc>(new GooString(pdfFileName), ownerPassword, userPassword);
+    if (!doc->isOk()) {
+        return false;
+    }
+    const int nPages = doc->getNumPages();
+
+    // extract the pages; the worker threads share nothing but the page
+    // counter, each one reads the file through its own PDFDoc
+    std::vector<std::vector<PageTerm>> pageTerms(nPages);
+    std::atomic_int nextPage { 1 };
+    auto extractPages = [&](PDFDoc *workerDoc) {
+        int pg;
+        while ((pg = nextPage++) <= nPages) {
+            extractPageTerms(workerDoc, pg, &pageTerms[pg - 1]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < std::min(nThreads, nPages); ++i) {
+        workers.emplace_back([&] {
+            PDFDoc workerDoc(new GooString(pdfFileName), ownerPassword, userPassword);
+            if (workerDoc.isOk()) {
+                extractPages(&workerDoc);
+            }
+        });
+    }
+    extractPages(doc.get());
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    // invert the page term lists -- pages are visited in order, so each
+    // term's postings come out sorted by page, then by word
+    std::map<std::string, std::vector<TextIndexPosting>> postingLists;
+    for (std::vector<PageTerm> &terms : pageTerms) {
+        for (PageTerm &pt : terms) {
+            postingLists[std::move(pt.term)].push_back(pt.posting);
+        }
+        std::vector<PageTerm>().swap(terms);
+    }
+
+    std::vector<TextIndexTerm> terms;
+    std::string strings;
+    uint64_t nPostings = 0;
+    terms.reserve(postingLists.size());
+    for (const auto &entry : postingLists) {
+        terms.push_back({ (uint32_t)strings.size(), (uint32_t)entry.first.size(), (uint32_t)nPostings, (uint32_t)entry.second.size() });
+        strings.append(entry.first);
+        nPostings += entry.second.size();
+    }
+    strings.resize((strings.size() + 7) & ~(size_t)7, '\0');
+
+    TextIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, textIndexMagic, sizeof(textIndexMagic));
+    header.byteOrder = textIndexByteOrder;
+    header.version = textIndexVersion;
+    header.pdfSize = pdfSize;
+    header.pdfChecksum = pdfChecksum;
+    header.pdfMTime = pdfMTime;
+    header.nPages = nPages;
+    header.nTerms = terms.size();
+    header.termsOffset = sizeof(header);
+    header.stringsOffset = header.termsOffset + terms.size() * sizeof(TextIndexTerm);
+    header.stringsLen = strings.size();
+    header.postingsOffset = header.stringsOffset + strings.size();
+    header.nPostings = nPostings;
+
+    FILE *f = openFile(indexFileName, "wb");
+    if (!f) {
+        error(errIO, -1, "Couldn't open file '{0:s}'", indexFileName);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && (terms.empty() || fwrite(terms.data(), sizeof(TextIndexTerm), terms.size(), f) == terms.size());
+    ok = ok && (strings.empty() || fwrite(strings.data(), 1, strings.size(), f) == strings.size());
+    for (const auto &entry : postingLists) {
+        ok = ok && fwrite(entry.second.data(), sizeof(TextIndexPosting), entry.second.size(), f) == entry.second.size();
+    }
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error(errIO, -1, "Couldn't write file '{0:s}'", indexFileName);
+    }
+
+    return ok;
+}
@@ -0,0 +1,97 @@
+//========================================================================
+//
+// TextIndex.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Persistent full-text index of a PDF file, built from TextOutputDev.
+//
+//========================================================================
+
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "goo/gfile.h"
+#include "CharTypes.h"
+
+class GooString;
+
+//------------------------------------------------------------------------
+// TextIndexHit
+//------------------------------------------------------------------------
+
+// An occurrence of a term in the indexed document.  The bounding box is
+// in TextOutputDev coordinates (points, origin at the top left of the
+// crop box of the unrotated page).
+struct TextIndexHit
+{
+    int page; // page number (1-based)
+    int word; // index of the word in the TextWordList of the page
+    double xMin, yMin, xMax, yMax; // bounding box of the term
+};
+
+//------------------------------------------------------------------------
+// TextIndex
+//------------------------------------------------------------------------
+
+// An on-disk inverted index mapping each term of a document to the
+// places where it occurs.  A term is a maximal run of alphanumeric
+// chars of a TextWord, NFKC normalized and uppercased.
+//
+// The index file is mapped into memory (where mmap is available) and
+// queried in place, so answering a query doesn't need the PDF file,
+// apart from checking that the index is still valid for it, which
+// usually only stats it.  The file is laid out in host byte order; an
+// index written on a host with a different byte order is rejected as
+// invalid.
+class TextIndex
+{
+public:
+    // Open the index file <indexFileName>.
+    explicit TextIndex(const char *indexFileName);
+    ~TextIndex();
+
+    TextIndex(const TextIndex &) = delete;
+    TextIndex &operator=(const TextIndex &) = delete;
+
+    // Was the index successfully opened?
+    bool isOk() const { return data != nullptr; }
+
+    // Check that the index was built from the current contents of the
+    // file <pdfFileName>.  A file with the size and the modification time
+    // it had when it was indexed is assumed not to have changed, unless
+    // <checkContents> is set; otherwise its contents are read and
+    // compared through their checksum.
+    bool isValidFor(const char *pdfFileName, bool checkContents = false) const;
+
+    int getNumPages() const;
+    int getNumTerms() const;
+
+    // Find all the occurrences of the term <s>, which is normalized the
+    // same way the indexed terms were.  The hits are sorted by page,
+    // then by word.
+    std::vector<TextIndexHit> find(const Unicode *s, int len) const;
+
+    // Build the index of the PDF file <pdfFileName> and write it to
+    // <indexFileName>.  The pages are extracted by <nThreads> workers,
+    // each one with its own PDFDoc.  Returns false if the PDF file
+    // can't be opened or the index file can't be written.
+    static bool build(const char *pdfFileName, const GooString *ownerPassword, const GooString *userPassword, const char *indexFileName, int nThreads);
+
+    // Normalize <s> into the UTF-8 form used as index key.
+    static std::string normalizeTerm(const Unicode *s, int len);
+
+    // Compute the size and the checksum of the contents of the file
+    // <fileName>.  Returns false if the file can't be read.
+    static bool computeChecksum(const char *fileName, Goffset *size, unsigned long long *checksum);
+
+private:
+    const unsigned char *data; // contents of the index file
+    size_t dataLen; // length of data
+    bool mapped; // set if data is mmaped, else it's gmalloc'ed
+};
+
+#endif
@@ -1162,6 +1162,36 @@ int TextLine::cmpXY(const void *p1, const void *p2)
     return line1->secondaryCmp(line2);
 }
 
+void TextLine::getRangeBBox(int start, int afterEnd, double *xMinA, double *yMinA, double *xMaxA, double *yMaxA) const
+{
+    switch (rot) {
+    case 0:
+        *xMinA = edge[start];
+        *xMaxA = edge[afterEnd];
+        *yMinA = yMin;
+        *yMaxA = yMax;
+        break;
+    case 1:
+        *xMinA = xMin;
+        *xMaxA = xMax;
+        *yMinA = edge[start];
+        *yMaxA = edge[afterEnd];
+        break;
+    case 2:
+        *xMinA = edge[afterEnd];
+        *xMaxA = edge[start];
+        *yMinA = yMin;
+        *yMaxA = yMax;
+        break;
+    case 3:
+        *xMinA = xMin;
+        *xMaxA = xMax;
+        *yMinA = edge[afterEnd];
+        *yMaxA = edge[start];
+        break;
+    }
+}
+
 void TextLine::coalesce(const UnicodeMap *uMap)
 {
     TextWord *word0, *word1;
@@ -2426,6 +2456,9 @@ TextPage::TextPage(bool rawOrderA, bool discardDiagA)
     fonts = new std::vector<TextFontInfo *>();
     lastFindXMin = lastFindYMin = 0;
     haveLastFind = false;
+    for (TextSearchBuffer *&buf : searchBuffers) {
+        buf = nullptr;
+    }
     underlines = new std::vector<TextUnderline *>();
     links = new std::vector<TextLink *>();
     mergeCombining = true;
@@ -2488,6 +2521,7 @@ void TextPage::clear()
     TextFlow *flow;
     TextWord *word;
 
+    clearSearchBuffers();
     if (curWord) {
         delete curWord;
         curWord = nullptr;
@@ -2872,6 +2906,8 @@ void TextPage::coalesce(bool physLayout, double fixedPitch, bool doHTML)
         return;
     }
 
+    clearSearchBuffers();
+
     const UnicodeMap *uMap = globalParams->getTextEncoding();
     blkList = nullptr;
     lastBlk = nullptr;
@@ -3962,32 +3998,7 @@ bool TextPage::findText(const Unicode *s, int len, bool startAtTop, bool stopAtB
                             normStart = line->normalized_idx[j];
                             normAfterEnd = line->normalized_idx[j + len - 1] + 1;
                         }
-                        switch (line->rot) {
-                        case 0:
-                            xMin1 = line->edge[normStart];
-                            xMax1 = line->edge[normAfterEnd];
-                            yMin1 = line->yMin;
-                            yMax1 = line->yMax;
-                            break;
-                        case 1:
-                            xMin1 = line->xMin;
-                            xMax1 = line->xMax;
-                            yMin1 = line->edge[normStart];
-                            yMax1 = line->edge[normAfterEnd];
-                            break;
-                        case 2:
-                            xMin1 = line->edge[normAfterEnd];
-                            xMax1 = line->edge[normStart];
-                            yMin1 = line->yMin;
-                            yMax1 = line->yMax;
-                            break;
-                        case 3:
-                            xMin1 = line->xMin;
-                            xMax1 = line->xMax;
-                            yMin1 = line->edge[normAfterEnd];
-                            yMax1 = line->edge[normStart];
-                            break;
-                        }
+                        line->getRangeBBox(normStart, normAfterEnd, &xMin1, &yMin1, &xMax1, &yMax1);
                         if (backward) {
                             if ((startAtTop || yMin1 < yStart || (yMin1 == yStart && xMin1 < xStart)) && (stopAtBottom || yMin1 > yStop || (yMin1 == yStop && xMin1 > xStop))) {
                                 if (!found || yMin1 > yMin0 || (yMin1 == yMin0 && xMin1 > xMin0)) {
@@ -4042,6 +4053,272 @@ bool TextPage::findText(const Unicode *s, int len, bool startAtTop, bool stopAtB
     return false;
 }
 
+//------------------------------------------------------------------------
+// TextSearchBuffer
+//------------------------------------------------------------------------
+
+// The folded (normalized, and optionally uppercased and/or converted to
+// ascii) text of all the lines of a page, in reading order.  Each line
+// is followed by a 0 separator, so that matches never span lines.
+class TextSearchBuffer
+{
+public:
+    std::vector<Unicode> text; // folded text
+    std::vector<int> idx; // index of each folded char into the
+                          //   Unicode text of its line
+    std::vector<int> lineStart; // offset of each line into text
+    std::vector<const TextLine *> lines;
+};
+
+//------------------------------------------------------------------------
+// TextSearchAutomaton
+//------------------------------------------------------------------------
+
+namespace {
+
+// Aho-Corasick automaton matching a set of search terms in one pass.
+class TextSearchAutomaton
+{
+public:
+    TextSearchAutomaton() : nodes(1) { }
+
+    bool isEmpty() const { return nodes.size() == 1; }
+
+    void addTerm(const Unicode *s, int len, int term)
+    {
+        int state = 0;
+        for (int i = 0; i < len; ++i) {
+            int next = transition(state, s[i]);
+            if (next < 0) {
+                // keep the edges sorted for the binary search in transition()
+                next = nodes.size();
+                auto &edges = nodes[state].edges;
+                edges.insert(std::lower_bound(edges.begin(), edges.end(), std::make_pair(s[i], 0)), std::make_pair(s[i], next));
+                nodes.emplace_back();
+            }
+            state = next;
+        }
+        nodes[state].terms.emplace_back(term, len);
+    }
+
+    // Compute the failure links.  Must be called once, after all the
+    // terms have been added.
+    void build()
+    {
+        std::vector<int> queue;
+        size_t head;
+
+        for (const auto &edge : nodes[0].edges) {
+            nodes[edge.second].fail = 0;
+            queue.push_back(edge.second);
+        }
+        for (head = 0; head < queue.size(); ++head) {
+            const int state = queue[head];
+            for (const auto &edge : nodes[state].edges) {
+                int fail = nodes[state].fail;
+                int next;
+                while ((next = transition(fail, edge.first)) < 0 && fail != 0) {
+                    fail = nodes[fail].fail;
+                }
+                fail = next < 0 ? 0 : next;
+                Node &child = nodes[edge.second];
+                child.fail = fail;
+                child.terms.insert(child.terms.end(), nodes[fail].terms.begin(), nodes[fail].terms.end());
+                queue.push_back(edge.second);
+            }
+        }
+    }
+
+    int step(int state, Unicode c) const
+    {
+        int next;
+        while ((next = transition(state, c)) < 0) {
+            if (state == 0) {
+                return 0;
+            }
+            state = nodes[state].fail;
+        }
+        return next;
+    }
+
+    // The (term, length) pairs of all the terms ending at <state>.
+    const std::vector<std::pair<int, int>> &getTerms(int state) const { return nodes[state].terms; }
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<Unicode, int>> edges; // (char, target state)
+        std::vector<std::pair<int, int>> terms;
+        int fail = 0;
+    };
+
+    int transition(int state, Unicode c) const
+    {
+        const auto &edges = nodes[state].edges;
+        const auto it = std::lower_bound(edges.begin(), edges.end(), c, [](const std::pair<Unicode, int> &edge, Unicode u) { return edge.first < u; });
+        if (it != edges.end() && it->first == c) {
+            return it->second;
+        }
+        return -1;
+    }
+
+    std::vector<Node> nodes;
+};
+
+}
+
+void TextPage::clearSearchBuffers()
+{
+    for (TextSearchBuffer *&buf : searchBuffers) {
+        delete buf;
+        buf = nullptr;
+    }
+}
+
+const TextSearchBuffer *TextPage::getSearchBuffer(bool caseSensitive, bool ignoreDiacritics)
+{
+    TextSearchBuffer *&buf = searchBuffers[(caseSensitive ? 1 : 0) | (ignoreDiacritics ? 2 : 0)];
+
+    if (buf) {
+        return buf;
+    }
+
+    buf = new TextSearchBuffer();
+    for (int i = 0; i < nBlocks; ++i) {
+        for (TextLine *line = blocks[i]->lines; line; line = line->next) {
+            if (!line->normalized)
+                line->normalized = unicodeNormalizeNFKC(line->text, line->len, &line->normalized_len, &line->normalized_idx, true);
+            const Unicode *src = line->normalized;
+            const int *srcIdx = line->normalized_idx;
+            int m = line->normalized_len;
+            if (ignoreDiacritics) {
+                if (!line->ascii_translation)
+                    unicodeToAscii7(line->normalized, line->normalized_len, &line->ascii_translation, &line->ascii_len, line->normalized_idx, &line->ascii_idx);
+                if (line->ascii_len) {
+                    src = line->ascii_translation;
+                    srcIdx = line->ascii_idx;
+                    m = line->ascii_len;
+                }
+            }
+
+            buf->lineStart.push_back(buf->text.size());
+            buf->lines.push_back(line);
+            for (int k = 0; k < m; ++k) {
+                buf->text.push_back(caseSensitive ? src[k] : unicodeToUpper(src[k]));
+                buf->idx.push_back(srcIdx[k]);
+            }
+            buf->text.push_back(0);
+            buf->idx.push_back(0);
+        }
+    }
+
+    return buf;
+}
+
+size_t TextPage::getMemorySize() const
+{
+    const size_t wordCharSize = sizeof(Unicode) + sizeof(CharCode) + sizeof(double) + sizeof(int) + sizeof(TextFontInfo *) + sizeof(Matrix);
+    const size_t lineCharSize = sizeof(Unicode) + sizeof(double) + sizeof(int);
+    size_t size = sizeof(TextPage);
+
+    for (const TextWord *word = rawWords; word; word = word->next) {
+        size += sizeof(TextWord) + word->size * wordCharSize;
+    }
+    for (const TextFlow *flow = flows; flow; flow = flow->next) {
+        size += sizeof(TextFlow);
+        for (const TextBlock *blk = flow->blocks; blk; blk = blk->next) {
+            size += sizeof(TextBlock) + sizeof(TextBlock *);
+            for (const TextLine *line = blk->lines; line; line = line->next) {
+                size += sizeof(TextLine) + line->len * lineCharSize;
+                size += (line->normalized_len + line->ascii_len) * (sizeof(Unicode) + sizeof(int));
+                for (const TextWord *word = line->words; word; word = word->next) {
+                    size += sizeof(TextWord) + word->size * wordCharSize;
+                }
+            }
+        }
+    }
+    if (fonts) {
+        size += fonts->size() * sizeof(TextFontInfo);
+    }
+    for (const TextSearchBuffer *buf : searchBuffers) {
+        if (buf) {
+            size += sizeof(TextSearchBuffer) + buf->text.capacity() * sizeof(Unicode) + (buf->idx.capacity() + buf->lineStart.capacity()) * sizeof(int) + buf->lines.capacity() * sizeof(const TextLine *);
+        }
+    }
+    return size;
+}
+
+std::vector<TextSearchHit> TextPage::findAllText(const std::vector<std::vector<Unicode>> &terms, bool caseSensitive, bool ignoreDiacritics, bool wholeWord)
+{
+    std::vector<TextSearchHit> hits;
+    // one automaton for the terms matched against the normalized text,
+    // one for the terms matched against its ascii translation
+    TextSearchAutomaton automata[2];
+
+    if (rawOrder) {
+        return hits;
+    }
+
+    // normalize the search terms the same way findText does; terms that
+    // are not pure ascii don't use ignoreDiacritics (as they won't match)
+    for (size_t t = 0; t < terms.size(); ++t) {
+        int len = terms[t].size();
+        if (len == 0) {
+            continue;
+        }
+        Unicode *reordered = (Unicode *)gmallocn(len, sizeof(Unicode));
+        reorderText(terms[t].data(), len, nullptr, primaryLR, nullptr, reordered);
+        Unicode *s2 = unicodeNormalizeNFKC(reordered, len, &len, nullptr);
+        bool ascii = true;
+        for (int i = 0; i < len; ++i) {
+            if (!caseSensitive) {
+                s2[i] = unicodeToUpper(s2[i]);
+            }
+            if (!isAscii7(s2[i])) {
+                ascii = false;
+            }
+        }
+        if (len > 0) {
+            automata[ignoreDiacritics && ascii ? 1 : 0].addTerm(s2, len, t);
+        }
+        gfree(s2);
+        gfree(reordered);
+    }
+
+    for (int mode = 0; mode < 2; ++mode) {
+        TextSearchAutomaton &automaton = automata[mode];
+        if (automaton.isEmpty()) {
+            continue;
+        }
+        automaton.build();
+
+        const TextSearchBuffer *buf = getSearchBuffer(caseSensitive, mode == 1);
+        const std::vector<Unicode> &txt = buf->text;
+        const int n = txt.size();
+        int state = 0;
+        for (int pos = 0; pos < n; ++pos) {
+            state = automaton.step(state, txt[pos]);
+            for (const std::pair<int, int> &term : automaton.getTerms(state)) {
+                const int start = pos + 1 - term.second;
+                if (wholeWord && ((start > 0 && unicodeTypeAlphaNum(txt[start - 1])) || (pos + 1 < n && unicodeTypeAlphaNum(txt[pos + 1])))) {
+                    continue;
+                }
+                const int lineIdx = std::upper_bound(buf->lineStart.begin(), buf->lineStart.end(), start) - buf->lineStart.begin() - 1;
+                TextSearchHit hit;
+                hit.term = term.first;
+                // where the term matches a subsequence of a compatibility
+                // equivalence decomposition, highlight the entire glyph
+                buf->lines[lineIdx]->getRangeBBox(buf->idx[start], buf->idx[pos] + 1, &hit.xMin, &hit.yMin, &hit.xMax, &hit.yMax);
+                hits.push_back(hit);
+            }
+        }
+    }
+
+    std::stable_sort(hits.begin(), hits.end(), [](const TextSearchHit &h1, const TextSearchHit &h2) { return h1.yMin < h2.yMin || (h1.yMin == h2.yMin && h1.xMin < h2.xMin); });
+
+    return hits;
+}
+
 GooString *TextPage::getText(double xMin, double yMin, double xMax, double yMax, EndOfLineKind textEOL) const
 {
     GooString *s;
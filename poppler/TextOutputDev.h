@@ -60,6 +60,7 @@ class TextUnderline;
 class TextWordList;
 class TextPage;
 class TextSelectionVisitor;
+class TextSearchBuffer;
 
 //------------------------------------------------------------------------
 
@@ -333,6 +334,10 @@ public:
     bool isHyphenated() const { return hyphenated; }
 
 private:
+    // Get the bounding box of the chars [<start>, <afterEnd>) of the
+    // Unicode text of the line.
+    void getRangeBBox(int start, int afterEnd, double *xMinA, double *yMinA, double *xMaxA, double *yMaxA) const;
+
     TextBlock *blk; // parent block
     int rot; // text rotation
     double xMin, xMax; // bounding box x coordinates
@@ -547,6 +552,17 @@ private:
     friend class TextSelectionDumper;
 };
 
+//------------------------------------------------------------------------
+// TextSearchHit
+//------------------------------------------------------------------------
+
+// An occurrence of one of the terms passed to TextPage::findAllText.
+struct TextSearchHit
+{
+    int term; // index of the matching search term
+    double xMin, yMin, xMax, yMax; // bounding box of the occurrence
+};
+
 //------------------------------------------------------------------------
 // TextPage
 //------------------------------------------------------------------------
@@ -612,6 +628,14 @@ public:
     bool findText(const Unicode *s, int len, bool startAtTop, bool stopAtBottom, bool startAtLast, bool stopAtLast, bool caseSensitive, bool ignoreDiacritics, bool backward, bool wholeWord, double *xMin, double *yMin, double *xMax,
                   double *yMax);
 
+    // Find all the occurrences of all the <terms> in a single pass over
+    // the page text.  The case/diacritics folded text of the page is
+    // built on first use and kept, so further searches only scan it.
+    // <caseSensitive>, <ignoreDiacritics> and <wholeWord> have the same
+    // meaning as for findText.  The hits are sorted from top to bottom,
+    // then from left to right.
+    std::vector<TextSearchHit> findAllText(const std::vector<std::vector<Unicode>> &terms, bool caseSensitive, bool ignoreDiacritics, bool wholeWord);
+
     // Get the text which is inside the specified rectangle.
     GooString *getText(double xMin, double yMin, double xMax, double yMax, EndOfLineKind textEOL) const;
 
@@ -640,6 +664,14 @@ public:
     // character are drawn on eachother.
     void setMergeCombining(bool merge);
 
+    // Forget the last find result, so that findText with <startAtLast>
+    // or <stopAtLast> behaves as on a freshly extracted page.
+    void forgetLastFind() { haveLastFind = false; }
+
+    // Return the approximate amount of memory, in bytes, used by the
+    // text of the page.
+    size_t getMemorySize() const;
+
 #ifdef TEXTOUT_WORD_LIST
     // Build a flat word list, in content stream order (if
     // this->rawOrder is true), physical layout order (if <physLayout>
@@ -653,6 +685,8 @@ private:
     ~TextPage();
 
     void clear();
+    void clearSearchBuffers();
+    const TextSearchBuffer *getSearchBuffer(bool caseSensitive, bool ignoreDiacritics);
     void assignColumns(TextLineFrag *frags, int nFrags, bool rot) const;
     int dumpFragment(const Unicode *text, int len, const UnicodeMap *uMap, GooString *s) const;
 
@@ -690,6 +724,9 @@ private:
             lastFindYMin;
     bool haveLastFind;
 
+    TextSearchBuffer *searchBuffers[4]; // folded page text for findAllText,
+                                        //   indexed by case/diacritics mode
+
     std::vector<TextUnderline *> *underlines;
     std::vector<TextLink *> *links;
 
@@ -0,0 +1,131 @@
+//========================================================================
+//
+// TextPageCache.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+
+#include "OptionalContent.h"
+#include "PDFDoc.h"
+#include "TextOutputDev.h"
+#include "TextPageCache.h"
+
+//------------------------------------------------------------------------
+// TextPageCache
+//------------------------------------------------------------------------
+
+TextPageCache::TextPageCache(size_t maxBytesA)
+{
+    maxBytes = maxBytesA;
+    curBytes = 0;
+}
+
+TextPageCache::~TextPageCache()
+{
+    clear();
+}
+
+TextPage *TextPageCache::acquire(PDFDoc *doc, const Key &key, bool (*abortCheckCbk)(void *data), void *abortCheckCbkData)
+{
+    // read before the extraction, so that a change made meanwhile by
+    // another thread makes the text out of date
+    const Version version = getVersion(doc);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(entries.begin(), entries.end(), [&key](const Entry &entry) { return entry.key == key; });
+        if (it != entries.end()) {
+            TextPage *text = it->text;
+            const bool upToDate = it->version == version;
+            curBytes -= it->size;
+            entries.erase(it);
+            if (upToDate) {
+                acquired[text] = version;
+                return text;
+            }
+            text->decRefCnt();
+        }
+    }
+
+    TextOutputDev td(nullptr, false, 0, key.rawOrder, false);
+    doc->displayPage(&td, key.page, 72, 72, key.rotate, false, key.crop, false, abortCheckCbk, abortCheckCbkData, nullptr, nullptr, true);
+    if (abortCheckCbk && (*abortCheckCbk)(abortCheckCbkData)) {
+        return nullptr;
+    }
+    TextPage *text = td.takeText();
+    std::lock_guard<std::mutex> lock(mutex);
+    acquired[text] = version;
+    return text;
+}
+
+void TextPageCache::release(const Key &key, TextPage *text)
+{
+    Version version = { 0, 0 };
+    bool acquiredHere = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = acquired.find(text);
+        if (it != acquired.end()) {
+            version = it->second;
+            acquiredHere = true;
+            acquired.erase(it);
+        }
+        if (!acquiredHere || maxBytes == 0) {
+            text->decRefCnt();
+            return;
+        }
+    }
+
+    // the size is measured now, so that it includes the search buffers
+    // built while the page was in use
+    const size_t size = text->getMemorySize();
+    text->forgetLastFind();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool cached = std::any_of(entries.begin(), entries.end(), [&key](const Entry &entry) { return entry.key == key; });
+    if (cached || size > maxBytes) {
+        text->decRefCnt();
+        return;
+    }
+    entries.insert(entries.begin(), Entry { key, text, size, version });
+    curBytes += size;
+    shrink(maxBytes);
+}
+
+size_t TextPageCache::getMaxBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxBytes;
+}
+
+void TextPageCache::setMaxBytes(size_t maxBytesA)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    maxBytes = maxBytesA;
+    shrink(maxBytes);
+}
+
+void TextPageCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    shrink(0);
+}
+
+TextPageCache::Version TextPageCache::getVersion(PDFDoc *doc)
+{
+    const OCGs *optContent = doc->getOptContentConfig();
+    return Version { doc->getXRef()->getModificationCount(), optContent ? optContent->getStateGeneration() : 0 };
+}
+
+void TextPageCache::shrink(size_t limit)
+{
+    while (curBytes > limit) {
+        curBytes -= entries.back().size;
+        entries.back().text->decRefCnt();
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,106 @@
+//========================================================================
+//
+// TextPageCache.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Memory bounded cache of the text of the pages of a document.
+//
+//========================================================================
+
+#ifndef TEXTPAGECACHE_H
+#define TEXTPAGECACHE_H
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class PDFDoc;
+class TextPage;
+
+//------------------------------------------------------------------------
+// TextPageCache
+//------------------------------------------------------------------------
+
+// Keeps the TextPages extracted from the pages of a document, so that
+// repeated text queries on a page (like a search updated as the user
+// types) don't extract and lay out its text again each time.  When the
+// cached pages take more than the byte limit, the least recently used
+// ones are dropped.  A limit of 0 disables the cache.  A page is only
+// taken from the cache if the document wasn't modified since its text was
+// extracted, like by a form field or an annotation edited, and if no
+// optional content group was shown or hidden meanwhile.
+//
+// A TextPage obtained from acquire() is out of the cache until it is
+// given back with release(), so it is only ever used by one thread at
+// a time.
+class TextPageCache
+{
+public:
+    // The extraction settings of a TextPage.
+    struct Key
+    {
+        int page; // page number (1-based)
+        int rotate; // rotation, in degrees
+        bool rawOrder; // keep text in content stream order
+        bool crop; // drop the text outside of the crop box
+
+        bool operator==(const Key &other) const { return page == other.page && rotate == other.rotate && rawOrder == other.rawOrder && crop == other.crop; }
+    };
+
+    explicit TextPageCache(size_t maxBytesA = 0);
+    ~TextPageCache();
+
+    TextPageCache(const TextPageCache &) = delete;
+    TextPageCache &operator=(const TextPageCache &) = delete;
+
+    // Return the text of the page of <doc> described by <key>, with a
+    // reference owned by the caller.  It is taken out of the cache if
+    // it's there and up to date, else extracted.  Returns nullptr if
+    // <abortCheckCbk> stopped the extraction.
+    TextPage *acquire(PDFDoc *doc, const Key &key, bool (*abortCheckCbk)(void *data) = nullptr, void *abortCheckCbkData = nullptr);
+
+    // Give back <text>, returned by acquire() for <key>, releasing the
+    // caller's reference.  It is kept in the cache if it fits in the
+    // byte limit.
+    void release(const Key &key, TextPage *text);
+
+    size_t getMaxBytes() const;
+
+    // Change the byte limit, dropping the pages which don't fit anymore.
+    void setMaxBytes(size_t maxBytesA);
+
+    // Drop all the cached pages.
+    void clear();
+
+private:
+    // The state of the document a TextPage was extracted from.
+    struct Version
+    {
+        unsigned int modificationCount; // XRef modification count
+        unsigned int ocStateGeneration; // optional content state generation
+
+        bool operator==(const Version &other) const { return modificationCount == other.modificationCount && ocStateGeneration == other.ocStateGeneration; }
+    };
+
+    struct Entry
+    {
+        Key key;
+        TextPage *text;
+        size_t size; // approximate memory size of text
+        Version version; // document state text was extracted from
+    };
+
+    static Version getVersion(PDFDoc *doc);
+
+    void shrink(size_t limit);
+
+    size_t maxBytes; // byte limit
+    size_t curBytes; // total size of the cached pages
+    std::vector<Entry> entries; // cached pages, most recently used first
+    std::unordered_map<const TextPage *, Version> acquired; // document states of the pages out of the cache
+    mutable std::mutex mutex;
+};
+
+#endif
@@ -57,6 +57,7 @@
 #include "Error.h"
 #include "ErrorCodes.h"
 #include "XRef.h"
+#include "JBIG2Stream.h"
 
 //------------------------------------------------------------------------
 // Permission bits
@@ -238,6 +239,7 @@ XRef::XRef() : objStrs { 5 }
     capacity = 0;
     size = 0;
     modified = false;
+    modificationCount = 0;
     streamEnds = nullptr;
     streamEndsLen = 0;
     mainXRefEntriesOffset = 0;
@@ -373,6 +375,8 @@ XRef *XRef::copy() const
         xref->fileKey[i] = fileKey[i];
     }
 
+    xref->jbig2GlobalsCache = getJBIG2GlobalsCache();
+
     if (xref->reserve(size) == 0) {
         error(errSyntaxError, -1, "unable to allocate {0:d} entries", size);
         delete xref;
@@ -1300,6 +1304,15 @@ void XRef::removeDocInfo()
     }
 }
 
+std::shared_ptr<JBIG2GlobalsCache> XRef::getJBIG2GlobalsCache() const
+{
+    xrefLocker();
+    if (!jbig2GlobalsCache) {
+        jbig2GlobalsCache = std::make_shared<JBIG2GlobalsCache>();
+    }
+    return jbig2GlobalsCache;
+}
+
 bool XRef::getStreamEnd(Goffset streamStart, Goffset *streamEnd)
 {
     int a, b, m;
@@ -1376,6 +1389,19 @@ void XRef::add(int num, int gen, Goffset offs, bool used)
     }
 }
 
+// Objects given to the XRef can be seen by other threads, so their
+// later modifications need to lock.
+static void freezeObject(const Object &obj)
+{
+    if (obj.isDict()) {
+        obj.getDict()->freeze();
+    } else if (obj.isArray()) {
+        obj.getArray()->freeze();
+    } else if (obj.isStream()) {
+        obj.getStream()->getDict()->freeze();
+    }
+}
+
 void XRef::setModifiedObject(const Object *o, Ref r)
 {
     xrefLocker();
@@ -1385,6 +1411,7 @@ void XRef::setModifiedObject(const Object *o, Ref r)
     }
     XRefEntry *e = getEntry(r.num);
     e->obj = o->copy();
+    freezeObject(e->obj);
     e->setFlag(XRefEntry::Updated, true);
     setModified();
 }
@@ -1412,6 +1439,7 @@ Ref XRef::addIndirectObject(const Object *o)
     }
     e->type = xrefEntryUncompressed;
     e->obj = o->copy();
+    freezeObject(e->obj);
     e->setFlag(XRefEntry::Updated, true);
     setModified();
 
@@ -1441,6 +1469,20 @@ void XRef::removeIndirectObject(Ref r)
     setModified();
 }
 
+void XRef::discardModifiedObjects()
+{
+    xrefLocker();
+    for (int i = 0; i < size; ++i) {
+        if (entries[i].getFlag(XRefEntry::Updated)) {
+            entries[i].obj.setToNull();
+            entries[i].setFlag(XRefEntry::Updated, false);
+        }
+    }
+    objStrs.clear();
+    modified = false;
+    ++modificationCount;
+}
+
 void XRef::writeXRef(XRef::XRefWriter *writer, bool writeAllEntries)
 {
     // create free entries linked-list
@@ -34,6 +34,9 @@
 #ifndef XREF_H
 #define XREF_H
 
+#include <atomic>
+#include <memory>
+
 #include "poppler-config.h"
 #include "Object.h"
 #include "Stream.h"
@@ -43,6 +46,7 @@ class Dict;
 class Stream;
 class Parser;
 class ObjectStream;
+class JBIG2GlobalsCache;
 
 //------------------------------------------------------------------------
 // XRef
@@ -174,6 +178,10 @@ public:
     int getRootGen() const { return rootGen; }
     Ref getRoot() const { return { rootNum, rootGen }; }
 
+    // Get the cache of decoded JBIG2Globals streams of the document,
+    // shared with the copies of this XRef.
+    std::shared_ptr<JBIG2GlobalsCache> getJBIG2GlobalsCache() const;
+
     // Get end position for a stream in a damaged file.
     // Returns false if unknown or file is not damaged.
     bool getStreamEnd(Goffset streamStart, Goffset *streamEnd);
@@ -195,13 +203,28 @@ public:
 
     // Was the XRef modified?
     bool isModified() const { return modified; }
+    // Was the xref table reconstructed, or its reconstruction given up,
+    // because an object couldn't be fetched?
+    bool isReconstructed() const { return xrefReconstructed; }
     // Set the modification flag for XRef to true.
-    void setModified() { modified = true; }
+    void setModified()
+    {
+        modified = true;
+        ++modificationCount;
+    }
+    // Number of changes made to the objects, for the caches of data
+    // derived from them, like the text of the pages.
+    unsigned int getModificationCount() const { return modificationCount; }
 
     // Write access
     void setModifiedObject(const Object *o, Ref r);
     Ref addIndirectObject(const Object *o);
     void removeIndirectObject(Ref r);
+    // Drop the changes made with setModifiedObject(), so that the objects
+    // are read from the file again, and forget the cached object streams,
+    // whose objects may have been changed in place.  Objects added or
+    // removed since the document was opened are not restored.
+    void discardModifiedObjects();
     void add(int num, int gen, Goffset offs, bool used);
     void add(Ref ref, Goffset offs, bool used);
 
@@ -227,6 +250,7 @@ private:
     bool xrefReconstructed; // marker, true if xref was already reconstructed
     Object trailerDict; // trailer dictionary
     bool modified;
+    std::atomic<unsigned int> modificationCount; // number of changes to the objects
     Goffset *streamEnds; // 'endstream' positions - only used in
                          //   damaged files
     int streamEndsLen; // number of valid entries in streamEnds
@@ -246,6 +270,7 @@ private:
     bool scannedSpecialFlags; // true if scanSpecialFlags has been called
     bool strOwner; // true if str is owned by the instance
     mutable std::recursive_mutex mutex;
+    mutable std::shared_ptr<JBIG2GlobalsCache> jbig2GlobalsCache; // created on first use
 
     int reserve(int newSize);
     int resize(int newSize);
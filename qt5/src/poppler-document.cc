@@ -718,6 +718,24 @@ Document::RenderHints Document::renderHints() const
     return Document::RenderHints(m_doc->m_hints);
 }
 
+void Document::clearRenderCache()
+{
+#if defined(HAVE_SPLASH)
+    QMutexLocker locker(&m_doc->m_splashOutputDevMutex);
+    m_doc->m_splashOutputDev.reset();
+#endif
+}
+
+void Document::setTextCacheSize(qint64 bytes)
+{
+    m_doc->m_textPageCache.setMaxBytes(bytes > 0 ? bytes : 0);
+}
+
+qint64 Document::textCacheSize() const
+{
+    return m_doc->m_textPageCache.getMaxBytes();
+}
+
 PSConverter *Document::psConverter() const
 {
     return new PSConverter(m_doc);
@@ -348,11 +348,14 @@ inline TextPage *PageData::prepareTextSearch(const QString &text, Page::Rotation
     const int rotation = (int)rotate * 90;
 
     // fetch ourselves a textpage
-    TextOutputDev td(nullptr, true, 0, false, false);
-    parentDoc->doc->displayPage(&td, index + 1, 72, 72, rotation, false, true, false, nullptr, nullptr, nullptr, nullptr, true);
-    TextPage *textPage = td.takeText();
+    const TextPageCache::Key key = { index + 1, rotation, false, true };
+    return parentDoc->m_textPageCache.acquire(parentDoc->doc, key);
+}
 
-    return textPage;
+inline void PageData::finishTextSearch(TextPage *textPage, Page::Rotation rotate)
+{
+    const TextPageCache::Key key = { index + 1, (int)rotate * 90, false, true };
+    parentDoc->m_textPageCache.release(key, textPage);
 }
 
 inline bool PageData::performSingleTextSearch(TextPage *textPage, QVector<Unicode> &u, double &sLeft, double &sTop, double &sRight, double &sBottom, Page::SearchDirection direction, bool sCase, bool sWords, bool sDiacritics = false)
@@ -459,6 +462,63 @@ QImage Page::renderToImage(double xres, double yres, int x, int y, int w, int h,
     return renderToImage(xres, yres, x, y, w, h, rotate, partialUpdateCallback, shouldDoPartialUpdateCallback, nullptr, payload);
 }
 
+#if defined(HAVE_SPLASH)
+static std::unique_ptr<Qt5SplashOutputDev> createSplashOutputDev(DocumentData *doc)
+{
+    SplashColor bgColor;
+    const bool overprintPreview = doc->m_hints & Document::OverprintPreview ? true : false;
+    if (overprintPreview) {
+        unsigned char c, m, y, k;
+
+        c = 255 - doc->paperColor.blue();
+        m = 255 - doc->paperColor.red();
+        y = 255 - doc->paperColor.green();
+        k = c;
+        if (m < k) {
+            k = m;
+        }
+        if (y < k) {
+            k = y;
+        }
+        bgColor[0] = c - k;
+        bgColor[1] = m - k;
+        bgColor[2] = y - k;
+        bgColor[3] = k;
+        for (int i = 4; i < SPOT_NCOMPS + 4; i++) {
+            bgColor[i] = 0;
+        }
+    } else {
+        bgColor[0] = doc->paperColor.blue();
+        bgColor[1] = doc->paperColor.green();
+        bgColor[2] = doc->paperColor.red();
+    }
+
+    const SplashColorMode colorMode = overprintPreview ? splashModeDeviceN8 : splashModeXBGR8;
+
+    SplashThinLineMode thinLineMode = splashThinLineDefault;
+    if (doc->m_hints & Document::ThinLineShape)
+        thinLineMode = splashThinLineShape;
+    if (doc->m_hints & Document::ThinLineSolid)
+        thinLineMode = splashThinLineSolid;
+
+    const bool ignorePaperColor = doc->m_hints & Document::IgnorePaperColor;
+
+    std::unique_ptr<Qt5SplashOutputDev> splash_output = std::make_unique<Qt5SplashOutputDev>(colorMode, 4, false, ignorePaperColor, ignorePaperColor ? nullptr : bgColor, true, thinLineMode, overprintPreview);
+
+    splash_output->setFontAntialias(doc->m_hints & Document::TextAntialiasing ? true : false);
+    splash_output->setVectorAntialias(doc->m_hints & Document::Antialiasing ? true : false);
+    splash_output->setFreeTypeHinting(doc->m_hints & Document::TextHinting ? true : false, doc->m_hints & Document::TextSlightHinting ? true : false);
+
+#    ifdef USE_CMS
+    splash_output->setDisplayProfile(doc->m_displayProfile);
+#    endif
+
+    splash_output->startDoc(doc->doc);
+
+    return splash_output;
+}
+#endif
+
 // Translate the text hinting settings from poppler-speak to Qt-speak
 static QFont::HintingPreference QFontHintingFromPopplerHinting(int renderHints)
 {
@@ -479,65 +539,60 @@ QImage Page::renderToImage(double xres, double yres, int xPos, int yPos, int w,
     switch (m_page->parentDoc->m_backend) {
     case Poppler::Document::SplashBackend: {
 #if defined(HAVE_SPLASH)
-        SplashColor bgColor;
-        const bool overprintPreview = m_page->parentDoc->m_hints & Document::OverprintPreview ? true : false;
-        if (overprintPreview) {
-            unsigned char c, m, y, k;
-
-            c = 255 - m_page->parentDoc->paperColor.blue();
-            m = 255 - m_page->parentDoc->paperColor.red();
-            y = 255 - m_page->parentDoc->paperColor.green();
-            k = c;
-            if (m < k) {
-                k = m;
-            }
-            if (y < k) {
-                k = y;
-            }
-            bgColor[0] = c - k;
-            bgColor[1] = m - k;
-            bgColor[2] = y - k;
-            bgColor[3] = k;
-            for (int i = 4; i < SPOT_NCOMPS + 4; i++) {
-                bgColor[i] = 0;
+        DocumentData *doc = m_page->parentDoc;
+
+        // Render with the output device of the document, so that its fonts
+        // and glyph caches are reused from one call to the next, unless
+        // another thread is rendering with it right now
+        std::unique_ptr<Qt5SplashOutputDev> ownOutputDev;
+        Qt5SplashOutputDev *splash_output;
+        const bool useDocOutputDev = doc->m_splashOutputDevMutex.tryLock();
+        if (useDocOutputDev) {
+            if (!doc->m_splashOutputDev || doc->m_splashOutputDevHints != doc->m_hints || doc->m_splashOutputDevPaperColor != doc->paperColor
+#    ifdef USE_CMS
+                || doc->m_splashOutputDev->getDisplayProfile() != doc->m_displayProfile
+#    endif
+            ) {
+                doc->m_splashOutputDev = createSplashOutputDev(doc);
+                doc->m_splashOutputDevHints = doc->m_hints;
+                doc->m_splashOutputDevPaperColor = doc->paperColor;
             }
+            splash_output = static_cast<Qt5SplashOutputDev *>(doc->m_splashOutputDev.get());
         } else {
-            bgColor[0] = m_page->parentDoc->paperColor.blue();
-            bgColor[1] = m_page->parentDoc->paperColor.green();
-            bgColor[2] = m_page->parentDoc->paperColor.red();
+            ownOutputDev = createSplashOutputDev(doc);
+            splash_output = ownOutputDev.get();
         }
 
-        const SplashColorMode colorMode = overprintPreview ? splashModeDeviceN8 : splashModeXBGR8;
-
-        SplashThinLineMode thinLineMode = splashThinLineDefault;
-        if (m_page->parentDoc->m_hints & Document::ThinLineShape)
-            thinLineMode = splashThinLineShape;
-        if (m_page->parentDoc->m_hints & Document::ThinLineSolid)
-            thinLineMode = splashThinLineSolid;
-
-        const bool ignorePaperColor = m_page->parentDoc->m_hints & Document::IgnorePaperColor;
-
-        Qt5SplashOutputDev splash_output(colorMode, 4, false, ignorePaperColor, ignorePaperColor ? nullptr : bgColor, true, thinLineMode, overprintPreview);
-
-        splash_output.setCallbacks(partialUpdateCallback, shouldDoPartialUpdateCallback, shouldAbortRenderCallback, payload);
+        splash_output->setCallbacks(partialUpdateCallback, shouldDoPartialUpdateCallback, shouldAbortRenderCallback, payload);
 
-        splash_output.setFontAntialias(m_page->parentDoc->m_hints & Document::TextAntialiasing ? true : false);
-        splash_output.setVectorAntialias(m_page->parentDoc->m_hints & Document::Antialiasing ? true : false);
-        splash_output.setFreeTypeHinting(m_page->parentDoc->m_hints & Document::TextHinting ? true : false, m_page->parentDoc->m_hints & Document::TextSlightHinting ? true : false);
+        const bool hideAnnotations = doc->m_hints & Document::HideAnnotations;
 
-#    ifdef USE_CMS
-        splash_output.setDisplayProfile(m_page->parentDoc->m_displayProfile);
-#    endif
-
-        splash_output.startDoc(m_page->parentDoc->doc);
+        OutputDevCallbackHelper *abortHelper = splash_output;
+        const auto displayPage = [&] {
+            doc->doc->displayPageSlice(splash_output, m_page->index + 1, xres, yres, rotation, false, true, false, xPos, yPos, w, h, shouldAbortRenderCallback ? shouldAbortRenderInternalCallback : nullAbortCallBack, abortHelper,
+                                       (hideAnnotations) ? annotDisplayDecideCbk : nullAnnotCallBack, nullptr, true);
+        };
 
-        const bool hideAnnotations = m_page->parentDoc->m_hints & Document::HideAnnotations;
+        if ((doc->m_hints & Document::ProgressiveRendering) && partialUpdateCallback) {
+            // draw the large images and the shadings as placeholders first,
+            // and publish that before rendering the page completely
+            splash_output->setPlaceholderMode(true);
+            displayPage();
+            splash_output->setPlaceholderMode(false);
+            if (splash_output->hasPlaceholders() && !(shouldAbortRenderCallback && shouldAbortRenderCallback(payload))) {
+                partialUpdateCallback(splash_output->getXBGRImage(false /* takeImageData */), payload);
+                displayPage();
+            }
+        } else {
+            displayPage();
+        }
 
-        OutputDevCallbackHelper *abortHelper = &splash_output;
-        m_page->parentDoc->doc->displayPageSlice(&splash_output, m_page->index + 1, xres, yres, rotation, false, true, false, xPos, yPos, w, h, shouldAbortRenderCallback ? shouldAbortRenderInternalCallback : nullAbortCallBack, abortHelper,
-                                                 (hideAnnotations) ? annotDisplayDecideCbk : nullAnnotCallBack, nullptr, true);
+        img = splash_output->getXBGRImage(true /* takeImageData */);
 
-        img = splash_output.getXBGRImage(true /* takeImageData */);
+        if (useDocOutputDev) {
+            splash_output->setCallbacks(nullptr, nullptr, nullptr, QVariant());
+            doc->m_splashOutputDevMutex.unlock();
+        }
 #endif
         break;
     }
@@ -610,23 +665,22 @@ QImage Page::thumbnail() const
 
 QString Page::text(const QRectF &r, TextLayout textLayout) const
 {
-    TextOutputDev *output_dev;
     GooString *s;
     QString result;
 
     const bool rawOrder = textLayout == RawOrderLayout;
-    output_dev = new TextOutputDev(nullptr, false, 0, rawOrder, false);
-    m_page->parentDoc->doc->displayPageSlice(output_dev, m_page->index + 1, 72, 72, 0, false, true, false, -1, -1, -1, -1, nullptr, nullptr, nullptr, nullptr, true);
+    const TextPageCache::Key key = { m_page->index + 1, 0, rawOrder, true };
+    TextPage *textPage = m_page->parentDoc->m_textPageCache.acquire(m_page->parentDoc->doc, key);
     if (r.isNull()) {
         const PDFRectangle *rect = m_page->page->getCropBox();
-        s = output_dev->getText(rect->x1, rect->y1, rect->x2, rect->y2);
+        s = textPage->getText(rect->x1, rect->y1, rect->x2, rect->y2, TextOutputDev::defaultEndOfLine());
     } else {
-        s = output_dev->getText(r.left(), r.top(), r.right(), r.bottom());
+        s = textPage->getText(r.left(), r.top(), r.right(), r.bottom(), TextOutputDev::defaultEndOfLine());
     }
 
     result = QString::fromUtf8(s->c_str());
 
-    delete output_dev;
+    m_page->parentDoc->m_textPageCache.release(key, textPage);
     delete s;
     return result;
 }
@@ -645,7 +699,7 @@ bool Page::search(const QString &text, double &sLeft, double &sTop, double &sRig
 
     const bool found = m_page->performSingleTextSearch(textPage, u, sLeft, sTop, sRight, sBottom, direction, sCase, false);
 
-    textPage->decRefCnt();
+    m_page->finishTextSearch(textPage, rotate);
 
     return found;
 }
@@ -661,7 +715,7 @@ bool Page::search(const QString &text, double &sLeft, double &sTop, double &sRig
 
     const bool found = m_page->performSingleTextSearch(textPage, u, sLeft, sTop, sRight, sBottom, direction, sCase, sWords, sDiacritics);
 
-    textPage->decRefCnt();
+    m_page->finishTextSearch(textPage, rotate);
 
     return found;
 }
@@ -675,7 +729,7 @@ QList<QRectF> Page::search(const QString &text, SearchMode caseSensitive, Rotati
 
     const QList<QRectF> results = m_page->performMultipleTextSearch(textPage, u, sCase, false);
 
-    textPage->decRefCnt();
+    m_page->finishTextSearch(textPage, rotate);
 
     return results;
 }
@@ -691,7 +745,36 @@ QList<QRectF> Page::search(const QString &text, SearchFlags flags, Rotation rota
 
     const QList<QRectF> results = m_page->performMultipleTextSearch(textPage, u, sCase, sWords, sDiacritics);
 
-    textPage->decRefCnt();
+    m_page->finishTextSearch(textPage, rotate);
+
+    return results;
+}
+
+QList<QList<QRectF>> Page::search(const QStringList &texts, SearchFlags flags, Rotation rotate) const
+{
+    const bool sCase = flags.testFlag(IgnoreCase) ? false : true;
+    const bool sWords = flags.testFlag(WholeWords) ? true : false;
+    const bool sDiacritics = flags.testFlag(IgnoreDiacritics) ? true : false;
+
+    std::vector<std::vector<Unicode>> terms;
+    terms.reserve(texts.size());
+    for (const QString &text : texts) {
+        const QVector<uint> u = text.toUcs4();
+        terms.emplace_back(u.begin(), u.end());
+    }
+
+    QVector<Unicode> u;
+    TextPage *textPage = m_page->prepareTextSearch(QString(), rotate, &u);
+
+    QList<QList<QRectF>> results;
+    for (int i = 0; i < texts.size(); ++i) {
+        results.append(QList<QRectF>());
+    }
+    for (const TextSearchHit &hit : textPage->findAllText(terms, sCase, sDiacritics, sWords)) {
+        results[hit.term].append(QRectF(QPointF(hit.xMin, hit.yMin), QPointF(hit.xMax, hit.yMax)));
+    }
+
+    m_page->finishTextSearch(textPage, rotate);
 
     return results;
 }
@@ -703,23 +786,22 @@ QList<TextBox *> Page::textList(Rotation rotate) const
 
 QList<TextBox *> Page::textList(Rotation rotate, ShouldAbortQueryFunc shouldAbortExtractionCallback, const QVariant &closure) const
 {
-    TextOutputDev *output_dev;
-
     QList<TextBox *> output_list;
 
-    output_dev = new TextOutputDev(nullptr, false, 0, false, false);
-
     int rotation = (int)rotate * 90;
 
+    const TextPageCache::Key key = { m_page->index + 1, rotation, false, false };
     TextExtractionAbortHelper abortHelper(shouldAbortExtractionCallback, closure);
-    m_page->parentDoc->doc->displayPageSlice(output_dev, m_page->index + 1, 72, 72, rotation, false, false, false, -1, -1, -1, -1, shouldAbortExtractionCallback ? shouldAbortExtractionInternalCallback : nullAbortCallBack, &abortHelper,
-                                             nullptr, nullptr, true);
+    TextPage *textPage = m_page->parentDoc->m_textPageCache.acquire(m_page->parentDoc->doc, key, shouldAbortExtractionCallback ? shouldAbortExtractionInternalCallback : nullAbortCallBack, &abortHelper);
+    if (!textPage) {
+        return output_list;
+    }
 
-    TextWordList *word_list = output_dev->makeWordList();
+    TextWordList *word_list = textPage->makeWordList(false);
 
     if (!word_list || (shouldAbortExtractionCallback && shouldAbortExtractionCallback(closure))) {
         delete word_list;
-        delete output_dev;
+        m_page->parentDoc->m_textPageCache.release(key, textPage);
         return output_list;
     }
 
@@ -754,7 +836,7 @@ QList<TextBox *> Page::textList(Rotation rotate, ShouldAbortQueryFunc shouldAbor
     }
 
     delete word_list;
-    delete output_dev;
+    m_page->parentDoc->m_textPageCache.release(key, textPage);
 
     return output_list;
 }
@@ -237,6 +237,9 @@ DocumentData::~DocumentData()
 {
     qDeleteAll(m_embeddedFiles);
     delete (OptContentModel *)m_optContentModel;
+#if defined(HAVE_SPLASH)
+    m_splashOutputDev.reset();
+#endif
     delete doc;
 }
 
@@ -246,6 +249,9 @@ void DocumentData::init()
     paperColor = Qt::white;
     m_hints = 0;
     m_optContentModel = nullptr;
+#if defined(HAVE_SPLASH)
+    m_splashOutputDevHints = 0;
+#endif
 }
 
 void DocumentData::addTocChildren(QDomDocument *docSyn, QDomNode *parent, const std::vector<::OutlineItem *> *items)
@@ -821,6 +821,24 @@ rather unexpected results.
     **/
     QList<QRectF> search(const QString &text, SearchFlags flags = NoSearchFlags, Rotation rotate = Rotate0) const;
 
+    /**
+       Returns the occurrences of several texts on the page.
+
+       All the texts are searched for in a single pass over the text of the page,
+       which is much faster than calling search() for each of them.
+
+       \param texts the texts to search
+       \param flags the flags to consider during matching
+       \param rotate the rotation to apply for the search order
+
+       \returns for each of the texts, the list of all its occurrences
+
+       \warning Do not use the returned QRectF as arguments of another search call because of truncation issues if qreal is defined as float.
+
+       \since 21.03
+    **/
+    QList<QList<QRectF>> search(const QStringList &texts, SearchFlags flags = NoSearchFlags, Rotation rotate = Rotate0) const;
+
     /**
        Returns a list of text of the page
 
@@ -1188,7 +1206,8 @@ public:
         ThinLineSolid = 0x00000020, ///< Enhance thin lines solid \since 0.24
         ThinLineShape = 0x00000040, ///< Enhance thin lines shape. Wins over ThinLineSolid \since 0.24
         IgnorePaperColor = 0x00000080, ///< Do not compose with the paper color \since 0.35
-        HideAnnotations = 0x00000100 ///< Do not render annotations \since 0.60
+        HideAnnotations = 0x00000100, ///< Do not render annotations \since 0.60
+        ProgressiveRendering = 0x00000200 ///< With the Splash backend, first render the large images and the shadings as placeholders, and report that through the partial update callback, before rendering the page completely \since 21.03
     };
     Q_DECLARE_FLAGS(RenderHints, RenderHint)
 
@@ -1785,6 +1804,40 @@ QString subject = m_doc->info("Subject");
      */
     RenderHints renderHints() const;
 
+    /**
+      Releases the fonts, glyph caches and page bitmap that the Splash
+      backend keeps between Page::renderToImage() calls.
+
+      They are built again by the next rendering. Call this to give memory
+      back when the document is not going to be rendered for a while.
+
+      \since 21.03
+     */
+    void clearRenderCache();
+
+    /**
+      Sets the maximum amount of memory, in bytes, used to keep the text
+      of the pages between calls to Page::text(), Page::search() and
+      Page::textList(), so that querying the text of a page again doesn't
+      extract it again.
+
+      When the limit is reached, the text of the least recently used pages
+      is dropped. The default, 0, keeps no text. The text is extracted
+      again once the document is modified, like when a form field or an
+      annotation is edited, added or removed, and once an optional content
+      item is shown or hidden.
+
+      \since 21.03
+     */
+    void setTextCacheSize(qint64 bytes);
+
+    /**
+      The maximum amount of memory, in bytes, used to keep the text of the pages.
+
+      \since 21.03
+     */
+    qint64 textCacheSize() const;
+
     /**
       Gets a new PS converter for this document.
 
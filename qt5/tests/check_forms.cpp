@@ -18,6 +18,7 @@ private slots:
     void testSetAppearanceText();
     void testStandAloneWidgets(); // check for 'de facto' tooltips. Issue #34
     void testUnicodeFieldAttributes();
+    void testTextCacheAfterEdit();
 };
 
 void TestForms::testCheckbox()
@@ -253,5 +254,82 @@ void TestForms::testUnicodeFieldAttributes()
     QCOMPARE(field->uiName(), QStringLiteral("Texto de ayuda"));
 }
 
+// A document with a text field and a free text annotation, whose
+// appearances are generated
+static QByteArray textCacheDocument()
+{
+    const QList<QByteArray> objects = { "<< /Type /Catalog /Pages 2 0 R /AcroForm << /Fields [5 0 R] /DA (/Helv 12 Tf 0 g) /DR << /Font << /Helv 6 0 R >> >> >> >>",
+                                        "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                                        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 6 0 R >> >> /Contents 4 0 R /Annots [5 0 R 7 0 R] >>",
+                                        "<< /Length 38 >>\nstream\nBT /F1 12 Tf 72 720 Td (Content) Tj ET\nendstream",
+                                        "<< /Type /Annot /Subtype /Widget /FT /Tx /T (field) /V (Hello) /Rect [72 600 300 630] /DA (/Helv 12 Tf 0 g) /F 4 /P 3 0 R >>",
+                                        "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+                                        "<< /Type /Annot /Subtype /FreeText /Rect [72 400 300 430] /Contents (Note) /DA (/Helv 12 Tf 0 g) /F 4 /P 3 0 R >>" };
+    QByteArray pdf("%PDF-1.7\n");
+    QList<int> offsets;
+    for (int i = 0; i < objects.size(); ++i) {
+        offsets << pdf.size();
+        pdf += QByteArray::number(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const int xrefOffset = pdf.size();
+    pdf += "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (int offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer\n<< /Size " + QByteArray::number(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    return pdf;
+}
+
+static QStringList words(Poppler::Page *page)
+{
+    QStringList result;
+    const QList<Poppler::TextBox *> boxes = page->textList();
+    for (Poppler::TextBox *box : boxes) {
+        result << box->text();
+    }
+    qDeleteAll(boxes);
+    return result;
+}
+
+void TestForms::testTextCacheAfterEdit()
+{
+    QScopedPointer<Poppler::Document> document(Poppler::Document::loadFromData(textCacheDocument()));
+    QVERIFY(document);
+    document->setTextCacheSize(16 * 1024 * 1024);
+
+    QScopedPointer<Poppler::Page> page(document->page(0));
+    QVERIFY(page);
+
+    QVERIFY(page->text(QRectF()).contains(QStringLiteral("Hello")));
+    QCOMPARE(page->search(QStringLiteral("Hello")).size(), 1);
+    QVERIFY(words(page.data()).contains(QStringLiteral("Hello")));
+    QVERIFY(page->text(QRectF()).contains(QStringLiteral("Note")));
+
+    // the text of the edited field is read again
+    QList<Poppler::FormField *> forms = page->formFields();
+    QCOMPARE(forms.size(), 1);
+    QCOMPARE(forms.at(0)->type(), Poppler::FormField::FormText);
+    static_cast<Poppler::FormFieldText *>(forms.at(0))->setText(QStringLiteral("World"));
+    qDeleteAll(forms);
+
+    QString text = page->text(QRectF());
+    QVERIFY(text.contains(QStringLiteral("World")));
+    QVERIFY(!text.contains(QStringLiteral("Hello")));
+    QCOMPARE(page->search(QStringLiteral("Hello")).size(), 0);
+    QCOMPARE(page->search(QStringLiteral("World")).size(), 1);
+    QVERIFY(words(page.data()).contains(QStringLiteral("World")));
+
+    // and so is the text of the edited annotation
+    QList<Poppler::Annotation *> annotations = page->annotations(QSet<Poppler::Annotation::SubType>() << Poppler::Annotation::AText);
+    QCOMPARE(annotations.size(), 1);
+    annotations.at(0)->setContents(QStringLiteral("Changed"));
+    qDeleteAll(annotations);
+
+    text = page->text(QRectF());
+    QVERIFY(text.contains(QStringLiteral("Changed")));
+    QVERIFY(!text.contains(QStringLiteral("Note")));
+    QCOMPARE(page->search(QStringLiteral("Changed")).size(), 1);
+}
+
 QTEST_GUILESS_MAIN(TestForms)
 #include "check_forms.moc"
@@ -0,0 +1,164 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+#include <QImage>
+
+#include <poppler-qt5.h>
+
+// Unit tests for the Splash output device Document keeps across
+// Page::renderToImage() calls: whatever was rendered before, and from
+// however many threads, the pages render as with a new document.
+class TestRenderCache : public QObject
+{
+    Q_OBJECT
+public:
+    TestRenderCache(QObject *parent = nullptr) : QObject(parent) { }
+private slots:
+    void checkSettings_data();
+    void checkSettings();
+    void checkThreads();
+    void checkClearRenderCache();
+};
+
+static QByteArray streamObject(const QByteArray &data)
+{
+    return "<< /Length " + QByteArray::number(data.size()) + " >>\nstream\n" + data + "\nendstream";
+}
+
+// A document with two pages of different sizes, with text, thin lines and
+// filled shapes.
+static QByteArray pdfData()
+{
+    const QList<QByteArray> objects = { "<< /Type /Catalog /Pages 2 0 R >>",
+                                        "<< /Type /Pages /Kids [3 0 R 4 0 R] /Count 2 >>",
+                                        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 7 0 R >> >> /Contents 5 0 R >>",
+                                        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 300 400] /Resources << /Font << /F1 7 0 R >> >> /Contents 6 0 R >>",
+                                        streamObject("BT /F1 24 Tf 72 700 Td (Render cache) Tj ET 0.2 0.4 0.8 rg 100 100 m 400 200 l 300 500 l h f 0 0 0 RG 0 w 72 650 m 500 600 l S 1 0 0 RG 0.3 w 72 640 m 500 590 l S"),
+                                        streamObject("BT /F1 18 Tf 20 350 Td (Second page) Tj ET 0 0.6 0 rg 20 20 m 280 60 l 150 300 l h f"),
+                                        "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>" };
+    QByteArray pdf("%PDF-1.4\n");
+    QList<int> offsets;
+    for (int i = 0; i < objects.size(); ++i) {
+        offsets << pdf.size();
+        pdf += QByteArray::number(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const int xrefOffset = pdf.size();
+    pdf += "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (int offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer\n<< /Size " + QByteArray::number(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    return pdf;
+}
+
+static std::unique_ptr<Poppler::Document> loadDocument(int hint = 0, const QColor &paperColor = Qt::white)
+{
+    std::unique_ptr<Poppler::Document> doc(Poppler::Document::loadFromData(pdfData()));
+    if (doc) {
+        doc->setRenderBackend(Poppler::Document::SplashBackend);
+        if (hint) {
+            doc->setRenderHint((Poppler::Document::RenderHint)hint, true);
+        }
+        doc->setPaperColor(paperColor);
+    }
+    return doc;
+}
+
+static QImage render(Poppler::Document *doc, int index)
+{
+    std::unique_ptr<Poppler::Page> page(doc->page(index));
+    const double res = index == 0 ? 72 : 100;
+    return page ? page->renderToImage(res, res) : QImage();
+}
+
+void TestRenderCache::checkSettings_data()
+{
+    QTest::addColumn<int>("hint");
+    QTest::addColumn<QColor>("paperColor");
+
+    QTest::newRow("Antialiasing") << (int)Poppler::Document::Antialiasing << QColor(Qt::white);
+    QTest::newRow("TextAntialiasing") << (int)Poppler::Document::TextAntialiasing << QColor(Qt::white);
+    QTest::newRow("TextHinting") << (int)Poppler::Document::TextHinting << QColor(Qt::white);
+    QTest::newRow("ThinLineSolid") << (int)Poppler::Document::ThinLineSolid << QColor(Qt::white);
+    QTest::newRow("OverprintPreview") << (int)Poppler::Document::OverprintPreview << QColor(Qt::white);
+    QTest::newRow("IgnorePaperColor") << (int)Poppler::Document::IgnorePaperColor << QColor(Qt::white);
+    QTest::newRow("paper color") << 0 << QColor(255, 240, 200);
+}
+
+void TestRenderCache::checkSettings()
+{
+    QFETCH(int, hint);
+    QFETCH(QColor, paperColor);
+
+    std::unique_ptr<Poppler::Document> doc = loadDocument();
+    QVERIFY(doc != nullptr);
+    const QImage before = render(doc.get(), 0);
+    QVERIFY(!before.isNull());
+    QCOMPARE(render(doc.get(), 1), render(loadDocument().get(), 1));
+
+    // changing a setting renders as a new document with that setting
+    if (hint) {
+        doc->setRenderHint((Poppler::Document::RenderHint)hint, true);
+    }
+    doc->setPaperColor(paperColor);
+    std::unique_ptr<Poppler::Document> freshDoc = loadDocument(hint, paperColor);
+    QVERIFY(freshDoc != nullptr);
+    QCOMPARE(render(doc.get(), 0), render(freshDoc.get(), 0));
+    QCOMPARE(render(doc.get(), 1), render(freshDoc.get(), 1));
+
+    // and so does changing it back
+    if (hint) {
+        doc->setRenderHint((Poppler::Document::RenderHint)hint, false);
+    }
+    doc->setPaperColor(Qt::white);
+    QCOMPARE(render(doc.get(), 0), before);
+}
+
+void TestRenderCache::checkThreads()
+{
+    std::unique_ptr<Poppler::Document> refDoc = loadDocument();
+    QVERIFY(refDoc != nullptr);
+    const QImage refs[2] = { render(refDoc.get(), 0), render(refDoc.get(), 1) };
+
+    // two threads rendering the pages of one document at once, at
+    // different sizes
+    std::unique_ptr<Poppler::Document> doc = loadDocument();
+    QVERIFY(doc != nullptr);
+    std::atomic<int> mismatches(0);
+    const auto renderPages = [&doc, &refs, &mismatches](int first) {
+        for (int i = 0; i < 20; ++i) {
+            const int index = (first + i) % 2;
+            if (render(doc.get(), index) != refs[index]) {
+                ++mismatches;
+            }
+        }
+    };
+    std::thread thread1(renderPages, 0);
+    std::thread thread2(renderPages, 1);
+    thread1.join();
+    thread2.join();
+    QCOMPARE(mismatches.load(), 0);
+
+    // the device of the document is still usable
+    QCOMPARE(render(doc.get(), 0), refs[0]);
+    QCOMPARE(render(doc.get(), 1), refs[1]);
+}
+
+void TestRenderCache::checkClearRenderCache()
+{
+    std::unique_ptr<Poppler::Document> doc = loadDocument();
+    QVERIFY(doc != nullptr);
+    doc->clearRenderCache();
+    const QImage image = render(doc.get(), 0);
+    QVERIFY(!image.isNull());
+    doc->clearRenderCache();
+    QCOMPARE(render(doc.get(), 0), image);
+    QCOMPARE(render(doc.get(), 0), image);
+}
+
+QTEST_GUILESS_MAIN(TestRenderCache)
+
+#include "check_render_cache.moc"
@@ -14,6 +14,7 @@ private slots:
     void testIgnoreDiacritics();
     void testRussianSearch(); // Issue #743
     void testDeseretSearch(); // Issue #853
+    void testSearchMultipleTexts();
 };
 
 void TestSearch::bug7063()
@@ -279,5 +280,22 @@ void TestSearch::testDeseretSearch()
     QCOMPARE(page->search(str2, l, t, r, b, Poppler::Page::FromTop, Poppler::Page::IgnoreCase), true);
 }
 
+void TestSearch::testSearchMultipleTexts()
+{
+    QScopedPointer<Poppler::Document> document(Poppler::Document::load(TESTDATADIR "/unittestcases/xr01.pdf"));
+    QVERIFY(document);
+
+    QScopedPointer<Poppler::Page> page(document->page(0));
+    QVERIFY(page);
+
+    const QStringList texts { QStringLiteral(u"is"), QStringLiteral(u"This"), QStringLiteral(u"xyzzy") };
+    const QList<QList<QRectF>> results = page->search(texts, Poppler::Page::IgnoreCase);
+    QCOMPARE(results.size(), texts.size());
+    for (int i = 0; i < texts.size(); ++i) {
+        QCOMPARE(results[i], page->search(texts[i], Poppler::Page::IgnoreCase));
+    }
+    QVERIFY(results[2].isEmpty());
+}
+
 QTEST_GUILESS_MAIN(TestSearch)
 #include "check_search.moc"
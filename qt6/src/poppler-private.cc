@@ -180,6 +180,9 @@ DocumentData::~DocumentData()
 {
     qDeleteAll(m_embeddedFiles);
     delete (OptContentModel *)m_optContentModel;
+#if defined(HAVE_SPLASH)
+    m_splashOutputDev.reset();
+#endif
     delete doc;
 }
 
@@ -189,6 +192,9 @@ void DocumentData::init()
     paperColor = Qt::white;
     m_hints = 0;
     m_optContentModel = nullptr;
+#if defined(HAVE_SPLASH)
+    m_splashOutputDevHints = 0;
+#endif
 }
 
 FormWidget *FormFieldData::getFormWidget(const FormField *f)
@@ -45,12 +45,15 @@
 #include <QtCore/QPointer>
 #include <QtCore/QVector>
 
+#include <memory>
+
 #include <config.h>
 #include <poppler-config.h>
 #include <GfxState.h>
 #include <GlobalParams.h>
 #include <Form.h>
 #include <PDFDoc.h>
+#include <TextPageCache.h>
 #include <FontInfo.h>
 #include <OutputDev.h>
 #include <Error.h>
@@ -170,10 +173,17 @@ public:
     QPointer<OptContentModel> m_optContentModel;
     QColor paperColor;
     int m_hints;
+    TextPageCache m_textPageCache;
 #ifdef USE_CMS
     GfxLCMSProfilePtr m_sRGBProfile;
     GfxLCMSProfilePtr m_displayProfile;
 #endif
+#if defined(HAVE_SPLASH)
+    std::unique_ptr<SplashOutputDev> m_splashOutputDev; // kept across Page::renderToImage() calls
+    int m_splashOutputDevHints; // m_hints m_splashOutputDev was created with
+    QColor m_splashOutputDevPaperColor; // paperColor m_splashOutputDev was created with
+    QMutex m_splashOutputDevMutex;
+#endif
 };
 
 class FontInfoData
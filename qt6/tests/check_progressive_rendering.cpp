@@ -0,0 +1,166 @@
+#include <memory>
+
+#include <QtTest/QtTest>
+#include <QtCore/QDebug>
+#include <QImage>
+
+#include <poppler-qt6.h>
+
+// Unit tests for the ProgressiveRendering hint: the image returned is the
+// one rendered without the hint, and the partial update callback gets a
+// draft of the page only when large images or shadings were drawn as
+// placeholders.
+class TestProgressiveRendering : public QObject
+{
+    Q_OBJECT
+public:
+    TestProgressiveRendering(QObject *parent = nullptr) : QObject(parent) { }
+private slots:
+    void checkRendering_data();
+    void checkRendering();
+    void checkAbort();
+};
+
+static QByteArray streamObject(const QByteArray &entries, const QByteArray &data)
+{
+    return "<< " + entries + " /Length " + QByteArray::number(data.size()) + " >>\nstream\n" + data + "\nendstream";
+}
+
+// A document whose first page has text, a large image and a shading, and
+// whose second page has text and a small image.
+static QByteArray pdfData()
+{
+    QByteArray large, small;
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 300; ++x) {
+            large += (char)(x ^ y);
+        }
+    }
+    for (int i = 0; i < 16 * 16; ++i) {
+        small += (char)(i * 16);
+    }
+    const QByteArray resources = "/Resources << /Font << /F1 4 0 R >> /XObject << /Im1 7 0 R /Im2 8 0 R >> /Shading << /Sh0 << /ShadingType 2 /ColorSpace /DeviceRGB /Coords [100 0 500 0] /Function << /FunctionType 2 /Domain [0 1] /C0 [1 0 0] /C1 [0 0 1] /N 1 >> >> >> >>";
+    const QList<QByteArray> objects = { "<< /Type /Catalog /Pages 2 0 R >>",
+                                        "<< /Type /Pages /Kids [3 0 R 5 0 R] /Count 2 >>",
+                                        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] " + resources + " /Contents 6 0 R >>",
+                                        "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+                                        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] " + resources + " /Contents 9 0 R >>",
+                                        streamObject("", "BT /F1 24 Tf 72 720 Td (Progressive) Tj ET q 300 0 0 300 72 350 cm /Im1 Do Q q 100 100 400 150 re W n /Sh0 sh Q 0 0.5 0 rg 72 50 400 30 re f"),
+                                        streamObject("/Type /XObject /Subtype /Image /Width 300 /Height 300 /ColorSpace /DeviceGray /BitsPerComponent 8", large),
+                                        streamObject("/Type /XObject /Subtype /Image /Width 16 /Height 16 /ColorSpace /DeviceGray /BitsPerComponent 8", small),
+                                        streamObject("", "BT /F1 24 Tf 72 720 Td (Text only) Tj ET q 64 0 0 64 72 500 cm /Im2 Do Q") };
+    QByteArray pdf("%PDF-1.4\n");
+    QList<int> offsets;
+    for (int i = 0; i < objects.size(); ++i) {
+        offsets << pdf.size();
+        pdf += QByteArray::number(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const int xrefOffset = pdf.size();
+    pdf += "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (int offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer\n<< /Size " + QByteArray::number(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    return pdf;
+}
+
+static std::unique_ptr<Poppler::Document> loadDocument(int hint)
+{
+    std::unique_ptr<Poppler::Document> doc(Poppler::Document::loadFromData(pdfData()));
+    if (doc) {
+        doc->setRenderBackend(Poppler::Document::SplashBackend);
+        if (hint) {
+            doc->setRenderHint((Poppler::Document::RenderHint)hint, true);
+        }
+    }
+    return doc;
+}
+
+static int partialUpdates = 0;
+static QImage partialImage;
+
+static void partialUpdate(const QImage &image, const QVariant & /*closure*/)
+{
+    ++partialUpdates;
+    partialImage = image.copy();
+}
+
+// the draft is only passed to partialUpdate(), not dumped while rendering
+static bool shouldDoPartialUpdate(const QVariant & /*closure*/)
+{
+    return false;
+}
+
+static bool shouldAbort(const QVariant &closure)
+{
+    return closure.toBool();
+}
+
+static QImage render(Poppler::Document *doc, int index, bool abort = false)
+{
+    std::unique_ptr<Poppler::Page> page(doc->page(index));
+    return page ? page->renderToImage(72, 72, -1, -1, -1, -1, Poppler::Page::Rotate0, partialUpdate, shouldDoPartialUpdate, shouldAbort, QVariant(abort)) : QImage();
+}
+
+void TestProgressiveRendering::checkRendering_data()
+{
+    QTest::addColumn<int>("hint");
+
+    QTest::newRow("default") << 0;
+    QTest::newRow("Antialiasing") << (int)Poppler::Document::Antialiasing;
+    QTest::newRow("OverprintPreview") << (int)Poppler::Document::OverprintPreview;
+    QTest::newRow("IgnorePaperColor") << (int)Poppler::Document::IgnorePaperColor;
+}
+
+void TestProgressiveRendering::checkRendering()
+{
+    QFETCH(int, hint);
+
+    std::unique_ptr<Poppler::Document> refDoc = loadDocument(hint);
+    QVERIFY(refDoc != nullptr);
+    const QImage refs[2] = { render(refDoc.get(), 0), render(refDoc.get(), 1) };
+    QVERIFY(!refs[0].isNull());
+    QVERIFY(!refs[1].isNull());
+
+    std::unique_ptr<Poppler::Document> doc = loadDocument(hint);
+    QVERIFY(doc != nullptr);
+    doc->setRenderHint(Poppler::Document::ProgressiveRendering, true);
+
+    // twice, to render with the device of the previous page
+    for (int pass = 0; pass < 2; ++pass) {
+        partialUpdates = 0;
+        QCOMPARE(render(doc.get(), 0), refs[0]);
+        QCOMPARE(partialUpdates, 1);
+        QCOMPARE(partialImage.size(), refs[0].size());
+        QVERIFY(partialImage != refs[0]);
+
+        partialUpdates = 0;
+        QCOMPARE(render(doc.get(), 1), refs[1]);
+        QCOMPARE(partialUpdates, 0);
+    }
+
+    // and without the hint again
+    doc->setRenderHint(Poppler::Document::ProgressiveRendering, false);
+    partialUpdates = 0;
+    QCOMPARE(render(doc.get(), 0), refs[0]);
+    QCOMPARE(partialUpdates, 0);
+}
+
+void TestProgressiveRendering::checkAbort()
+{
+    std::unique_ptr<Poppler::Document> doc = loadDocument(Poppler::Document::ProgressiveRendering);
+    QVERIFY(doc != nullptr);
+    partialUpdates = 0;
+    render(doc.get(), 0, true);
+    QCOMPARE(partialUpdates, 0);
+
+    // the document still renders completely
+    std::unique_ptr<Poppler::Document> refDoc = loadDocument(0);
+    QVERIFY(refDoc != nullptr);
+    QCOMPARE(render(doc.get(), 0), render(refDoc.get(), 0));
+    QCOMPARE(partialUpdates, 1);
+}
+
+QTEST_GUILESS_MAIN(TestProgressiveRendering)
+
+#include "check_progressive_rendering.moc"
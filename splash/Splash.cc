@@ -1262,6 +1262,42 @@ inline void Splash::pipeIncX(SplashPipe *pipe)
     }
 }
 
+inline void Splash::updateModX(int x)
+{
+    if (x < modXMin) {
+        modXMin = x;
+    }
+    if (x > modXMax) {
+        modXMax = x;
+    }
+}
+
+inline void Splash::updateModY(int y)
+{
+    if (y < modYMin) {
+        modYMin = y;
+    }
+    if (y > modYMax) {
+        modYMax = y;
+    }
+}
+
+// Add the rectangle (<xMin>, <yMin>) - (<xMax>, <yMax>) to the modified
+// region.
+inline void Splash::updateModRegion(int xMin, int yMin, int xMax, int yMax)
+{
+    xMin = std::max(xMin, 0);
+    yMin = std::max(yMin, 0);
+    xMax = std::min(xMax, bitmap->width - 1);
+    yMax = std::min(yMax, bitmap->height - 1);
+    if (xMin <= xMax && yMin <= yMax) {
+        updateModX(xMin);
+        updateModX(xMax);
+        updateModY(yMin);
+        updateModY(yMax);
+    }
+}
+
 inline void Splash::drawPixel(SplashPipe *pipe, int x, int y, bool noClip)
 {
     if (unlikely(y < 0))
@@ -1270,6 +1306,8 @@ inline void Splash::drawPixel(SplashPipe *pipe, int x, int y, bool noClip)
     if (noClip || state->clip->test(x, y)) {
         pipeSetXY(pipe, x, y);
         (this->*pipe->run)(pipe);
+        updateModX(x);
+        updateModY(y);
     }
 }
 
@@ -1326,6 +1364,8 @@ inline void Splash::drawAAPixel(SplashPipe *pipe, int x, int y)
         pipeSetXY(pipe, x, y);
         pipe->shape = div255(aaGamma[t] * pipe->shape);
         (this->*pipe->run)(pipe);
+        updateModX(x);
+        updateModY(y);
     }
 }
 
@@ -1334,6 +1374,7 @@ inline void Splash::drawSpan(SplashPipe *pipe, int x0, int x1, int y, bool noCli
     int x;
 
     if (noClip) {
+        updateModRegion(x0, y, x1, y);
         pipeSetXY(pipe, x0, y);
         for (x = x0; x <= x1; ++x) {
             (this->*pipe->run)(pipe);
@@ -1345,6 +1386,7 @@ inline void Splash::drawSpan(SplashPipe *pipe, int x0, int x1, int y, bool noCli
         if (x1 > state->clip->getXMaxI()) {
             x1 = state->clip->getXMaxI();
         }
+        updateModRegion(x0, y, x1, y);
         pipeSetXY(pipe, x0, y);
         for (x = x0; x <= x1; ++x) {
             if (state->clip->test(x, y)) {
@@ -1374,6 +1416,7 @@ inline void Splash::drawAALine(SplashPipe *pipe, int x0, int x1, int y, bool adj
     p2 = p1 + aaBuf->getRowSize();
     p3 = p2 + aaBuf->getRowSize();
 #endif
+    updateModRegion(x0, y, x1, y);
     pipeSetXY(pipe, x0, y);
     for (x = x0; x <= x1; ++x) {
 
@@ -1441,8 +1484,12 @@ Splash::Splash(SplashBitmap *bitmapA, bool vectorAntialiasA, SplashScreenParams
     }
     minLineWidth = 0;
     thinLineMode = splashThinLineDefault;
+    imageInterpolation = true;
+    abortCheckCbk = nullptr;
+    abortCheckCbkData = nullptr;
     debugMode = false;
     alpha0Bitmap = nullptr;
+    clearModRegion();
 }
 
 Splash::Splash(SplashBitmap *bitmapA, bool vectorAntialiasA, SplashScreen *screenA)
@@ -1463,8 +1510,12 @@ Splash::Splash(SplashBitmap *bitmapA, bool vectorAntialiasA, SplashScreen *scree
     }
     minLineWidth = 0;
     thinLineMode = splashThinLineDefault;
+    imageInterpolation = true;
+    abortCheckCbk = nullptr;
+    abortCheckCbkData = nullptr;
     debugMode = false;
     alpha0Bitmap = nullptr;
+    clearModRegion();
 }
 
 Splash::~Splash()
@@ -1871,6 +1922,16 @@ void Splash::clear(SplashColorPtr color, unsigned char alpha)
     if (bitmap->alpha) {
         memset(bitmap->alpha, alpha, bitmap->width * bitmap->height);
     }
+
+    updateModRegion(0, 0, bitmap->width - 1, bitmap->height - 1);
+}
+
+void Splash::clearModRegion()
+{
+    modXMin = bitmap->width;
+    modYMin = bitmap->height;
+    modXMax = -1;
+    modYMax = -1;
 }
 
 SplashError Splash::stroke(SplashPath *path)
@@ -2033,12 +2094,10 @@ void Splash::strokeWide(SplashPath *path, SplashCoord w)
 SplashPath *Splash::flattenPath(SplashPath *path, SplashCoord *matrix, SplashCoord flatness)
 {
     SplashPath *fPath;
-    SplashCoord flatness2;
     unsigned char flag;
     int i;
 
     fPath = new SplashPath();
-    flatness2 = flatness * flatness;
     i = 0;
     while (i < path->length) {
         flag = path->flags[i];
@@ -2047,7 +2106,7 @@ SplashPath *Splash::flattenPath(SplashPath *path, SplashCoord *matrix, SplashCoo
             ++i;
         } else {
             if (flag & splashPathCurve) {
-                flattenCurve(path->pts[i - 1].x, path->pts[i - 1].y, path->pts[i].x, path->pts[i].y, path->pts[i + 1].x, path->pts[i + 1].y, path->pts[i + 2].x, path->pts[i + 2].y, matrix, flatness2, fPath);
+                flattenCurve(path->pts[i - 1].x, path->pts[i - 1].y, path->pts[i].x, path->pts[i].y, path->pts[i + 1].x, path->pts[i + 1].y, path->pts[i + 2].x, path->pts[i + 2].y, matrix, flatness, fPath);
                 i += 3;
             } else {
                 fPath->lineTo(path->pts[i].x, path->pts[i].y);
@@ -2061,92 +2120,36 @@ SplashPath *Splash::flattenPath(SplashPath *path, SplashCoord *matrix, SplashCoo
     return fPath;
 }
 
-void Splash::flattenCurve(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1, SplashCoord x2, SplashCoord y2, SplashCoord x3, SplashCoord y3, SplashCoord *matrix, SplashCoord flatness2, SplashPath *fPath)
-{
-    SplashCoord cx[splashMaxCurveSplits + 1][3];
-    SplashCoord cy[splashMaxCurveSplits + 1][3];
-    int cNext[splashMaxCurveSplits + 1];
-    SplashCoord xl0, xl1, xl2, xr0, xr1, xr2, xr3, xx1, xx2, xh;
-    SplashCoord yl0, yl1, yl2, yr0, yr1, yr2, yr3, yy1, yy2, yh;
-    SplashCoord dx, dy, mx, my, tx, ty, d1, d2;
-    int p1, p2, p3;
-
-    // initial segment
-    p1 = 0;
-    p2 = splashMaxCurveSplits;
-    cx[p1][0] = x0;
-    cy[p1][0] = y0;
-    cx[p1][1] = x1;
-    cy[p1][1] = y1;
-    cx[p1][2] = x2;
-    cy[p1][2] = y2;
-    cx[p2][0] = x3;
-    cy[p2][0] = y3;
-    cNext[p1] = p2;
-
-    while (p1 < splashMaxCurveSplits) {
-
-        // get the next segment
-        xl0 = cx[p1][0];
-        yl0 = cy[p1][0];
-        xx1 = cx[p1][1];
-        yy1 = cy[p1][1];
-        xx2 = cx[p1][2];
-        yy2 = cy[p1][2];
-        p2 = cNext[p1];
-        xr3 = cx[p2][0];
-        yr3 = cy[p2][0];
-
-        // compute the distances (in device space) from the control points
-        // to the midpoint of the straight line (this is a bit of a hack,
-        // but it's much faster than computing the actual distances to the
-        // line)
-        transform(matrix, (xl0 + xr3) * 0.5, (yl0 + yr3) * 0.5, &mx, &my);
-        transform(matrix, xx1, yy1, &tx, &ty);
-        dx = tx - mx;
-        dy = ty - my;
-        d1 = dx * dx + dy * dy;
-        transform(matrix, xx2, yy2, &tx, &ty);
-        dx = tx - mx;
-        dy = ty - my;
-        d2 = dx * dx + dy * dy;
-
-        // if the curve is flat enough, or no more subdivisions are
-        // allowed, add the straight line segment
-        if (p2 - p1 == 1 || (d1 <= flatness2 && d2 <= flatness2)) {
-            fPath->lineTo(xr3, yr3);
-            p1 = p2;
-
-            // otherwise, subdivide the curve
-        } else {
-            xl1 = splashAvg(xl0, xx1);
-            yl1 = splashAvg(yl0, yy1);
-            xh = splashAvg(xx1, xx2);
-            yh = splashAvg(yy1, yy2);
-            xl2 = splashAvg(xl1, xh);
-            yl2 = splashAvg(yl1, yh);
-            xr2 = splashAvg(xx2, xr3);
-            yr2 = splashAvg(yy2, yr3);
-            xr1 = splashAvg(xh, xr2);
-            yr1 = splashAvg(yh, yr2);
-            xr0 = splashAvg(xl2, xr1);
-            yr0 = splashAvg(yl2, yr1);
-            // add the new subdivision points
-            p3 = (p1 + p2) / 2;
-            cx[p1][1] = xl1;
-            cy[p1][1] = yl1;
-            cx[p1][2] = xl2;
-            cy[p1][2] = yl2;
-            cNext[p1] = p3;
-            cx[p3][0] = xr0;
-            cy[p3][0] = yr0;
-            cx[p3][1] = xr1;
-            cy[p3][1] = yr1;
-            cx[p3][2] = xr2;
-            cy[p3][2] = yr2;
-            cNext[p3] = p2;
-        }
+void Splash::flattenCurve(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1, SplashCoord x2, SplashCoord y2, SplashCoord x3, SplashCoord y3, SplashCoord *matrix, SplashCoord flatness, SplashPath *fPath)
+{
+    // the number of segments is set by the curvature in device space
+    const SplashCoord d1x = x0 - 2 * x1 + x2, d1y = y0 - 2 * y1 + y2;
+    const SplashCoord d2x = x1 - 2 * x2 + x3, d2y = y1 - 2 * y2 + y3;
+    const int n = splashCurveSplits(d1x * matrix[0] + d1y * matrix[2], d1x * matrix[1] + d1y * matrix[3], d2x * matrix[0] + d2y * matrix[2], d2x * matrix[1] + d2y * matrix[3], flatness);
+
+    // p(t) = a t^3 + b t^2 + c t + p0, evaluated by forward differencing
+    const SplashCoord h = (SplashCoord)1 / n;
+    const SplashCoord ax = x3 - x0 + 3 * (x1 - x2), ay = y3 - y0 + 3 * (y1 - y2);
+    const SplashCoord bx = 3 * d1x, by = 3 * d1y;
+    const SplashCoord cx = 3 * (x1 - x0), cy = 3 * (y1 - y0);
+    SplashCoord dx = ((ax * h + bx) * h + cx) * h;
+    SplashCoord dy = ((ay * h + by) * h + cy) * h;
+    SplashCoord ddx = (6 * ax * h + 2 * bx) * h * h;
+    SplashCoord ddy = (6 * ay * h + 2 * by) * h * h;
+    const SplashCoord dddx = 6 * ax * h * h * h;
+    const SplashCoord dddy = 6 * ay * h * h * h;
+
+    SplashCoord x = x0, y = y0;
+    for (int i = 1; i < n; ++i) {
+        x += dx;
+        y += dy;
+        fPath->lineTo(x, y);
+        dx += ddx;
+        dy += ddy;
+        ddx += dddx;
+        ddy += dddy;
     }
+    fPath->lineTo(x3, y3);
 }
 
 SplashPath *Splash::makeDashedPath(SplashPath *path)
@@ -2637,6 +2640,7 @@ void Splash::fillGlyph2(int x0, int y0, SplashGlyphBitmap *glyph, bool noClip)
         xxLimit = bitmap->width - xStart;
     if (yyLimit + yStart >= bitmap->height)
         yyLimit = bitmap->height - yStart;
+    updateModRegion(xStart, yStart, xStart + xxLimit - 1, yStart + yyLimit - 1);
 
     if (noClip) {
         if (glyph->aa) {
@@ -2721,7 +2725,7 @@ void Splash::fillGlyph2(int x0, int y0, SplashGlyphBitmap *glyph, bool noClip)
     }
 }
 
-SplashError Splash::fillImageMask(SplashImageMaskSource src, void *srcData, int w, int h, SplashCoord *mat, bool glyphMode)
+SplashError Splash::fillImageMask(SplashImageMaskSource src, void *srcData, int w, int h, SplashCoord *mat, bool glyphMode, SplashImageBitsSource bitsSrc)
 {
     SplashBitmap *scaledMask;
     SplashClipResult clipRes;
@@ -2765,7 +2769,7 @@ SplashError Splash::fillImageMask(SplashImageMaskSource src, void *srcData, int
             if (yp < 0 || yp > INT_MAX - 1) {
                 return splashErrBadArg;
             }
-            scaledMask = scaleMask(src, srcData, w, h, scaledWidth, scaledHeight);
+            scaledMask = scaleMask(src, srcData, w, h, scaledWidth, scaledHeight, bitsSrc);
             blitMask(scaledMask, x0, y0, clipRes);
             delete scaledMask;
         }
@@ -2792,7 +2796,7 @@ SplashError Splash::fillImageMask(SplashImageMaskSource src, void *srcData, int
             if (yp < 0 || yp > INT_MAX - 1) {
                 return splashErrBadArg;
             }
-            scaledMask = scaleMask(src, srcData, w, h, scaledWidth, scaledHeight);
+            scaledMask = scaleMask(src, srcData, w, h, scaledWidth, scaledHeight, bitsSrc);
             vertFlipImage(scaledMask, scaledWidth, scaledHeight, 1);
             blitMask(scaledMask, x0, y0, clipRes);
             delete scaledMask;
@@ -2800,13 +2804,13 @@ SplashError Splash::fillImageMask(SplashImageMaskSource src, void *srcData, int
 
         // all other cases
     } else {
-        arbitraryTransformMask(src, srcData, w, h, mat, glyphMode);
+        arbitraryTransformMask(src, srcData, w, h, mat, glyphMode, bitsSrc);
     }
 
     return splashOk;
 }
 
-void Splash::arbitraryTransformMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, SplashCoord *mat, bool glyphMode)
+void Splash::arbitraryTransformMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, SplashCoord *mat, bool glyphMode, SplashImageBitsSource bitsSrc)
 {
     SplashBitmap *scaledMask;
     SplashClipResult clipRes, clipRes2;
@@ -2912,7 +2916,7 @@ void Splash::arbitraryTransformMask(SplashImageMaskSource src, void *srcData, in
     ir11 = r00 / det;
 
     // scale the input image
-    scaledMask = scaleMask(src, srcData, srcWidth, srcHeight, scaledWidth, scaledHeight);
+    scaledMask = scaleMask(src, srcData, srcWidth, srcHeight, scaledWidth, scaledHeight, bitsSrc);
     if (scaledMask->data == nullptr) {
         error(errInternal, -1, "scaledMask->data is NULL in Splash::arbitraryTransformMask");
         delete scaledMask;
@@ -3069,13 +3073,15 @@ void Splash::arbitraryTransformMask(SplashImageMaskSource src, void *srcData, in
 }
 
 // Scale an image mask into a SplashBitmap.
-SplashBitmap *Splash::scaleMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight)
+SplashBitmap *Splash::scaleMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashImageBitsSource bitsSrc)
 {
     SplashBitmap *dest;
 
     dest = new SplashBitmap(scaledWidth, scaledHeight, 1, splashModeMono8, false);
     if (scaledHeight < srcHeight) {
-        if (scaledWidth < srcWidth) {
+        if (scaledWidth < srcWidth && bitsSrc) {
+            scaleMaskYdownXdownBits(bitsSrc, srcData, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
+        } else if (scaledWidth < srcWidth) {
             scaleMaskYdownXdown(src, srcData, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
         } else {
             scaleMaskYdownXup(src, srcData, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
@@ -3174,6 +3180,133 @@ void Splash::scaleMaskYdownXdown(SplashImageMaskSource src, void *srcData, int s
     gfree(lineBuf);
 }
 
+// Count the 1 bits in <x>.
+static inline unsigned int countOneBits(unsigned long long x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Compute the source columns [xs[x], xs[x+1]) averaged into each
+// destination column x, stepping like the x scale Bresenham of the
+// scale*YdownXdown functions.  Returns a scaledWidth + 1 array.
+static int *getBoxFilterSpans(int srcWidth, int scaledWidth)
+{
+    int *xs = (int *)gmallocn_checkoverflow(scaledWidth + 1, sizeof(int));
+    if (unlikely(!xs)) {
+        return nullptr;
+    }
+    const int xp = srcWidth / scaledWidth;
+    const int xq = srcWidth % scaledWidth;
+    int xt = 0;
+    xs[0] = 0;
+    for (int x = 0; x < scaledWidth; ++x) {
+        if ((xt += xq) >= scaledWidth) {
+            xt -= scaledWidth;
+            xs[x + 1] = xs[x] + xp + 1;
+        } else {
+            xs[x + 1] = xs[x] + xp;
+        }
+    }
+    return xs;
+}
+
+// Add to counts[x] the number of 1 bits in columns [xs[x], xs[x+1]) of
+// the packed line <bits>, for each of the <n> destination columns.
+// The line must be followed by 8 bytes of padding.
+static void countBitsInSpans(const unsigned char *bits, const int *xs, int n, unsigned int *counts)
+{
+    for (int i = 0; i < n; ++i) {
+        const int x1 = xs[i + 1];
+        unsigned int count = 0;
+        for (int x = xs[i]; x < x1;) {
+            const unsigned char *p = bits + (x >> 3);
+            unsigned long long w = ((unsigned long long)p[0] << 56) | ((unsigned long long)p[1] << 48) | ((unsigned long long)p[2] << 40) | ((unsigned long long)p[3] << 32) | ((unsigned long long)p[4] << 24)
+                    | ((unsigned long long)p[5] << 16) | ((unsigned long long)p[6] << 8) | (unsigned long long)p[7];
+            // at least 57 valid pixels remain after dropping the
+            // leading ones
+            const int k = std::min(x1 - x, 57);
+            count += countOneBits((w << (x & 7)) >> (64 - k));
+            x += k;
+        }
+        counts[i] += count;
+    }
+}
+
+// Same as scaleMaskYdownXdown, for a mask read as packed bits: the
+// pixels under each destination pixel are counted a word at a time
+// instead of being expanded to bytes and summed.
+void Splash::scaleMaskYdownXdownBits(SplashImageBitsSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest)
+{
+    unsigned char *lineBuf;
+    unsigned int *countBuf;
+    unsigned char *destPtr;
+    int *xs;
+    int yp, yq, xp, yt, y, yStep, x, d0, d1;
+    int i;
+
+    // Bresenham parameters for y scale
+    yp = srcHeight / scaledHeight;
+    yq = srcHeight % scaledHeight;
+
+    xp = srcWidth / scaledWidth;
+
+    // allocate buffers
+    const int lineSize = (srcWidth >> 3) + ((srcWidth & 7) ? 1 : 0);
+    lineBuf = (unsigned char *)gmalloc(lineSize + 8);
+    memset(lineBuf, 0, lineSize + 8);
+    countBuf = (unsigned int *)gmallocn_checkoverflow(scaledWidth, sizeof(unsigned int));
+    xs = getBoxFilterSpans(srcWidth, scaledWidth);
+    if (unlikely(!countBuf || !xs)) {
+        error(errInternal, -1, "Couldn't allocate memory in Splash::scaleMaskYdownXdownBits");
+        gfree(xs);
+        gfree(countBuf);
+        gfree(lineBuf);
+        return;
+    }
+
+    // init y scale Bresenham
+    yt = 0;
+
+    destPtr = dest->data;
+    for (y = 0; y < scaledHeight; ++y) {
+
+        // y scale Bresenham
+        if ((yt += yq) >= scaledHeight) {
+            yt -= scaledHeight;
+            yStep = yp + 1;
+        } else {
+            yStep = yp;
+        }
+
+        // read rows from image
+        memset(countBuf, 0, scaledWidth * sizeof(unsigned int));
+        for (i = 0; i < yStep; ++i) {
+            (*src)(srcData, lineBuf);
+            countBitsInSpans(lineBuf, xs, scaledWidth, countBuf);
+        }
+
+        d0 = (255 << 23) / (yStep * xp);
+        d1 = (255 << 23) / (yStep * (xp + 1));
+
+        for (x = 0; x < scaledWidth; ++x) {
+            // (255 * pix) / xStep * yStep
+            const unsigned int d = xs[x + 1] - xs[x] == xp ? d0 : d1;
+            *destPtr++ = (unsigned char)((countBuf[x] * d) >> 23);
+        }
+    }
+
+    gfree(xs);
+    gfree(countBuf);
+    gfree(lineBuf);
+}
+
 void Splash::scaleMaskYdownXup(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest)
 {
     unsigned char *lineBuf;
@@ -3438,6 +3571,7 @@ void Splash::blitMask(SplashBitmap *src, int xDest, int yDest, SplashClipResult
         }
     } else {
         pipeInit(&pipe, xDest, yDest, state->fillPattern, nullptr, (unsigned char)splashRound(state->fillAlpha * 255), true, false);
+        updateModRegion(xDest, yDest, xDest + w - 1, yDest + h - 1);
         if (clipRes == splashClipAllInside) {
             for (y = 0; y < h; ++y) {
                 pipeSetXY(&pipe, xDest, yDest + y);
@@ -3468,7 +3602,8 @@ void Splash::blitMask(SplashBitmap *src, int xDest, int yDest, SplashClipResult
     }
 }
 
-SplashError Splash::drawImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, bool srcAlpha, int w, int h, SplashCoord *mat, bool interpolate, bool tilingPattern)
+SplashError Splash::drawImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, bool srcAlpha, int w, int h, SplashCoord *mat, bool interpolate, bool tilingPattern, SplashImageBitsSource bitsSrc,
+                              SplashColorConstPtr bitColors)
 {
     bool ok;
     SplashBitmap *scaledImg;
@@ -3548,7 +3683,7 @@ SplashError Splash::drawImage(SplashImageSource src, SplashICCTransform tf, void
             if (yp < 0 || yp > INT_MAX - 1) {
                 return splashErrBadArg;
             }
-            scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, w, h, scaledWidth, scaledHeight, interpolate, tilingPattern);
+            scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, w, h, scaledWidth, scaledHeight, interpolate, tilingPattern, bitsSrc, bitColors);
             if (scaledImg == nullptr) {
                 return splashErrBadArg;
             }
@@ -3588,7 +3723,7 @@ SplashError Splash::drawImage(SplashImageSource src, SplashICCTransform tf, void
             if (yp < 0 || yp > INT_MAX - 1) {
                 return splashErrBadArg;
             }
-            scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, w, h, scaledWidth, scaledHeight, interpolate, tilingPattern);
+            scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, w, h, scaledWidth, scaledHeight, interpolate, tilingPattern, bitsSrc, bitColors);
             if (scaledImg == nullptr) {
                 return splashErrBadArg;
             }
@@ -3602,14 +3737,14 @@ SplashError Splash::drawImage(SplashImageSource src, SplashICCTransform tf, void
 
         // all other cases
     } else {
-        return arbitraryTransformImage(src, tf, srcData, srcMode, nComps, srcAlpha, w, h, mat, interpolate, tilingPattern);
+        return arbitraryTransformImage(src, tf, srcData, srcMode, nComps, srcAlpha, w, h, mat, interpolate, tilingPattern, bitsSrc, bitColors);
     }
 
     return splashOk;
 }
 
 SplashError Splash::arbitraryTransformImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, SplashCoord *mat, bool interpolate,
-                                            bool tilingPattern)
+                                            bool tilingPattern, SplashImageBitsSource bitsSrc, SplashColorConstPtr bitColors)
 {
     SplashBitmap *scaledImg;
     SplashClipResult clipRes, clipRes2;
@@ -3741,7 +3876,7 @@ SplashError Splash::arbitraryTransformImage(SplashImageSource src, SplashICCTran
     if (yp < 0 || yp > INT_MAX - 1) {
         return splashErrBadArg;
     }
-    scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, interpolate);
+    scaledImg = scaleImage(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, interpolate, false, bitsSrc, bitColors);
 
     if (scaledImg == nullptr) {
         return splashErrBadArg;
@@ -3924,7 +4059,8 @@ static bool isImageInterpolationRequired(int srcWidth, int srcHeight, int scaled
 }
 
 // Scale an image into a SplashBitmap.
-SplashBitmap *Splash::scaleImage(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, bool interpolate, bool tilingPattern)
+SplashBitmap *Splash::scaleImage(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, bool interpolate, bool tilingPattern,
+                                 SplashImageBitsSource bitsSrc, SplashColorConstPtr bitColors)
 {
     SplashBitmap *dest;
 
@@ -3932,7 +4068,9 @@ SplashBitmap *Splash::scaleImage(SplashImageSource src, void *srcData, SplashCol
     if (dest->getDataPtr() != nullptr && srcHeight > 0 && srcWidth > 0) {
         bool success = true;
         if (scaledHeight < srcHeight) {
-            if (scaledWidth < srcWidth) {
+            if (scaledWidth < srcWidth && bitsSrc && !srcAlpha) {
+                success = scaleImageYdownXdownBits(bitsSrc, bitColors, srcData, srcMode, nComps, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
+            } else if (scaledWidth < srcWidth) {
                 success = scaleImageYdownXdown(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
             } else {
                 success = scaleImageYdownXup(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
@@ -3941,7 +4079,7 @@ SplashBitmap *Splash::scaleImage(SplashImageSource src, void *srcData, SplashCol
             if (scaledWidth < srcWidth) {
                 success = scaleImageYupXdown(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
             } else {
-                if (!tilingPattern && isImageInterpolationRequired(srcWidth, srcHeight, scaledWidth, scaledHeight, interpolate)) {
+                if (!tilingPattern && imageInterpolation && isImageInterpolationRequired(srcWidth, srcHeight, scaledWidth, scaledHeight, interpolate)) {
                     success = scaleImageYupXupBilinear(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
                 } else {
                     success = scaleImageYupXup(src, srcData, srcMode, nComps, srcAlpha, srcWidth, srcHeight, scaledWidth, scaledHeight, dest);
@@ -4196,6 +4334,115 @@ bool Splash::scaleImageYdownXdown(SplashImageSource src, void *srcData, SplashCo
     return true;
 }
 
+// Same as scaleImageYdownXdown, for a 1-bit image read as packed bits,
+// whose 0 and 1 pixels have the colors in <bitColors>: each destination
+// pixel mixes the two colors by the count of 1 bits under it.  The
+// result matches summing the expanded lines.
+bool Splash::scaleImageYdownXdownBits(SplashImageBitsSource src, SplashColorConstPtr bitColors, void *srcData, SplashColorMode srcMode, int nComps, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest)
+{
+    unsigned char *lineBuf;
+    unsigned int *countBuf;
+    unsigned int pix[SPOT_NCOMPS + 4];
+    unsigned char *destPtr;
+    int *xs;
+    int yp, yq, xp, yt, y, yStep, xStep, x, d0, d1;
+    int i, cp;
+
+    // Bresenham parameters for y scale
+    yp = srcHeight / scaledHeight;
+    yq = srcHeight % scaledHeight;
+
+    xp = srcWidth / scaledWidth;
+
+    // allocate buffers
+    const int lineSize = (srcWidth >> 3) + ((srcWidth & 7) ? 1 : 0);
+    lineBuf = (unsigned char *)gmalloc(lineSize + 8);
+    memset(lineBuf, 0, lineSize + 8);
+    countBuf = (unsigned int *)gmallocn_checkoverflow(scaledWidth, sizeof(unsigned int));
+    xs = getBoxFilterSpans(srcWidth, scaledWidth);
+    if (unlikely(!countBuf || !xs)) {
+        gfree(xs);
+        gfree(countBuf);
+        gfree(lineBuf);
+        return false;
+    }
+
+    // init y scale Bresenham
+    yt = 0;
+
+    destPtr = dest->data;
+    for (y = 0; y < scaledHeight; ++y) {
+
+        // y scale Bresenham
+        if ((yt += yq) >= scaledHeight) {
+            yt -= scaledHeight;
+            yStep = yp + 1;
+        } else {
+            yStep = yp;
+        }
+
+        // read rows from image
+        memset(countBuf, 0, scaledWidth * sizeof(unsigned int));
+        for (i = 0; i < yStep; ++i) {
+            (*src)(srcData, lineBuf);
+            countBitsInSpans(lineBuf, xs, scaledWidth, countBuf);
+        }
+
+        d0 = (1 << 23) / (yStep * xp);
+        d1 = (1 << 23) / (yStep * (xp + 1));
+
+        for (x = 0; x < scaledWidth; ++x) {
+            xStep = xs[x + 1] - xs[x];
+            const unsigned int d = xStep == xp ? d0 : d1;
+            const unsigned int n1 = countBuf[x];
+            const unsigned int n0 = yStep * xStep - n1;
+
+            // pix / xStep * yStep
+            for (cp = 0; cp < nComps; ++cp) {
+                pix[cp] = ((bitColors[cp] * n0 + bitColors[nComps + cp] * n1) * d) >> 23;
+            }
+
+            // store the pixel
+            switch (srcMode) {
+            case splashModeMono8:
+                *destPtr++ = (unsigned char)pix[0];
+                break;
+            case splashModeRGB8:
+                *destPtr++ = (unsigned char)pix[0];
+                *destPtr++ = (unsigned char)pix[1];
+                *destPtr++ = (unsigned char)pix[2];
+                break;
+            case splashModeXBGR8:
+                *destPtr++ = (unsigned char)pix[2];
+                *destPtr++ = (unsigned char)pix[1];
+                *destPtr++ = (unsigned char)pix[0];
+                *destPtr++ = (unsigned char)255;
+                break;
+            case splashModeBGR8:
+                *destPtr++ = (unsigned char)pix[2];
+                *destPtr++ = (unsigned char)pix[1];
+                *destPtr++ = (unsigned char)pix[0];
+                break;
+            case splashModeCMYK8:
+            case splashModeDeviceN8:
+                for (cp = 0; cp < nComps; ++cp) {
+                    *destPtr++ = (unsigned char)pix[cp];
+                }
+                break;
+            case splashModeMono1: // mono1 is not allowed
+            default:
+                break;
+            }
+        }
+    }
+
+    gfree(xs);
+    gfree(countBuf);
+    gfree(lineBuf);
+
+    return true;
+}
+
 bool Splash::scaleImageYdownXup(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest)
 {
     unsigned char *lineBuf, *alphaLineBuf;
@@ -4881,6 +5128,7 @@ void Splash::blitImage(SplashBitmap *src, bool srcAlpha, int xDest, int yDest, S
     // draw the unclipped region
     if (x0 < w && y0 < h && x0 < x1 && y0 < y1) {
         pipeInit(&pipe, xDest + x0, yDest + y0, nullptr, pixel, (unsigned char)splashRound(state->fillAlpha * 255), srcAlpha, false);
+        updateModRegion(xDest + x0, yDest + y0, xDest + x1 - 1, yDest + y1 - 1);
         if (srcAlpha) {
             for (y = y0; y < y1; ++y) {
                 pipeSetXY(&pipe, xDest + x0, yDest + y);
@@ -4947,6 +5195,7 @@ void Splash::blitImageClipped(SplashBitmap *src, bool srcAlpha, int xSrc, int yS
         }
     } else {
         pipeInit(&pipe, xDest, yDest, nullptr, pixel, (unsigned char)splashRound(state->fillAlpha * 255), srcAlpha, false);
+        updateModRegion(xDest, yDest, xDest + w - 1, yDest + h - 1);
         if (srcAlpha) {
             for (y = 0; y < h; ++y) {
                 ap = src->getAlphaPtr() + (ySrc + y) * src->getWidth() + xSrc;
@@ -4998,6 +5247,7 @@ SplashError Splash::composite(SplashBitmap *src, int xSrc, int ySrc, int xDest,
         for (x = bitmap->getSeparationList()->size(); x < (int)src->getSeparationList()->size(); x++)
             bitmap->getSeparationList()->push_back((GfxSeparationColorSpace *)((*src->getSeparationList())[x])->copy());
     }
+    updateModRegion(xDest, yDest, xDest + w - 1, yDest + h - 1);
     if (src->alpha) {
         pipeInit(&pipe, xDest, yDest, nullptr, pixel, (unsigned char)splashRound(state->fillAlpha * 255), true, nonIsolated, knockout, (unsigned char)splashRound(knockoutOpacity * 255));
         if (noClip) {
@@ -5060,6 +5310,11 @@ SplashError Splash::composite(SplashBitmap *src, int xSrc, int ySrc, int xDest,
 }
 
 void Splash::compositeBackground(SplashColorConstPtr color)
+{
+    compositeBackground(color, 0, 0, bitmap->width - 1, bitmap->height - 1);
+}
+
+void Splash::compositeBackground(SplashColorConstPtr color, int xMin, int yMin, int xMax, int yMax)
 {
     SplashColorPtr p;
     unsigned char *q;
@@ -5072,15 +5327,22 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         error(errInternal, -1, "bitmap->alpha is NULL in Splash::compositeBackground");
         return;
     }
+    xMin = std::max(xMin, 0);
+    yMin = std::max(yMin, 0);
+    xMax = std::min(xMax, bitmap->width - 1);
+    yMax = std::min(yMax, bitmap->height - 1);
+    if (xMin > xMax || yMin > yMax) {
+        return;
+    }
 
     switch (bitmap->mode) {
     case splashModeMono1:
         color0 = color[0];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            mask = 0x80;
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + (xMin >> 3)];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            mask = 0x80 >> (xMin & 7);
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 alpha1 = 255 - alpha;
                 c = (*p & mask) ? 0xff : 0x00;
@@ -5099,10 +5361,10 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         break;
     case splashModeMono8:
         color0 = color[0];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + xMin];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 alpha1 = 255 - alpha;
                 p[0] = div255(alpha1 * color0 + alpha * p[0]);
@@ -5115,10 +5377,10 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         color0 = color[0];
         color1 = color[1];
         color2 = color[2];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + xMin * 3];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 if (alpha == 0) {
                     p[0] = color0;
@@ -5138,10 +5400,10 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         color0 = color[0];
         color1 = color[1];
         color2 = color[2];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + xMin * 4];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 if (alpha == 0) {
                     p[0] = color0;
@@ -5163,10 +5425,10 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         color1 = color[1];
         color2 = color[2];
         color3 = color[3];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + xMin * 4];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 if (alpha == 0) {
                     p[0] = color0;
@@ -5187,10 +5449,10 @@ void Splash::compositeBackground(SplashColorConstPtr color)
     case splashModeDeviceN8:
         for (cp = 0; cp < SPOT_NCOMPS + 4; cp++)
             colorsp[cp] = color[cp];
-        for (y = 0; y < bitmap->height; ++y) {
-            p = &bitmap->data[y * bitmap->rowSize];
-            q = &bitmap->alpha[y * bitmap->width];
-            for (x = 0; x < bitmap->width; ++x) {
+        for (y = yMin; y <= yMax; ++y) {
+            p = &bitmap->data[y * bitmap->rowSize + xMin * (SPOT_NCOMPS + 4)];
+            q = &bitmap->alpha[y * bitmap->width + xMin];
+            for (x = xMin; x <= xMax; ++x) {
                 alpha = *q++;
                 if (alpha == 0) {
                     for (cp = 0; cp < SPOT_NCOMPS + 4; cp++)
@@ -5205,7 +5467,9 @@ void Splash::compositeBackground(SplashColorConstPtr color)
         }
         break;
     }
-    memset(bitmap->alpha, 255, bitmap->width * bitmap->height);
+    for (y = yMin; y <= yMax; ++y) {
+        memset(bitmap->alpha + y * bitmap->width + xMin, 255, xMax - xMin + 1);
+    }
 }
 
 bool Splash::gouraudTriangleShadedFill(SplashGouraudColor *shading)
@@ -5253,7 +5517,9 @@ bool Splash::gouraudTriangleShadedFill(SplashGouraudColor *shading)
     // - assign the actual color into cSrcVal: pipe uses cSrcVal by reference
     // - invoke drawPixel(&pipe,X,Y,bNoClip);
     const bool bDirectBlit = vectorAntialias ? false : pipe.noTransparency && !state->blendFunc && !shading->isParameterized();
-    if (!bDirectBlit) {
+    if (bDirectBlit) {
+        updateModRegion(clip->getXMinI(), clip->getYMinI(), clip->getXMaxI(), clip->getYMaxI());
+    } else {
         blitTarget = new SplashBitmap(bitmap->getWidth(), bitmap->getHeight(), bitmap->getRowPad(), bitmap->getMode(), true, bitmap->getRowSize() >= 0);
         bitmapData = blitTarget->getDataPtr();
         bitmapAlpha = blitTarget->getAlphaPtr();
@@ -5275,6 +5541,9 @@ bool Splash::gouraudTriangleShadedFill(SplashGouraudColor *shading)
         int scanEdgeR[2] = { 0, 0 };
 
         for (int i = 0; i < shading->getNTriangles(); ++i) {
+            if ((i & 15) == 15 && checkAbort()) {
+                break;
+            }
             shading->getParametrizedTriangle(i, xdbl + 0, ydbl + 0, color + 0, xdbl + 1, ydbl + 1, color + 1, xdbl + 2, ydbl + 2, color + 2);
             for (int m = 0; m < 3; ++m) {
                 xt = xdbl[m] * (double)userToCanvasMatrix[0] + ydbl[m] * (double)userToCanvasMatrix[2] + (double)userToCanvasMatrix[4];
@@ -5464,6 +5733,9 @@ bool Splash::gouraudTriangleShadedFill(SplashGouraudColor *shading)
         int scanEdgeR[2] = { 0, 0 };
 
         for (int i = 0; i < shading->getNTriangles(); ++i) {
+            if ((i & 15) == 15 && checkAbort()) {
+                break;
+            }
             // Sadly this current algorithm only supports shadings where the three triangle vertices have the same color
             shading->getNonParametrizedTriangle(i, bitmapMode, xdbl + 0, ydbl + 0, (SplashColorPtr)&color, xdbl + 1, ydbl + 1, (SplashColorPtr)&auxColor1, xdbl + 2, ydbl + 2, (SplashColorPtr)&auxColor2);
             if (!splashColorEqual(color, auxColor1) || !splashColorEqual(color, auxColor2)) {
@@ -5652,6 +5924,429 @@ bool Splash::gouraudTriangleShadedFill(SplashGouraudColor *shading)
     return true;
 }
 
+// Draw the triangle (v0, v1, v2) of a flattened patch mesh into the
+// w x h buffers <colorBuf> and <coverBuf>, whose top left corner is at
+// (xOff, yOff) in device space.  Like the non-antialiased fills, every
+// pixel touched by the triangle is marked as covered, so that the
+// triangles of neighbouring patches, which approximate their common
+// side differently, don't leave cracks between them.  The color (or
+// parameter value) is interpolated linearly between the vertices.
+static void fillPatchMeshTriangle(SplashPatchMeshColor *shading, bool parameterized, SplashColorMode mode, int nComps, const SplashPatchMeshVertex *v0, const SplashPatchMeshVertex *v1, const SplashPatchMeshVertex *v2, int xOff, int yOff, int w,
+                                  int h, unsigned char *colorBuf, unsigned char *coverBuf)
+{
+    double a0[splashMaxColorComps], dadx[splashMaxColorComps], dady[splashMaxColorComps], a[splashMaxColorComps];
+
+    // sort the vertices by y
+    if (v1->y < v0->y) {
+        std::swap(v0, v1);
+    }
+    if (v2->y < v1->y) {
+        std::swap(v1, v2);
+    }
+    if (v1->y < v0->y) {
+        std::swap(v0, v1);
+    }
+    const double x0 = v0->x - xOff, y0 = v0->y - yOff;
+    const double x1 = v1->x - xOff, y1 = v1->y - yOff;
+    const double x2 = v2->x - xOff, y2 = v2->y - yOff;
+
+    const double det = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    if (!std::isfinite(det) || fabs(det) < 1e-9) {
+        return; // degenerate triangle
+    }
+
+    // the attributes are planes a(x, y) = a0 + dadx * (x - x0) + dady * (y - y0)
+    const int nAttrs = parameterized ? 1 : nComps;
+    for (int k = 0; k < nAttrs; ++k) {
+        const double c0 = parameterized ? v0->t : v0->color[k];
+        const double c1 = parameterized ? v1->t : v1->color[k];
+        const double c2 = parameterized ? v2->t : v2->color[k];
+        a0[k] = c0;
+        dadx[k] = ((c1 - c0) * (y2 - y0) - (c2 - c0) * (y1 - y0)) / det;
+        dady[k] = ((c2 - c0) * (x1 - x0) - (c1 - c0) * (x2 - x0)) / det;
+    }
+
+    // x coordinate of the edge (xa, ya) - (xb, yb) at y, with ya < yb
+    auto edgeX = [](double xa, double ya, double xb, double yb, double y) { return xa + (y - ya) * (xb - xa) / (yb - ya); };
+
+    // scan the rows of pixels the triangle intersects
+    const int yStart = (int)std::clamp(floor(y0), 0.0, (double)h);
+    const int yEnd = (int)std::clamp(floor(y2) + 1, 0.0, (double)h);
+    for (int py = yStart; py < yEnd; ++py) {
+        const double yc = py + 0.5;
+        const double ya = std::max((double)py, y0);
+        const double yb = std::min((double)(py + 1), y2);
+        if (ya > yb) {
+            continue;
+        }
+        double xa = edgeX(x0, y0, x2, y2, ya);
+        double xb = edgeX(x0, y0, x2, y2, yb);
+        if (xa > xb) {
+            std::swap(xa, xb);
+        }
+        if (ya <= y1 && y1 <= yb) {
+            xa = std::min(xa, x1);
+            xb = std::max(xb, x1);
+        }
+        if (ya < y1) {
+            const double xc = edgeX(x0, y0, x1, y1, ya);
+            const double xd = edgeX(x0, y0, x1, y1, std::min(yb, y1));
+            xa = std::min(xa, std::min(xc, xd));
+            xb = std::max(xb, std::max(xc, xd));
+        }
+        if (yb > y1) {
+            const double xc = edgeX(x1, y1, x2, y2, std::max(ya, y1));
+            const double xd = edgeX(x1, y1, x2, y2, yb);
+            xa = std::min(xa, std::min(xc, xd));
+            xb = std::max(xb, std::max(xc, xd));
+        }
+
+        // fill the pixels intersecting [xa, xb]
+        const int xStart = (int)std::clamp(floor(xa), 0.0, (double)w);
+        const int xEnd = (int)std::clamp(floor(xb) + 1, 0.0, (double)w);
+        if (xStart >= xEnd) {
+            continue;
+        }
+        for (int k = 0; k < nAttrs; ++k) {
+            a[k] = a0[k] + dadx[k] * (xStart + 0.5 - x0) + dady[k] * (yc - y0);
+        }
+        unsigned char *cover = coverBuf + (size_t)py * w + xStart;
+        unsigned char *color = colorBuf + ((size_t)py * w + xStart) * nComps;
+        for (int px = xStart; px < xEnd; ++px) {
+            if (parameterized) {
+                shading->getParameterizedColor(a[0], mode, color);
+                a[0] += dadx[0];
+            } else {
+                for (int k = 0; k < nComps; ++k) {
+                    const int c = (int)(a[k] + 0.5);
+                    color[k] = (unsigned char)(c < 0 ? 0 : c > 255 ? 255 : c);
+                    a[k] += dadx[k];
+                }
+            }
+            *cover++ = 1;
+            color += nComps;
+        }
+    }
+}
+
+// Return the number of samples, out of splashAASize * splashAASize, set
+// for pixel <x> in <aaBuf>.
+static inline int aaBufCoverage(SplashBitmap *aaBuf, int x)
+{
+#if splashAASize == 4
+    static const int bitCount4[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    const unsigned char *p = aaBuf->getDataPtr() + (x >> 1);
+    const int w = aaBuf->getRowSize();
+    if (x & 1) {
+        return bitCount4[*p & 0x0f] + bitCount4[p[w] & 0x0f] + bitCount4[p[2 * w] & 0x0f] + bitCount4[p[3 * w] & 0x0f];
+    }
+    return bitCount4[*p >> 4] + bitCount4[p[w] >> 4] + bitCount4[p[2 * w] >> 4] + bitCount4[p[3 * w] >> 4];
+#else
+    int t = 0;
+    for (int yy = 0; yy < splashAASize; ++yy) {
+        for (int xx = 0; xx < splashAASize; ++xx) {
+            const unsigned char *p = aaBuf->getDataPtr() + yy * aaBuf->getRowSize() + ((x * splashAASize + xx) >> 3);
+            t += (*p >> (7 - ((x * splashAASize + xx) & 7))) & 1;
+        }
+    }
+    return t;
+#endif
+}
+
+bool Splash::patchMeshShadedFill(SplashPatchMeshColor *shading)
+{
+    SplashClip *clip = state->clip;
+    const SplashColorMode mode = bitmap->mode == splashModeMono1 ? splashModeMono8 : bitmap->mode;
+    const int nComps = splashColorModeNComps[mode];
+    const bool parameterized = shading->isParameterized();
+    double bxMin, byMin, bxMax, byMax;
+
+    // only the part of the mesh inside the clip rectangle is drawn
+    shading->getBBox(&bxMin, &byMin, &bxMax, &byMax);
+    const int xMin = (int)std::max((double)std::max(clip->getXMinI(), 0), floor(bxMin));
+    const int yMin = (int)std::max((double)std::max(clip->getYMinI(), 0), floor(byMin));
+    const int xMax = (int)std::min((double)std::min(clip->getXMaxI(), bitmap->width - 1), floor(bxMax));
+    const int yMax = (int)std::min((double)std::min(clip->getYMaxI(), bitmap->height - 1), floor(byMax));
+    if (xMin > xMax || yMin > yMax) {
+        return true;
+    }
+    const int w = xMax - xMin + 1;
+    const int h = yMax - yMin + 1;
+
+    // the whole mesh is drawn before being composited, as later patches
+    // are painted over the earlier ones
+    unsigned char *colorBuf = (unsigned char *)gmallocn3(w, h, nComps, true);
+    unsigned char *coverBuf = (unsigned char *)gmallocn(w, h, true);
+    if (unlikely(!colorBuf || !coverBuf)) {
+        gfree(colorBuf);
+        gfree(coverBuf);
+        return false;
+    }
+    memset(coverBuf, 0, (size_t)w * h);
+
+    std::vector<SplashPatchMeshVertex> grid;
+    for (int i = 0; i < shading->getNPatches(); ++i) {
+        if ((i & 15) == 15 && checkAbort()) {
+            break;
+        }
+        const int n = shading->getPatchGrid(i, mode, &grid);
+        for (int v = 0; v < n; ++v) {
+            for (int u = 0; u < n; ++u) {
+                const SplashPatchMeshVertex *p00 = &grid[v * (n + 1) + u];
+                const SplashPatchMeshVertex *p01 = p00 + 1;
+                const SplashPatchMeshVertex *p10 = p00 + (n + 1);
+                const SplashPatchMeshVertex *p11 = p10 + 1;
+                fillPatchMeshTriangle(shading, parameterized, mode, nComps, p00, p01, p11, xMin, yMin, w, h, colorBuf, coverBuf);
+                fillPatchMeshTriangle(shading, parameterized, mode, nComps, p00, p11, p10, xMin, yMin, w, h, colorBuf, coverBuf);
+            }
+        }
+    }
+
+    // composite the covered spans, with the anti-aliased coverage of the
+    // clip paths as for path fills
+    SplashPipe pipe;
+    SplashColor cSrcVal;
+    const bool noClip = clip->getNumPaths() == 0;
+    const bool aaClip = !noClip && vectorAntialias && aaBuf;
+    pipeInit(&pipe, xMin, yMin, nullptr, cSrcVal, (unsigned char)splashRound(state->fillAlpha * 255), aaClip, false);
+    updateModRegion(xMin, yMin, xMax, yMax);
+    for (int y = 0; y < h; ++y) {
+        const unsigned char *cover = coverBuf + (size_t)y * w;
+        const unsigned char *color = colorBuf + (size_t)y * w * nComps;
+        int first = 0, last = w - 1;
+        while (first < w && !cover[first]) {
+            ++first;
+        }
+        if (first == w) {
+            continue;
+        }
+        while (!cover[last]) {
+            --last;
+        }
+        int x0 = xMin + first, x1 = xMin + last;
+        const SplashClipResult clipRes = noClip ? splashClipAllInside : clip->testSpan(x0, x1, yMin + y);
+        if (clipRes == splashClipAllOutside) {
+            continue;
+        }
+        if (clipRes == splashClipPartial && aaClip) {
+            memset(aaBuf->getDataPtr(), 0xff, aaBuf->getRowSize() * aaBuf->getHeight());
+            clip->clipAALine(aaBuf, &x0, &x1, yMin + y);
+        }
+        first = std::max(first, x0 - xMin);
+        last = std::min(last, x1 - xMin);
+
+        int x = first;
+        while (x <= last) {
+            if (!cover[x]) {
+                ++x;
+                continue;
+            }
+            pipeSetXY(&pipe, xMin + x, yMin + y);
+            for (; x <= last && cover[x]; ++x) {
+                unsigned char shape = 255;
+                if (clipRes != splashClipAllInside) {
+                    if (aaClip) {
+                        shape = (unsigned char)aaGamma[aaBufCoverage(aaBuf, xMin + x)];
+                    } else if (!clip->test(xMin + x, yMin + y)) {
+                        shape = 0;
+                    }
+                }
+                if (shape == 0) {
+                    pipeIncX(&pipe);
+                    continue;
+                }
+                memcpy(cSrcVal, color + (size_t)x * nComps, nComps);
+                pipe.shape = shape;
+                (this->*pipe.run)(&pipe);
+            }
+        }
+    }
+
+    gfree(colorBuf);
+    gfree(coverBuf);
+    return true;
+}
+
+// Is the transfer function of <mode> the identity?
+bool Splash::isIdentityTransfer(SplashColorMode mode)
+{
+    for (int i = 0; i < 256; ++i) {
+        switch (mode) {
+        case splashModeMono1:
+        case splashModeMono8:
+            if (state->grayTransfer[i] != i) {
+                return false;
+            }
+            break;
+        case splashModeRGB8:
+        case splashModeBGR8:
+        case splashModeXBGR8:
+            if (state->rgbTransferR[i] != i || state->rgbTransferG[i] != i || state->rgbTransferB[i] != i) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reduce <v> modulo <n>, into [0, n).
+static inline double tileWrap(double v, int n)
+{
+    v -= n * floor(v / n);
+    return (v >= 0 && v < n) ? v : 0;
+}
+
+SplashError Splash::tileFill(SplashBitmap *tile, bool uncolored, const SplashCoord *mat)
+{
+    SplashClip *clip = state->clip;
+    const SplashColorMode srcMode = bitmap->mode == splashModeMono1 ? splashModeMono8 : bitmap->mode;
+    const int nComps = splashColorModeNComps[srcMode];
+    const int tw = tile->getWidth();
+    const int th = tile->getHeight();
+    SplashColor fillColor, pixel;
+
+    if (tile->getMode() != (uncolored ? splashModeMono8 : srcMode) || !tile->getAlphaPtr()) {
+        return splashErrModeMismatch;
+    }
+
+    // device space -> tile space
+    const SplashCoord det = mat[0] * mat[3] - mat[1] * mat[2];
+    if (!std::isfinite(1 / det)) {
+        return splashErrSingularMatrix;
+    }
+    const SplashCoord inv[6] = { mat[3] / det, -mat[1] / det, -mat[2] / det, mat[0] / det, (mat[2] * mat[5] - mat[3] * mat[4]) / det, (mat[1] * mat[4] - mat[0] * mat[5]) / det };
+    if (!std::isfinite(inv[4]) || !std::isfinite(inv[5])) {
+        return splashErrSingularMatrix;
+    }
+
+    const int xMin = std::max(clip->getXMinI(), 0);
+    const int yMin = std::max(clip->getYMinI(), 0);
+    const int xMax = std::min(clip->getXMaxI(), bitmap->width - 1);
+    const int yMax = std::min(clip->getYMaxI(), bitmap->height - 1);
+    if (xMin > xMax || yMin > yMax) {
+        return splashOk;
+    }
+
+    const unsigned char alpha = (unsigned char)splashRound(state->fillAlpha * 255);
+    const bool staticFill = !uncolored || state->fillPattern->isStatic();
+    if (uncolored && staticFill) {
+        state->fillPattern->getColor(0, 0, fillColor);
+    }
+
+    // When the tile pixels are the device pixels, the opaque rows of the
+    // tile can be copied as they are to the bitmap, unless the pipe would
+    // change them.
+    const bool unitScale = inv[0] == 1 && inv[1] == 0 && inv[2] == 0 && (inv[3] == 1 || inv[3] == -1);
+    const bool directCopy = unitScale && !uncolored && alpha == 255 && !state->softMask && !state->blendFunc && !state->inNonIsolatedGroup
+            && (bitmap->mode == splashModeMono8 || bitmap->mode == splashModeRGB8 || bitmap->mode == splashModeBGR8 || bitmap->mode == splashModeXBGR8) && isIdentityTransfer(bitmap->mode);
+    std::vector<bool> opaqueRows;
+    if (directCopy) {
+        opaqueRows.resize(th);
+        for (int ty = 0; ty < th; ++ty) {
+            const unsigned char *ap = tile->getAlphaPtr() + (size_t)ty * tw;
+            int tx = 0;
+            while (tx < tw && ap[tx] == 255) {
+                ++tx;
+            }
+            opaqueRows[ty] = tx == tw;
+        }
+    }
+
+    SplashPipe pipe;
+    pipeInit(&pipe, xMin, yMin, nullptr, pixel, alpha, true, false);
+    updateModRegion(xMin, yMin, xMax, yMax);
+    const bool noClip = clip->getNumPaths() == 0;
+    const bool aaClip = !noClip && vectorAntialias && aaBuf;
+
+    for (int y = yMin; y <= yMax; ++y) {
+        int x0 = xMin, x1 = xMax;
+        SplashClipResult clipRes = noClip ? splashClipAllInside : clip->testSpan(x0, x1, y);
+        if (clipRes == splashClipAllOutside) {
+            continue;
+        }
+        if (clipRes == splashClipPartial && aaClip) {
+            memset(aaBuf->getDataPtr(), 0xff, aaBuf->getRowSize() * aaBuf->getHeight());
+            clip->clipAALine(aaBuf, &x0, &x1, y);
+            if (x0 > x1) {
+                continue;
+            }
+        }
+
+        double u = tileWrap(inv[0] * (x0 + 0.5) + inv[2] * (y + 0.5) + inv[4], tw);
+        double v = tileWrap(inv[1] * (x0 + 0.5) + inv[3] * (y + 0.5) + inv[5], th);
+
+        if (directCopy && clipRes == splashClipAllInside && opaqueRows[std::min((int)v, th - 1)]) {
+            // copy the tile row over the span, wrapping around its end
+            const unsigned char *tileRow = tile->getDataPtr() + (size_t)std::min((int)v, th - 1) * tile->getRowSize();
+            unsigned char *dest = bitmap->data + (size_t)y * bitmap->rowSize + (size_t)x0 * nComps;
+            int tx = std::min((int)u, tw - 1);
+            for (int x = x0; x <= x1;) {
+                const int n = std::min(tw - tx, x1 - x + 1);
+                memcpy(dest, tileRow + (size_t)tx * nComps, (size_t)n * nComps);
+                dest += (size_t)n * nComps;
+                x += n;
+                tx = 0;
+            }
+            if (bitmap->alpha) {
+                memset(bitmap->alpha + (size_t)y * bitmap->width + x0, 255, x1 - x0 + 1);
+            }
+            continue;
+        }
+
+        pipeSetXY(&pipe, x0, y);
+        for (int x = x0; x <= x1; ++x) {
+            const int tx = std::min((int)u, tw - 1);
+            const int ty = std::min((int)v, th - 1);
+            u += inv[0];
+            v += inv[1];
+            if (u < 0 || u >= tw) {
+                u = tileWrap(u, tw);
+            }
+            if (v < 0 || v >= th) {
+                v = tileWrap(v, th);
+            }
+
+            // compute the shape value
+            unsigned char shape = tile->getAlphaPtr()[(size_t)ty * tw + tx];
+            if (clipRes != splashClipAllInside) {
+                if (aaClip) {
+                    shape = div255(aaGamma[aaBufCoverage(aaBuf, x)] * shape);
+                } else if (!clip->test(x, y)) {
+                    shape = 0;
+                }
+            }
+            if (shape == 0) {
+                pipeIncX(&pipe);
+                continue;
+            }
+
+            // compute the source color
+            const unsigned char *tp = tile->getDataPtr() + (size_t)ty * tile->getRowSize() + (size_t)tx * (uncolored ? 1 : nComps);
+            if (uncolored) {
+                if (!staticFill) {
+                    state->fillPattern->getColor(x, y, fillColor);
+                }
+                for (int i = 0; i < nComps; ++i) {
+                    if (srcMode == splashModeCMYK8 || srcMode == splashModeDeviceN8) {
+                        pixel[i] = div255(fillColor[i] * (255 - tp[0]));
+                    } else {
+                        pixel[i] = 255 - div255((255 - fillColor[i]) * (255 - tp[0]));
+                    }
+                }
+            } else {
+                memcpy(pixel, tp, nComps);
+            }
+            pipe.shape = shape;
+            (this->*pipe.run)(&pipe);
+        }
+    }
+
+    return splashOk;
+}
+
 SplashError Splash::blitTransparent(SplashBitmap *src, int xSrc, int ySrc, int xDest, int yDest, int w, int h)
 {
     SplashColorPtr p, sp;
@@ -5684,6 +6379,8 @@ SplashError Splash::blitTransparent(SplashBitmap *src, int xSrc, int ySrc, int x
     if (height < 0)
         height = 0;
 
+    updateModRegion(xDest, yDest, xDest + width - 1, yDest + height - 1);
+
     switch (bitmap->mode) {
     case splashModeMono1:
         for (y = 0; y < height; ++y) {
@@ -6142,6 +6839,9 @@ SplashError Splash::shadedFill(SplashPath *path, bool hasBBox, SplashPattern *pa
         // draw the spans
         if (vectorAntialias) {
             for (y = yMinI; y <= yMaxI; ++y) {
+                if (((y - yMinI) & 15) == 15 && checkAbort()) {
+                    break;
+                }
                 scanner.renderAALine(aaBuf, &x0, &x1, y);
                 if (clipRes != splashClipAllInside) {
                     state->clip->clipAALine(aaBuf, &x0, &x1, y);
@@ -6206,6 +6906,9 @@ SplashError Splash::shadedFill(SplashPath *path, bool hasBBox, SplashPattern *pa
         } else {
             SplashClipResult clipRes2;
             for (y = yMinI; y <= yMaxI; ++y) {
+                if (((y - yMinI) & 15) == 15 && checkAbort()) {
+                    break;
+                }
                 SplashXPathScanIterator iterator(scanner, y);
                 while (iterator.getNextSpan(&x0, &x1)) {
                     if (clipRes == splashClipAllInside) {
@@ -53,6 +53,11 @@ typedef bool (*SplashImageMaskSource)(void *data, SplashColorPtr pixel);
 // returns false.
 typedef bool (*SplashImageSource)(void *data, SplashColorPtr colorLine, unsigned char *alphaLine);
 
+// Retrieves the next line of a 1-bit image or image mask, packed eight
+// pixels per byte, most significant bit first.  If the image stream
+// is exhausted, returns false.
+typedef bool (*SplashImageBitsSource)(void *data, unsigned char *bits);
+
 // Use ICCColorSpace to transform a bitmap
 typedef void (*SplashICCTransform)(void *data, SplashBitmap *bitmap);
 
@@ -184,7 +189,10 @@ public:
     // Note that the Splash y axis points downward, and the image source
     // is assumed to produce pixels in raster order, starting from the
     // top line.
-    SplashError fillImageMask(SplashImageMaskSource src, void *srcData, int w, int h, SplashCoord *mat, bool glyphMode);
+    // If <bitsSrc> is given, it reads the same lines as <src>, packed
+    // into bits; it is used instead of <src> where the mask is scaled
+    // down, which saves expanding the pixels into bytes.
+    SplashError fillImageMask(SplashImageMaskSource src, void *srcData, int w, int h, SplashCoord *mat, bool glyphMode, SplashImageBitsSource bitsSrc = nullptr);
 
     // Draw an image.  This will read <h> lines of <w> pixels from
     // <src>, starting with the top line.  These pixels are assumed to
@@ -201,7 +209,11 @@ public:
     //    BGR8         BGR8
     //    CMYK8        CMYK8
     // The matrix behaves as for fillImageMask.
-    SplashError drawImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, bool srcAlpha, int w, int h, SplashCoord *mat, bool interpolate, bool tilingPattern = false);
+    // A 1-bit image without alpha can also be read through <bitsSrc>,
+    // in which case <bitColors> holds the colors of the 0 and 1 pixels,
+    // laid out as in the lines returned by <src>.
+    SplashError drawImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, bool srcAlpha, int w, int h, SplashCoord *mat, bool interpolate, bool tilingPattern = false,
+                          SplashImageBitsSource bitsSrc = nullptr, SplashColorConstPtr bitColors = nullptr);
 
     // Composite a rectangular region from <src> onto this Splash
     // object.
@@ -211,6 +223,11 @@ public:
     // background alpha is assumed to be 1.
     void compositeBackground(SplashColorConstPtr color);
 
+    // Composite the rectangle (<xMin>, <yMin>) - (<xMax>, <yMax>) of
+    // this Splash object onto a background color; the rest of the
+    // bitmap is left alone.
+    void compositeBackground(SplashColorConstPtr color, int xMin, int yMin, int xMax, int yMax);
+
     // Copy a rectangular region from <src> onto the bitmap belonging to
     // this Splash object.  The destination alpha values are all set to
     // zero.
@@ -235,10 +252,37 @@ public:
     void setThinLineMode(SplashThinLineMode thinLineModeA) { thinLineMode = thinLineModeA; }
     SplashThinLineMode getThinLineMode() { return thinLineMode; }
 
+    // Setter/Getter for image interpolation: when off, images scaled up
+    // are never interpolated, even if they ask for it.
+    void setImageInterpolation(bool imageInterpolationA) { imageInterpolation = imageInterpolationA; }
+    bool getImageInterpolation() { return imageInterpolation; }
+
+    // Set the callback which the shadings check every few rows or
+    // triangles, to stop filling when it returns true.
+    void setAbortCheckCbk(bool (*abortCheckCbkA)(void *data), void *abortCheckCbkDataA)
+    {
+        abortCheckCbk = abortCheckCbkA;
+        abortCheckCbkData = abortCheckCbkDataA;
+    }
+
     // Get clipping status for the last drawing operation subject to
     // clipping.
     SplashClipResult getClipRes() { return opClipRes; }
 
+    // Get a bounding box which includes all modifications since the
+    // last call to clearModRegion.  The box is empty (*xMin > *xMax) if
+    // nothing was drawn.
+    void getModRegion(int *xMin, int *yMin, int *xMax, int *yMax)
+    {
+        *xMin = modXMin;
+        *yMin = modYMin;
+        *xMax = modXMax;
+        *yMax = modYMax;
+    }
+
+    // Clear the modified region bounding box.
+    void clearModRegion();
+
     // Toggle debug mode on or off.
     void setDebugMode(bool debugModeA) { debugMode = debugModeA; }
 
@@ -255,9 +299,25 @@ public:
     SplashError shadedFill(SplashPath *path, bool hasBBox, SplashPattern *pattern, bool clipToStrokePath);
     // Draw a gouraud triangle shading.
     bool gouraudTriangleShadedFill(SplashGouraudColor *shading);
+    // Draw a patch mesh shading.  The patches are flattened into
+    // Gouraud shaded triangles, drawn into a buffer which is then
+    // composited through the pipe.  Returns false if the buffer can't be
+    // allocated.
+    bool patchMeshShadedFill(SplashPatchMeshColor *shading);
+    // Fill the clip region with copies of <tile>, which must have an
+    // alpha channel.  <mat> maps tile space, where the tile covers
+    // [0, w] x [0, h], to device space; the tile repeats every w units
+    // along the x axis and every h units along the y axis of tile space.
+    // If <uncolored> is set, <tile> is a Mono8 bitmap painted with the
+    // fill pattern (the darker, the closer to the fill color); otherwise
+    // it has the mode of the destination bitmap (Mono8 for a Mono1
+    // bitmap).
+    SplashError tileFill(SplashBitmap *tile, bool uncolored, const SplashCoord *mat);
 
 private:
+    bool checkAbort() { return abortCheckCbk && (*abortCheckCbk)(abortCheckCbkData); }
     void pipeInit(SplashPipe *pipe, int x, int y, SplashPattern *pattern, SplashColorPtr cSrc, unsigned char aInput, bool usesShape, bool nonIsolatedGroup, bool knockout = false, unsigned char knockoutOpacity = 255);
+    bool isIdentityTransfer(SplashColorMode mode);
     void pipeRun(SplashPipe *pipe);
     void pipeRunSimpleMono1(SplashPipe *pipe);
     void pipeRunSimpleMono8(SplashPipe *pipe);
@@ -275,6 +335,9 @@ private:
     void pipeRunAADeviceN8(SplashPipe *pipe);
     void pipeSetXY(SplashPipe *pipe, int x, int y);
     void pipeIncX(SplashPipe *pipe);
+    void updateModX(int x);
+    void updateModY(int y);
+    void updateModRegion(int xMin, int yMin, int xMax, int yMax);
     void drawPixel(SplashPipe *pipe, int x, int y, bool noClip);
     void drawAAPixelInit();
     void drawAAPixel(SplashPipe *pipe, int x, int y);
@@ -284,23 +347,26 @@ private:
     void strokeNarrow(SplashPath *path);
     void strokeWide(SplashPath *path, SplashCoord w);
     SplashPath *flattenPath(SplashPath *path, SplashCoord *matrix, SplashCoord flatness);
-    void flattenCurve(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1, SplashCoord x2, SplashCoord y2, SplashCoord x3, SplashCoord y3, SplashCoord *matrix, SplashCoord flatness2, SplashPath *fPath);
+    void flattenCurve(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1, SplashCoord x2, SplashCoord y2, SplashCoord x3, SplashCoord y3, SplashCoord *matrix, SplashCoord flatness, SplashPath *fPath);
     SplashPath *makeDashedPath(SplashPath *xPath);
     void getBBoxFP(SplashPath *path, SplashCoord *xMinA, SplashCoord *yMinA, SplashCoord *xMaxA, SplashCoord *yMaxA);
     SplashError fillWithPattern(SplashPath *path, bool eo, SplashPattern *pattern, SplashCoord alpha);
     bool pathAllOutside(SplashPath *path);
     void fillGlyph2(int x0, int y0, SplashGlyphBitmap *glyph, bool noclip);
-    void arbitraryTransformMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, SplashCoord *mat, bool glyphMode);
-    SplashBitmap *scaleMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight);
+    void arbitraryTransformMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, SplashCoord *mat, bool glyphMode, SplashImageBitsSource bitsSrc);
+    SplashBitmap *scaleMask(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashImageBitsSource bitsSrc = nullptr);
     void scaleMaskYdownXdown(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
+    void scaleMaskYdownXdownBits(SplashImageBitsSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     void scaleMaskYdownXup(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     void scaleMaskYupXdown(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     void scaleMaskYupXup(SplashImageMaskSource src, void *srcData, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     void blitMask(SplashBitmap *src, int xDest, int yDest, SplashClipResult clipRes);
     SplashError arbitraryTransformImage(SplashImageSource src, SplashICCTransform tf, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, SplashCoord *mat, bool interpolate,
-                                        bool tilingPattern = false);
-    SplashBitmap *scaleImage(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, bool interpolate, bool tilingPattern = false);
+                                        bool tilingPattern = false, SplashImageBitsSource bitsSrc = nullptr, SplashColorConstPtr bitColors = nullptr);
+    SplashBitmap *scaleImage(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, bool interpolate, bool tilingPattern = false,
+                             SplashImageBitsSource bitsSrc = nullptr, SplashColorConstPtr bitColors = nullptr);
     bool scaleImageYdownXdown(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
+    bool scaleImageYdownXdownBits(SplashImageBitsSource src, SplashColorConstPtr bitColors, void *srcData, SplashColorMode srcMode, int nComps, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     bool scaleImageYdownXup(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     bool scaleImageYupXdown(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
     bool scaleImageYupXup(SplashImageSource src, void *srcData, SplashColorMode srcMode, int nComps, bool srcAlpha, int srcWidth, int srcHeight, int scaledWidth, int scaledHeight, SplashBitmap *dest);
@@ -324,8 +390,12 @@ private:
                                 //   bitmap containing the alpha0 values
     int alpha0X, alpha0Y; // offset within alpha0Bitmap
     SplashCoord aaGamma[splashAASize * splashAASize + 1];
+    int modXMin, modYMin, modXMax, modYMax;
     SplashCoord minLineWidth;
     SplashThinLineMode thinLineMode;
+    bool imageInterpolation;
+    bool (*abortCheckCbk)(void *data); // callback to check for an abort
+    void *abortCheckCbkData;
     SplashClipResult opClipRes;
     bool vectorAntialias;
     bool inShading;
@@ -52,7 +52,7 @@
 // SplashBitmap
 //------------------------------------------------------------------------
 
-SplashBitmap::SplashBitmap(int widthA, int heightA, int rowPadA, SplashColorMode modeA, bool alphaA, bool topDown, std::vector<GfxSeparationColorSpace *> *separationListA)
+SplashBitmap::SplashBitmap(int widthA, int heightA, int rowPadA, SplashColorMode modeA, bool alphaA, bool topDown, std::vector<GfxSeparationColorSpace *> *separationListA, bool zeroed)
 {
     width = widthA;
     height = heightA;
@@ -107,14 +107,18 @@ SplashBitmap::SplashBitmap(int widthA, int heightA, int rowPadA, SplashColorMode
         rowSize += rowPad - 1;
         rowSize -= rowSize % rowPad;
     }
-    data = (SplashColorPtr)gmallocn_checkoverflow(rowSize, height);
+    if (zeroed) {
+        data = (SplashColorPtr)gcallocn_checkoverflow(rowSize, height);
+    } else {
+        data = (SplashColorPtr)gmallocn_checkoverflow(rowSize, height);
+    }
     if (data != nullptr) {
         if (!topDown) {
             data += (height - 1) * rowSize;
             rowSize = -rowSize;
         }
         if (alphaA) {
-            alpha = (unsigned char *)gmallocn(width, height);
+            alpha = (unsigned char *)(zeroed ? gcallocn(width, height) : gmallocn(width, height));
         } else {
             alpha = nullptr;
         }
@@ -368,7 +372,23 @@ SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, FILE *f, in
     ImgWriter *writer;
     SplashError e;
 
-    SplashColorMode imageWriterFormat = splashModeRGB8;
+    SplashColorMode imageWriterFormat;
+
+    writer = createImgWriter(format, mode, &imageWriterFormat, params);
+    if (!writer) {
+        return splashErrGeneric;
+    }
+
+    e = writeImgFile(writer, f, hDPI, vDPI, imageWriterFormat);
+    delete writer;
+    return e;
+}
+
+ImgWriter *SplashBitmap::createImgWriter(SplashImageFileFormat format, SplashColorMode mode, SplashColorMode *imageWriterFormat, WriteImgParams *params)
+{
+    ImgWriter *writer;
+
+    *imageWriterFormat = splashModeRGB8;
 
     switch (format) {
 #ifdef ENABLE_LIBPNG
@@ -393,11 +413,11 @@ SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, FILE *f, in
         switch (mode) {
         case splashModeMono1:
             writer = new TiffWriter(TiffWriter::MONOCHROME);
-            imageWriterFormat = splashModeMono1;
+            *imageWriterFormat = splashModeMono1;
             break;
         case splashModeMono8:
             writer = new TiffWriter(TiffWriter::GRAY);
-            imageWriterFormat = splashModeMono8;
+            *imageWriterFormat = splashModeMono8;
             break;
         case splashModeRGB8:
         case splashModeBGR8:
@@ -421,12 +441,10 @@ SplashError SplashBitmap::writeImgFile(SplashImageFileFormat format, FILE *f, in
         // Not the greatest error message, but users of this function should
         // have already checked whether their desired format is compiled in.
         error(errInternal, -1, "Support for this image type not compiled in");
-        return splashErrGeneric;
+        return nullptr;
     }
 
-    e = writeImgFile(writer, f, hDPI, vDPI, imageWriterFormat);
-    delete writer;
-    return e;
+    return writer;
 }
 
 #include "poppler/GfxState_helpers.h"
@@ -651,22 +669,30 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
         return splashErrGeneric;
     }
 
+    SplashError e = writeImgRows(writer, imageWriterFormat);
+    if (e != splashOk) {
+        return e;
+    }
+
+    if (!writer->close()) {
+        return splashErrGeneric;
+    }
+
+    return splashOk;
+}
+
+SplashError SplashBitmap::writeImgRows(ImgWriter *writer, SplashColorMode imageWriterFormat)
+{
     switch (mode) {
     case splashModeCMYK8:
         if (writer->supportCMYK()) {
-            SplashColorPtr row;
-            unsigned char **row_pointers = new unsigned char *[height];
-            row = data;
-
+            SplashColorPtr row = data;
             for (int y = 0; y < height; ++y) {
-                row_pointers[y] = row;
+                if (!writer->writeRow(&row)) {
+                    return splashErrGeneric;
+                }
                 row += rowSize;
             }
-            if (!writer->writePointers(row_pointers, height)) {
-                delete[] row_pointers;
-                return splashErrGeneric;
-            }
-            delete[] row_pointers;
         } else {
             unsigned char *row = new unsigned char[3 * width];
             for (int y = 0; y < height; y++) {
@@ -703,19 +729,13 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
         }
         break;
     case splashModeRGB8: {
-        SplashColorPtr row;
-        unsigned char **row_pointers = new unsigned char *[height];
-        row = data;
-
+        SplashColorPtr row = data;
         for (int y = 0; y < height; ++y) {
-            row_pointers[y] = row;
+            if (!writer->writeRow(&row)) {
+                return splashErrGeneric;
+            }
             row += rowSize;
         }
-        if (!writer->writePointers(row_pointers, height)) {
-            delete[] row_pointers;
-            return splashErrGeneric;
-        }
-        delete[] row_pointers;
     } break;
 
     case splashModeBGR8: {
@@ -756,19 +776,13 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
 
     case splashModeMono8: {
         if (imageWriterFormat == splashModeMono8) {
-            SplashColorPtr row;
-            unsigned char **row_pointers = new unsigned char *[height];
-            row = data;
-
+            SplashColorPtr row = data;
             for (int y = 0; y < height; ++y) {
-                row_pointers[y] = row;
+                if (!writer->writeRow(&row)) {
+                    return splashErrGeneric;
+                }
                 row += rowSize;
             }
-            if (!writer->writePointers(row_pointers, height)) {
-                delete[] row_pointers;
-                return splashErrGeneric;
-            }
-            delete[] row_pointers;
         } else if (imageWriterFormat == splashModeRGB8) {
             unsigned char *row = new unsigned char[3 * width];
             for (int y = 0; y < height; y++) {
@@ -793,19 +807,13 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
 
     case splashModeMono1: {
         if (imageWriterFormat == splashModeMono1) {
-            SplashColorPtr row;
-            unsigned char **row_pointers = new unsigned char *[height];
-            row = data;
-
+            SplashColorPtr row = data;
             for (int y = 0; y < height; ++y) {
-                row_pointers[y] = row;
+                if (!writer->writeRow(&row)) {
+                    return splashErrGeneric;
+                }
                 row += rowSize;
             }
-            if (!writer->writePointers(row_pointers, height)) {
-                delete[] row_pointers;
-                return splashErrGeneric;
-            }
-            delete[] row_pointers;
         } else if (imageWriterFormat == splashModeRGB8) {
             unsigned char *row = new unsigned char[3 * width];
             for (int y = 0; y < height; y++) {
@@ -829,11 +837,7 @@ SplashError SplashBitmap::writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int
     } break;
 
     default:
-        // can't happen
-        break;
-    }
-
-    if (!writer->close()) {
+        error(errInternal, -1, "unsupported SplashBitmap mode");
         return splashErrGeneric;
     }
 
@@ -49,8 +49,12 @@ public:
     // Create a new bitmap.  It will have <widthA> x <heightA> pixels in
     // color mode <modeA>.  Rows will be padded out to a multiple of
     // <rowPad> bytes.  If <topDown> is false, the bitmap will be stored
-    // upside-down, i.e., with the last row first in memory.
-    SplashBitmap(int widthA, int heightA, int rowPad, SplashColorMode modeA, bool alphaA, bool topDown = true, std::vector<GfxSeparationColorSpace *> *separationList = nullptr);
+    // upside-down, i.e., with the last row first in memory.  If
+    // <zeroed> is true, the pixels and alpha values start out as zeroes;
+    // the memory is then requested zero-filled from the system, which
+    // doesn't touch (or, for large bitmaps, even commit) the pages that
+    // are never drawn to.
+    SplashBitmap(int widthA, int heightA, int rowPad, SplashColorMode modeA, bool alphaA, bool topDown = true, std::vector<GfxSeparationColorSpace *> *separationList = nullptr, bool zeroed = false);
     static SplashBitmap *copy(SplashBitmap *src);
 
     ~SplashBitmap();
@@ -84,6 +88,17 @@ public:
     SplashError writeImgFile(SplashImageFileFormat format, FILE *f, int hDPI, int vDPI, WriteImgParams *params = nullptr);
     SplashError writeImgFile(ImgWriter *writer, FILE *f, int hDPI, int vDPI, SplashColorMode imageWriterFormat);
 
+    // Write the rows of the bitmap to <writer>, which has already been
+    // initialized.  Used to write an image a strip at a time: the writer
+    // is initialized with the size of the whole image, then each strip
+    // bitmap is written in turn, then the writer is closed.
+    SplashError writeImgRows(ImgWriter *writer, SplashColorMode imageWriterFormat);
+
+    // Create the writer that writeImgFile uses for <format> and bitmaps
+    // in <mode>, and set *imageWriterFormat to the mode of the rows to
+    // pass to it.  Returns nullptr if <format> isn't compiled in.
+    static ImgWriter *createImgWriter(SplashImageFileFormat format, SplashColorMode mode, SplashColorMode *imageWriterFormat, WriteImgParams *params = nullptr);
+
     enum ConversionMode
     {
         conversionOpaque,
@@ -117,7 +132,7 @@ private:
 
     friend class Splash;
 
-    void setJpegParams(ImgWriter *writer, WriteImgParams *params);
+    static void setJpegParams(ImgWriter *writer, WriteImgParams *params);
 };
 
 #endif
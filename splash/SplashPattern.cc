@@ -55,3 +55,9 @@ bool SplashSolidColor::getColor(int x, int y, SplashColorPtr c)
 //------------------------------------------------------------------------
 
 SplashGouraudColor::~SplashGouraudColor() = default;
+
+//------------------------------------------------------------------------
+// SplashPatchMeshColor
+//------------------------------------------------------------------------
+
+SplashPatchMeshColor::~SplashPatchMeshColor() = default;
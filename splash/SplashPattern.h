@@ -22,6 +22,8 @@
 #ifndef SPLASHPATTERN_H
 #define SPLASHPATTERN_H
 
+#include <vector>
+
 #include "SplashTypes.h"
 
 class SplashScreen;
@@ -103,4 +105,37 @@ public:
     virtual void getParameterizedColor(double t, SplashColorMode mode, SplashColorPtr c) = 0;
 };
 
+//------------------------------------------------------------------------
+// SplashPatchMeshColor (needed for patchMeshShadedFill)
+//------------------------------------------------------------------------
+
+// A vertex of a patch flattened into a grid, in device space.
+struct SplashPatchMeshVertex
+{
+    double x, y;
+    double t; // parameter value, for parameterized shadings
+    SplashColor color; // color, for non-parameterized shadings
+};
+
+class SplashPatchMeshColor : public SplashPattern
+{
+public:
+    ~SplashPatchMeshColor() override;
+
+    virtual bool isParameterized() = 0;
+
+    virtual int getNPatches() = 0;
+
+    // Get a bounding box of the whole mesh, in device space.
+    virtual void getBBox(double *xMin, double *yMin, double *xMax, double *yMax) = 0;
+
+    // Flatten patch <i> into a grid of (n + 1) x (n + 1) vertices, fine
+    // enough to be drawn as 2 * n * n Gouraud shaded triangles, and
+    // return n.  The vertices are stored row by row into <grid>, with
+    // their colors in <mode>.
+    virtual int getPatchGrid(int i, SplashColorMode mode, std::vector<SplashPatchMeshVertex> *grid) = 0;
+
+    virtual void getParameterizedColor(double t, SplashColorMode mode, SplashColorPtr c) = 0;
+};
+
 #endif
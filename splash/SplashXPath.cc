@@ -273,109 +273,42 @@ void SplashXPath::grow(int nSegs)
     }
 }
 
+// Flatten a curve into segments of equal parameter length, their
+// number derived from the curvature, and evaluate the points by forward
+// differencing.
 void SplashXPath::addCurve(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1, SplashCoord x2, SplashCoord y2, SplashCoord x3, SplashCoord y3, SplashCoord flatness, bool first, bool last, bool end0, bool end1)
 {
-    SplashCoord *cx = new SplashCoord[(splashMaxCurveSplits + 1) * 3];
-    SplashCoord *cy = new SplashCoord[(splashMaxCurveSplits + 1) * 3];
-    int *cNext = new int[splashMaxCurveSplits + 1];
-    SplashCoord xl0, xl1, xl2, xr0, xr1, xr2, xr3, xx1, xx2, xh;
-    SplashCoord yl0, yl1, yl2, yr0, yr1, yr2, yr3, yy1, yy2, yh;
-    SplashCoord dx, dy, mx, my, d1, d2, flatness2;
-    int p1, p2, p3;
-
-    flatness2 = flatness * flatness;
-
-    // initial segment
-    p1 = 0;
-    p2 = splashMaxCurveSplits;
-
-    *(cx + p1 * 3 + 0) = x0;
-    *(cx + p1 * 3 + 1) = x1;
-    *(cx + p1 * 3 + 2) = x2;
-    *(cx + p2 * 3 + 0) = x3;
-
-    *(cy + p1 * 3 + 0) = y0;
-    *(cy + p1 * 3 + 1) = y1;
-    *(cy + p1 * 3 + 2) = y2;
-    *(cy + p2 * 3 + 0) = y3;
-
-    *(cNext + p1) = p2;
-
-    while (p1 < splashMaxCurveSplits) {
-
-        // get the next segment
-        xl0 = *(cx + p1 * 3 + 0);
-        xx1 = *(cx + p1 * 3 + 1);
-        xx2 = *(cx + p1 * 3 + 2);
-
-        yl0 = *(cy + p1 * 3 + 0);
-        yy1 = *(cy + p1 * 3 + 1);
-        yy2 = *(cy + p1 * 3 + 2);
-
-        p2 = *(cNext + p1);
-
-        xr3 = *(cx + p2 * 3 + 0);
-        yr3 = *(cy + p2 * 3 + 0);
-
-        // compute the distances from the control points to the
-        // midpoint of the straight line (this is a bit of a hack, but
-        // it's much faster than computing the actual distances to the
-        // line)
-        mx = (xl0 + xr3) * 0.5;
-        my = (yl0 + yr3) * 0.5;
-        dx = xx1 - mx;
-        dy = yy1 - my;
-        d1 = dx * dx + dy * dy;
-        dx = xx2 - mx;
-        dy = yy2 - my;
-        d2 = dx * dx + dy * dy;
-
-        // if the curve is flat enough, or no more subdivisions are
-        // allowed, add the straight line segment
-        if (p2 - p1 == 1 || (d1 <= flatness2 && d2 <= flatness2)) {
-            addSegment(xl0, yl0, xr3, yr3);
-            p1 = p2;
-
-            // otherwise, subdivide the curve
-        } else {
-            xl1 = (xl0 + xx1) * 0.5;
-            yl1 = (yl0 + yy1) * 0.5;
-            xh = (xx1 + xx2) * 0.5;
-            yh = (yy1 + yy2) * 0.5;
-            xl2 = (xl1 + xh) * 0.5;
-            yl2 = (yl1 + yh) * 0.5;
-            xr2 = (xx2 + xr3) * 0.5;
-            yr2 = (yy2 + yr3) * 0.5;
-            xr1 = (xh + xr2) * 0.5;
-            yr1 = (yh + yr2) * 0.5;
-            xr0 = (xl2 + xr1) * 0.5;
-            yr0 = (yl2 + yr1) * 0.5;
-            // add the new subdivision points
-            p3 = (p1 + p2) / 2;
-
-            *(cx + p1 * 3 + 1) = xl1;
-            *(cx + p1 * 3 + 2) = xl2;
-
-            *(cy + p1 * 3 + 1) = yl1;
-            *(cy + p1 * 3 + 2) = yl2;
-
-            *(cNext + p1) = p3;
-
-            *(cx + p3 * 3 + 0) = xr0;
-            *(cx + p3 * 3 + 1) = xr1;
-            *(cx + p3 * 3 + 2) = xr2;
-
-            *(cy + p3 * 3 + 0) = yr0;
-            *(cy + p3 * 3 + 1) = yr1;
-            *(cy + p3 * 3 + 2) = yr2;
-
-            *(cNext + p3) = p2;
-        }
+    const int n = splashCurveSplits(x0 - 2 * x1 + x2, y0 - 2 * y1 + y2, x1 - 2 * x2 + x3, y1 - 2 * y2 + y3, flatness);
+
+    grow(n);
+    if (unlikely(!segs)) {
+        return;
     }
 
-    delete[] cx;
-    delete[] cy;
-    delete[] cNext;
+    // p(t) = a t^3 + b t^2 + c t + p0
+    const SplashCoord h = (SplashCoord)1 / n;
+    const SplashCoord ax = x3 - x0 + 3 * (x1 - x2), ay = y3 - y0 + 3 * (y1 - y2);
+    const SplashCoord bx = 3 * (x0 - 2 * x1 + x2), by = 3 * (y0 - 2 * y1 + y2);
+    const SplashCoord cx = 3 * (x1 - x0), cy = 3 * (y1 - y0);
+    SplashCoord dx = ((ax * h + bx) * h + cx) * h;
+    SplashCoord dy = ((ay * h + by) * h + cy) * h;
+    SplashCoord ddx = (6 * ax * h + 2 * bx) * h * h;
+    SplashCoord ddy = (6 * ay * h + 2 * by) * h * h;
+    const SplashCoord dddx = 6 * ax * h * h * h;
+    const SplashCoord dddy = 6 * ay * h * h * h;
+
+    SplashCoord xa = x0, ya = y0;
+    for (int i = 1; i < n; ++i) {
+        const SplashCoord xb = xa + dx, yb = ya + dy;
+        addSegment(xa, ya, xb, yb);
+        xa = xb;
+        ya = yb;
+        dx += ddx;
+        dy += ddy;
+        ddx += dddx;
+        ddy += dddy;
+    }
+    addSegment(xa, ya, x3, y3);
 }
 
 void SplashXPath::addSegment(SplashCoord x0, SplashCoord y0, SplashCoord x1, SplashCoord y1)
@@ -22,7 +22,9 @@
 #ifndef SPLASHXPATH_H
 #define SPLASHXPATH_H
 
+#include <algorithm>
 #include "SplashTypes.h"
+#include "SplashMath.h"
 
 class SplashPath;
 struct SplashXPathAdjust;
@@ -31,6 +33,26 @@ struct SplashXPathAdjust;
 
 #define splashMaxCurveSplits (1 << 10)
 
+// Number of line segments of equal parameter length needed to
+// approximate a cubic Bezier curve, given the second differences of its
+// control points, (d1x, d1y) = p0 - 2 p1 + p2 and (d2x, d2y) = p1 - 2 p2
+// + p3, in device space.  By Wang's bound, n segments are off the curve
+// by at most 3/4 max(|d1|, |d2|) / n^2.  This is kept under a tenth of
+// <flatness>, as a whole pixel (the usual flatness) would show as
+// visible corners on large curves.
+static inline int splashCurveSplits(SplashCoord d1x, SplashCoord d1y, SplashCoord d2x, SplashCoord d2y, SplashCoord flatness)
+{
+    const SplashCoord dd = std::max(d1x * d1x + d1y * d1y, d2x * d2x + d2y * d2y);
+    const SplashCoord n2 = (SplashCoord)7.5 * splashSqrt(dd) / flatness;
+    if (!(n2 > 1)) {
+        return 1;
+    }
+    if (!(n2 < (SplashCoord)splashMaxCurveSplits * splashMaxCurveSplits)) {
+        return splashMaxCurveSplits;
+    }
+    return splashCeil(splashSqrt(n2));
+}
+
 //------------------------------------------------------------------------
 // SplashXPathSeg
 //------------------------------------------------------------------------
@@ -0,0 +1,420 @@
+//========================================================================
+//
+// check-ccitt-fax-stream.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks the decoding of CCITT fax streams.  The streams are made by an
+// encoder following the ITU-T T.4 and T.6 recommendations, with K < 0,
+// K = 0 and K > 0, with and without EndOfLine, EncodedByteAlign and
+// EndOfBlock, and getChar(), getChars() and the runs of readRowRuns()
+// must all give the encoded bitmaps.  Truncated streams must give the
+// same rows with the three of them, the rows before the cut being the
+// encoded ones.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Error.h"
+#include "Object.h"
+#include "Stream.h"
+#include "test-utils.h"
+
+// A bilevel bitmap, with 1 for black.
+typedef std::vector<std::vector<unsigned char>> Bitmap;
+
+//------------------------------------------------------------------------
+// codes (T.4, tables 1 to 4)
+//------------------------------------------------------------------------
+
+static const char *const whiteTermCodes[64] = { "00110101", "000111",   "0111",     "1000",     "1011",     "1100",     "1110",     "1111",     "10011",    "10100",    "00111",    "01000",    "001000",   "000011",   "110100",   "110101",
+                                                "101010",   "101011",   "0100111",  "0001100",  "0001000",  "0010111",  "0000011",  "0000100",  "0101000",  "0101011",  "0010011",  "0100100",  "0011000",  "00000010", "00000011", "00011010",
+                                                "00011011", "00010010", "00010011", "00010100", "00010101", "00010110", "00010111", "00101000", "00101001", "00101010", "00101011", "00101100", "00101101", "00000100", "00000101", "00001010",
+                                                "00001011", "01010010", "01010011", "01010100", "01010101", "00100100", "00100101", "01011000", "01011001", "01011010", "01011011", "01001010", "01001011", "00110010", "00110011", "00110100" };
+
+// 64 to 1728
+static const char *const whiteMakeupCodes[27] = { "11011",     "10010",     "010111",    "0110111",   "00110110",  "00110111",  "01100100",  "01100101",  "01101000",  "01100111",  "011001100", "011001101", "011010010", "011010011",
+                                                  "011010100", "011010101", "011010110", "011010111", "011011000", "011011001", "011011010", "011011011", "010011000", "010011001", "010011010", "011000",    "010011011" };
+
+static const char *const blackTermCodes[64] = { "0000110111",   "010",          "11",           "10",           "011",          "0011",         "0010",         "00011",        "000101",       "000100",       "0000100",
+                                                "0000101",      "0000111",      "00000100",     "00000111",     "000011000",    "0000010111",   "0000011000",   "0000001000",   "00001100111",  "00001101000",  "00001101100",
+                                                "00000110111",  "00000101000",  "00000010111",  "00000011000",  "000011001010", "000011001011", "000011001100", "000011001101", "000001101000", "000001101001", "000001101010",
+                                                "000001101011", "000011010010", "000011010011", "000011010100", "000011010101", "000011010110", "000011010111", "000001101100", "000001101101", "000011011010", "000011011011",
+                                                "000001010100", "000001010101", "000001010110", "000001010111", "000001100100", "000001100101", "000001010010", "000001010011", "000000100100", "000000110111", "000000111000",
+                                                "000000100111", "000000101000", "000001011000", "000001011001", "000000101011", "000000101100", "000001011010", "000001100110", "000001100111" };
+
+// 64 to 1728
+static const char *const blackMakeupCodes[27] = { "0000001111",    "000011001000",  "000011001001",  "000001011011",  "000000110011",  "000000110100",  "000000110101",  "0000001101100", "0000001101101",
+                                                  "0000001001010", "0000001001011", "0000001001100", "0000001001101", "0000001110010", "0000001110011", "0000001110100", "0000001110101", "0000001110110",
+                                                  "0000001110111", "0000001010010", "0000001010011", "0000001010100", "0000001010101", "0000001011010", "0000001011011", "0000001100100", "0000001100101" };
+
+// 1792 to 2560, for both colors
+static const char *const extMakeupCodes[13] = { "00000001000", "00000001100", "00000001101", "000000010010", "000000010011", "000000010100", "000000010101", "000000010110", "000000010111", "000000011100", "000000011101", "000000011110", "000000011111" };
+
+static const char *const eolCode = "000000000001";
+static const char *const passCode = "0001";
+static const char *const horizCode = "001";
+// a1 - b1 = -3 to 3
+static const char *const vertCodes[7] = { "0000010", "000010", "010", "1", "011", "000011", "0000011" };
+
+//------------------------------------------------------------------------
+// encoder
+//------------------------------------------------------------------------
+
+class BitWriter
+{
+public:
+    void putBit(int bit)
+    {
+        if (nBits % 8 == 0) {
+            out.push_back(0);
+        }
+        if (bit) {
+            out.back() |= (char)(0x80 >> (nBits % 8));
+        }
+        ++nBits;
+    }
+    void putCode(const char *code)
+    {
+        for (const char *p = code; *p; ++p) {
+            putBit(*p == '1');
+        }
+    }
+    // Pad with zero bits up to a byte boundary, or so that the next
+    // <n> bits end on one.
+    void align(int n = 0)
+    {
+        while ((nBits + n) % 8) {
+            putBit(0);
+        }
+    }
+    size_t bits() const { return nBits; }
+    const std::string &data() const { return out; }
+
+private:
+    std::string out;
+    size_t nBits = 0;
+};
+
+static void putRun(BitWriter *w, int run, bool black)
+{
+    while (run >= 2560) {
+        w->putCode(extMakeupCodes[12]);
+        run -= 2560;
+    }
+    if (run >= 1792) {
+        w->putCode(extMakeupCodes[run / 64 - 28]);
+    } else if (run >= 64) {
+        w->putCode(black ? blackMakeupCodes[run / 64 - 1] : whiteMakeupCodes[run / 64 - 1]);
+    }
+    w->putCode(black ? blackTermCodes[run % 64] : whiteTermCodes[run % 64]);
+}
+
+static int pixel(const std::vector<unsigned char> &row, int x)
+{
+    return x >= 0 && x < (int)row.size() ? row[x] : 0;
+}
+
+// Return the first changing element of <row> after <x>, or the width of
+// the row.
+static int nextChange(const std::vector<unsigned char> &row, int x)
+{
+    for (int i = x + 1; i < (int)row.size(); ++i) {
+        if (pixel(row, i) != pixel(row, i - 1)) {
+            return i;
+        }
+    }
+    return (int)row.size();
+}
+
+// T.4, section 4.1.
+static void encode1D(BitWriter *w, const std::vector<unsigned char> &row)
+{
+    // the first run is white, maybe empty
+    int color = 0;
+    for (int x = 0; x < (int)row.size(); color ^= 1) {
+        int end = x;
+        while (end < (int)row.size() && row[end] == color) {
+            ++end;
+        }
+        putRun(w, end - x, color);
+        x = end;
+    }
+}
+
+// T.4, section 4.2, with the row above being <ref>.
+static void encode2D(BitWriter *w, const std::vector<unsigned char> &row, const std::vector<unsigned char> &ref)
+{
+    const int columns = (int)row.size();
+    int a0 = -1;
+    int color = 0;
+    while (a0 < columns) {
+        const int a1 = nextChange(row, a0);
+        int b1 = nextChange(ref, a0);
+        if (b1 < columns && pixel(ref, b1) == color) {
+            b1 = nextChange(ref, b1);
+        }
+        const int b2 = nextChange(ref, b1);
+        if (b2 < a1) {
+            w->putCode(passCode);
+            a0 = b2;
+        } else if (a1 - b1 >= -3 && a1 - b1 <= 3) {
+            w->putCode(vertCodes[a1 - b1 + 3]);
+            a0 = a1;
+            color ^= 1;
+        } else {
+            const int a2 = nextChange(row, a1);
+            w->putCode(horizCode);
+            putRun(w, a1 - (a0 < 0 ? 0 : a0), color);
+            putRun(w, a2 - a1, !color);
+            a0 = a2;
+        }
+    }
+}
+
+struct Params
+{
+    int k;
+    bool endOfLine;
+    bool byteAlign;
+    bool endOfBlock;
+    bool blackIs1;
+};
+
+// Return the encoded <bitmap>, and the number of bits up to the end of
+// each row in <rowEnds>.
+static std::string encode(const Bitmap &bitmap, const Params &params, std::vector<size_t> *rowEnds)
+{
+    BitWriter w;
+    rowEnds->clear();
+    for (size_t y = 0; y < bitmap.size(); ++y) {
+        if (params.endOfLine) {
+            // with EncodedByteAlign, the EOL codes end on byte boundaries
+            if (params.byteAlign) {
+                w.align(12);
+            }
+            w.putCode(eolCode);
+        } else if (params.byteAlign) {
+            w.align();
+        }
+        const bool twoD = params.k < 0 || (params.k > 0 && y % params.k != 0);
+        if (params.k > 0) {
+            w.putBit(!twoD);
+        }
+        if (twoD) {
+            encode2D(&w, bitmap[y], y > 0 ? bitmap[y - 1] : std::vector<unsigned char>(bitmap[y].size(), 0));
+        } else {
+            encode1D(&w, bitmap[y]);
+        }
+        rowEnds->push_back(w.bits());
+    }
+    if (params.endOfBlock) {
+        if (params.byteAlign) {
+            w.align(params.endOfLine ? 12 : 0);
+        }
+        // EOFB, or RTC
+        for (int i = 0; i < (params.k < 0 ? 2 : 6); ++i) {
+            w.putCode(eolCode);
+            if (params.k > 0) {
+                w.putBit(1);
+            }
+        }
+    }
+    w.align();
+    return w.data();
+}
+
+//------------------------------------------------------------------------
+// decoding
+//------------------------------------------------------------------------
+
+static int decodingErrors = 0;
+
+static void countError(ErrorCategory /*category*/, Goffset /*pos*/, const char * /*msg*/)
+{
+    ++decodingErrors;
+}
+
+static int rowBytes(int columns)
+{
+    return (columns + 7) >> 3;
+}
+
+// Return the rows of <bitmap> packed as the stream gives them.
+static std::string pack(const Bitmap &bitmap, size_t rows, int columns, bool blackIs1)
+{
+    std::string packed;
+    for (size_t y = 0; y < rows; ++y) {
+        for (int i = 0; i < rowBytes(columns); ++i) {
+            unsigned char c = 0;
+            for (int x = i * 8; x < i * 8 + 8 && x < columns; ++x) {
+                if (!bitmap[y][x]) {
+                    c |= 0x80 >> (x & 7);
+                }
+            }
+            packed.push_back((char)(blackIs1 ? c ^ 0xff : c));
+        }
+    }
+    return packed;
+}
+
+static CCITTFaxStream *makeStream(const std::string &data, const Params &params, int columns, int rows)
+{
+    return new CCITTFaxStream(new MemStream(data.data(), 0, data.size(), Object(objNull)), params.k, params.endOfLine, params.byteAlign, columns, params.endOfBlock ? 0 : rows, params.endOfBlock, params.blackIs1, 0);
+}
+
+static std::string decodeWithGetChar(CCITTFaxStream *str)
+{
+    std::string out;
+    int c;
+    str->reset();
+    while ((c = str->getChar()) != EOF) {
+        out.push_back((char)c);
+    }
+    str->close();
+    return out;
+}
+
+static std::string decodeWithGetChars(CCITTFaxStream *str)
+{
+    static const int chunks[4] = { 1, 5, 13, 64 };
+    std::string out;
+    unsigned char buf[64];
+    int n;
+    str->reset();
+    for (int i = 0; (n = str->doGetChars(chunks[i % 4], buf)) > 0; ++i) {
+        out.append((const char *)buf, n);
+    }
+    str->close();
+    return out;
+}
+
+static std::string decodeWithRuns(CCITTFaxStream *str, int columns, bool blackIs1)
+{
+    std::string out;
+    std::vector<int> runs;
+    str->reset();
+    while (str->readRowRuns(&runs)) {
+        Bitmap row(1, std::vector<unsigned char>(columns, 0));
+        int x = 0;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            TEST_CHECK(runs[i] >= 0 && x + runs[i] <= columns);
+            for (int j = 0; j < runs[i] && x < columns; ++j) {
+                row[0][x++] = i & 1;
+            }
+        }
+        TEST_CHECK(x == columns);
+        out += pack(row, 1, columns, blackIs1);
+    }
+    str->close();
+    return out;
+}
+
+// Decode <data> with getChar(), getChars() and readRowRuns(), which must
+// give the same rows, and return them.
+static std::string decode(const std::string &data, const Params &params, int columns, int rows)
+{
+    CCITTFaxStream *str = makeStream(data, params, columns, rows);
+    const std::string out = decodeWithGetChar(str);
+    TEST_CHECK(decodeWithGetChars(str) == out);
+    TEST_CHECK(decodeWithRuns(str, columns, params.blackIs1) == out);
+    TEST_CHECK(out.size() % rowBytes(columns) == 0);
+    delete str;
+    return out;
+}
+
+//------------------------------------------------------------------------
+
+// Return a bitmap whose rows repeat the one above, move its changing
+// elements by a few pixels, are white, black, or random runs, short or
+// long.
+static Bitmap randomBitmap(std::mt19937 &rng, int columns, int rows)
+{
+    Bitmap bitmap(rows, std::vector<unsigned char>(columns, 0));
+    for (int y = 0; y < rows; ++y) {
+        std::vector<unsigned char> &row = bitmap[y];
+        const unsigned int kind = rng() % 20;
+        if (kind < 3) {
+            if (y > 0) {
+                row = bitmap[y - 1];
+            }
+        } else if (kind < 8) {
+            // toggle the color at each moved changing element
+            std::vector<unsigned char> toggles(columns + 1, 0);
+            for (int x = y > 0 ? nextChange(bitmap[y - 1], -1) : columns; x < columns; x = nextChange(bitmap[y - 1], x)) {
+                const int moved = std::max(0, std::min(columns, x + (int)(rng() % 7) - 3));
+                toggles[moved] ^= 1;
+            }
+            unsigned char color = 0;
+            for (int x = 0; x < columns; ++x) {
+                color ^= toggles[x];
+                row[x] = color;
+            }
+        } else if (kind < 18) {
+            unsigned char color = rng() % 2;
+            for (int x = 0; x < columns; color ^= 1) {
+                const unsigned int length = rng() % 10;
+                int run = length < 5 ? 1 + rng() % 4 : length < 8 ? 1 + rng() % 64 : 1 + rng() % columns;
+                for (; run > 0 && x < columns; --run) {
+                    row[x++] = color;
+                }
+            }
+        } else {
+            row.assign(columns, kind == 19);
+        }
+    }
+    return bitmap;
+}
+
+static void checkDecoding(const Params &params, std::mt19937 &rng)
+{
+    const int widths[] = { 1, 2, 7, 8, 9, 17, 63, 64, 65, 200, 1728, 2600, 5200 };
+    for (const int columns : widths) {
+        for (int n = 0; n < 4; ++n) {
+            const int rows = 1 + rng() % (columns > 1000 ? 8 : 30);
+            const Bitmap bitmap = randomBitmap(rng, columns, rows);
+            std::vector<size_t> rowEnds;
+            const std::string data = encode(bitmap, params, &rowEnds);
+
+            decodingErrors = 0;
+            TEST_CHECK(decode(data, params, columns, rows) == pack(bitmap, rows, columns, params.blackIs1));
+            TEST_CHECK(decodingErrors == 0);
+
+            // the rows encoded before the cut are decoded, whatever the
+            // rest of the truncated stream gives
+            for (int i = 1; i <= 8; ++i) {
+                const size_t length = i < 8 ? data.size() * i / 8 : data.size() - 1;
+                size_t complete = 0;
+                while (complete < rowEnds.size() && rowEnds[complete] <= 8 * length) {
+                    ++complete;
+                }
+                const std::string out = decode(data.substr(0, length), params, columns, rows);
+                const std::string expected = pack(bitmap, complete, columns, params.blackIs1);
+                TEST_CHECK(out.compare(0, expected.size(), expected) == 0);
+            }
+        }
+    }
+}
+
+int main()
+{
+    setErrorCallback(countError);
+
+    std::mt19937 rng(1);
+    // K, EndOfLine, EncodedByteAlign, EndOfBlock, BlackIs1
+    const Params params[] = { { -1, false, false, true, false }, { -1, false, true, true, false }, { -1, false, false, false, false }, { -1, false, true, false, true },
+                              { 0, false, false, true, false },  { 0, true, false, true, false },  { 0, false, true, true, true },    { 0, true, true, true, false },
+                              { 0, false, false, false, false }, { 0, false, true, false, false }, { 2, true, false, true, false },   { 4, false, false, true, true },
+                              { 3, false, true, false, false },  { 2, true, true, true, false },   { 1, false, false, false, false } };
+    for (const Params &p : params) {
+        checkDecoding(p, rng);
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+//========================================================================
+//
+// check-font-match-cache.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks the file cache of system font matches of GlobalParams: hits,
+// invalidation, merging the matches of several writers, and reading
+// damaged files.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "goo/GooString.h"
+#include "GfxFont.h"
+#include "GlobalParams.h"
+#include "PDFDoc.h"
+#include "XRef.h"
+#include "test-utils.h"
+
+static const int numFonts = 8;
+
+// Return the path of the system font matched for <font> by <params>, or
+// an empty string.
+static std::string findFont(GlobalParams *params, const GfxFont *font)
+{
+    SysFontType type;
+    int fontNum;
+    std::unique_ptr<GooString> path(params->findSystemFontFile(font, &type, &fontNum));
+    return path ? path->toStr() : std::string();
+}
+
+static std::string readFile(const std::string &fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    std::ostringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+static std::vector<std::string> split(const std::string &s, char sep)
+{
+    std::vector<std::string> fields(1);
+    for (char c : s) {
+        if (c == sep) {
+            fields.emplace_back();
+        } else {
+            fields.back().push_back(c);
+        }
+    }
+    return fields;
+}
+
+// Return the number of matches in the cache file <fileName>, or -1 if
+// it isn't a well formed one.
+static int countMatches(const std::string &fileName)
+{
+    std::vector<std::string> lines = split(readFile(fileName), '\n');
+    if (lines.size() < 2 || !lines.back().empty() || split(lines[0], '\t').size() != 2 || split(lines[0], '\t')[0] != "poppler-font-match-cache-1") {
+        return -1;
+    }
+    for (size_t i = 1; i + 1 < lines.size(); ++i) {
+        if (split(lines[i], '\t').size() != 8) {
+            return -1;
+        }
+    }
+    return (int)lines.size() - 2;
+}
+
+// Replace the font path of every match of the cache file <fileName> with
+// <path>, and its stamp with <stamp> if it isn't empty.
+static void rewriteMatches(const std::string &fileName, const std::string &path, const std::string &stamp)
+{
+    std::vector<std::string> lines = split(readFile(fileName), '\n');
+    std::string data;
+    for (size_t i = 0; i + 1 < lines.size(); ++i) {
+        std::vector<std::string> fields = split(lines[i], '\t');
+        if (i == 0 && !stamp.empty()) {
+            fields[1] = stamp;
+        } else if (i > 0) {
+            fields[1] = path;
+        }
+        for (size_t j = 0; j < fields.size(); ++j) {
+            data += (j ? "\t" : "") + fields[j];
+        }
+        data += "\n";
+    }
+    TEST_CHECK(testWriteFile(fileName, data));
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-font-match-cache <work-dir>\n");
+        return 99;
+    }
+    const std::string workDir = std::string(argv[1]) + "/check-font-match-cache.dir";
+    const std::string pdfFileName = workDir + "/fonts.pdf";
+    const std::string cacheFileName = workDir + "/fonts.cache";
+    const std::string markerPath = workDir + "/marker.ttf";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(workDir);
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    // a page using non-embedded fonts that aren't installed
+    std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>", "" };
+    std::string fontResources;
+    for (int i = 0; i < numFonts; ++i) {
+        fontResources += "/F" + std::to_string(i) + " " + std::to_string(objects.size() + 1) + " 0 R ";
+        objects.push_back("<< /Type /Font /Subtype /Type1 /BaseFont /PopplerCheckFont" + std::to_string(i) + (i % 2 ? "-Bold" : "") + " >>");
+    }
+    objects[2] = "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << " + fontResources + ">> >> >>";
+    TEST_CHECK(testWriteFile(pdfFileName, testPdf(objects)));
+
+    PDFDoc doc(new GooString(pdfFileName));
+    TEST_CHECK(doc.isOk());
+    if (!doc.isOk()) {
+        return 1;
+    }
+    std::vector<GfxFont *> fonts;
+    for (int i = 0; i < numFonts; ++i) {
+        const Ref ref = { 4 + i, 0 };
+        Object fontObj = doc.getXRef()->fetch(ref);
+        fonts.push_back(GfxFont::makeFont(doc.getXRef(), ("F" + std::to_string(i)).c_str(), ref, fontObj.getDict()));
+    }
+
+    // the matches are saved, and the file isn't rewritten when no new
+    // match was found
+    std::vector<std::string> expected;
+    {
+        GlobalParams params;
+        params.setFontMatchCacheFile(cacheFileName.c_str());
+        for (int i = 0; i < 2; ++i) {
+            expected.push_back(findFont(&params, fonts[i]));
+        }
+        TEST_CHECK(params.saveFontMatchCache());
+        TEST_CHECK(countMatches(cacheFileName) == 2);
+    }
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(cacheFileName) - std::chrono::seconds(60);
+    std::filesystem::last_write_time(cacheFileName, mtime);
+    {
+        GlobalParams params;
+        params.setFontMatchCacheFile(cacheFileName.c_str());
+        for (int i = 0; i < 2; ++i) {
+            TEST_CHECK(findFont(&params, fonts[i]) == expected[i]);
+        }
+    }
+    TEST_CHECK(std::filesystem::last_write_time(cacheFileName) == mtime);
+
+    // nor when another writer already saved the same matches
+    {
+        GlobalParams params1, params2;
+        params1.setFontMatchCacheFile((cacheFileName + ".2").c_str());
+        params2.setFontMatchCacheFile((cacheFileName + ".2").c_str());
+        findFont(&params1, fonts[0]);
+        findFont(&params2, fonts[0]);
+        TEST_CHECK(params1.saveFontMatchCache());
+        std::filesystem::last_write_time(cacheFileName + ".2", mtime);
+        TEST_CHECK(params2.saveFontMatchCache());
+        TEST_CHECK(std::filesystem::last_write_time(cacheFileName + ".2") == mtime);
+    }
+    std::filesystem::remove(cacheFileName + ".2");
+
+    // matches are read from the file
+    rewriteMatches(cacheFileName, markerPath, "");
+    {
+        GlobalParams params;
+        params.setFontMatchCacheFile(cacheFileName.c_str());
+        for (int i = 0; i < 2; ++i) {
+            TEST_CHECK(findFont(&params, fonts[i]) == markerPath);
+        }
+    }
+
+    // a file written for another font configuration is ignored, and
+    // replaced by the new matches
+    rewriteMatches(cacheFileName, markerPath, "123abc");
+    {
+        GlobalParams params;
+        params.setFontMatchCacheFile(cacheFileName.c_str());
+        for (int i = 0; i < 2; ++i) {
+            TEST_CHECK(findFont(&params, fonts[i]) == expected[i]);
+        }
+    }
+    TEST_CHECK(countMatches(cacheFileName) == 2);
+    TEST_CHECK(readFile(cacheFileName).find("123abc") == std::string::npos);
+
+    // the matches of writers sharing the file are merged
+    {
+        GlobalParams params1, params2;
+        params1.setFontMatchCacheFile(cacheFileName.c_str());
+        params2.setFontMatchCacheFile(cacheFileName.c_str());
+        findFont(&params1, fonts[2]);
+        findFont(&params2, fonts[3]);
+        TEST_CHECK(params1.saveFontMatchCache());
+        TEST_CHECK(params2.saveFontMatchCache());
+        TEST_CHECK(countMatches(cacheFileName) == 4);
+    }
+
+    // concurrent writers never leave a partial file behind
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&fonts, &cacheFileName, t]() {
+                for (int round = 0; round < 20; ++round) {
+                    GlobalParams params;
+                    params.setFontMatchCacheFile(cacheFileName.c_str());
+                    findFont(&params, fonts[4 + t]);
+                    params.saveFontMatchCache();
+                }
+            });
+        }
+        for (int round = 0; round < 200; ++round) {
+            const int n = countMatches(cacheFileName);
+            TEST_CHECK(n >= 4 && n <= numFonts);
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        const int n = countMatches(cacheFileName);
+        TEST_CHECK(n >= 4 && n <= numFonts);
+        int files = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(workDir)) {
+            (void)entry;
+            ++files;
+        }
+        TEST_CHECK(files == 2);
+    }
+
+    // damaged files are ignored, or their bad lines skipped
+    const std::vector<std::string> damaged = { "", "garbage\n", "poppler-font-match-cache-1\n", std::string("\0\1\2\3\t\n\xff", 7), readFile(cacheFileName).substr(0, 40),
+                                               split(readFile(cacheFileName), '\n')[0] + "\nkey\t/path\t99\t0\t0\t0\t0\tname\nkey2\t/path\n\\\n" };
+    for (const std::string &data : damaged) {
+        TEST_CHECK(testWriteFile(cacheFileName, data));
+        GlobalParams params;
+        params.setFontMatchCacheFile(cacheFileName.c_str());
+        for (int i = 0; i < 2; ++i) {
+            TEST_CHECK(findFont(&params, fonts[i]) == expected[i]);
+        }
+        TEST_CHECK(params.saveFontMatchCache());
+        TEST_CHECK(countMatches(cacheFileName) == 2);
+    }
+
+    for (GfxFont *font : fonts) {
+        font->decRefCnt();
+    }
+    std::filesystem::remove_all(workDir);
+
+    return testFailures() == 0 ? 0 : 1;
+}
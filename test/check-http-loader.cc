@@ -0,0 +1,436 @@
+//========================================================================
+//
+// check-http-loader.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks loading files over HTTP with CurlCachedFileLoader, and
+// prefetching the pages of a linearized file from its hint tables.
+// Run by range-server.py, which serves the work directory and logs the
+// requests it gets.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "goo/GooString.h"
+#include "CachedFile.h"
+#include "CurlCachedFile.h"
+#include "GlobalParams.h"
+#include "Hints.h"
+#include "Linearization.h"
+#include "PDFDoc.h"
+#include "Page.h"
+#include "Stream.h"
+#include "test-utils.h"
+
+static const int numPages = 3;
+
+//------------------------------------------------------------------------
+// a linearized file
+//------------------------------------------------------------------------
+
+// A linearized file of <numPages> pages using a font shared by all of
+// them, with the byte ranges its hint tables give for each page.
+struct LinearizedPdf
+{
+    std::string data;
+    std::vector<ByteRange> pageRanges[numPages];
+
+    // the layout of the file
+    std::vector<size_t> offsets = std::vector<size_t>(12, 0);
+    size_t hintsOffset = 0;
+    size_t hintsLength = 0;
+    size_t mainXRef = 0;
+    size_t mainXRefEntries = 0;
+};
+
+// Append <n> bits of <value> to <bits>.
+static void appendBits(std::vector<bool> *bits, uint32_t value, int n)
+{
+    for (int i = n - 1; i >= 0; --i) {
+        bits->push_back((value >> i) & 1);
+    }
+}
+
+static std::string bitsToBytes(std::vector<bool> bits)
+{
+    std::string bytes;
+    while (bits.size() % 8) {
+        bits.push_back(false);
+    }
+    for (size_t i = 0; i < bits.size(); i += 8) {
+        char c = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            c = (char)((c << 1) | bits[i + j]);
+        }
+        bytes.push_back(c);
+    }
+    return bytes;
+}
+
+static std::string padded(size_t n)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%010zu", n);
+    return buf;
+}
+
+static ByteRange byteRange(size_t offset, size_t length)
+{
+    ByteRange r;
+    r.offset = offset;
+    r.length = length;
+    return r;
+}
+
+// Objects 1 to 4 are the page dicts and contents of pages 2 and 3, the
+// first page section is made of the linearization dict (5), the hint
+// stream (6), page 1 (7), the font (8), the contents of page 1 (9), the
+// catalog (10) and the page tree (11).  Every number that depends on an
+// offset has a fixed width, so that the layout of <prev> can be used.
+static LinearizedPdf makeLinearizedPdf(size_t contentsSize, const LinearizedPdf *prev)
+{
+    const LinearizedPdf none;
+    const LinearizedPdf &p = prev ? *prev : none;
+    LinearizedPdf pdf;
+    size_t firstXRef;
+
+    auto contents = [contentsSize](int page) {
+        std::string s = "BT /F1 24 Tf 72 700 Td (Page " + std::to_string(page) + ") Tj ET\n";
+        while (s.size() < contentsSize) {
+            s += "% padding to spread the pages over several chunks of the cache\n";
+        }
+        return testStreamObject("", s);
+    };
+    auto pageDict = [](int contentsNum) { return "<< /Type /Page /Parent 11 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 8 0 R >> >> /Contents " + std::to_string(contentsNum) + " 0 R >>"; };
+    auto object = [&pdf](int num, const std::string &body) {
+        pdf.offsets[num] = pdf.data.size();
+        pdf.data += std::to_string(num) + " 0 obj\n" + body + "\nendobj\n";
+    };
+
+    // the hint tables, with the offsets of the objects after the hint
+    // stream given as if it wasn't there
+    std::vector<bool> bits;
+    const size_t page1Length = p.offsets[1] - p.offsets[7];
+    const size_t page2Length = p.offsets[3] - p.offsets[1];
+    const size_t page3Length = p.mainXRef - p.offsets[3];
+    appendBits(&bits, 2, 32); // least number of objects in a page
+    appendBits(&bits, p.offsets[7] - p.hintsLength, 32); // offset of the first page
+    appendBits(&bits, 0, 16); // bits for the number of objects
+    appendBits(&bits, 0, 32); // least page length
+    appendBits(&bits, 32, 16); // bits for the page lengths
+    appendBits(&bits, 0, 32); // least contents offset
+    appendBits(&bits, 0, 16);
+    appendBits(&bits, 0, 32); // least contents length
+    appendBits(&bits, 0, 16);
+    appendBits(&bits, 8, 16); // bits for the number of shared objects
+    appendBits(&bits, 8, 16); // bits for the shared object ids
+    appendBits(&bits, 0, 16);
+    appendBits(&bits, 1, 16);
+    appendBits(&bits, page1Length, 32);
+    appendBits(&bits, page2Length, 32);
+    appendBits(&bits, page3Length, 32);
+    appendBits(&bits, 0, 8); // page 1 uses no shared object
+    appendBits(&bits, 1, 8); // pages 2 and 3 use the font
+    appendBits(&bits, 1, 8);
+    appendBits(&bits, 1, 8);
+    appendBits(&bits, 1, 8);
+    const std::string pageOffsetTable = bitsToBytes(bits);
+    bits.clear();
+    appendBits(&bits, 0, 32); // no shared objects after the first page
+    appendBits(&bits, 0, 32);
+    appendBits(&bits, 2, 32); // groups of the first page: page 1, the font
+    appendBits(&bits, 2, 32);
+    appendBits(&bits, 0, 16);
+    appendBits(&bits, 0, 32); // least group length
+    appendBits(&bits, 32, 16); // bits for the group lengths
+    appendBits(&bits, p.offsets[8] - p.offsets[7], 32);
+    appendBits(&bits, p.offsets[9] - p.offsets[8], 32);
+    appendBits(&bits, 0, 8); // no signatures
+    const std::string hintData = pageOffsetTable + bitsToBytes(bits);
+
+    pdf.data = "%PDF-1.5\n%\xe2\xe3\xcf\xd3\n";
+    object(5,
+           "<< /Linearized 1 /L " + padded(p.data.size()) + " /H [ " + padded(p.hintsOffset) + " " + padded(p.hintsLength) + " ] /O 7 /E " + padded(p.offsets[1]) + " /N " + std::to_string(numPages) + " /T "
+                   + padded(p.mainXRefEntries) + " >>");
+    firstXRef = pdf.data.size();
+    pdf.data += "xref\n5 7\n";
+    for (int i = 5; i < 12; ++i) {
+        pdf.data += padded(p.offsets[i]) + " 00000 n \n";
+    }
+    pdf.data += "trailer\n<< /Size 12 /Root 10 0 R /Prev " + padded(p.mainXRef) + " >>\nstartxref\n0\n%%EOF\n";
+    pdf.hintsOffset = pdf.data.size();
+    object(6, testStreamObject("/S " + std::to_string(pageOffsetTable.size()), hintData));
+    pdf.hintsLength = pdf.data.size() - pdf.hintsOffset;
+    object(7, pageDict(9));
+    object(8, "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>");
+    object(9, contents(1));
+    object(10, "<< /Type /Catalog /Pages 11 0 R >>");
+    object(11, "<< /Type /Pages /Kids [7 0 R 1 0 R 3 0 R] /Count " + std::to_string(numPages) + " >>");
+    object(1, pageDict(2));
+    object(2, contents(2));
+    object(3, pageDict(4));
+    object(4, contents(3));
+    pdf.mainXRef = pdf.data.size();
+    pdf.data += "xref\n0 5\n";
+    pdf.mainXRefEntries = pdf.data.size();
+    pdf.data += "0000000000 65535 f \n";
+    for (int i = 1; i < 5; ++i) {
+        pdf.data += padded(pdf.offsets[i]) + " 00000 n \n";
+    }
+    pdf.data += "trailer\n<< /Size 12 >>\nstartxref\n" + std::to_string(firstXRef) + "\n%%EOF\n";
+
+    pdf.pageRanges[0] = { byteRange(pdf.offsets[7], pdf.offsets[1] - pdf.offsets[7]), byteRange(pdf.mainXRefEntries + 20, 0) };
+    pdf.pageRanges[1] = { byteRange(pdf.offsets[1], pdf.offsets[3] - pdf.offsets[1]), byteRange(pdf.mainXRefEntries + 20, 40), byteRange(pdf.offsets[8], pdf.offsets[9] - pdf.offsets[8]), byteRange(0, 0) };
+    pdf.pageRanges[2] = { byteRange(pdf.offsets[3], pdf.mainXRef - pdf.offsets[3]), byteRange(pdf.mainXRefEntries + 60, 40), byteRange(pdf.offsets[8], pdf.offsets[9] - pdf.offsets[8]), byteRange(0, 0) };
+    return pdf;
+}
+
+//------------------------------------------------------------------------
+// the server log
+//------------------------------------------------------------------------
+
+struct Request
+{
+    std::string path;
+    long long first; // -1 for a whole file response
+    long long last;
+    int inProgress;
+};
+
+// Return the requests logged to <logFileName> since the previous call.
+static std::vector<Request> newRequests(const std::string &logFileName)
+{
+    static size_t seen = 0;
+    std::ifstream log(logFileName);
+    std::vector<Request> requests;
+    std::string path, first;
+    size_t n = 0;
+    while (log >> path >> first) {
+        Request r;
+        r.path = path;
+        if (first == "full") {
+            r.first = r.last = -1;
+        } else {
+            r.first = std::stoll(first);
+            log >> r.last;
+        }
+        log >> r.inProgress;
+        if (n++ >= seen) {
+            requests.push_back(r);
+        }
+    }
+    seen = n;
+    std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) { return a.first < b.first; });
+    return requests;
+}
+
+static std::vector<std::pair<long long, long long>> requestedRanges(const std::vector<Request> &requests)
+{
+    std::vector<std::pair<long long, long long>> ranges;
+    for (const Request &r : requests) {
+        ranges.emplace_back(r.first, r.last);
+    }
+    return ranges;
+}
+
+// Return the chunk aligned ranges CachedFile requests to load <ranges>
+// in a file of <length> bytes, when <loaded> chunks are already loaded.
+static std::vector<std::pair<long long, long long>> chunkRanges(const std::vector<ByteRange> &ranges, size_t length, const std::set<long long> &loaded)
+{
+    const long long numChunks = length / CachedFileChunkSize + 1;
+    std::vector<bool> needed(numChunks, false);
+    for (const ByteRange &r : ranges) {
+        if (r.length == 0) {
+            continue;
+        }
+        for (long long chunk = r.offset / CachedFileChunkSize; chunk <= (long long)std::min<size_t>(r.offset + r.length - 1, length - 1) / CachedFileChunkSize; ++chunk) {
+            needed[chunk] = !loaded.count(chunk);
+        }
+    }
+    long long lastNeeded = -1;
+    for (long long chunk = 0; chunk < numChunks; ++chunk) {
+        if (!needed[chunk]) {
+            continue;
+        }
+        if (lastNeeded >= 0 && chunk - lastNeeded - 1 <= CachedFileMaxGapChunks) {
+            bool gapIsNew = true;
+            for (long long c = lastNeeded + 1; c < chunk; ++c) {
+                gapIsNew = gapIsNew && !loaded.count(c);
+            }
+            for (long long c = lastNeeded + 1; c < chunk && gapIsNew; ++c) {
+                needed[c] = true;
+            }
+        }
+        lastNeeded = chunk;
+    }
+    std::vector<std::pair<long long, long long>> chunks;
+    for (long long chunk = 0; chunk < numChunks; ++chunk) {
+        if (needed[chunk] && (chunk == 0 || !needed[chunk - 1])) {
+            chunks.emplace_back(chunk * CachedFileChunkSize, 0);
+        }
+        if (needed[chunk]) {
+            chunks.back().second = std::min<long long>((chunk + 1) * CachedFileChunkSize, length) - 1;
+        }
+    }
+    return chunks;
+}
+
+static void addLoadedChunks(const std::vector<Request> &requests, std::set<long long> *loaded)
+{
+    for (const Request &r : requests) {
+        for (long long chunk = r.first / CachedFileChunkSize; chunk <= r.last / CachedFileChunkSize; ++chunk) {
+            loaded->insert(chunk);
+        }
+    }
+}
+
+static bool readsAs(CachedFile *cachedFile, size_t offset, size_t length, const std::string &data)
+{
+    std::string buf(length, '\0');
+    return cachedFile->seek(offset, SEEK_SET) == 0 && cachedFile->read(&buf[0], 1, length) == length && buf == data.substr(offset, length);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: range-server.py <work-dir> check-http-loader <work-dir> (run with the URL of <work-dir> as last argument)\n");
+        return 99;
+    }
+    const std::string pdfFileName = std::string(argv[1]) + "/linearized.pdf";
+    const std::string logFileName = std::string(argv[1]) + "/range-server.log";
+    const std::string url = std::string(argv[2]) + "/linearized.pdf";
+    const std::string fullUrl = std::string(argv[2]) + "/full/linearized.pdf";
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    // the second pass has the right offsets, so a third changes nothing
+    LinearizedPdf pdf = makeLinearizedPdf(60000, nullptr);
+    pdf = makeLinearizedPdf(60000, &pdf);
+    TEST_CHECK(makeLinearizedPdf(60000, &pdf).data == pdf.data);
+    TEST_CHECK(testWriteFile(pdfFileName, pdf.data));
+    TEST_CHECK(pdf.data.size() > 20 * CachedFileChunkSize);
+
+    // the hint tables give the expected byte ranges
+    {
+        PDFDoc doc(new GooString(pdfFileName));
+        TEST_CHECK(doc.isOk() && doc.isLinearized());
+        TEST_CHECK(doc.getNumPages() == numPages);
+        Hints hints(doc.getBaseStream(), doc.getLinearization(), doc.getXRef(), nullptr);
+        TEST_CHECK(hints.isOk());
+        for (int page = 1; page <= numPages; ++page) {
+            std::unique_ptr<std::vector<ByteRange>> ranges(hints.getPageRanges(page));
+            const std::vector<ByteRange> &expected = pdf.pageRanges[page - 1];
+            TEST_CHECK(ranges && ranges->size() == expected.size());
+            for (size_t i = 0; ranges && i < ranges->size() && i < expected.size(); ++i) {
+                TEST_CHECK((*ranges)[i].offset == expected[i].offset && (*ranges)[i].length == expected[i].length);
+            }
+            TEST_CHECK(doc.getPage(page) != nullptr);
+        }
+    }
+
+    // ranges with short gaps between them are loaded with one request
+    const std::set<long long> noChunks;
+    newRequests(logFileName);
+    {
+        CachedFile *cachedFile = new CachedFile(new CurlCachedFileLoader(), new GooString(url));
+        TEST_CHECK(cachedFile->getLength() == pdf.data.size());
+        const std::vector<ByteRange> ranges = { byteRange(10, 10), byteRange(3 * CachedFileChunkSize + 5, 10), byteRange(9 * CachedFileChunkSize, 10) };
+        TEST_CHECK(cachedFile->cache(ranges) == 0);
+        const std::vector<std::pair<long long, long long>> expected = { { 0, 4 * CachedFileChunkSize - 1 }, { 9 * CachedFileChunkSize, 10 * CachedFileChunkSize - 1 } };
+        TEST_CHECK(requestedRanges(newRequests(logFileName)) == expected);
+        TEST_CHECK(readsAs(cachedFile, 0, 4 * CachedFileChunkSize, pdf.data));
+        TEST_CHECK(readsAs(cachedFile, 9 * CachedFileChunkSize + 100, 1000, pdf.data));
+        TEST_CHECK(newRequests(logFileName).empty());
+        cachedFile->decRefCnt();
+    }
+
+    // distant ranges are loaded concurrently, and end up in the right
+    // place
+    {
+        CachedFile *cachedFile = new CachedFile(new CurlCachedFileLoader(), new GooString(url));
+        std::vector<ByteRange> ranges;
+        for (int chunk = 0; chunk <= 18; chunk += 6) {
+            ranges.push_back(byteRange(chunk * CachedFileChunkSize + 100, 10));
+        }
+        TEST_CHECK(cachedFile->cache(ranges) == 0);
+        const std::vector<Request> requests = newRequests(logFileName);
+        TEST_CHECK(requestedRanges(requests) == chunkRanges(ranges, pdf.data.size(), noChunks));
+        int maxInProgress = 0;
+        for (const Request &r : requests) {
+            maxInProgress = std::max(maxInProgress, r.inProgress);
+        }
+        TEST_CHECK(maxInProgress > 1 && maxInProgress <= 4);
+        for (const ByteRange &r : ranges) {
+            TEST_CHECK(readsAs(cachedFile, r.offset - 100, CachedFileChunkSize, pdf.data));
+        }
+        TEST_CHECK(newRequests(logFileName).empty());
+        cachedFile->decRefCnt();
+    }
+
+    // a server answering with the whole file only serves its start
+    {
+        CachedFile *cachedFile = new CachedFile(new CurlCachedFileLoader(), new GooString(fullUrl));
+        TEST_CHECK(cachedFile->getLength() == pdf.data.size());
+        TEST_CHECK(cachedFile->cache({ byteRange(0, 100) }) == 0);
+        TEST_CHECK(readsAs(cachedFile, 0, CachedFileChunkSize, pdf.data));
+        TEST_CHECK(cachedFile->cache({ byteRange(10 * CachedFileChunkSize, 100) }) != 0);
+        char buf[100];
+        TEST_CHECK(cachedFile->seek(10 * CachedFileChunkSize, SEEK_SET) == 0 && cachedFile->read(buf, 1, sizeof(buf)) == 0);
+        for (const Request &r : newRequests(logFileName)) {
+            TEST_CHECK(r.path == "/full/linearized.pdf" && r.first == -1);
+        }
+        cachedFile->decRefCnt();
+    }
+
+    // prefetching a page loads exactly the ranges of its hint tables
+    // that aren't loaded yet, after which the page needs no more
+    // requests
+    {
+        CachedFile *cachedFile = new CachedFile(new CurlCachedFileLoader(), new GooString(url));
+        PDFDoc doc(new CachedFileStream(cachedFile, 0, false, cachedFile->getLength(), Object(objNull)));
+        TEST_CHECK(doc.isOk() && doc.isLinearized());
+        // the first use of the hint tables checks the page dicts of all
+        // the pages
+        TEST_CHECK(doc.getPage(1) != nullptr);
+        std::set<long long> loaded;
+        addLoadedChunks(newRequests(logFileName), &loaded);
+        for (int page : { 3, 2 }) {
+            TEST_CHECK(doc.prefetchPages(page, page));
+            const std::vector<Request> requests = newRequests(logFileName);
+            TEST_CHECK(!requests.empty());
+            TEST_CHECK(requestedRanges(requests) == chunkRanges(pdf.pageRanges[page - 1], pdf.data.size(), loaded));
+            addLoadedChunks(requests, &loaded);
+
+            Page *p = doc.getPage(page);
+            TEST_CHECK(p != nullptr);
+            if (p) {
+                Object contents = p->getContents();
+                TEST_CHECK(contents.isStream());
+                if (contents.isStream()) {
+                    contents.streamReset();
+                    int n = 0;
+                    while (contents.streamGetChar() != EOF) {
+                        ++n;
+                    }
+                    TEST_CHECK(n >= 60000);
+                }
+                Dict *resources = p->getResourceDict();
+                Object fonts = resources ? resources->lookup("Font") : Object();
+                TEST_CHECK(fonts.isDict() && fonts.dictLookup("F1").isDict("Font"));
+            }
+            TEST_CHECK(newRequests(logFileName).empty());
+        }
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+//========================================================================
+//
+// check-image-prefetcher.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks that ImagePrefetcher decodes the large images a page draws,
+// directly or in a form, and not the other images of its resources, nor
+// the names in the data of its inline images.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "goo/GooString.h"
+#include "GlobalParams.h"
+#include "ImagePrefetcher.h"
+#include "PDFDoc.h"
+#include "Stream.h"
+#include "test-utils.h"
+
+static std::string imageData(int size, int seed)
+{
+    std::string data;
+    for (int i = 0; i < size * size; ++i) {
+        data.push_back((char)(i * seed));
+    }
+    return data;
+}
+
+static std::string imageObject(int size, int seed)
+{
+    return testStreamObject("/Type /XObject /Subtype /Image /Width " + std::to_string(size) + " /Height " + std::to_string(size) + " /ColorSpace /DeviceGray /BitsPerComponent 8", imageData(size, seed));
+}
+
+// Return the data read from <str>, and delete it.
+static std::string readStream(Stream *str)
+{
+    std::string data;
+    str->reset();
+    for (int c; (c = str->getChar()) != EOF;) {
+        data.push_back(c);
+    }
+    str->close();
+    delete str;
+    return data;
+}
+
+// Return the data of the image <num> decoded by <prefetcher>, or an
+// empty string if it isn't prefetched.  Prefetches the page again until
+// the worker has decoded it, as an image not started yet is dropped.
+static std::string decodedImage(PDFDoc *doc, ImagePrefetcher *prefetcher, int num)
+{
+    const Ref ref = { num, 0 };
+    Object obj = doc->getXRef()->fetch(ref);
+    for (int i = 0; i < 500; ++i) {
+        Stream *str = prefetcher->getDecodedImage(ref, obj.getStream());
+        if (str) {
+            return readStream(str);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        prefetcher->prefetchPage(1);
+    }
+    return std::string();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-image-prefetcher <work-dir>\n");
+        return 99;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+    const std::string pdfFileName = std::string(argv[1]) + "/check-image-prefetcher.pdf";
+
+    // /Im1 is drawn by the page, /Im2 by the form /Fm1, /Im3 only appears
+    // in the data of an inline image, /Im4 isn't drawn, and /Small is too
+    // small to be prefetched
+    const std::string content = "q 100 0 0 100 0 0 cm /Im1 Do Q q 8 0 0 1 0 200 cm BI /W 8 /H 1 /BPC 8 /CS /G ID /Im3 Do \nEI Q /Fm1 Do q 8 0 0 8 0 300 cm /Small Do Q";
+    TEST_CHECK(testWriteFile(pdfFileName,
+                             testPdf({ "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                                       "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /XObject << /Im1 5 0 R /Im2 6 0 R /Im3 7 0 R /Im4 8 0 R /Fm1 9 0 R /Small 10 0 R >> >> /Contents 4 0 R >>",
+                                       testStreamObject("", content), imageObject(100, 3), imageObject(80, 5), imageObject(90, 7), imageObject(70, 11),
+                                       testStreamObject("/Type /XObject /Subtype /Form /BBox [0 0 612 792]", "q 80 0 0 80 200 200 cm /Im2 Do Q"), imageObject(8, 13) })));
+    PDFDoc doc(new GooString(pdfFileName));
+    TEST_CHECK(doc.isOk());
+    if (!doc.isOk()) {
+        return 1;
+    }
+
+    ImagePrefetcher prefetcher(&doc, 1);
+    prefetcher.prefetchPage(1);
+    TEST_CHECK(decodedImage(&doc, &prefetcher, 5) == imageData(100, 3));
+    TEST_CHECK(decodedImage(&doc, &prefetcher, 6) == imageData(80, 5));
+
+    // once the images drawn are decoded, the others aren't prefetched
+    const Ref others[] = { { 7, 0 }, { 8, 0 }, { 10, 0 } };
+    for (const Ref ref : others) {
+        Object obj = doc.getXRef()->fetch(ref);
+        Stream *str = prefetcher.getDecodedImage(ref, obj.getStream());
+        TEST_CHECK(!str);
+        delete str;
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,454 @@
+//========================================================================
+//
+// check-jbig2-stream.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks the decoding of JBIG2 generic regions and their combination
+// into the page.  The streams are made by a per-pixel encoder following
+// the JBIG2 specification, for every template, with and without typical
+// prediction, and with the adaptive pixels at their nominal positions,
+// near the current pixel or far from it, and they must decode to the
+// encoded bitmaps, bit for bit.  Regions placed at random positions,
+// partly or completely outside the page, and combined with every
+// operator, must give the page a per-pixel combination does.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Error.h"
+#include "JBIG2Stream.h"
+#include "Object.h"
+#include "Stream.h"
+#include "test-utils.h"
+
+// A bilevel bitmap, whose pixels outside are 0.
+struct Bitmap
+{
+    Bitmap(int wA, int hA, int value = 0) : w(wA), h(hA), pixels((size_t)wA * hA, value) { }
+
+    int get(int x, int y) const { return x >= 0 && x < w && y >= 0 && y < h ? pixels[(size_t)y * w + x] : 0; }
+    void set(int x, int y, int pix) { pixels[(size_t)y * w + x] = pix; }
+    bool sameRow(int y1, int y2) const
+    {
+        for (int x = 0; x < w; ++x) {
+            if (get(x, y1) != get(x, y2)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator==(const Bitmap &other) const { return w == other.w && h == other.h && pixels == other.pixels; }
+
+    int w, h;
+    std::vector<unsigned char> pixels;
+};
+
+//------------------------------------------------------------------------
+// MQ arithmetic encoder (JBIG2 specification, annex E.2)
+//------------------------------------------------------------------------
+
+class ArithEncoder
+{
+public:
+    explicit ArithEncoder(int contextSize) : index(contextSize, 0), mps(contextSize, 0)
+    {
+        a = 0x8000;
+        c = 0;
+        ct = 12;
+        // the byte before the output, which carries never reach
+        out.push_back(0);
+    }
+
+    void encodeBit(unsigned int cx, int bit)
+    {
+        const unsigned int qe = qeTab[index[cx]];
+        a -= qe;
+        if (bit == mps[cx]) {
+            if (a & 0x8000) {
+                c += qe;
+                return;
+            }
+            if (a < qe) {
+                a = qe;
+            } else {
+                c += qe;
+            }
+            index[cx] = nmpsTab[index[cx]];
+        } else {
+            if (a < qe) {
+                c += qe;
+            } else {
+                a = qe;
+            }
+            if (switchTab[index[cx]]) {
+                mps[cx] = 1 - mps[cx];
+            }
+            index[cx] = nlpsTab[index[cx]];
+        }
+        do {
+            a <<= 1;
+            c <<= 1;
+            if (--ct == 0) {
+                byteOut();
+            }
+        } while (!(a & 0x8000));
+    }
+
+    // Flush the encoder and return its output, ended by a marker.
+    std::string finish()
+    {
+        const unsigned int tempC = c + a;
+        c |= 0xffff;
+        if (c >= tempC) {
+            c -= 0x8000;
+        }
+        c <<= ct;
+        byteOut();
+        c <<= ct;
+        byteOut();
+        if (out.back() != 0xff) {
+            out.push_back(0xff);
+        }
+        out.push_back(0xac);
+        return std::string(out.begin() + 1, out.end());
+    }
+
+private:
+    void byteOut()
+    {
+        if (out.back() == 0xff) {
+            out.push_back(c >> 20);
+            c &= 0xfffff;
+            ct = 7;
+        } else if (c < 0x8000000) {
+            out.push_back(c >> 19);
+            c &= 0x7ffff;
+            ct = 8;
+        } else {
+            ++out.back();
+            if (out.back() == 0xff) {
+                c &= 0x7ffffff;
+                out.push_back(c >> 20);
+                c &= 0xfffff;
+                ct = 7;
+            } else {
+                out.push_back(c >> 19);
+                c &= 0x7ffff;
+                ct = 8;
+            }
+        }
+    }
+
+    static const unsigned int qeTab[47];
+    static const int nmpsTab[47];
+    static const int nlpsTab[47];
+    static const int switchTab[47];
+
+    unsigned int a, c;
+    int ct;
+    std::vector<unsigned char> out;
+    std::vector<int> index, mps;
+};
+
+const unsigned int ArithEncoder::qeTab[47] = { 0x5601, 0x3401, 0x1801, 0x0ac1, 0x0521, 0x0221, 0x5601, 0x5401, 0x4801, 0x3801, 0x3001, 0x2401, 0x1c01, 0x1601, 0x5601, 0x5401, 0x5101, 0x4801, 0x3801, 0x3401, 0x3001, 0x2801, 0x2401, 0x2201,
+                                               0x1c01, 0x1801, 0x1601, 0x1401, 0x1201, 0x1101, 0x0ac1, 0x09c1, 0x08a1, 0x0521, 0x0441, 0x02a1, 0x0221, 0x0141, 0x0111, 0x0085, 0x0049, 0x0025, 0x0015, 0x0009, 0x0005, 0x0001, 0x5601 };
+const int ArithEncoder::nmpsTab[47] = { 1, 2, 3, 4, 5, 38, 7, 8, 9, 10, 11, 12, 13, 29, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 45, 46 };
+const int ArithEncoder::nlpsTab[47] = { 1, 6, 9, 12, 29, 33, 6, 14, 14, 14, 17, 18, 20, 21, 14, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 46 };
+const int ArithEncoder::switchTab[47] = { 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+//------------------------------------------------------------------------
+// generic regions
+//------------------------------------------------------------------------
+
+struct GenericParams
+{
+    int templ;
+    bool tpgdOn;
+    int atx[4], aty[4];
+};
+
+// The context of pixel (<x>, <y>) of <bitmap>, built pixel by pixel as
+// in figures 3 to 6 of the specification.
+static unsigned int genericContext(const Bitmap &bitmap, const GenericParams &params, int x, int y)
+{
+    const auto p = [&bitmap, x, y](int dx, int dy) { return (unsigned int)bitmap.get(x + dx, y + dy); };
+    const auto at = [&params, &p](int i) { return p(params.atx[i], params.aty[i]); };
+    switch (params.templ) {
+    case 0:
+        return p(-1, -2) << 15 | p(0, -2) << 14 | p(1, -2) << 13 | p(-2, -1) << 12 | p(-1, -1) << 11 | p(0, -1) << 10 | p(1, -1) << 9 | p(2, -1) << 8 | p(-4, 0) << 7 | p(-3, 0) << 6 | p(-2, 0) << 5 | p(-1, 0) << 4 | at(0) << 3 | at(1) << 2
+                | at(2) << 1 | at(3);
+    case 1:
+        return p(-1, -2) << 12 | p(0, -2) << 11 | p(1, -2) << 10 | p(2, -2) << 9 | p(-2, -1) << 8 | p(-1, -1) << 7 | p(0, -1) << 6 | p(1, -1) << 5 | p(2, -1) << 4 | p(-3, 0) << 3 | p(-2, 0) << 2 | p(-1, 0) << 1 | at(0);
+    case 2:
+        return p(-1, -2) << 9 | p(0, -2) << 8 | p(1, -2) << 7 | p(-2, -1) << 6 | p(-1, -1) << 5 | p(0, -1) << 4 | p(1, -1) << 3 | p(-2, 0) << 2 | p(-1, 0) << 1 | at(0);
+    default:
+        return p(-3, -1) << 9 | p(-2, -1) << 8 | p(-1, -1) << 7 | p(0, -1) << 6 | p(1, -1) << 5 | p(-4, 0) << 4 | p(-3, 0) << 3 | p(-2, 0) << 2 | p(-1, 0) << 1 | at(0);
+    }
+}
+
+// Return the arithmetic coded data of <bitmap> (section 6.2.5.7).
+static std::string encodeGeneric(const Bitmap &bitmap, const GenericParams &params)
+{
+    static const int contextBits[4] = { 16, 13, 10, 10 };
+    // the contexts of the typical row bit (figures 8 to 11), with the
+    // pixels ordered as in genericContext()
+    static const unsigned int ltpContext[4] = { 0x3953, 0x079a, 0x0e3, 0x18b };
+    ArithEncoder enc(1 << contextBits[params.templ]);
+    bool ltp = false;
+    for (int y = 0; y < bitmap.h; ++y) {
+        if (params.tpgdOn) {
+            // a row is typical if it is the same as the one above, the
+            // row above the first one being white
+            const bool typical = y > 0 ? bitmap.sameRow(y, y - 1) : bitmap.sameRow(y, -1);
+            enc.encodeBit(ltpContext[params.templ], typical != ltp);
+            ltp = typical;
+            if (ltp) {
+                continue;
+            }
+        }
+        for (int x = 0; x < bitmap.w; ++x) {
+            enc.encodeBit(genericContext(bitmap, params, x, y), bitmap.get(x, y));
+        }
+    }
+    return enc.finish();
+}
+
+static void appendULong(std::string *s, unsigned int x)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        s->push_back((char)(x >> shift));
+    }
+}
+
+// Append a segment of type <type>, associated with page 1, to <s>.
+static void appendSegment(std::string *s, unsigned int segNum, unsigned int type, const std::string &data)
+{
+    appendULong(s, segNum);
+    s->push_back((char)type);
+    s->push_back(0); // no referred-to segments
+    s->push_back(1);
+    appendULong(s, data.size());
+    *s += data;
+}
+
+static std::string pageInfoSegment(int w, int h, int defPixel)
+{
+    std::string data;
+    appendULong(&data, w);
+    appendULong(&data, h);
+    appendULong(&data, 0);
+    appendULong(&data, 0);
+    data.push_back((char)((defPixel << 2) | 0x40)); // combination operators overridden by the regions
+    data.push_back(0);
+    data.push_back(0);
+    return data;
+}
+
+// An immediate generic region segment with the bitmap <bitmap>, at (<x>,
+// <y>) on the page, and combined with <combOp>.
+static std::string genericRegionSegment(const Bitmap &bitmap, const GenericParams &params, int x, int y, int combOp)
+{
+    std::string data;
+    appendULong(&data, bitmap.w);
+    appendULong(&data, bitmap.h);
+    appendULong(&data, (unsigned int)x);
+    appendULong(&data, (unsigned int)y);
+    data.push_back((char)combOp);
+    data.push_back((char)((params.templ << 1) | (params.tpgdOn ? 8 : 0)));
+    for (int i = 0; i < (params.templ == 0 ? 4 : 1); ++i) {
+        data.push_back((char)params.atx[i]);
+        data.push_back((char)params.aty[i]);
+    }
+    return data + encodeGeneric(bitmap, params);
+}
+
+static int decodingErrors = 0;
+
+static void countError(ErrorCategory /*category*/, Goffset /*pos*/, const char * /*msg*/)
+{
+    ++decodingErrors;
+}
+
+// Return the page of the embedded JBIG2 stream <data>, <w> x <h> pixels.
+static Bitmap decodePage(const std::string &data, int w, int h)
+{
+    JBIG2Stream str(new MemStream(data.data(), 0, data.size(), Object(objNull)), Object(objNull), nullptr);
+    Bitmap page(w, h);
+    str.reset();
+    const int line = (w + 7) >> 3;
+    for (int y = 0; y < h; ++y) {
+        for (int i = 0; i < line; ++i) {
+            const int c = str.getChar();
+            for (int x = i * 8; x < i * 8 + 8 && x < w; ++x) {
+                // the stream gives 1 for white
+                page.set(x, y, c == EOF ? 2 : !((c >> (7 - (x & 7))) & 1));
+            }
+        }
+    }
+    TEST_CHECK(str.getChar() == EOF);
+    str.close();
+    return page;
+}
+
+// Return a <w> x <h> bitmap, with rows repeating the one above, white
+// rows, and random rows of density <density> percent.
+static Bitmap randomBitmap(std::mt19937 &rng, int w, int h, int density)
+{
+    Bitmap bitmap(w, h);
+    for (int y = 0; y < h; ++y) {
+        const unsigned int kind = rng() % 8;
+        for (int x = 0; x < w; ++x) {
+            if (kind == 0) {
+                bitmap.set(x, y, 0);
+            } else if (kind <= 2) {
+                bitmap.set(x, y, bitmap.get(x, y - 1));
+            } else {
+                bitmap.set(x, y, (int)(rng() % 100) < density);
+            }
+        }
+    }
+    return bitmap;
+}
+
+static void checkGenericRegions()
+{
+    std::mt19937 rng(1);
+
+    // nominal, near and far adaptive pixels, the near ones reading the
+    // current row, the row above, and the rows further up
+    const int nominalATX[4][4] = { { 3, -3, 2, -2 }, { 3 }, { 2 }, { 2 } };
+    const int nominalATY[4][4] = { { -1, -1, -2, -2 }, { -1 }, { -1 }, { -1 } };
+    const int nearATX[3][4] = { { -1, 5, -8, 8 }, { -5, 0, 7, -6 }, { 1, -2, 4, -7 } };
+    const int nearATY[3][4] = { { 0, -1, -2, -1 }, { 0, -3, -1, -5 }, { -1, 0, -4, -2 } };
+    const int farATX[2][4] = { { -20, 3, -3, 2 }, { 9, -12, 40, -128 } };
+    const int farATY[2][4] = { { -3, -1, -1, -2 }, { -1, 0, -7, -1 } };
+
+    const int widths[] = { 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 150 };
+    int segNum = 0;
+    for (int templ = 0; templ < 4; ++templ) {
+        for (bool tpgdOn : { false, true }) {
+            std::vector<GenericParams> atParams;
+            GenericParams params = { templ, tpgdOn, {}, {} };
+            for (int i = 0; i < 4; ++i) {
+                params.atx[i] = nominalATX[templ][i];
+                params.aty[i] = nominalATY[templ][i];
+            }
+            atParams.push_back(params);
+            for (int j = 0; j < 3; ++j) {
+                for (int i = 0; i < 4; ++i) {
+                    params.atx[i] = nearATX[j][i];
+                    params.aty[i] = nearATY[j][i];
+                }
+                atParams.push_back(params);
+            }
+            for (int j = 0; j < 2; ++j) {
+                for (int i = 0; i < 4; ++i) {
+                    params.atx[i] = farATX[j][i];
+                    params.aty[i] = farATY[j][i];
+                }
+                atParams.push_back(params);
+            }
+
+            for (const GenericParams &p : atParams) {
+                for (int w : widths) {
+                    for (int density : { 5, 50, 95 }) {
+                        const int h = 1 + rng() % 40;
+                        const Bitmap bitmap = randomBitmap(rng, w, h, density);
+                        std::string data;
+                        appendSegment(&data, segNum++, 48, pageInfoSegment(w, h, 0));
+                        appendSegment(&data, segNum++, 38, genericRegionSegment(bitmap, p, 0, 0, 4));
+                        decodingErrors = 0;
+                        const bool same = decodePage(data, w, h) == bitmap;
+                        if (!same || decodingErrors) {
+                            fprintf(stderr, "generic region: template %d, TPGDON %d, AT (%d,%d), width %d, density %d\n", templ, tpgdOn, p.atx[0], p.aty[0], w, density);
+                        }
+                        TEST_CHECK(same);
+                        TEST_CHECK(decodingErrors == 0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+// combining regions into the page
+//------------------------------------------------------------------------
+
+static void combine(Bitmap *page, const Bitmap &region, int x, int y, int combOp)
+{
+    for (int yy = 0; yy < region.h; ++yy) {
+        for (int xx = 0; xx < region.w; ++xx) {
+            const int px = x + xx, py = y + yy;
+            if (px < 0 || px >= page->w || py < 0 || py >= page->h) {
+                continue;
+            }
+            const int d = page->get(px, py), s = region.get(xx, yy);
+            switch (combOp) {
+            case 0:
+                page->set(px, py, d | s);
+                break;
+            case 1:
+                page->set(px, py, d & s);
+                break;
+            case 2:
+                page->set(px, py, d ^ s);
+                break;
+            case 3:
+                page->set(px, py, !(d ^ s));
+                break;
+            default:
+                page->set(px, py, s);
+                break;
+            }
+        }
+    }
+}
+
+static void checkCombine()
+{
+    std::mt19937 rng(2);
+    const GenericParams params = { 0, false, { 3, -3, 2, -2 }, { -1, -1, -2, -2 } };
+
+    for (int n = 0; n < 300; ++n) {
+        // half the time, on byte boundaries
+        const bool aligned = n % 2 == 0;
+        const int pageW = aligned ? 8 * (1 + rng() % 24) : 1 + rng() % 200;
+        const int pageH = 1 + rng() % 60;
+        const int defPixel = rng() % 2;
+        Bitmap page(pageW, pageH, defPixel);
+        std::string data;
+        int segNum = 0;
+        appendSegment(&data, segNum++, 48, pageInfoSegment(pageW, pageH, defPixel));
+        for (int i = 0; i < 6; ++i) {
+            const int w = aligned ? 8 * (1 + rng() % 12) : 1 + rng() % 120;
+            const int h = 1 + rng() % 40;
+            const int x = aligned ? 8 * ((int)(rng() % 32) - 8) : (int)(rng() % (pageW + 2 * w + 20)) - w - 10;
+            const int y = (int)(rng() % (pageH + 2 * h)) - h;
+            const int combOp = rng() % 5;
+            const Bitmap region = randomBitmap(rng, w, h, 50);
+            appendSegment(&data, segNum++, 38, genericRegionSegment(region, params, x, y, combOp));
+            combine(&page, region, x, y, combOp);
+        }
+        decodingErrors = 0;
+        TEST_CHECK(decodePage(data, pageW, pageH) == page);
+        TEST_CHECK(decodingErrors == 0);
+    }
+}
+
+int main()
+{
+    setErrorCallback(countError);
+
+    checkGenericRegions();
+    checkCombine();
+
+    return testFailures() == 0 ? 0 : 1;
+}
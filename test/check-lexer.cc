@@ -0,0 +1,331 @@
+//========================================================================
+//
+// check-lexer.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks that the Lexer gets the same objects when it scans the chars a
+// stream holds in its buffer as when it reads them one by one: from
+// memory streams, from streams showing a few chars at a time, from flate
+// streams decoding ahead, and from content arrays whose tokens end at
+// the stream boundaries.  The content has tokens cut by the end of the
+// buffer, comments running to it, inline images, streams, signs in the
+// middle of numbers and integers of more than 9 digits.  Some reals must
+// also be correctly rounded.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Error.h"
+#include "Lexer.h"
+#include "Object.h"
+#include "Stream.h"
+#include "test-utils.h"
+#ifdef ENABLE_ZLIB
+#    include "FlateEncoder.h"
+#endif
+
+// A memory stream showing 1 to <maxChunk> of its next chars at a time to
+// the Lexer, or none of them if <maxChunk> is 0.
+class ChunkedMemStream : public MemStream
+{
+public:
+    ChunkedMemStream(const char *bufA, Goffset lengthA, int maxChunkA) : MemStream(bufA, 0, lengthA, Object(objNull)), maxChunk(maxChunkA), calls(0) { }
+
+    const unsigned char *getBufferedChars(int *n) override
+    {
+        const unsigned char *p = MemStream::getBufferedChars(n);
+        *n = maxChunk > 0 ? std::min(*n, 1 + calls++ % maxChunk) : 0;
+        return p;
+    }
+
+private:
+    int maxChunk;
+    int calls;
+};
+
+static std::string describe(const Object &obj)
+{
+    char buf[64];
+    switch (obj.getType()) {
+    case objBool:
+        return obj.getBool() ? "true" : "false";
+    case objInt:
+        return "int " + std::to_string(obj.getInt());
+    case objInt64:
+        return "int64 " + std::to_string(obj.getInt64());
+    case objReal:
+        snprintf(buf, sizeof(buf), "real %.17g", obj.getReal());
+        return buf;
+    case objString:
+        return "string " + obj.getString()->toStr();
+    case objHexString:
+        return "hex string " + obj.getHexString()->toStr();
+    case objName:
+        return std::string("name ") + obj.getName();
+    case objCmd:
+        return std::string("cmd ") + obj.getCmd();
+    default:
+        return obj.getTypeName();
+    }
+}
+
+// Return the objects of <lexer>, reading the inline image data after
+// the ID commands and the 8 bytes after the stream keywords as a parser
+// does.
+static std::vector<std::string> lex(Lexer *lexer)
+{
+    std::vector<std::string> objs;
+    for (int i = 0; i < 1000000; ++i) {
+        const Object obj = lexer->getObj();
+        if (obj.isEOF()) {
+            break;
+        }
+        objs.push_back(describe(obj));
+        if (obj.isCmd("ID")) {
+            lexer->skipChar();
+            std::string data;
+            int c, prev = EOF;
+            while (lexer->getStream() && (c = lexer->getStream()->getChar()) != EOF && !(prev == 'E' && c == 'I')) {
+                data.push_back((char)c);
+                prev = c;
+            }
+            objs.push_back("inline image data " + data);
+        } else if (obj.isCmd("stream")) {
+            lexer->skipToNextLine();
+            std::string data;
+            int c;
+            while (data.size() < 8 && lexer->getStream() && (c = lexer->getStream()->getChar()) != EOF) {
+                data.push_back((char)c);
+            }
+            objs.push_back("stream data " + data);
+        }
+    }
+    return objs;
+}
+
+static std::vector<std::string> lexStream(Stream *str)
+{
+    Lexer lexer(nullptr, str);
+    return lex(&lexer);
+}
+
+// Lex <content> split into a content array at <cuts>.
+static std::vector<std::string> lexContentArray(const std::string &content, const std::vector<size_t> &cuts, int maxChunk)
+{
+    Object array(new Array(nullptr));
+    size_t start = 0;
+    for (size_t i = 0; i <= cuts.size(); ++i) {
+        const size_t end = i < cuts.size() ? cuts[i] : content.size();
+        array.arrayAdd(Object(static_cast<Stream *>(new ChunkedMemStream(content.data() + start, end - start, maxChunk))));
+        start = end;
+    }
+    Lexer lexer(nullptr, &array);
+    return lex(&lexer);
+}
+
+//------------------------------------------------------------------------
+
+static std::string randomDigits(std::mt19937 &rng, int n)
+{
+    std::string s;
+    for (int i = 0; i < n; ++i) {
+        s.push_back((char)('0' + rng() % 10));
+    }
+    return s;
+}
+
+static std::string randomToken(std::mt19937 &rng)
+{
+    static const char *const fixed[] = { "1.-5",     "-1.-2",      "1-2",         "--3",     "+-4",       "1.2.3",      "-",       "+",           ".",         "-.",   "5.",    ".5",    "-.75",        "+2.5",
+                                         "1e5",      "2147483647", "2147483648",  "-2147483648", "-2147483649", "9223372036854775807", "9223372036854775808", "99999999999999999999",
+                                         "0000000000012", "/Name", "/A#20B", "/",  "/a/b",      "re",         "Tj",      "T*",          "'",         "\"",   "true",  "false", "null",        "BT",
+                                         "(a b)",    "(nested (x) \\) esc)", "<414243>", "<< /K 1 >>", "[1 2 3]", "{",  "}",       ")",           ">",         "<<",   ">>",    "[",     "]" };
+    const unsigned int kind = rng() % 10;
+    if (kind == 0) {
+        // an integer, maybe over 9 digits
+        const char *const signs[3] = { "", "-", "+" };
+        return signs[rng() % 3] + randomDigits(rng, 1 + rng() % 20);
+    } else if (kind == 1) {
+        // a real, maybe of more than 15 or 64 digits
+        const int n = rng() % 3 == 0 ? 1 + rng() % 80 : 1 + rng() % 8;
+        return (rng() % 2 ? "-" : "") + randomDigits(rng, rng() % n) + "." + randomDigits(rng, rng() % n);
+    } else if (kind == 2) {
+        // a name or a command, maybe longer than the token buffer
+        const int n = rng() % 4 == 0 ? 100 + rng() % 100 : 1 + rng() % 10;
+        std::string s(rng() % 2 ? "/" : "");
+        for (int i = 0; i < n; ++i) {
+            s.push_back((char)('a' + rng() % 26));
+        }
+        return s;
+    } else if (kind == 3) {
+        // a comment, up to the end of its line
+        return "% comment " + randomDigits(rng, rng() % 10) + (rng() % 2 ? "\n" : "\r");
+    } else if (kind == 4 && rng() % 4 == 0) {
+        std::string data;
+        for (int i = 1 + rng() % 40; i > 0; --i) {
+            const char c = (char)(rng() % 256);
+            data.push_back(c == 'E' ? 'e' : c);
+        }
+        return std::string("BI /W 1 /H 1 ID") + (rng() % 2 ? " " : "\n") + data + "\nEI";
+    } else if (kind == 5 && rng() % 4 == 0) {
+        std::string data;
+        for (int i = 0; i < 8; ++i) {
+            data.push_back((char)(rng() % 256));
+        }
+        return std::string("<< /Length 8 >> stream") + (rng() % 2 ? "\n" : "\r\n") + data + "\nendstream";
+    }
+    return fixed[rng() % (sizeof(fixed) / sizeof(fixed[0]))];
+}
+
+static std::string randomContent(std::mt19937 &rng, size_t size)
+{
+    static const std::string separators[] = { " ", " ", " ", "\n", "\r\n", "\t", std::string(1, '\0'), "\f", "", "  \n\n " };
+    std::string content;
+    while (content.size() < size) {
+        content += randomToken(rng) + separators[rng() % 10];
+    }
+    // a comment up to the end
+    return content + "% the end";
+}
+
+// Return <data> as a zlib stream of stored deflate blocks of random
+// sizes.
+static std::string storedBlocks(std::mt19937 &rng, const std::string &data)
+{
+    std::string out("\x78\x01", 2);
+    for (size_t pos = 0; pos < data.size();) {
+        const size_t len = std::min<size_t>(data.size() - pos, 1 + rng() % 9000);
+        out.push_back(pos + len == data.size() ? 1 : 0);
+        out.push_back((char)(len & 0xff));
+        out.push_back((char)(len >> 8));
+        out.push_back((char)(~len & 0xff));
+        out.push_back((char)((~len >> 8) & 0xff));
+        out.append(data, pos, len);
+        pos += len;
+    }
+    // the Adler-32 checksum isn't checked
+    return out + std::string(4, '\0');
+}
+
+static void checkContent(std::mt19937 &rng)
+{
+    for (int n = 0; n < 8; ++n) {
+        const std::string content = randomContent(rng, n < 4 ? 2000 : 100000);
+        const std::vector<std::string> expected = lexStream(new ChunkedMemStream(content.data(), content.size(), 0));
+        TEST_CHECK(expected.size() > 100);
+
+        TEST_CHECK(lexStream(new MemStream(content.data(), 0, content.size(), Object(objNull))) == expected);
+        for (int maxChunk : { 1, 2, 3, 7, 16 }) {
+            TEST_CHECK(lexStream(new ChunkedMemStream(content.data(), content.size(), maxChunk)) == expected);
+        }
+
+        const std::string stored = storedBlocks(rng, content);
+        TEST_CHECK(lexStream(new FlateStream(new MemStream(stored.data(), 0, stored.size(), Object(objNull)), 1, 1, 1, 8)) == expected);
+#ifdef ENABLE_ZLIB
+        std::string compressed;
+        MemStream contentStr(content.data(), 0, content.size(), Object(objNull));
+        FlateEncoder encoder(&contentStr);
+        encoder.reset();
+        encoder.fillString(compressed);
+        TEST_CHECK(lexStream(new FlateStream(new MemStream(compressed.data(), 0, compressed.size(), Object(objNull)), 1, 1, 1, 8)) == expected);
+#endif
+
+        // the tokens end at the stream boundaries
+        std::vector<size_t> cuts;
+        for (int i = rng() % 40; i > 0; --i) {
+            cuts.push_back(rng() % (content.size() + 1));
+        }
+        std::sort(cuts.begin(), cuts.end());
+        const std::vector<std::string> expectedArray = lexContentArray(content, cuts, 0);
+        for (int maxChunk : { 3, INT_MAX }) {
+            TEST_CHECK(lexContentArray(content, cuts, maxChunk) == expectedArray);
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+
+static std::string realText(double x)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "real %.17g", x);
+    return buf;
+}
+
+// Check the number <text> gives <expected> however it is scanned, at the
+// end of the stream or not.
+static void checkNumber(const std::string &text, const std::string &expected)
+{
+    for (const std::string &s : { text, text + " ", text + "]" }) {
+        for (int maxChunk : { 0, 1, 4, INT_MAX }) {
+            const std::vector<std::string> objs = lexStream(new ChunkedMemStream(s.data(), s.size(), maxChunk));
+            TEST_CHECK(!objs.empty() && objs[0] == expected);
+        }
+    }
+}
+
+static void checkNumbers()
+{
+    static const struct
+    {
+        const char *text;
+        double value;
+    } reals[] = { { "0.1", 0.1 },
+                  { "0.7", 0.7 },
+                  { "2.675", 2.675 },
+                  { "123.456", 123.456 },
+                  { "-0.000123", -0.000123 },
+                  { ".5", 0.5 },
+                  { "-.75", -0.75 },
+                  { "+2.5", 2.5 },
+                  { "5.", 5.0 },
+                  { ".", 0.0 },
+                  { "1.-5", 1.5 },
+                  { "3.141592653589793", 3.141592653589793 },
+                  { "0.30000000000000004", 0.30000000000000004 },
+                  { "0.1000000000000000055511151231257827", 0.1 },
+                  { "9007199254740993.0", 9007199254740992.0 },
+                  { "12345678901234567890.5", 12345678901234567890.5 },
+                  { "0.0000000000000000000000001", 1e-25 },
+                  { "1.7976931348623157", 1.7976931348623157 },
+                  { "000000000000000000001.5", 1.5 } };
+    for (const auto &real : reals) {
+        checkNumber(real.text, realText(real.value));
+    }
+    // more than 64 significant digits
+    checkNumber("1" + std::string(70, '0') + ".0", realText(1e70));
+
+    checkNumber("1234567890", "int 1234567890");
+    checkNumber("2147483647", "int 2147483647");
+    checkNumber("2147483648", "int64 2147483648");
+    checkNumber("-2147483648", "int -2147483648");
+    checkNumber("-2147483649", "int64 -2147483649");
+    checkNumber("9223372036854775807", "int64 9223372036854775807");
+    checkNumber("9223372036854775808", realText(9223372036854775808.0));
+    checkNumber("0000000000042", "int 42");
+    checkNumber("+0000000001", "int 1");
+    checkNumber("-0", "int 0");
+}
+
+static void ignoreError(ErrorCategory /*category*/, Goffset /*pos*/, const char * /*msg*/) { }
+
+int main()
+{
+    // badly formatted numbers, unterminated strings and such
+    setErrorCallback(ignoreError);
+
+    std::mt19937 rng(1);
+    checkContent(rng);
+    checkNumbers();
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+//========================================================================
+//
+// check-patch-mesh-clip.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks that the native patch mesh shading rasterizer of Splash gives
+// the edges of an anti-aliased clip path partial coverage, that it renders
+// like the generic Gfx fallback, and that a translucent mesh is composited
+// once over the paper.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "goo/GooString.h"
+#include "GlobalParams.h"
+#include "Object.h" /* must be included before SplashOutputDev.h because of sloppiness in SplashOutputDev.h */
+#include "PDFDoc.h"
+#include "SplashOutputDev.h"
+#include "splash/SplashBitmap.h"
+#include "test-utils.h"
+
+// A SplashOutputDev leaving the patch mesh shadings to Gfx, which
+// subdivides them into flat filled quadrilaterals.
+class FallbackOutputDev : public SplashOutputDev
+{
+public:
+    FallbackOutputDev(SplashColorPtr paperColorA) : SplashOutputDev(splashModeRGB8, 4, false, paperColorA) { }
+
+    bool useShadedFills(int type) override { return type != 6 && type != 7 && SplashOutputDev::useShadedFills(type); }
+};
+
+// Return a page with a Coons patch mesh covering [100 500] x [100 600],
+// clipped by a curved path, and painted with the fill opacity <ca>.
+static std::string makePdf(double ca)
+{
+    const double pts[12][2] = { { 100, 100 }, { 100, 266 }, { 100, 433 }, { 100, 600 }, { 233, 600 }, { 366, 600 }, { 500, 600 }, { 500, 433 }, { 500, 266 }, { 500, 100 }, { 366, 100 }, { 233, 100 } };
+    std::string mesh(1, '\0');
+    for (const auto &pt : pts) {
+        const uint16_t x = (uint16_t)(pt[0] / 612 * 65535), y = (uint16_t)(pt[1] / 792 * 65535);
+        mesh += { (char)(x >> 8), (char)(x & 0xff), (char)(y >> 8), (char)(y & 0xff) };
+    }
+    mesh += std::string("\xff\x00\x00\x00\xff\x00\x00\x00\xff\xff\xff\x00", 12);
+
+    const std::string content = "q /GS0 gs 300 350 m 300 460 200 550 150 500 c 60 420 120 250 300 350 c h W n /Sh0 sh Q";
+    return testPdf({ "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                     "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Shading << /Sh0 5 0 R >> /ExtGState << /GS0 << /ca " + std::to_string(ca) + " >> >> >> /Contents 4 0 R >>",
+                     testStreamObject("", content), testStreamObject("/ShadingType 6 /ColorSpace /DeviceRGB /BitsPerCoordinate 16 /BitsPerComponent 8 /BitsPerFlag 8 /Decode [0 612 0 792 0 1 0 1 0 1]", mesh) });
+}
+
+static const unsigned char *pixel(SplashBitmap *bitmap, int x, int y)
+{
+    return bitmap->getDataPtr() + y * bitmap->getRowSize() + 3 * x;
+}
+
+static bool isWhite(const unsigned char *p)
+{
+    return p[0] == 255 && p[1] == 255 && p[2] == 255;
+}
+
+// Return the mean difference between <bitmap> and <ref> composited with
+// the opacity <alpha> over white paper, away from the edges of <ref>.
+static double meanInteriorDifference(SplashBitmap *bitmap, SplashBitmap *ref, double alpha)
+{
+    double sum = 0;
+    int n = 0;
+    for (int y = 1; y + 1 < ref->getHeight(); ++y) {
+        for (int x = 1; x + 1 < ref->getWidth(); ++x) {
+            if (isWhite(pixel(ref, x - 1, y)) || isWhite(pixel(ref, x, y)) || isWhite(pixel(ref, x + 1, y)) || isWhite(pixel(ref, x, y - 1)) || isWhite(pixel(ref, x, y + 1))) {
+                continue;
+            }
+            for (int i = 0; i < 3; ++i) {
+                sum += std::abs(pixel(bitmap, x, y)[i] - (alpha * pixel(ref, x, y)[i] + (1 - alpha) * 255));
+            }
+            ++n;
+        }
+    }
+    return n > 10000 ? sum / (3.0 * n) : 255;
+}
+
+// Is <p> strictly between the white paper and <q>?
+static bool isPartial(const unsigned char *p, const unsigned char *q)
+{
+    bool between = true, differs = false;
+    for (int i = 0; i < 3; ++i) {
+        between = between && p[i] >= q[i] && (p[i] < 255 || q[i] == 255);
+        differs = differs || p[i] != q[i];
+    }
+    return between && differs;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-patch-mesh-clip <work-dir>\n");
+        return 99;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    SplashColor paperColor;
+    paperColor[0] = paperColor[1] = paperColor[2] = 0xff;
+    std::unique_ptr<SplashBitmap> opaqueBitmap;
+    for (double ca : { 1.0, 0.6 }) {
+        const std::string pdfFileName = std::string(argv[1]) + "/check-patch-mesh-clip.pdf";
+        TEST_CHECK(testWriteFile(pdfFileName, makePdf(ca)));
+        PDFDoc doc(new GooString(pdfFileName));
+        TEST_CHECK(doc.isOk());
+        if (!doc.isOk()) {
+            break;
+        }
+
+        SplashOutputDev native(splashModeRGB8, 4, false, paperColor);
+        native.startDoc(&doc);
+        doc.displayPage(&native, 1, 72, 72, 0, true, false, false);
+        SplashBitmap *bitmap = native.getBitmap();
+
+        // the left end of the clipped rows is anti-aliased
+        int rows = 0, partialRows = 0;
+        for (int y = 0; y < bitmap->getHeight(); ++y) {
+            int x = 0;
+            while (x + 1 < bitmap->getWidth() && isWhite(pixel(bitmap, x, y))) {
+                ++x;
+            }
+            if (x + 1 < bitmap->getWidth()) {
+                ++rows;
+                if (isPartial(pixel(bitmap, x, y), pixel(bitmap, x + 1, y))) {
+                    ++partialRows;
+                }
+            }
+        }
+        TEST_CHECK(rows > 150);
+        TEST_CHECK(partialRows > rows / 2);
+
+        if (ca == 1) {
+            // apart from the edges, the fallback renders the same
+            FallbackOutputDev fallback(paperColor);
+            fallback.startDoc(&doc);
+            doc.displayPage(&fallback, 1, 72, 72, 0, true, false, false);
+            TEST_CHECK(meanInteriorDifference(bitmap, fallback.getBitmap(), 1) < 4);
+            opaqueBitmap.reset(native.takeBitmap());
+        } else {
+            // the mesh is composited once, over the paper
+            TEST_CHECK(meanInteriorDifference(bitmap, opaqueBitmap.get(), ca) < 1);
+        }
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
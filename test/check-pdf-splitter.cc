@@ -0,0 +1,270 @@
+//========================================================================
+//
+// check-pdf-splitter.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks PDFSplitter on plain and encrypted documents: the files of the
+// pages are the ones PDFDoc::savePageAs() writes from a new document,
+// with any number of threads, and saving stops at the first page that
+// can't be saved.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "goo/GooString.h"
+#include "Decrypt.h"
+#include "ErrorCodes.h"
+#include "GlobalParams.h"
+#include "PDFDoc.h"
+#include "PDFSplitter.h"
+#include "Stream.h"
+#include "test-utils.h"
+
+static const int numPages = 6;
+
+static std::string readFile(const std::string &fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    std::ostringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+// Return the file <fileName> without the ID of its trailer, which is made
+// from the time and the file name.
+static std::string readPageFile(const std::string &fileName)
+{
+    std::string data = readFile(fileName);
+    const size_t start = data.rfind("/ID [");
+    const size_t end = start == std::string::npos ? start : data.find("] /Root", start);
+    if (end != std::string::npos) {
+        data.erase(start, end + 1 - start);
+    }
+    return data;
+}
+
+static std::string rc4(const std::string &key, const std::string &data)
+{
+    unsigned char state[256];
+    for (int i = 0; i < 256; ++i) {
+        state[i] = i;
+    }
+    for (int i = 0, j = 0; i < 256; ++i) {
+        j = (j + state[i] + (unsigned char)key[i % key.size()]) & 0xff;
+        std::swap(state[i], state[j]);
+    }
+    std::string out;
+    for (size_t n = 0, i = 0, j = 0; n < data.size(); ++n) {
+        i = (i + 1) & 0xff;
+        j = (j + state[i]) & 0xff;
+        std::swap(state[i], state[j]);
+        out.push_back(data[n] ^ state[(state[i] + state[j]) & 0xff]);
+    }
+    return out;
+}
+
+static std::string md5String(const std::string &data)
+{
+    unsigned char digest[16];
+    md5((const unsigned char *)data.data(), data.size(), digest);
+    return std::string((const char *)digest, 16);
+}
+
+static std::string hex(const std::string &data)
+{
+    std::string s = "<";
+    for (unsigned char c : data) {
+        static const char digits[] = "0123456789abcdef";
+        s += digits[c >> 4];
+        s += digits[c & 0xf];
+    }
+    return s + ">";
+}
+
+// Encrypts the strings and streams of a document with the 40-bit RC4
+// standard security handler (revision 2), or leaves them as they are.
+class Encryption
+{
+public:
+    Encryption(bool enabledA, const std::string &userPassword, const std::string &ownerPassword) : enabled(enabledA)
+    {
+        const std::string ownerKey = md5String(pad(ownerPassword)).substr(0, 5);
+        o = rc4(ownerKey, pad(userPassword));
+        fileKey = md5String(pad(userPassword) + o + std::string("\xfc\xff\xff\xff", 4) + id).substr(0, 5);
+        u = rc4(fileKey, pad(""));
+    }
+
+    // a string of the object <num>
+    std::string string(int num, const std::string &s) const { return hex(enabled ? rc4(objectKey(num), s) : s); }
+
+    // a stream object <num>
+    std::string stream(int num, const std::string &entries, const std::string &data) const { return testStreamObject(entries, enabled ? rc4(objectKey(num), data) : data); }
+
+    // Return <pdf> with the encryption dict and the ID in its trailer.
+    std::string finish(const std::string &pdf) const
+    {
+        const std::string extra = enabled ? " /Encrypt << /Filter /Standard /V 1 /R 2 /O " + hex(o) + " /U " + hex(u) + " /P -4 >> /ID [" + hex(id) + " " + hex(id) + "]" : "";
+        const size_t pos = pdf.find(" /Root 1 0 R >>");
+        return pdf.substr(0, pos) + " /Root 1 0 R" + extra + pdf.substr(pos + 12);
+    }
+
+private:
+    static std::string pad(const std::string &password)
+    {
+        static const char padding[] = "\x28\xbf\x4e\x5e\x4e\x75\x8a\x41\x64\x00\x4e\x56\xff\xfa\x01\x08\x2e\x2e\x00\xb6\xd0\x68\x3e\x80\x2f\x0c\xa9\xfe\x64\x53\x69\x7a";
+        return (password + std::string(padding, 32)).substr(0, 32);
+    }
+
+    std::string objectKey(int num) const
+    {
+        const char numGen[5] = { (char)(num & 0xff), (char)((num >> 8) & 0xff), (char)((num >> 16) & 0xff), 0, 0 };
+        return md5String(fileKey + std::string(numGen, 5)).substr(0, 10);
+    }
+
+    const bool enabled;
+    const std::string id = "0123456789abcdef";
+    std::string o, u, fileKey;
+};
+
+// Return a document of numPages pages sharing a font and an image, each
+// one with its own content stream and annotation.
+static std::string makePdf(const Encryption &enc)
+{
+    std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>", "", "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+                                         enc.stream(4, "/Type /XObject /Subtype /Image /Width 2 /Height 2 /ColorSpace /DeviceGray /BitsPerComponent 8", std::string("\x00\x80\xff\x40", 4)),
+                                         "<< /Title " + enc.string(5, "Shared title") + " >>" };
+    std::string kids;
+    for (int i = 1; i <= numPages; ++i) {
+        const int pageNum = objects.size() + 1;
+        kids += std::to_string(pageNum) + " 0 R ";
+        objects.push_back("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 3 0 R >> /XObject << /Im1 4 0 R >> >> /Contents " + std::to_string(pageNum + 1) + " 0 R /Annots ["
+                          + std::to_string(pageNum + 2) + " 0 R] >>");
+        objects.push_back(enc.stream(pageNum + 1, "", "BT /F1 12 Tf 72 720 Td (Page " + std::to_string(i) + ") Tj ET q 10 0 0 10 72 600 cm /Im1 Do Q"));
+        objects.push_back("<< /Type /Annot /Subtype /Text /Rect [100 100 120 120] /Contents " + enc.string(pageNum + 2, "Note " + std::to_string(i)) + " /P " + std::to_string(pageNum) + " 0 R >>");
+    }
+    objects[1] = "<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(numPages) + " >>";
+    std::string pdf = testPdf(objects);
+    const size_t pos = pdf.find(" /Root 1 0 R >>");
+    pdf.insert(pos, " /Info 5 0 R");
+    return enc.finish(pdf);
+}
+
+// Return the decoded content stream of the single page of <fileName>, or
+// an empty string.
+static std::string pageContent(const std::string &fileName, const GooString *userPassword)
+{
+    PDFDoc doc(new GooString(fileName), nullptr, userPassword);
+    if (!doc.isOk() || doc.getNumPages() != 1) {
+        return std::string();
+    }
+    Object contents = doc.getPage(1)->getContents();
+    if (!contents.isStream()) {
+        return std::string();
+    }
+    std::string data;
+    Stream *str = contents.getStream();
+    str->reset();
+    for (int c; (c = str->getChar()) != EOF;) {
+        data.push_back(c);
+    }
+    str->close();
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-pdf-splitter <work-dir>\n");
+        return 99;
+    }
+    const std::string workDir = std::string(argv[1]) + "/check-pdf-splitter.dir";
+    std::filesystem::remove_all(workDir);
+    std::filesystem::create_directories(workDir);
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    std::vector<int> pageNos;
+    for (int i = 1; i <= numPages; ++i) {
+        pageNos.push_back(i);
+    }
+    auto pageNames = [&workDir](const std::string &prefix) {
+        std::vector<std::string> names;
+        for (int i = 1; i <= numPages; ++i) {
+            names.push_back(workDir + "/" + prefix + "-" + std::to_string(i) + ".pdf");
+        }
+        return names;
+    };
+
+    // a plain document, one encrypted with an empty user password, and
+    // one that needs its user password
+    const struct
+    {
+        const char *name;
+        bool encrypted;
+        const char *userPassword;
+    } docs[] = { { "plain", false, "" }, { "encrypted", true, "" }, { "password", true, "user" } };
+    for (const auto &d : docs) {
+        const std::string pdfFileName = workDir + "/" + d.name + ".pdf";
+        TEST_CHECK(testWriteFile(pdfFileName, makePdf(Encryption(d.encrypted, d.userPassword, "owner"))));
+        const GooString fileName(pdfFileName);
+        const GooString userPassword(d.userPassword);
+        const GooString *password = *d.userPassword ? &userPassword : nullptr;
+
+        // what savePageAs() writes from a new document for each page
+        const std::vector<std::string> refNames = pageNames(std::string(d.name) + "-ref");
+        for (int i = 0; i < numPages; ++i) {
+            PDFDoc doc(fileName.copy(), nullptr, password);
+            TEST_CHECK(doc.isOk());
+            const GooString name(refNames[i]);
+            TEST_CHECK(doc.isOk() && doc.savePageAs(&name, pageNos[i]) == errNone);
+            TEST_CHECK(pageContent(refNames[i], password).find("(Page " + std::to_string(pageNos[i]) + ")") != std::string::npos);
+        }
+
+        for (int nThreads : { 1, 3 }) {
+            const std::vector<std::string> names = pageNames(std::string(d.name) + "-" + std::to_string(nThreads));
+            PDFSplitter splitter(&fileName, nullptr, password);
+            TEST_CHECK(splitter.savePages(pageNos, names, nThreads) == errNone);
+            for (int i = 0; i < numPages; ++i) {
+                TEST_CHECK(!readFile(names[i]).empty() && readPageFile(names[i]) == readPageFile(refNames[i]));
+            }
+        }
+
+        // without the user password, nothing is written
+        if (password) {
+            const std::vector<std::string> names = pageNames(std::string(d.name) + "-nopassword");
+            PDFSplitter splitter(&fileName, nullptr, nullptr);
+            TEST_CHECK(splitter.savePages(pageNos, names, 3) == errEncrypted);
+            for (const std::string &name : names) {
+                TEST_CHECK(!std::filesystem::exists(name));
+            }
+        }
+
+        // the pages before one that can't be saved are written, and with
+        // one thread, the pages after it aren't
+        for (int nThreads : { 1, 3 }) {
+            std::vector<std::string> names = pageNames(std::string(d.name) + "-failure-" + std::to_string(nThreads));
+            names[2] = workDir + "/missing/page.pdf";
+            PDFSplitter splitter(&fileName, nullptr, password);
+            TEST_CHECK(splitter.savePages(pageNos, names, nThreads) == errOpenFile);
+            TEST_CHECK(!readFile(names[0]).empty() && readPageFile(names[0]) == readPageFile(refNames[0]) && readPageFile(names[1]) == readPageFile(refNames[1]));
+            if (nThreads == 1) {
+                for (int i = 3; i < numPages; ++i) {
+                    TEST_CHECK(!std::filesystem::exists(names[i]));
+                }
+            }
+        }
+    }
+
+    std::filesystem::remove_all(workDir);
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+//========================================================================
+//
+// check-pdfunite-dedup.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks pdfunite -dedup on files sharing a font, its descriptor and its
+// font file, each with a page of its own: the output has one copy of the
+// shared objects, but one of each rewritten page and of each object in a
+// reference cycle, and it has the pages and text of the files.  The
+// objects written don't depend on the number of threads.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "goo/GooString.h"
+#include "GlobalParams.h"
+#include "PDFDoc.h"
+#include "TextOutputDev.h"
+#include "test-utils.h"
+
+// Return a file whose page shows <text> in a font with an embedded font
+// file, has a link to itself, and refers to two objects referring to
+// each other.
+static std::string makePdf(const std::string &text)
+{
+    const std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>",
+                                               "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                                               "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 4 0 R >> /Properties << /C 8 0 R >> >> /Contents 7 0 R /Annots [10 0 R] >>",
+                                               "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding /FontDescriptor 5 0 R >>",
+                                               "<< /Type /FontDescriptor /FontName /Helvetica /Flags 32 /FontBBox [-166 -225 1000 931] /ItalicAngle 0 /Ascent 718 /Descent -207 /CapHeight 718 /StemV 88 /FontFile 6 0 R >>",
+                                               testStreamObject("/Length1 40 /Length2 0 /Length3 0", "%!PS-AdobeFont-1.0: Helvetica 001.000\n"),
+                                               testStreamObject("", "BT /F1 12 Tf 72 720 Td (" + text + ") Tj ET"),
+                                               "<< /Cycle 9 0 R >>",
+                                               "<< /Cycle 8 0 R >>",
+                                               "<< /Type /Annot /Subtype /Link /Rect [72 700 200 740] /Dest [3 0 R /Fit] >>" };
+    return testPdf(objects);
+}
+
+static std::string readFile(const std::string &fileName)
+{
+    std::ifstream f(fileName, std::ios::binary);
+    std::ostringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+static bool runPdfunite(const std::string &pdfunite, const std::string &options, const std::vector<std::string> &inputs, const std::string &output)
+{
+    std::string command = "\"" + pdfunite + "\" " + options;
+    for (const std::string &input : inputs) {
+        command += " \"" + input + "\"";
+    }
+    command += " \"" + output + "\"";
+    return system(command.c_str()) == 0;
+}
+
+struct Counts
+{
+    int fonts = 0;
+    int fontDescriptors = 0;
+    int fontFiles = 0;
+    int pages = 0;
+    int cycles = 0;
+};
+
+// Count the objects of each kind in <doc>.
+static Counts countObjects(PDFDoc *doc)
+{
+    Counts counts;
+    XRef *xref = doc->getXRef();
+    for (int num = 1; num < xref->getNumObjects(); ++num) {
+        const XRefEntry *entry = xref->getEntry(num);
+        if (entry->type == xrefEntryFree) {
+            continue;
+        }
+        const Object obj = xref->fetch(num, entry->gen);
+        const Dict *dict = obj.isDict() ? obj.getDict() : obj.isStream() ? obj.getStream()->getDict() : nullptr;
+        if (!dict) {
+            continue;
+        }
+        const Object type = dict->lookup("Type");
+        if (type.isName("Font")) {
+            ++counts.fonts;
+        } else if (type.isName("FontDescriptor")) {
+            ++counts.fontDescriptors;
+        } else if (type.isName("Page")) {
+            ++counts.pages;
+        } else if (dict->hasKey("Length1")) {
+            ++counts.fontFiles;
+        } else if (dict->hasKey("Cycle")) {
+            ++counts.cycles;
+        }
+    }
+    return counts;
+}
+
+static std::string pageText(PDFDoc *doc, int page)
+{
+    TextOutputDev dev(nullptr, false, 0, false, false);
+    doc->displayPage(&dev, page, 72, 72, 0, false, true, false);
+    std::unique_ptr<GooString> s(dev.getText(0, 0, 612, 792));
+    return s->toStr();
+}
+
+static Ref contentsRef(PDFDoc *doc, int page)
+{
+    const Object pageObj = doc->getXRef()->fetch(*doc->getCatalog()->getPageRef(page));
+    const Object &contents = pageObj.dictLookupNF("Contents");
+    return contents.isRef() ? contents.getRef() : Ref::INVALID();
+}
+
+// Return the objects and the xref table of the file <fileName>, without
+// the trailer, whose ID is made from the time and the file name.
+static std::string readObjects(const std::string &fileName)
+{
+    const std::string data = readFile(fileName);
+    return data.substr(0, data.rfind("trailer"));
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: check-pdfunite-dedup <pdfunite> <work-dir>\n");
+        return 99;
+    }
+    const std::string pdfunite = argv[1];
+    const std::string workDir = argv[2];
+    const std::string first = workDir + "/check-pdfunite-dedup-1.pdf";
+    const std::string second = workDir + "/check-pdfunite-dedup-2.pdf";
+    const std::string united = workDir + "/check-pdfunite-dedup.pdf";
+    const std::string united1 = workDir + "/check-pdfunite-dedup-j1.pdf";
+    const std::string united4 = workDir + "/check-pdfunite-dedup-j4.pdf";
+    if (!testWriteFile(first, makePdf("First page")) || !testWriteFile(second, makePdf("Second page"))) {
+        fprintf(stderr, "can't write the files\n");
+        return 99;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    // the first file twice, so that its content and its pages are also
+    // the same
+    const std::vector<std::string> inputs = { first, second, first };
+    TEST_CHECK(runPdfunite(pdfunite, "", inputs, united));
+    TEST_CHECK(runPdfunite(pdfunite, "-dedup -j 1", inputs, united1));
+    TEST_CHECK(runPdfunite(pdfunite, "-dedup -j 4", inputs, united4));
+
+    PDFDoc doc(new GooString(united));
+    PDFDoc dedupDoc(new GooString(united1));
+    TEST_CHECK(doc.isOk() && dedupDoc.isOk());
+    if (!doc.isOk() || !dedupDoc.isOk()) {
+        return 1;
+    }
+
+    const Counts counts = countObjects(&doc);
+    TEST_CHECK(counts.fonts == 3 && counts.fontDescriptors == 3 && counts.fontFiles == 3);
+
+    // the pages reached from the links are rewritten in each file, and
+    // aren't written once
+    const Counts dedupCounts = countObjects(&dedupDoc);
+    TEST_CHECK(dedupCounts.fonts == 1);
+    TEST_CHECK(dedupCounts.fontDescriptors == 1);
+    TEST_CHECK(dedupCounts.fontFiles == 1);
+    TEST_CHECK(dedupCounts.pages == counts.pages);
+    TEST_CHECK(dedupCounts.pages == 6);
+    TEST_CHECK(dedupCounts.cycles == counts.cycles);
+    TEST_CHECK(dedupCounts.cycles == 6);
+
+    TEST_CHECK(dedupDoc.getNumPages() == 3);
+    for (int page = 1; page <= dedupDoc.getNumPages(); ++page) {
+        TEST_CHECK(pageText(&dedupDoc, page) == pageText(&doc, page));
+        TEST_CHECK(pageText(&dedupDoc, page).find(page == 2 ? "Second page" : "First page") != std::string::npos);
+    }
+    TEST_CHECK(contentsRef(&dedupDoc, 1) == contentsRef(&dedupDoc, 3));
+    TEST_CHECK(contentsRef(&dedupDoc, 1) != contentsRef(&dedupDoc, 2));
+    TEST_CHECK(contentsRef(&doc, 1) != contentsRef(&doc, 3));
+
+    TEST_CHECK(readObjects(united1) == readObjects(united4));
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+//========================================================================
+//
+// check-text-index.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks building and querying a TextIndex, and when it's found invalid
+// for its PDF file.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "goo/gmem.h"
+#include "GlobalParams.h"
+#include "TextIndex.h"
+#include "test-utils.h"
+
+static std::vector<TextIndexHit> find(const TextIndex &index, const std::string &term)
+{
+    const std::vector<Unicode> u(term.begin(), term.end());
+    return index.find(u.data(), u.size());
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-text-index <work-dir>\n");
+        return 99;
+    }
+    const std::string pdfFileName = std::string(argv[1]) + "/check-text-index.pdf";
+    const std::string indexFileName = std::string(argv[1]) + "/check-text-index.idx";
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    const std::string pdf = testTextPdf({ { "The quick brown fox" }, { "jumps over the lazy dog.", "Fox-trot" } });
+    TEST_CHECK(testWriteFile(pdfFileName, pdf));
+
+    // build and query
+    TEST_CHECK(TextIndex::build(pdfFileName.c_str(), nullptr, nullptr, indexFileName.c_str(), 2));
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(index.isOk());
+        TEST_CHECK(index.getNumPages() == 2);
+        TEST_CHECK(index.isValidFor(pdfFileName.c_str()));
+        TEST_CHECK(index.isValidFor(pdfFileName.c_str(), true));
+
+        const std::vector<TextIndexHit> fox = find(index, "fox");
+        TEST_CHECK(fox.size() == 2);
+        TEST_CHECK(fox.size() == 2 && fox[0].page == 1 && fox[1].page == 2 && fox[0].word == 3 && fox[1].word == 5);
+        TEST_CHECK(find(index, "FOX").size() == 2);
+        TEST_CHECK(find(index, "the").size() == 2);
+        TEST_CHECK(find(index, "trot").size() == 1);
+        TEST_CHECK(find(index, "cat").empty());
+    }
+
+    // a touched file is still indexed if its contents are the same
+    const std::filesystem::path path(pdfFileName);
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(path);
+    std::filesystem::last_write_time(path, mtime + std::chrono::seconds(10));
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(index.isValidFor(pdfFileName.c_str()));
+    }
+
+    // a file changed in place, keeping its size and modification time,
+    // is only found different when its contents are checked
+    std::string changed = pdf;
+    changed.replace(changed.find("brown"), 5, "black");
+    TEST_CHECK(testWriteFile(pdfFileName, changed));
+    std::filesystem::last_write_time(path, mtime);
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(index.isValidFor(pdfFileName.c_str()));
+        TEST_CHECK(!index.isValidFor(pdfFileName.c_str(), true));
+    }
+
+    // a changed file is found different
+    std::filesystem::last_write_time(path, mtime + std::chrono::seconds(20));
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(!index.isValidFor(pdfFileName.c_str()));
+    }
+    TEST_CHECK(testWriteFile(pdfFileName, pdf + "\n"));
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(!index.isValidFor(pdfFileName.c_str()));
+    }
+    TEST_CHECK(!TextIndex(indexFileName.c_str()).isValidFor((pdfFileName + ".missing").c_str()));
+
+    // rebuilding it makes it valid again
+    TEST_CHECK(TextIndex::build(pdfFileName.c_str(), nullptr, nullptr, indexFileName.c_str(), 1));
+    {
+        TextIndex index(indexFileName.c_str());
+        TEST_CHECK(index.isValidFor(pdfFileName.c_str(), true));
+        TEST_CHECK(find(index, "brown").size() == 1);
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
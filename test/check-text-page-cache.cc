@@ -0,0 +1,137 @@
+//========================================================================
+//
+// check-text-page-cache.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks that TextPageCache keeps the text of the pages, and extracts it
+// again after a form field or an annotation of the document is edited, or
+// an optional content group is hidden or shown.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <memory>
+#include <string>
+
+#include "goo/GooString.h"
+#include "Annot.h"
+#include "Form.h"
+#include "GlobalParams.h"
+#include "OptionalContent.h"
+#include "PDFDoc.h"
+#include "TextOutputDev.h"
+#include "TextPageCache.h"
+#include "test-utils.h"
+
+// Return the text of the page of <doc>, through <cache>.
+static std::string pageText(TextPageCache *cache, PDFDoc *doc, TextPage **textPage = nullptr)
+{
+    const TextPageCache::Key key = { 1, 0, false, true };
+    TextPage *text = cache->acquire(doc, key);
+    if (!text) {
+        return std::string();
+    }
+    if (textPage) {
+        *textPage = text;
+    }
+    std::unique_ptr<GooString> s(text->getText(0, 0, 612, 792, eolUnix));
+    cache->release(key, text);
+    return s->toStr();
+}
+
+// Return <s> in UTF-16BE, with its byte order mark.
+static GooString utf16(const std::string &s)
+{
+    GooString u("\xfe\xff");
+    for (char c : s) {
+        u.append('\0');
+        u.append(c);
+    }
+    return u;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-text-page-cache <work-dir>\n");
+        return 99;
+    }
+    const std::string pdfFileName = std::string(argv[1]) + "/check-text-page-cache.pdf";
+
+    globalParams = std::make_unique<GlobalParams>();
+
+    // a page with a text field and a free text annotation, whose
+    // appearances are generated, and text in an optional content group
+    TEST_CHECK(testWriteFile(pdfFileName,
+                             testPdf({ "<< /Type /Catalog /Pages 2 0 R /AcroForm << /Fields [5 0 R] /DA (/Helv 12 Tf 0 g) /DR << /Font << /Helv 6 0 R >> >> >> /OCProperties << /OCGs [8 0 R] /D << /ON [8 0 R] >> >> >>",
+                                       "<< /Type /Pages /Kids [3 0 R] /Count 1 >>", "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 6 0 R >> /Properties << /L1 8 0 R >> >> /Contents 4 0 R /Annots [5 0 R 7 0 R] >>",
+                                       testStreamObject("", "BT /F1 12 Tf 72 720 Td (Content) Tj ET /OC /L1 BDC BT /F1 12 Tf 72 500 Td (Layer) Tj ET EMC"),
+                                       "<< /Type /Annot /Subtype /Widget /FT /Tx /T (field) /V (Hello) /Rect [72 600 300 630] /DA (/Helv 12 Tf 0 g) /F 4 /P 3 0 R >>", "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>",
+                                       "<< /Type /Annot /Subtype /FreeText /Rect [72 400 300 430] /Contents (Note) /DA (/Helv 12 Tf 0 g) /F 4 /P 3 0 R >>", "<< /Type /OCG /Name (Layer) >>" })));
+    PDFDoc doc(new GooString(pdfFileName));
+    TEST_CHECK(doc.isOk());
+    if (!doc.isOk()) {
+        return 1;
+    }
+
+    TextPageCache cache(16 * 1024 * 1024);
+    TextPage *first = nullptr, *second = nullptr;
+    const std::string text = pageText(&cache, &doc, &first);
+    TEST_CHECK(text.find("Content") != std::string::npos && text.find("Hello") != std::string::npos && text.find("Note") != std::string::npos && text.find("Layer") != std::string::npos);
+
+    // the page is taken from the cache while the document is unchanged
+    TEST_CHECK(pageText(&cache, &doc, &second) == text);
+    TEST_CHECK(second == first);
+
+    // editing the field
+    std::unique_ptr<FormPageWidgets> widgets(doc.getPage(1)->getFormWidgets());
+    TEST_CHECK(widgets->getNumWidgets() == 1);
+    if (widgets->getNumWidgets() == 1 && widgets->getWidget(0)->getType() == formText) {
+        const GooString content = utf16("World");
+        static_cast<FormWidgetText *>(widgets->getWidget(0))->setContent(&content);
+    }
+    const std::string fieldText = pageText(&cache, &doc);
+    TEST_CHECK(fieldText.find("World") != std::string::npos && fieldText.find("Hello") == std::string::npos);
+
+    // editing the annotation
+    Annots *annots = doc.getPage(1)->getAnnots();
+    Annot *note = nullptr;
+    for (int i = 0; i < annots->getNumAnnots(); ++i) {
+        if (annots->getAnnot(i)->getType() == Annot::typeFreeText) {
+            note = annots->getAnnot(i);
+        }
+    }
+    TEST_CHECK(note);
+    if (note) {
+        GooString contents = utf16("Changed");
+        note->setContents(&contents);
+    }
+    const std::string noteText = pageText(&cache, &doc);
+    TEST_CHECK(noteText.find("Changed") != std::string::npos && noteText.find("Note") == std::string::npos);
+
+    // removing it, holding a reference like the bindings do
+    if (note) {
+        note->incRefCnt();
+        doc.getPage(1)->removeAnnot(note);
+        note->decRefCnt();
+    }
+    const std::string removedText = pageText(&cache, &doc);
+    TEST_CHECK(removedText.find("Changed") == std::string::npos && removedText.find("World") != std::string::npos);
+
+    // hiding the optional content group, and showing it again
+    const Ref layerRef = { 8, 0 };
+    OptionalContentGroup *layer = doc.getOptContentConfig() ? doc.getOptContentConfig()->findOcgByRef(layerRef) : nullptr;
+    TEST_CHECK(layer);
+    if (layer) {
+        TEST_CHECK(pageText(&cache, &doc).find("Layer") != std::string::npos);
+        layer->setState(OptionalContentGroup::Off);
+        const std::string hiddenText = pageText(&cache, &doc);
+        TEST_CHECK(hiddenText.find("Layer") == std::string::npos && hiddenText.find("Content") != std::string::npos);
+        layer->setState(OptionalContentGroup::On);
+        TEST_CHECK(pageText(&cache, &doc).find("Layer") != std::string::npos);
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+//========================================================================
+//
+// check-tiling-pattern.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Checks the tiles of tiling patterns cached by SplashOutputDev: colored
+// and uncolored patterns, axis-aligned, rotated or with steps that aren't
+// a whole number of pixels, render like the cells drawn one by one by
+// Gfx, in phase with them, cells filling their whole step leave no seams
+// between them where Gfx would not, and a tile isn't reused once optional
+// content it draws is shown or hidden.
+//
+//========================================================================
+
+#include <config.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "goo/GooString.h"
+#include "GlobalParams.h"
+#include "OptionalContent.h"
+#include "Object.h" /* must be included before SplashOutputDev.h because of sloppiness in SplashOutputDev.h */
+#include "PDFDoc.h"
+#include "SplashOutputDev.h"
+#include "splash/SplashBitmap.h"
+#include "test-utils.h"
+
+// A SplashOutputDev leaving the tiling patterns to Gfx, which draws
+// every cell as a form.
+class FallbackOutputDev : public SplashOutputDev
+{
+public:
+    FallbackOutputDev(SplashColorPtr paperColorA) : SplashOutputDev(splashModeRGB8, 4, false, paperColorA) { }
+
+    bool useTilingPatternFill() override { return false; }
+};
+
+// Return a page filling [40 540] x [40 740] with a tiling pattern of
+// paint type <paintType>, pattern matrix <matrix>, step <step> and cell
+// content <cell>.
+static std::string makePdf(int paintType, const std::string &matrix, double step, const std::string &cell)
+{
+    const std::string fill = paintType == 1 ? "/Pattern cs /P0 scn" : "/Cs0 cs 0 0.5 1 /P0 scn";
+    const std::string content = "q " + fill + " 40 40 500 700 re f Q";
+    const std::string cellContent = (paintType == 1 ? "1 0 0 rg 0 0.6 0 RG " : "") + cell;
+    return testPdf({ "<< /Type /Catalog /Pages 2 0 R >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                     "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Pattern << /P0 5 0 R >> /ColorSpace << /Cs0 [/Pattern /DeviceRGB] >> >> /Contents 4 0 R >>",
+                     testStreamObject("", content),
+                     testStreamObject("/Type /Pattern /PatternType 1 /PaintType " + std::to_string(paintType) + " /TilingType 1 /BBox [0 0 20 20] /XStep " + std::to_string(step) + " /YStep " + std::to_string(step)
+                                              + " /Matrix [" + matrix + "] /Resources << >>",
+                                      cellContent) });
+}
+
+static std::unique_ptr<SplashBitmap> render(SplashOutputDev *out, PDFDoc *doc)
+{
+    out->startDoc(doc);
+    doc->displayPage(out, 1, 72, 72, 0, true, false, false);
+    return std::unique_ptr<SplashBitmap>(out->takeBitmap());
+}
+
+static bool sameBitmap(SplashBitmap *a, SplashBitmap *b)
+{
+    return a->getWidth() == b->getWidth() && a->getHeight() == b->getHeight() && a->getRowSize() == b->getRowSize() && memcmp(a->getDataPtr(), b->getDataPtr(), (size_t)a->getRowSize() * a->getHeight()) == 0;
+}
+
+static const unsigned char *pixel(SplashBitmap *bitmap, int x, int y)
+{
+    return bitmap->getDataPtr() + y * bitmap->getRowSize() + 3 * x;
+}
+
+// Return the number of pixels inside the filled area whose color isn't
+// <color>.
+static int countSeams(SplashBitmap *bitmap, const unsigned char *color)
+{
+    int seams = 0;
+    for (int y = 60; y < 740; ++y) {
+        for (int x = 50; x < 530; ++x) {
+            const unsigned char *p = pixel(bitmap, x, y);
+            seams += std::abs(p[0] - color[0]) + std::abs(p[1] - color[1]) + std::abs(p[2] - color[2]) > 6;
+        }
+    }
+    return seams;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: check-tiling-pattern <work-dir>\n");
+        return 99;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+    const std::string pdfFileName = std::string(argv[1]) + "/check-tiling-pattern.pdf";
+    SplashColor paperColor;
+    paperColor[0] = paperColor[1] = paperColor[2] = 0xff;
+
+    // pattern matrices, and whether the tile is resampled to the device
+    // space, or the cell boundaries fall on the pixel boundaries
+    struct PatternMatrix
+    {
+        const char *matrix;
+        bool resampled;
+        bool aligned;
+    };
+    const PatternMatrix matrices[] = { { "1 0 0 1 0 0", false, true }, { "1 0 0 1 0.5 0.25", false, false }, { "1.37 0 0 1.37 3.3 5.7", false, false }, { "0.866 0.5 -0.5 0.866 0 0", true, true }, { "0 1.2 -1.2 0 7.3 2.7", false, false } };
+    for (int paintType = 1; paintType <= 2; ++paintType) {
+        for (const PatternMatrix &m : matrices) {
+            for (double step : { 20.0, 23.5 }) {
+                // cells drawn away from their edges: the tile puts them
+                // where Gfx does, to the pixel, unless it is resampled
+                TEST_CHECK(testWriteFile(pdfFileName, makePdf(paintType, m.matrix, step, "3 3 8 5 re f 12 10 m 13 10 l 17 16 l 16 16 l h f 14 4 m 18 4 l 16 8 l h f")));
+                PDFDoc doc(new GooString(pdfFileName));
+                TEST_CHECK(doc.isOk());
+                if (!doc.isOk()) {
+                    continue;
+                }
+                SplashOutputDev native(splashModeRGB8, 4, false, paperColor);
+                FallbackOutputDev fallback(paperColor);
+                std::unique_ptr<SplashBitmap> bitmap = render(&native, &doc);
+                std::unique_ptr<SplashBitmap> ref = render(&fallback, &doc);
+
+                double sum = 0;
+                int far = 0, n = 0;
+                for (int y = 60; y < 740; ++y) {
+                    for (int x = 50; x < 530; ++x) {
+                        for (int i = 0; i < 3; ++i) {
+                            const int d = std::abs(pixel(bitmap.get(), x, y)[i] - pixel(ref.get(), x, y)[i]);
+                            sum += d;
+                            far += d > 128;
+                            ++n;
+                        }
+                    }
+                }
+                TEST_CHECK(sum / n < (m.resampled ? 8 : 3));
+                TEST_CHECK(far < n / (m.resampled ? 50 : 100));
+            }
+        }
+
+        // cells filling their whole step: no seams between them when
+        // their boundaries are pixel boundaries, and never more than when
+        // Gfx draws them
+        const unsigned char color[3] = { (unsigned char)(paintType == 1 ? 255 : 0), (unsigned char)(paintType == 1 ? 0 : 128), (unsigned char)(paintType == 1 ? 0 : 255) };
+        for (const PatternMatrix &m : matrices) {
+            TEST_CHECK(testWriteFile(pdfFileName, makePdf(paintType, m.matrix, 20, "0 0 20 20 re f")));
+            PDFDoc doc(new GooString(pdfFileName));
+            TEST_CHECK(doc.isOk());
+            if (!doc.isOk()) {
+                continue;
+            }
+            SplashOutputDev native(splashModeRGB8, 4, false, paperColor);
+            FallbackOutputDev fallback(paperColor);
+            const int seams = countSeams(render(&native, &doc).get(), color);
+            if (m.aligned) {
+                TEST_CHECK(seams == 0);
+            }
+            TEST_CHECK(seams <= countSeams(render(&fallback, &doc).get(), color));
+        }
+    }
+
+    // a pattern whose cells are partly in an optional content group,
+    // rendered again by the same device once the group is hidden
+    TEST_CHECK(testWriteFile(pdfFileName,
+                             testPdf({ "<< /Type /Catalog /Pages 2 0 R /OCProperties << /OCGs [6 0 R] /D << /ON [6 0 R] >> >> >>", "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+                                       "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Pattern << /P0 5 0 R >> >> /Contents 4 0 R >>", testStreamObject("", "q /Pattern cs /P0 scn 40 40 500 700 re f Q"),
+                                       testStreamObject("/Type /Pattern /PatternType 1 /PaintType 1 /TilingType 1 /BBox [0 0 20 20] /XStep 20 /YStep 20 /Resources << /Properties << /L1 6 0 R >> >>",
+                                                        "0 0 1 rg 0 0 20 10 re f /OC /L1 BDC 1 0 0 rg 0 10 20 10 re f EMC"),
+                                       "<< /Type /OCG /Name (Layer) >>" })));
+    PDFDoc doc(new GooString(pdfFileName));
+    TEST_CHECK(doc.isOk());
+    const Ref layerRef = { 6, 0 };
+    OptionalContentGroup *layer = doc.isOk() && doc.getOptContentConfig() ? doc.getOptContentConfig()->findOcgByRef(layerRef) : nullptr;
+    TEST_CHECK(layer);
+    if (layer) {
+        SplashOutputDev out(splashModeRGB8, 4, false, paperColor);
+        std::unique_ptr<SplashBitmap> shown = render(&out, &doc);
+        layer->setState(OptionalContentGroup::Off);
+        doc.displayPage(&out, 1, 72, 72, 0, true, false, false);
+        std::unique_ptr<SplashBitmap> hidden(out.takeBitmap());
+        SplashOutputDev fresh(splashModeRGB8, 4, false, paperColor);
+        std::unique_ptr<SplashBitmap> ref = render(&fresh, &doc);
+        TEST_CHECK(sameBitmap(hidden.get(), ref.get()));
+        TEST_CHECK(!sameBitmap(hidden.get(), shown.get()));
+    }
+
+    return testFailures() == 0 ? 0 : 1;
+}
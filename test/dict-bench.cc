@@ -0,0 +1,219 @@
+//========================================================================
+//
+// dict-bench.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Parse every object of the given PDF files, loaded in memory, a number
+// of times, then look up the usual keys in all their dictionaries, by
+// name and by atom, and report the speed of each.  The lookups, and
+// optionally the rendering of the pages, are repeated by 1, 2, 4... up
+// to -j threads sharing the documents, to show how they scale.
+//
+//========================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GlobalParams.h"
+#include "Object.h"
+#include "PDFDoc.h"
+#include "SplashOutputDev.h"
+#include "Stream.h"
+#include "XRef.h"
+#include "utils/parseargs.h"
+
+static int iterations = 10;
+static int maxThreads = 1;
+static bool render = false;
+static bool printHelp = false;
+
+static const ArgDesc argDesc[] = { { "-n", argInt, &iterations, 0, "number of times each object is parsed and each key looked up" },
+                                   { "-j", argInt, &maxThreads, 0, "maximum number of threads doing the lookups and rendering" },
+                                   { "-render", argFlag, &render, 0, "also render all the pages with each number of threads" },
+                                   { "-h", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "--help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-?", argFlag, &printHelp, 0, "print usage information" },
+                                   {} };
+
+// keys looked up in every dictionary, some of which are usually missing
+static const char *const lookupKeys[] = { "Type", "Subtype", "Length", "Filter", "DecodeParms", "Resources", "Parent", "Kids", "Font", "XObject", "MediaBox", "Contents", "Rect", "P" };
+static const Atom lookupAtoms[] = { Atoms::Type, Atoms::Subtype, Atoms::Length, Atoms::Filter, Atoms::DecodeParms, Atoms::Resources, Atoms::Parent, Atoms::Kids, Atoms::Font, Atoms::XObject, Atoms::MediaBox, Atoms::Contents, Atoms::Rect, Atoms::P };
+static constexpr int nLookupKeys = sizeof(lookupKeys) / sizeof(lookupKeys[0]);
+
+struct Document
+{
+    std::vector<char> data;
+    std::unique_ptr<PDFDoc> doc;
+    std::vector<Object> dicts; // the dicts and streams of the document
+};
+
+static std::unique_ptr<Document> loadFile(const char *fileName)
+{
+    // parse from memory, so that the file reads don't hide the parsing time
+    FILE *f = fopen(fileName, "rb");
+    if (!f) {
+        fprintf(stderr, "Error opening %s\n", fileName);
+        return nullptr;
+    }
+    auto document = std::make_unique<Document>();
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        document->data.insert(document->data.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    document->doc = std::make_unique<PDFDoc>(new MemStream(document->data.data(), 0, document->data.size(), Object(objNull)));
+    if (!document->doc->isOk()) {
+        fprintf(stderr, "Error loading %s\n", fileName);
+        return nullptr;
+    }
+    return document;
+}
+
+// Fetch every object <iterations> times, keeping the dicts of the first
+// pass.  Returns the number of objects fetched.
+static long long parseObjects(Document *document)
+{
+    XRef *xref = document->doc->getXRef();
+    long long objects = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (int num = 1; num < xref->getNumObjects(); ++num) {
+            Object obj = xref->fetch(num, xref->getEntry(num)->gen);
+            if (i == 0 && (obj.isDict() || obj.isStream())) {
+                document->dicts.push_back(std::move(obj));
+            }
+            ++objects;
+        }
+    }
+    return objects;
+}
+
+// Look up <keys> in all the dicts <iterations> times.  Returns the
+// number of keys found.
+template<typename Key>
+static long long lookupAll(const std::vector<std::unique_ptr<Document>> &documents, const Key *keys)
+{
+    long long found = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const std::unique_ptr<Document> &document : documents) {
+            for (const Object &obj : document->dicts) {
+                const Dict *dict = obj.isDict() ? obj.getDict() : obj.getStream()->getDict();
+                for (int k = 0; k < nLookupKeys; ++k) {
+                    if (!dict->lookupNF(keys[k]).isNull()) {
+                        ++found;
+                    }
+                }
+            }
+        }
+    }
+    return found;
+}
+
+// Render the pages of <doc> until there are none left.
+static void renderPages(PDFDoc *doc, std::atomic_int *nextPage)
+{
+    SplashColor paperColor;
+    paperColor[0] = paperColor[1] = paperColor[2] = 0xff;
+    SplashOutputDev splashOut(splashModeRGB8, 4, false, paperColor);
+    splashOut.startDoc(doc);
+    int page;
+    while ((page = (*nextPage)++) <= doc->getNumPages()) {
+        doc->displayPage(&splashOut, page, 72, 72, 0, false, true, false);
+    }
+}
+
+// Run <func> in <nThreads> threads, and return the elapsed time.
+template<typename Func>
+static double runThreads(int nThreads, const Func &func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; ++i) {
+        threads.emplace_back(func);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// The thread counts tried: 1, 2, 4... and maxThreads.
+static std::vector<int> threadCounts()
+{
+    std::vector<int> counts;
+    for (int n = 1; n < maxThreads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = parseArgs(argDesc, &argc, argv);
+    if (!ok || argc < 2 || iterations < 1 || maxThreads < 1 || printHelp) {
+        printUsage(argv[0], "PDF-FILES...", argDesc);
+        return printHelp ? 0 : 1;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+    globalParams->setErrQuiet(true);
+
+    std::vector<std::unique_ptr<Document>> documents;
+    for (int i = 1; i < argc; ++i) {
+        if (std::unique_ptr<Document> document = loadFile(argv[i])) {
+            documents.push_back(std::move(document));
+        }
+    }
+
+    long long objects = 0;
+    long long dicts = 0;
+    const double parseSeconds = runThreads(1, [&] {
+        for (const std::unique_ptr<Document> &document : documents) {
+            objects += parseObjects(document.get());
+            dicts += document->dicts.size();
+        }
+    });
+
+    // ns/op is the time taken by each operation in one thread
+    printf("%-8s %7s %12s %10s %12s %10s\n", "phase", "threads", "ops", "seconds", "Mops/s", "ns/op");
+    printf("%-8s %7d %12lld %10.3f %12.2f %10.1f\n", "parse", 1, objects, parseSeconds, objects / 1e6 / parseSeconds, parseSeconds * 1e9 / objects);
+
+    const long long lookups = dicts * nLookupKeys * iterations;
+    const long long found = lookupAll(documents, lookupKeys);
+    for (int nThreads : threadCounts()) {
+        std::atomic<long long> nameFound { 0 }, atomFound { 0 };
+        const double nameSeconds = runThreads(nThreads, [&] { nameFound += lookupAll(documents, lookupKeys); });
+        const double atomSeconds = runThreads(nThreads, [&] { atomFound += lookupAll(documents, lookupAtoms); });
+        if (nameFound != found * nThreads || atomFound != found * nThreads) {
+            fprintf(stderr, "Lookups by name and by atom differ\n");
+        }
+        printf("%-8s %7d %12lld %10.3f %12.2f %10.1f\n", "lookup", nThreads, lookups * nThreads, nameSeconds, lookups * nThreads / 1e6 / nameSeconds, nameSeconds * 1e9 / lookups);
+        printf("%-8s %7d %12lld %10.3f %12.2f %10.1f\n", "atoms", nThreads, lookups * nThreads, atomSeconds, lookups * nThreads / 1e6 / atomSeconds, atomSeconds * 1e9 / lookups);
+    }
+
+    if (render) {
+        printf("\n%-8s %7s %12s %10s %12s %10s\n", "phase", "threads", "pages", "seconds", "pages/s", "ms/page");
+        for (int nThreads : threadCounts()) {
+            long long pages = 0;
+            double seconds = 0;
+            for (const std::unique_ptr<Document> &document : documents) {
+                PDFDoc *doc = document->doc.get();
+                std::atomic_int nextPage { 1 };
+                seconds += runThreads(nThreads, [doc, &nextPage] { renderPages(doc, &nextPage); });
+                pages += doc->getNumPages();
+            }
+            printf("%-8s %7d %12lld %10.3f %12.2f %10.1f\n", "render", nThreads, pages, seconds, pages / seconds, seconds * 1e3 / pages);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+//========================================================================
+//
+// jbig2-bench.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Decode every JBIG2 image of the given PDF files a number of times and
+// report the decoding speed, split by the kind of region the images are
+// mostly made of.
+//
+//========================================================================
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "GlobalParams.h"
+#include "Object.h"
+#include "PDFDoc.h"
+#include "Stream.h"
+#include "XRef.h"
+#include "goo/GooString.h"
+#include "utils/parseargs.h"
+
+static int iterations = 10;
+static bool printHelp = false;
+
+static const ArgDesc argDesc[] = { { "-n", argInt, &iterations, 0, "number of times each image is decoded" },
+                                   { "-h", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "--help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-?", argFlag, &printHelp, 0, "print usage information" },
+                                   {} };
+
+enum RegionKind
+{
+    regionGeneric,
+    regionText,
+    regionHalftone,
+    regionRefinement,
+    regionOther,
+    regionKindCount
+};
+
+static const char *regionKindNames[regionKindCount] = { "generic", "text", "halftone", "refinement", "other" };
+
+struct KindStats
+{
+    int images = 0;
+    double pixels = 0;
+    double seconds = 0;
+};
+
+static bool readBytes(const std::string &s, size_t *pos, size_t n, unsigned int *x)
+{
+    if (*pos + n > s.size()) {
+        return false;
+    }
+    *x = 0;
+    for (size_t i = 0; i < n; ++i) {
+        *x = (*x << 8) | (unsigned char)s[(*pos)++];
+    }
+    return true;
+}
+
+// Classify an embedded JBIG2 stream by the kind of region segments
+// holding most of its data (symbol dictionaries count as text).
+static RegionKind classifyStream(Stream *rawStr)
+{
+    std::string s;
+    unsigned long long bytes[regionKindCount] = {};
+    size_t pos = 0;
+    unsigned int segNum, flags, refFlags, x, length;
+
+    rawStr->reset();
+    rawStr->fillString(s);
+    rawStr->close();
+
+    while (readBytes(s, &pos, 4, &segNum) && readBytes(s, &pos, 1, &flags) && readBytes(s, &pos, 1, &refFlags)) {
+        unsigned int nRefSegs = refFlags >> 5;
+        if (nRefSegs == 7) {
+            if (!readBytes(s, &pos, 3, &x)) {
+                break;
+            }
+            nRefSegs = ((refFlags << 24) | x) & 0x1fffffff;
+            pos += (nRefSegs + 9) >> 3;
+        }
+        pos += nRefSegs * (segNum <= 256 ? 1 : segNum <= 65536 ? 2 : 4);
+        pos += (flags & 0x40) ? 4 : 1;
+        if (!readBytes(s, &pos, 4, &length) || length == 0xffffffff) {
+            break;
+        }
+        pos += length;
+
+        switch (flags & 0x3f) {
+        case 0:
+        case 4:
+        case 6:
+        case 7:
+            bytes[regionText] += length;
+            break;
+        case 20:
+        case 22:
+        case 23:
+            bytes[regionHalftone] += length;
+            break;
+        case 36:
+        case 38:
+        case 39:
+            bytes[regionGeneric] += length;
+            break;
+        case 40:
+        case 42:
+        case 43:
+            bytes[regionRefinement] += length;
+            break;
+        default:
+            bytes[regionOther] += length;
+            break;
+        }
+    }
+
+    int kind = regionOther;
+    for (int i = 0; i < regionKindCount; ++i) {
+        if (bytes[i] > bytes[kind]) {
+            kind = i;
+        }
+    }
+    return (RegionKind)kind;
+}
+
+static bool isJBIG2Image(Object *obj)
+{
+    if (!obj->isStream()) {
+        return false;
+    }
+    Stream *str = obj->getStream();
+    return str->getKind() == strJBIG2 && str->getNextStream() && str->getNextStream()->getKind() != strJBIG2;
+}
+
+static void benchFile(const char *fileName, KindStats *stats)
+{
+    std::unique_ptr<PDFDoc> doc = std::make_unique<PDFDoc>(new GooString(fileName));
+    if (!doc->isOk()) {
+        fprintf(stderr, "Error loading %s\n", fileName);
+        return;
+    }
+
+    XRef *xref = doc->getXRef();
+    std::vector<unsigned char> buf(65536);
+    for (int num = 1; num < xref->getNumObjects(); ++num) {
+        Object obj = xref->fetch(num, xref->getEntry(num)->gen);
+        if (!isJBIG2Image(&obj)) {
+            continue;
+        }
+        Stream *str = obj.getStream();
+        Object wObj = str->getDict()->lookup("Width");
+        Object hObj = str->getDict()->lookup("Height");
+        const int w = wObj.isInt() ? wObj.getInt() : 0;
+        const int h = hObj.isInt() ? hObj.getInt() : 0;
+        KindStats *kindStats = &stats[classifyStream(str->getNextStream())];
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            str->reset();
+            while (str->doGetChars(buf.size(), buf.data()) > 0) { }
+            str->close();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        ++kindStats->images;
+        kindStats->pixels += (double)w * h * iterations;
+        kindStats->seconds += elapsed.count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    KindStats stats[regionKindCount];
+
+    bool ok = parseArgs(argDesc, &argc, argv);
+    if (!ok || argc < 2 || iterations < 1 || printHelp) {
+        printUsage(argv[0], "PDF-FILES...", argDesc);
+        return printHelp ? 0 : 1;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+    globalParams->setErrQuiet(true);
+
+    for (int i = 1; i < argc; ++i) {
+        benchFile(argv[i], stats);
+    }
+
+    printf("%-12s %8s %12s %10s %10s\n", "region", "images", "Mpixels", "seconds", "Mpixels/s");
+    for (int i = 0; i < regionKindCount; ++i) {
+        if (stats[i].images == 0) {
+            continue;
+        }
+        printf("%-12s %8d %12.1f %10.3f %10.1f\n", regionKindNames[i], stats[i].images, stats[i].pixels / 1e6, stats[i].seconds, stats[i].pixels / 1e6 / stats[i].seconds);
+    }
+
+    return 0;
+}
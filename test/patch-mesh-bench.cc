@@ -0,0 +1,121 @@
+//========================================================================
+//
+// patch-mesh-bench.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Render the pages of the given PDF files with SplashOutputDev, once
+// with the native patch mesh shading rasterizer and once with the
+// generic Gfx fallback, and report the rendering times and the mean
+// difference between the two renderings.
+//
+//========================================================================
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+#include "GlobalParams.h"
+#include "Object.h" /* must be included before SplashOutputDev.h because of sloppiness in SplashOutputDev.h */
+#include "PDFDoc.h"
+#include "SplashOutputDev.h"
+#include "goo/GooString.h"
+#include "splash/SplashBitmap.h"
+#include "utils/parseargs.h"
+
+static int iterations = 5;
+static double resolution = 150;
+static bool printHelp = false;
+
+static const ArgDesc argDesc[] = { { "-n", argInt, &iterations, 0, "number of times each page is rendered" },
+                                   { "-r", argFP, &resolution, 0, "resolution, in DPI (default is 150)" },
+                                   { "-h", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "--help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-?", argFlag, &printHelp, 0, "print usage information" },
+                                   {} };
+
+// A SplashOutputDev leaving the patch mesh shadings to Gfx, which
+// subdivides them into flat filled quadrilaterals.
+class FallbackOutputDev : public SplashOutputDev
+{
+public:
+    FallbackOutputDev(SplashColorPtr paperColorA) : SplashOutputDev(splashModeRGB8, 4, false, paperColorA) { }
+
+    bool useShadedFills(int type) override { return type != 6 && type != 7 && SplashOutputDev::useShadedFills(type); }
+};
+
+// Render <page> <iterations> times, and return the time per rendering.
+static double renderPage(PDFDoc *doc, SplashOutputDev *out, int page)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        doc->displayPage(out, page, resolution, resolution, 0, true, false, false);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+static double meanDifference(SplashBitmap *a, SplashBitmap *b)
+{
+    if (a->getWidth() != b->getWidth() || a->getHeight() != b->getHeight()) {
+        return NAN;
+    }
+    double sum = 0;
+    for (int y = 0; y < a->getHeight(); ++y) {
+        const unsigned char *p = a->getDataPtr() + y * a->getRowSize();
+        const unsigned char *q = b->getDataPtr() + y * b->getRowSize();
+        for (int x = 0; x < 3 * a->getWidth(); ++x) {
+            sum += std::abs(p[x] - q[x]);
+        }
+    }
+    return sum / (3.0 * a->getWidth() * a->getHeight());
+}
+
+static void benchFile(const char *fileName, double *nativeTotal, double *fallbackTotal)
+{
+    std::unique_ptr<PDFDoc> doc = std::make_unique<PDFDoc>(new GooString(fileName));
+    if (!doc->isOk()) {
+        fprintf(stderr, "Error loading %s\n", fileName);
+        return;
+    }
+
+    SplashColor paperColor;
+    paperColor[0] = paperColor[1] = paperColor[2] = 0xff;
+    SplashOutputDev native(splashModeRGB8, 4, false, paperColor);
+    FallbackOutputDev fallback(paperColor);
+    native.startDoc(doc.get());
+    fallback.startDoc(doc.get());
+
+    for (int page = 1; page <= doc->getNumPages(); ++page) {
+        const double nativeTime = renderPage(doc.get(), &native, page);
+        const double fallbackTime = renderPage(doc.get(), &fallback, page);
+        printf("%-30s %5d %10.4f %10.4f %8.2f %8.3f\n", fileName, page, nativeTime, fallbackTime, fallbackTime / nativeTime, meanDifference(native.getBitmap(), fallback.getBitmap()));
+        *nativeTotal += nativeTime;
+        *fallbackTotal += fallbackTime;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = parseArgs(argDesc, &argc, argv);
+    if (!ok || argc < 2 || iterations < 1 || resolution <= 0 || printHelp) {
+        printUsage(argv[0], "PDF-FILES...", argDesc);
+        return printHelp ? 0 : 1;
+    }
+
+    globalParams = std::make_unique<GlobalParams>();
+    globalParams->setErrQuiet(true);
+
+    double nativeTotal = 0, fallbackTotal = 0;
+    printf("%-30s %5s %10s %10s %8s %8s\n", "file", "page", "native", "fallback", "speedup", "diff");
+    for (int i = 1; i < argc; ++i) {
+        benchFile(argv[i], &nativeTotal, &fallbackTotal);
+    }
+    if (nativeTotal > 0) {
+        printf("%-30s %5s %10.4f %10.4f %8.2f\n", "total", "", nativeTotal, fallbackTotal, fallbackTotal / nativeTotal);
+    }
+
+    return 0;
+}
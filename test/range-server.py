@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+#
+# range-server.py
+#
+# This file is licensed under the GPLv2 or later
+#
+# Serves the files of a directory over HTTP with byte range requests,
+# and runs a command with the URL of the directory as last argument.
+# Files under /full/ are served whole, ignoring the Range header, like
+# servers without range support do.  Every GET request is logged to
+# range-server.log in the directory, as
+#   <path> <first byte> <last byte> <transfers in progress>
+# with "full" instead of the byte range for whole file responses.
+#
+# usage: range-server.py <dir> <command> [<arg>...]
+
+import http.server
+import os
+import subprocess
+import sys
+import threading
+import time
+
+# How long a request takes, so that concurrent ones overlap
+REQUEST_DELAY = 0.2
+
+
+class RangeRequestHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def log_message(self, format, *args):
+        pass
+
+    def file_data(self):
+        path = self.path
+        full = path.startswith('/full/')
+        if full:
+            path = path[len('/full'):]
+        name = os.path.join(self.server.root, os.path.basename(path))
+        if not os.path.isfile(name):
+            return None, full
+        with open(name, 'rb') as f:
+            return f.read(), full
+
+    def send_data(self, code, data, headers, send_body):
+        self.send_response(code)
+        for key, value in headers:
+            self.send_header(key, value)
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        if send_body:
+            self.wfile.write(data)
+
+    def do_HEAD(self):
+        data, full = self.file_data()
+        if data is None:
+            self.send_data(404, b'', [], False)
+        else:
+            self.send_data(200, data, [] if full else [('Accept-Ranges', 'bytes')], False)
+
+    def do_GET(self):
+        data, full = self.file_data()
+        if data is None:
+            self.send_data(404, b'', [], True)
+            return
+
+        first = last = None
+        range_header = self.headers.get('Range')
+        if not full and range_header and range_header.startswith('bytes='):
+            first, _, last = range_header[len('bytes='):].partition('-')
+            first = int(first)
+            last = min(int(last), len(data) - 1) if last else len(data) - 1
+
+        server = self.server
+        with server.lock:
+            server.in_progress += 1
+        time.sleep(REQUEST_DELAY)
+        with server.lock:
+            entry = '%s %s %d\n' % (self.path, 'full' if first is None else '%d %d' % (first, last), server.in_progress)
+            server.in_progress -= 1
+            with open(server.log_name, 'a') as log:
+                log.write(entry)
+
+        if first is None:
+            self.send_data(200, data, [], True)
+        elif first >= len(data):
+            self.send_data(416, b'', [('Content-Range', 'bytes */%d' % len(data))], True)
+        else:
+            self.send_data(206, data[first:last + 1], [('Content-Range', 'bytes %d-%d/%d' % (first, last, len(data)))], True)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.stderr.write('usage: range-server.py <dir> <command> [<arg>...]\n')
+        return 99
+
+    os.makedirs(sys.argv[1], exist_ok=True)
+    server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), RangeRequestHandler)
+    server.daemon_threads = True
+    server.root = sys.argv[1]
+    server.log_name = os.path.join(sys.argv[1], 'range-server.log')
+    server.lock = threading.Lock()
+    server.in_progress = 0
+    open(server.log_name, 'w').close()
+
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    url = 'http://127.0.0.1:%d' % server.server_address[1]
+    result = subprocess.call(sys.argv[2:] + [url])
+    server.shutdown()
+    return result
+
+
+if __name__ == '__main__':
+    sys.exit(main())
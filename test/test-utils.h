@@ -0,0 +1,95 @@
+//========================================================================
+//
+// test-utils.h
+//
+// This file is licensed under the GPLv2 or later
+//
+// Helpers of the checks of the core library: writing small PDF files
+// and counting the failed checks.
+//
+//========================================================================
+
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+inline int &testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void testCheck(bool ok, const char *cond, const char *file, int line)
+{
+    if (!ok) {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+        ++testFailures();
+    }
+}
+
+// Count a failure, and print it, if <cond> doesn't hold.
+#define TEST_CHECK(cond) testCheck((cond), #cond, __FILE__, __LINE__)
+
+// Return a stream object with the dict entries <entries> and the data
+// <data>.
+inline std::string testStreamObject(const std::string &entries, const std::string &data)
+{
+    return "<< " + entries + " /Length " + std::to_string(data.size()) + " >>\nstream\n" + data + "\nendstream";
+}
+
+// Return a PDF file made of <objects>, numbered from 1, whose first one
+// is the catalog.
+inline std::string testPdf(const std::vector<std::string> &objects)
+{
+    std::string pdf = "%PDF-1.4\n";
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        offsets.push_back(pdf.size());
+        pdf += std::to_string(i + 1) + " 0 obj\n" + objects[i] + "\nendobj\n";
+    }
+    const size_t xref = pdf.size();
+    pdf += "xref\n0 " + std::to_string(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (size_t offset : offsets) {
+        char line[21];
+        snprintf(line, sizeof(line), "%010zu 00000 n \n", offset);
+        pdf += line;
+    }
+    pdf += "trailer\n<< /Size " + std::to_string(objects.size() + 1) + " /Root 1 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+    return pdf;
+}
+
+// Return a PDF file with a page of text in Helvetica for each string of
+// <pages>, one line per string of each page.
+inline std::string testTextPdf(const std::vector<std::vector<std::string>> &pages)
+{
+    std::vector<std::string> objects = { "<< /Type /Catalog /Pages 2 0 R >>", "", "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>" };
+    std::string kids;
+    for (const std::vector<std::string> &lines : pages) {
+        std::string content = "BT /F1 12 Tf 72 720 Td";
+        for (const std::string &line : lines) {
+            content += " (" + line + ") Tj 0 -20 Td";
+        }
+        content += " ET";
+        kids += std::to_string(objects.size() + 1) + " 0 R ";
+        objects.push_back("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 3 0 R >> >> /Contents " + std::to_string(objects.size() + 2) + " 0 R >>");
+        objects.push_back(testStreamObject("", content));
+    }
+    objects[1] = "<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(pages.size()) + " >>";
+    return testPdf(objects);
+}
+
+// Write <contents> to the file <fileName>.
+inline bool testWriteFile(const std::string &fileName, const std::string &contents)
+{
+    FILE *f = fopen(fileName.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    const bool ok = fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+    return fclose(f) == 0 && ok;
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include <cstddef>
 #include <cctype>
 #include <cmath>
+#include <algorithm>
 #include "goo/gmem.h"
 #include "goo/NetPBMWriter.h"
 #include "goo/PNGWriter.h"
@@ -403,9 +404,9 @@ void ImageOutputDev::writeImageFile(WriterHandle writer, ImageFormat format, con
                 }
             }
             std::vector<unsigned char> ret(row_length * height);
-            for (auto &byte : ret) {
-                byte = str->getChar();
-            }
+            int n = str->doGetChars(ret.size(), ret.data());
+            // missing data reads as EOF, as getChar() returns it
+            std::fill(ret.begin() + std::max(n, 0), ret.end(), (unsigned char)EOF);
             if (invert_bits) {
                 for (auto &byte : ret) {
                     byte ^= invert_bits;
@@ -21,9 +21,12 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstring>
+#include <string>
+#include <vector>
 #include "parseargs.h"
 #include "goo/GooString.h"
 #include "PDFDoc.h"
+#include "PDFSplitter.h"
 #include "ErrorCodes.h"
 #include "GlobalParams.h"
 #include "Win32Console.h"
@@ -31,11 +34,13 @@
 
 static int firstPage = 0;
 static int lastPage = 0;
+static int nThreads = 1;
 static bool printVersion = false;
 static bool printHelp = false;
 
 static const ArgDesc argDesc[] = { { "-f", argInt, &firstPage, 0, "first page to extract" },
                                    { "-l", argInt, &lastPage, 0, "last page to extract" },
+                                   { "-j", argInt, &nThreads, 0, "number of threads used to save the pages (default: 1)" },
                                    { "-v", argFlag, &printVersion, 0, "print copyright and version info" },
                                    { "-h", argFlag, &printHelp, 0, "print usage information" },
                                    { "-help", argFlag, &printHelp, 0, "print usage information" },
@@ -116,19 +121,17 @@ static bool extractPages(const char *srcFileName, const char *destFileName)
     }
     free(auxDestFileName);
 
+    std::vector<int> pageNos;
+    std::vector<std::string> pageNames;
     for (int pageNo = firstPage; pageNo <= lastPage; pageNo++) {
         snprintf(pathName, sizeof(pathName) - 1, destFileName, pageNo);
-        GooString *gpageName = new GooString(pathName);
-        PDFDoc *pagedoc = new PDFDoc(new GooString(srcFileName), nullptr, nullptr, nullptr);
-        int errCode = pagedoc->savePageAs(gpageName, pageNo);
-        if (errCode != errNone) {
-            delete gpageName;
-            delete doc;
-            delete pagedoc;
-            return false;
-        }
-        delete pagedoc;
-        delete gpageName;
+        pageNos.push_back(pageNo);
+        pageNames.emplace_back(pathName);
+    }
+    PDFSplitter splitter(gfileName, nullptr, nullptr);
+    if (splitter.savePages(pageNos, pageNames, nThreads) != errNone) {
+        delete doc;
+        return false;
     }
     delete doc;
     return true;
@@ -0,0 +1,130 @@
+//========================================================================
+//
+// pdftextindex.cc
+//
+// This file is licensed under the GPLv2 or later
+//
+// Build a persistent full-text index of a PDF file and query it.
+//
+//========================================================================
+
+#include "config.h"
+#include <poppler-config.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "parseargs.h"
+#include "goo/GooString.h"
+#include "goo/gmem.h"
+#include "GlobalParams.h"
+#include "TextIndex.h"
+#include "UTF.h"
+#include "Win32Console.h"
+
+static int nThreads = 0;
+static bool forceBuild = false;
+static bool noCheck = false;
+static bool checkContents = false;
+static char ownerPassword[33] = "\001";
+static char userPassword[33] = "\001";
+static bool quiet = false;
+static bool printVersion = false;
+static bool printHelp = false;
+
+static const ArgDesc argDesc[] = { { "-j", argInt, &nThreads, 0, "number of threads used to build the index (default: number of CPUs)" },
+                                   { "-build", argFlag, &forceBuild, 0, "rebuild the index even if it is up to date" },
+                                   { "-nocheck", argFlag, &noCheck, 0, "don't check that the index matches the PDF file before querying it" },
+                                   { "-checksum", argFlag, &checkContents, 0, "check that the index matches the contents of the PDF file, not only its size and modification time" },
+                                   { "-opw", argString, ownerPassword, sizeof(ownerPassword), "owner password (for encrypted files)" },
+                                   { "-upw", argString, userPassword, sizeof(userPassword), "user password (for encrypted files)" },
+                                   { "-q", argFlag, &quiet, 0, "don't print any messages or errors" },
+                                   { "-v", argFlag, &printVersion, 0, "print copyright and version info" },
+                                   { "-h", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "--help", argFlag, &printHelp, 0, "print usage information" },
+                                   { "-?", argFlag, &printHelp, 0, "print usage information" },
+                                   {} };
+
+int main(int argc, char *argv[])
+{
+    std::unique_ptr<GooString> ownerPW, userPW;
+    std::unique_ptr<TextIndex> index;
+    bool ok;
+
+    Win32Console win32Console(&argc, &argv);
+
+    // parse args
+    ok = parseArgs(argDesc, &argc, argv);
+    if (!ok || argc < 3 || printVersion || printHelp) {
+        fprintf(stderr, "pdftextindex version %s\n", PACKAGE_VERSION);
+        fprintf(stderr, "%s\n", popplerCopyright);
+        fprintf(stderr, "%s\n", xpdfCopyright);
+        if (!printVersion) {
+            printUsage("pdftextindex", "<PDF-file> <index-file> [<term> ...]", argDesc);
+        }
+        if (printVersion || printHelp)
+            return 0;
+        return 99;
+    }
+
+    const char *pdfFileName = argv[1];
+    const char *indexFileName = argv[2];
+
+    // read config file
+    globalParams = std::make_unique<GlobalParams>();
+    if (quiet) {
+        globalParams->setErrQuiet(quiet);
+    }
+
+    if (ownerPassword[0] != '\001') {
+        ownerPW = std::make_unique<GooString>(ownerPassword);
+    }
+    if (userPassword[0] != '\001') {
+        userPW = std::make_unique<GooString>(userPassword);
+    }
+
+    // (re)build the index if asked to, or if there is no up to date
+    // index to query
+    if (!forceBuild && argc > 3) {
+        index = std::make_unique<TextIndex>(indexFileName);
+        if (!index->isOk() || (!noCheck && !index->isValidFor(pdfFileName, checkContents))) {
+            index.reset();
+        }
+    }
+    if (!index) {
+        if (nThreads <= 0) {
+            nThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (!TextIndex::build(pdfFileName, ownerPW.get(), userPW.get(), indexFileName, nThreads)) {
+            return 1;
+        }
+        if (argc == 3) {
+            return 0;
+        }
+        index = std::make_unique<TextIndex>(indexFileName);
+        if (!index->isOk()) {
+            return 1;
+        }
+    }
+
+    // print the hits of each term
+    for (int i = 3; i < argc; ++i) {
+        uint16_t *utf16;
+        Unicode *u;
+        int len;
+
+        utf16 = utf8ToUtf16(argv[i], &len);
+        std::vector<Unicode> utf16Units(utf16, utf16 + len);
+        gfree(utf16);
+        len = UTF16toUCS4(utf16Units.data(), len, &u);
+        for (const TextIndexHit &hit : index->find(u, len)) {
+            printf("%s %d %d %.2f %.2f %.2f %.2f\n", argv[i], hit.page, hit.word, hit.xMin, hit.yMin, hit.xMax, hit.yMax);
+        }
+        gfree(u);
+    }
+
+    return 0;
+}
@@ -49,9 +49,12 @@
 #endif
 #include <cstdio>
 #include <cmath>
+#include <memory>
 #include "parseargs.h"
 #include "goo/gmem.h"
 #include "goo/GooString.h"
+#include "goo/NetPBMWriter.h"
+#include "goo/gfile.h"
 #include "GlobalParams.h"
 #include "Object.h"
 #include "PDFDoc.h"
@@ -60,6 +63,7 @@
 #include "splash/Splash.h"
 #include "splash/SplashErrorCodes.h"
 #include "SplashOutputDev.h"
+#include "ImagePrefetcher.h"
 #include "Win32Console.h"
 #include "numberofcharacters.h"
 #include "sanitychecks.h"
@@ -97,7 +101,12 @@ static int param_y = 0;
 static int param_w = 0;
 static int param_h = 0;
 static int sz = 0;
+static int stripHeight = 0;
 static bool hideAnnotations = false;
+static bool thumbnails = false;
+#ifndef UTILS_USE_PTHREADS
+static int prefetchThreads = 0;
+#endif // UTILS_USE_PTHREADS
 static bool useCropBox = false;
 static bool mono = false;
 static bool gray = false;
@@ -160,7 +169,12 @@ static const ArgDesc argDesc[] = { { "-f", argInt, &firstPage, 0, "first page to
                                    { "-H", argInt, &param_h, 0, "height of crop area in pixels (default is 0)" },
                                    { "-sz", argInt, &sz, 0, "size of crop square in pixels (sets W and H)" },
                                    { "-cropbox", argFlag, &useCropBox, 0, "use the crop box rather than media box" },
+                                   { "-strip-height", argInt, &stripHeight, 0, "render and write the pages in strips of this many pixel rows" },
                                    { "-hide-annotations", argFlag, &hideAnnotations, 0, "do not show annotations" },
+                                   { "-thumb", argFlag, &thumbnails, 0, "use the embedded page thumbnails large enough, render the other pages faster at a lower quality" },
+#ifndef UTILS_USE_PTHREADS
+                                   { "-prefetch", argInt, &prefetchThreads, 0, "number of threads decoding the images of each page while it's rendered" },
+#endif // UTILS_USE_PTHREADS
 
                                    { "-mono", argFlag, &mono, 0, "generate a monochrome PBM file" },
                                    { "-gray", argFlag, &gray, 0, "generate a grayscale PGM file" },
@@ -272,6 +286,75 @@ static bool parseJpegOptions()
 
 static auto annotDisplayDecideCbk = [](Annot *annot, void *user_data) { return !hideAnnotations; };
 
+static SplashColorMode getColorMode()
+{
+    return mono ? splashModeMono1 : gray ? splashModeMono8 : (jpegcmyk || overprint) ? splashModeDeviceN8 : splashModeRGB8;
+}
+
+struct StripWriter
+{
+    SplashOutputDev *splashOut;
+    ImgWriter *writer;
+    SplashColorMode imageWriterFormat;
+};
+
+static bool writeStrip(int stripY, int stripH, void *data)
+{
+    StripWriter *stripWriter = static_cast<StripWriter *>(data);
+    return stripWriter->splashOut->getBitmap()->writeImgRows(stripWriter->writer, stripWriter->imageWriterFormat) == splashOk;
+}
+
+// Render the page slice in strips of stripHeight rows, each of them
+// written out before the next one is rendered.
+static void savePageStrips(PDFDoc *doc, SplashOutputDev *splashOut, int pg, int x, int y, int w, int h, char *ppmFile, SplashBitmap::WriteImgParams *params)
+{
+    StripWriter stripWriter;
+    stripWriter.splashOut = splashOut;
+    if (png) {
+        stripWriter.writer = SplashBitmap::createImgWriter(splashFormatPng, getColorMode(), &stripWriter.imageWriterFormat, params);
+    } else if (jpeg) {
+        stripWriter.writer = SplashBitmap::createImgWriter(splashFormatJpeg, getColorMode(), &stripWriter.imageWriterFormat, params);
+    } else if (jpegcmyk) {
+        stripWriter.writer = SplashBitmap::createImgWriter(splashFormatJpegCMYK, getColorMode(), &stripWriter.imageWriterFormat, params);
+    } else if (tiff) {
+        stripWriter.writer = SplashBitmap::createImgWriter(splashFormatTiff, getColorMode(), &stripWriter.imageWriterFormat, params);
+    } else if (mono) {
+        stripWriter.writer = new NetPBMWriter(NetPBMWriter::MONOCHROME);
+        stripWriter.imageWriterFormat = splashModeMono1;
+    } else if (gray) {
+        stripWriter.writer = new NetPBMWriter(NetPBMWriter::GRAY);
+        stripWriter.imageWriterFormat = splashModeMono8;
+    } else {
+        stripWriter.writer = new NetPBMWriter(NetPBMWriter::RGB);
+        stripWriter.imageWriterFormat = splashModeRGB8;
+    }
+
+    FILE *f;
+    if (ppmFile != nullptr) {
+        f = openFile(ppmFile, "wb");
+    } else {
+#ifdef _WIN32
+        setmode(fileno(stdout), O_BINARY);
+#endif
+        f = stdout;
+    }
+
+    bool ok = stripWriter.writer && f && stripWriter.writer->init(f, w, h, x_resolution, y_resolution);
+    if (ok) {
+        ok = doc->displayPageStrips(splashOut, pg, x_resolution, y_resolution, 0, !useCropBox, false, false, x, y, w, h, stripHeight, writeStrip, &stripWriter, nullptr, nullptr, annotDisplayDecideCbk, nullptr);
+        ok = stripWriter.writer->close() && ok;
+    }
+    delete stripWriter.writer;
+    if (f && f != stdout) {
+        fclose(f);
+    }
+
+    if (!ok && ppmFile != nullptr) {
+        fprintf(stderr, "Could not write image to %s; exiting\n", ppmFile);
+        exit(EXIT_FAILURE);
+    }
+}
+
 static void savePageSlice(PDFDoc *doc, SplashOutputDev *splashOut, int pg, int x, int y, int w, int h, double pg_w, double pg_h, char *ppmFile)
 {
     if (w == 0)
@@ -280,9 +363,6 @@ static void savePageSlice(PDFDoc *doc, SplashOutputDev *splashOut, int pg, int x
         h = (int)ceil(pg_h);
     w = (x + w > pg_w ? (int)ceil(pg_w - x) : w);
     h = (y + h > pg_h ? (int)ceil(pg_h - y) : h);
-    doc->displayPageSlice(splashOut, pg, x_resolution, y_resolution, 0, !useCropBox, false, false, x, y, w, h, nullptr, nullptr, annotDisplayDecideCbk, nullptr);
-
-    SplashBitmap *bitmap = splashOut->getBitmap();
 
     SplashBitmap::WriteImgParams params;
     params.jpegQuality = jpegQuality;
@@ -290,6 +370,20 @@ static void savePageSlice(PDFDoc *doc, SplashOutputDev *splashOut, int pg, int x
     params.jpegOptimize = jpegOptimize;
     params.tiffCompression.Set(TiffCompressionStr);
 
+    // the embedded thumbnail can only replace a whole page
+    const bool thumbDisplayed = thumbnails && x == 0 && y == 0 && w == (int)ceil(pg_w) && h == (int)ceil(pg_h) && doc->displayPageThumb(splashOut, pg, x_resolution, y_resolution, 0, !useCropBox);
+
+    if (!thumbDisplayed && stripHeight > 0) {
+        savePageStrips(doc, splashOut, pg, x, y, w, h, ppmFile, &params);
+        return;
+    }
+
+    if (!thumbDisplayed) {
+        doc->displayPageSlice(splashOut, pg, x_resolution, y_resolution, 0, !useCropBox, false, false, x, y, w, h, nullptr, nullptr, annotDisplayDecideCbk, nullptr);
+    }
+
+    SplashBitmap *bitmap = splashOut->getBitmap();
+
     if (ppmFile != nullptr) {
         SplashError e;
 
@@ -358,9 +452,11 @@ static void processPageJobs()
         pthread_mutex_unlock(&pageJobMutex);
 
         // process the job
-        SplashOutputDev *splashOut = new SplashOutputDev(mono ? splashModeMono1 : gray ? splashModeMono8 : (jpegcmyk || overprint) ? splashModeDeviceN8 : splashModeRGB8, 4, false, *pageJob.paperColor, true, thinLineMode);
+        SplashOutputDev *splashOut = new SplashOutputDev(getColorMode(), 4, false, *pageJob.paperColor, true, thinLineMode);
         splashOut->setFontAntialias(fontAntialias);
         splashOut->setVectorAntialias(vectorAntialias);
+        splashOut->setImageInterpolation(!thumbnails);
+        splashOut->setReducedImageDecoding(thumbnails);
         splashOut->setEnableFreeType(enableFreeType);
 #    ifdef USE_CMS
         splashOut->setDisplayProfile(displayprofile);
@@ -389,6 +485,7 @@ int main(int argc, char *argv[])
     SplashColor paperColor;
 #ifndef UTILS_USE_PTHREADS
     SplashOutputDev *splashOut;
+    std::unique_ptr<ImagePrefetcher> imagePrefetcher;
 #else
     pthread_t *jobs;
 #endif // UTILS_USE_PTHREADS
@@ -437,6 +534,8 @@ int main(int argc, char *argv[])
         if (!GlobalParams::parseYesNo2(vectorAntialiasStr, &vectorAntialias)) {
             fprintf(stderr, "Bad '-aaVector' value on command line\n");
         }
+    } else if (thumbnails) {
+        vectorAntialias = false;
     }
 
     if (jpegOpt.getLength() > 0) {
@@ -587,10 +686,12 @@ int main(int argc, char *argv[])
 
 #ifndef UTILS_USE_PTHREADS
 
-    splashOut = new SplashOutputDev(mono ? splashModeMono1 : gray ? splashModeMono8 : (jpegcmyk || overprint) ? splashModeDeviceN8 : splashModeRGB8, 4, false, paperColor, true, thinLineMode);
+    splashOut = new SplashOutputDev(getColorMode(), 4, false, paperColor, true, thinLineMode);
 
     splashOut->setFontAntialias(fontAntialias);
     splashOut->setVectorAntialias(vectorAntialias);
+    splashOut->setImageInterpolation(!thumbnails);
+    splashOut->setReducedImageDecoding(thumbnails);
     splashOut->setEnableFreeType(enableFreeType);
 #    ifdef USE_CMS
     splashOut->setDisplayProfile(displayprofile);
@@ -600,6 +701,11 @@ int main(int argc, char *argv[])
 #    endif
     splashOut->startDoc(doc);
 
+    if (prefetchThreads > 0) {
+        imagePrefetcher = std::make_unique<ImagePrefetcher>(doc, prefetchThreads);
+        splashOut->setImagePrefetcher(imagePrefetcher.get());
+    }
+
 #endif // UTILS_USE_PTHREADS
 
     if (sz != 0)
@@ -656,6 +762,9 @@ int main(int argc, char *argv[])
         }
 #ifndef UTILS_USE_PTHREADS
         // process job in main thread
+        if (imagePrefetcher) {
+            imagePrefetcher->prefetchPage(pg);
+        }
         savePageSlice(doc, splashOut, pg, param_x, param_y, param_w, param_h, pg_w, pg_h, ppmFile);
 
         delete[] ppmFile;
@@ -677,6 +786,7 @@ int main(int argc, char *argv[])
 #endif // UTILS_USE_PTHREADS
     }
 #ifndef UTILS_USE_PTHREADS
+    imagePrefetcher.reset();
     delete splashOut;
 #else
 
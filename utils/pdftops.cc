@@ -104,6 +104,7 @@ static bool noEmbedTTFonts = false;
 static bool noEmbedCIDPSFonts = false;
 static bool noEmbedCIDTTFonts = false;
 static bool fontPassthrough = false;
+static bool noSubsetFonts = false;
 static bool optimizeColorSpace = false;
 static bool passLevel1CustomColor = false;
 static char rasterAntialiasStr[16] = "";
@@ -162,6 +163,7 @@ static const ArgDesc argDesc[] = { { "-f", argInt, &firstPage, 0, "first page to
                                    { "-noembcidps", argFlag, &noEmbedCIDPSFonts, 0, "don't embed CID PostScript fonts" },
                                    { "-noembcidtt", argFlag, &noEmbedCIDTTFonts, 0, "don't embed CID TrueType fonts" },
                                    { "-passfonts", argFlag, &fontPassthrough, 0, "don't substitute missing fonts" },
+                                   { "-nosubset", argFlag, &noSubsetFonts, 0, "don't subset TrueType and CID fonts" },
                                    { "-aaRaster", argString, rasterAntialiasStr, sizeof(rasterAntialiasStr), "enable anti-aliasing on rasterization: yes, no" },
                                    { "-rasterize", argString, forceRasterizeStr, sizeof(forceRasterizeStr), "control rasterization: always, never, whenneeded" },
 #ifdef HAVE_SPLASH
@@ -501,6 +503,7 @@ int main(int argc, char *argv[])
     psOut->setEmbedCIDPostScript(!noEmbedCIDPSFonts);
     psOut->setEmbedCIDTrueType(!noEmbedCIDTTFonts);
     psOut->setFontPassthrough(fontPassthrough);
+    psOut->setSubsetFonts(!noSubsetFonts);
     psOut->setPreloadImagesForms(preload);
     psOut->setOptimizeColorSpace(optimizeColorSpace);
     psOut->setPassLevel1CustomColor(passLevel1CustomColor);
@@ -20,15 +20,22 @@
 
 #include <PDFDoc.h>
 #include <GlobalParams.h>
+#include <ObjectDeduplicator.h>
 #include "parseargs.h"
 #include "config.h"
 #include <poppler-config.h>
+#include <algorithm>
+#include <thread>
 #include <vector>
 
+static bool dedup = false;
+static int nThreads = 0;
 static bool printVersion = false;
 static bool printHelp = false;
 
-static const ArgDesc argDesc[] = { { "-v", argFlag, &printVersion, 0, "print copyright and version info" }, { "-h", argFlag, &printHelp, 0, "print usage information" }, { "-help", argFlag, &printHelp, 0, "print usage information" },
+static const ArgDesc argDesc[] = { { "-dedup", argFlag, &dedup, 0, "write the identical objects of the source files once" },
+                                   { "-j", argInt, &nThreads, 0, "number of threads hashing the objects with -dedup (default: number of CPUs)" },
+                                   { "-v", argFlag, &printVersion, 0, "print copyright and version info" }, { "-h", argFlag, &printHelp, 0, "print usage information" }, { "-help", argFlag, &printHelp, 0, "print usage information" },
                                    { "--help", argFlag, &printHelp, 0, "print usage information" },         { "-?", argFlag, &printHelp, 0, "print usage information" }, {} };
 
 static void doMergeNameTree(PDFDoc *doc, XRef *srcXRef, XRef *countRef, int oldRefNum, int newRefNum, Dict *srcNameTree, Dict *mergeNameTree, int numOffset)
@@ -138,6 +145,7 @@ int main(int argc, char *argv[])
     int minorVersion = 0;
     char *fileName = argv[argc - 1];
     int exitCode;
+    ObjectDeduplicator deduplicator;
 
     exitCode = 99;
     const bool ok = parseArgs(argDesc, &argc, argv);
@@ -313,9 +321,34 @@ int main(int argc, char *argv[])
                 doMergeFormDict(afObj.getDict(), pageForm.getDict(), numOffset);
             }
         }
-        objectsCount += docs[i]->writePageObjects(outStr, yRef, numOffset, true);
+        if (dedup) {
+            // written once the duplicates of all the documents are known
+            deduplicator.addDocument(docs[i], yRef, numOffset, yRef->getNumObjects());
+        } else {
+            objectsCount += docs[i]->writePageObjects(outStr, yRef, numOffset, true);
+        }
         numOffset = yRef->getNumObjects() + 1;
     }
+    if (dedup) {
+        if (nThreads <= 0) {
+            nThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        deduplicator.deduplicate(yRef, nThreads);
+        for (i = 0; i < (int)docs.size(); i++) {
+            objectsCount += deduplicator.writeObjects(i, outStr, yRef);
+        }
+    }
+
+    // with -dedup, the references to duplicates are written as references
+    // to the objects kept instead
+    auto writeValue = [&](Object *obj, unsigned int offset) {
+        if (dedup) {
+            Object renumbered = deduplicator.renumber(*obj, yRef, offset);
+            PDFDoc::writeObject(&renumbered, outStr, yRef, 0, nullptr, cryptRC4, 0, 0, 0);
+        } else {
+            PDFDoc::writeObject(obj, outStr, yRef, offset, nullptr, cryptRC4, 0, 0, 0);
+        }
+    };
 
     rootNum = yRef->getNumObjects() + 1;
     yRef->add(rootNum, 0, outStr->getPos(), true);
@@ -327,7 +360,7 @@ int main(int argc, char *argv[])
         for (j = 0; j < intents.arrayGetLength(); j++) {
             Object intent = intents.arrayGet(j, 0);
             if (intent.isDict()) {
-                PDFDoc::writeObject(&intent, outStr, yRef, 0, nullptr, cryptRC4, 0, 0, 0);
+                writeValue(&intent, 0);
             }
         }
         outStr->printf("]");
@@ -335,17 +368,17 @@ int main(int argc, char *argv[])
     // insert AcroForm
     if (!afObj.isNull()) {
         outStr->printf(" /AcroForm ");
-        PDFDoc::writeObject(&afObj, outStr, yRef, 0, nullptr, cryptRC4, 0, 0, 0);
+        writeValue(&afObj, 0);
     }
     // insert OCProperties
     if (!ocObj.isNull() && ocObj.isDict()) {
         outStr->printf(" /OCProperties ");
-        PDFDoc::writeObject(&ocObj, outStr, yRef, 0, nullptr, cryptRC4, 0, 0, 0);
+        writeValue(&ocObj, 0);
     }
     // insert Names
     if (!names.isNull() && names.isDict()) {
         outStr->printf(" /Names ");
-        PDFDoc::writeObject(&names, outStr, yRef, 0, nullptr, cryptRC4, 0, 0, 0);
+        writeValue(&names, 0);
     }
     outStr->printf(">>\nendobj\n");
     objectsCount++;
@@ -372,7 +405,7 @@ int main(int argc, char *argv[])
                 outStr->printf("/Parent %d 0 R", rootNum + 1);
             } else {
                 outStr->printf("/%s ", key);
-                PDFDoc::writeObject(&value, outStr, yRef, offsets[i], nullptr, cryptRC4, 0, 0, 0);
+                writeValue(&value, offsets[i]);
             }
         }
         outStr->printf(" >>\nendobj\n");